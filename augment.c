@@ -0,0 +1,307 @@
+/**
+ * Created 10/18/2026
+ * This file augments a network's training sets while it trains, so that a
+ * few bitmaps can be seen as many without storing the copies.
+ *
+ * Worker threads take the decoded pels of the training sets (as read from
+ * the file that ./dibdump.c wrote), shift them by a few pels, flip them,
+ * change their brightness, and add noise, and put the results in a bounded
+ * queue. The training thread takes them from the queue after every epoch's
+ * pass over the real training sets (see trainForAllTrainingSets in
+ * ./network.c), so the workers augment the next sets while it trains on the
+ * last ones. When the queue is full, the workers wait.
+ *
+ * The augmented sets are numbered in the order they are trained on, and
+ * every random choice made for one only depends on its number, so training
+ * goes the same way no matter how many workers there are. Every cycle takes
+ * the same number of them, so a network resumed from a checkpoint (which
+ * keeps the seed they are made from) starts at the first set of its next
+ * cycle, and is trained on the same sets as a run that never stopped.
+ *
+ * Functions in this file:
+ *
+ * Augmenter *createAugmenter(const Network *net)
+ * void freeAugmenter(Augmenter *augmenter)
+ * double *takeAugmentedSet(Augmenter *augmenter, int *setIndex)
+ * void releaseAugmentedSet(Augmenter *augmenter)
+ * void *runAugmentWorker(void *argument)
+ * void augmentSet(const Augmenter *augmenter, long long sample, double *augmented)
+ * double augmentRandom(unsigned long long *state, double lowerBound, double upperBound)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "./headerfiles/networkInternals.h" // importing the network layout and functions
+#include "./headerfiles/augment.h"
+
+struct Augmenter
+{
+   const Network *net; // the network whose training sets are augmented (only read)
+
+   double *slots;           // AUGMENT_QUEUE_LENGTH training sets, inputStride apart
+   long long *slotSamples;  // the number of the augmented set in each slot (-1 while it is being made)
+   long long nextSample;    // the next augmented set for a worker to make
+   long long nextTaken;     // the next augmented set for the training thread to take
+   long long numReleased;   // augmented sets the training thread is done with (their slots are free)
+   int stopping;
+
+   pthread_mutex_t lock;
+   pthread_cond_t changed; // signalled whenever a slot is filled or freed, or the augmenter stops
+
+   int numThreads;
+   pthread_t *threads;
+
+   unsigned long long seed; // mixed with each augmented set's number for its random choices
+};
+
+// function headers ----------------------
+
+void *runAugmentWorker(void *);
+void augmentSet(const Augmenter *, long long, double *);
+double augmentRandom(unsigned long long *, double, double);
+
+// functions ----------------------
+
+/**
+ * Creates an augmenter for a network's training sets and starts its worker
+ * threads, which begin filling the queue straight away with the sets of the
+ * network's next cycle.
+ *
+ * @param net the network whose training sets to augment (they must be in memory)
+ * @return the new augmenter, or NULL if it could not be created
+ */
+Augmenter *createAugmenter(const Network *net)
+{
+   Augmenter *augmenter = calloc(1, sizeof(Augmenter));
+   if (augmenter == NULL)
+   {
+      printf("There was an error allocating memory for the augmenter.\n");
+      return NULL;
+   }
+
+   augmenter->net = net;
+   augmenter->seed = net->augmentSeed;
+   augmenter->nextSample = (long long)net->iteration * net->numTrainingSets * net->augmentCopies;
+   augmenter->nextTaken = augmenter->nextSample;
+   augmenter->numReleased = augmenter->nextSample;
+   augmenter->numThreads = net->augmentThreads > 0 ? net->augmentThreads : 1;
+   augmenter->slots = malloc((size_t)AUGMENT_QUEUE_LENGTH * net->inputStride * sizeof(double));
+   augmenter->slotSamples = malloc(AUGMENT_QUEUE_LENGTH * sizeof(long long));
+   augmenter->threads = malloc(augmenter->numThreads * sizeof(pthread_t));
+
+   if (augmenter->slots == NULL || augmenter->slotSamples == NULL || augmenter->threads == NULL)
+   {
+      printf("There was an error allocating memory for the augmenter.\n");
+      free(augmenter->slots);
+      free(augmenter->slotSamples);
+      free(augmenter->threads);
+      free(augmenter);
+      return NULL;
+   }
+
+   for (int i = 0; i < AUGMENT_QUEUE_LENGTH; i++)
+   {
+      augmenter->slotSamples[i] = -1;
+   }
+
+   pthread_mutex_init(&augmenter->lock, NULL);
+   pthread_cond_init(&augmenter->changed, NULL);
+
+   for (int i = 0; i < augmenter->numThreads; i++)
+   {
+      if (pthread_create(&augmenter->threads[i], NULL, &runAugmentWorker, augmenter) != 0)
+      {
+         printf("There was an error starting an augmentation thread.\n");
+         augmenter->numThreads = i; // only the ones that started are stopped
+         freeAugmenter(augmenter);
+         return NULL;
+      }
+   }
+
+   return augmenter;
+}
+
+/**
+ * Stops an augmenter's worker threads and frees it.
+ *
+ * @param augmenter the augmenter to free (NULL does nothing)
+ */
+void freeAugmenter(Augmenter *augmenter)
+{
+   if (augmenter == NULL)
+   {
+      return;
+   }
+
+   pthread_mutex_lock(&augmenter->lock);
+   augmenter->stopping = 1;
+   pthread_cond_broadcast(&augmenter->changed);
+   pthread_mutex_unlock(&augmenter->lock);
+
+   for (int i = 0; i < augmenter->numThreads; i++)
+   {
+      pthread_join(augmenter->threads[i], NULL);
+   }
+
+   pthread_mutex_destroy(&augmenter->lock);
+   pthread_cond_destroy(&augmenter->changed);
+   free(augmenter->slots);
+   free(augmenter->slotSamples);
+   free(augmenter->threads);
+   free(augmenter);
+
+   return;
+}
+
+/**
+ * Takes the next augmented training set from the queue, waiting for a
+ * worker to finish it if it is not ready yet. Only the training thread
+ * may take sets, and it must release each one before taking the next.
+ *
+ * @param augmenter the augmenter to take from
+ * @param setIndex where to store which training set it was made from
+ * @return the augmented inputs (valid until the set is released)
+ */
+double *takeAugmentedSet(Augmenter *augmenter, int *setIndex)
+{
+   long long sample = augmenter->nextTaken++;
+   int slot = (int)(sample % AUGMENT_QUEUE_LENGTH);
+
+   pthread_mutex_lock(&augmenter->lock);
+   while (augmenter->slotSamples[slot] != sample)
+   {
+      pthread_cond_wait(&augmenter->changed, &augmenter->lock);
+   }
+   pthread_mutex_unlock(&augmenter->lock);
+
+   *setIndex = (int)(sample % augmenter->net->numTrainingSets);
+
+   return augmenter->slots + (size_t)slot * augmenter->net->inputStride;
+}
+
+/**
+ * Frees the slot of the augmented training set taken last,
+ * so that a worker can fill it again.
+ *
+ * @param augmenter the augmenter the set was taken from
+ */
+void releaseAugmentedSet(Augmenter *augmenter)
+{
+   pthread_mutex_lock(&augmenter->lock);
+   augmenter->slotSamples[augmenter->numReleased % AUGMENT_QUEUE_LENGTH] = -1;
+   augmenter->numReleased++;
+   pthread_cond_broadcast(&augmenter->changed);
+   pthread_mutex_unlock(&augmenter->lock);
+
+   return;
+}
+
+/**
+ * Makes augmented training sets in order, one after another, for as long
+ * as there is room in the queue, until the augmenter is stopped.
+ *
+ * @param argument the augmenter the thread works for
+ * @return NULL
+ */
+void *runAugmentWorker(void *argument)
+{
+   Augmenter *augmenter = argument;
+
+   pthread_mutex_lock(&augmenter->lock);
+   while (!augmenter->stopping)
+   {
+      long long sample = augmenter->nextSample;
+      if (sample >= augmenter->numReleased + AUGMENT_QUEUE_LENGTH) // its slot still holds an earlier set
+      {
+         pthread_cond_wait(&augmenter->changed, &augmenter->lock);
+         continue;
+      }
+      augmenter->nextSample++;
+      pthread_mutex_unlock(&augmenter->lock);
+
+      int slot = (int)(sample % AUGMENT_QUEUE_LENGTH);
+      augmentSet(augmenter, sample, augmenter->slots + (size_t)slot * augmenter->net->inputStride);
+
+      pthread_mutex_lock(&augmenter->lock);
+      augmenter->slotSamples[slot] = sample;
+      pthread_cond_broadcast(&augmenter->changed);
+   }
+   pthread_mutex_unlock(&augmenter->lock);
+
+   return NULL;
+}
+
+/**
+ * Makes one augmented training set from the training set it is numbered
+ * after: shifted by up to augmentShift pels each way (repeating the edge
+ * pels), flipped left to right half of the time if augmentFlip is Y,
+ * brightened or darkened by up to augmentBrightness, and with up to
+ * augmentNoise of noise added to every pel.
+ *
+ * @param augmenter the augmenter making the set
+ * @param sample the number of the augmented set
+ * @param augmented where to store the augmented inputs
+ */
+void augmentSet(const Augmenter *augmenter, long long sample, double *augmented)
+{
+   const Network *net = augmenter->net;
+   int width = net->inputWidth;
+   int height = net->inputHeight;
+   const double *source = net->trainingInputs + (size_t)(sample % net->numTrainingSets) * net->inputStride;
+
+   unsigned long long state = augmenter->seed + (unsigned long long)sample * 0x9E3779B97F4A7C15ULL;
+
+   int shiftX = (int)floor(augmentRandom(&state, -net->augmentShift, net->augmentShift + 1.0));
+   int shiftY = (int)floor(augmentRandom(&state, -net->augmentShift, net->augmentShift + 1.0));
+   char flip = net->augmentFlip == 'Y' && augmentRandom(&state, 0.0, 1.0) < 0.5;
+   double brightness = augmentRandom(&state, -net->augmentBrightness, net->augmentBrightness);
+
+   for (int c = 0; c < net->inputChannels; c++)
+   {
+      const double *plane = source + c * width * height;
+
+      for (int y = 0; y < height; y++)
+      {
+         int sourceY = y - shiftY;
+         sourceY = sourceY < 0 ? 0 : (sourceY >= height ? height - 1 : sourceY);
+
+         for (int x = 0; x < width; x++)
+         {
+            int sourceX = (flip ? width - 1 - x : x) - shiftX;
+            sourceX = sourceX < 0 ? 0 : (sourceX >= width ? width - 1 : sourceX);
+
+            double value = plane[sourceY * width + sourceX] + brightness;
+            if (net->augmentNoise > 0.0)
+            {
+               value += augmentRandom(&state, -net->augmentNoise, net->augmentNoise);
+            }
+
+            augmented[c * width * height + y * width + x] = value;
+         }
+      }
+   } // for (int c = 0; c < inputChannels; c++)
+
+   return;
+}
+
+/**
+ * Steps a SplitMix64 generator and scales its output to a range, the same
+ * as randomNumber in ./network.c but with the state kept by the caller.
+ *
+ * @param state the state of the generator
+ * @param lowerBound the lower bound of the number
+ * @param upperBound the upper bound of the number
+ * @return a random number between the bounds
+ */
+double augmentRandom(unsigned long long *state, double lowerBound, double upperBound)
+{
+   unsigned long long z = (*state += 0x9E3779B97F4A7C15ULL);
+   z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+   z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+   z ^= z >> 31;
+
+   return (double)(z >> 11) / 9007199254740992.0 * (upperBound - lowerBound) + lowerBound; // top 53 bits, scaled to [0,1)
+}
@@ -0,0 +1,382 @@
+/**
+ * Created 10/18/2026
+ * This file tunes the matrix kernels (see ./matrixFunctions.c) for a
+ * network. It times a training step and a batch of forward passes on the
+ * network's exact layerDimensions with candidate thread counts and block
+ * sizes, keeps the fastest, and caches them in a file keyed by the topology
+ * and CPU model, so later runs on the same host start already tuned.
+ *
+ * The candidates are tried one setting at a time (threads, then depth,
+ * column, and row blocks), keeping the best value of each before moving on.
+ *
+ * Functions in this file:
+ *
+ * void autoTuneNetwork(Network *net)
+ * int findTunedSettings(char *tuningFile, char *key, int settings[])
+ * void saveTunedSettings(char *tuningFile, char *key, int settings[])
+ * void applyTunedSettings(int settings[])
+ * double timeTuningStep(Network *net, double *inputs, double *labels, double *batch, double *batchOutputs)
+ * void getCpuModel(char *model, int length)
+ * int getNumProcessors(void)
+ * double getWallTime(void)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#endif
+
+#include "./headerfiles/matrixFunctions.h"  // importing matrix kernels
+#include "./headerfiles/networkInternals.h" // importing the network layout and functions
+#include "./headerfiles/autoTune.h"
+
+#define MAX_TUNING_KEY_LENGTH 1024
+#define NUM_TUNED_SETTINGS 4     // threads, row block, depth block, column block
+#define MAX_THREAD_CANDIDATES 32 // most thread counts tried
+#define TUNING_BATCH_SIZE 64     // training sets in the batch of forward passes
+#define MIN_TUNING_TIME 0.02     // seconds each timing runs for
+#define NUM_TUNING_REPEATS 3     // timings taken of each candidate (the fastest is kept)
+
+/**
+ * Looks for tuned settings for the network's topology and this CPU in
+ * the network's tuning file, and tunes them from scratch (adding them to
+ * the file) if there are none. Either way, the settings are applied.
+ *
+ * @param net the network to tune for
+ */
+void autoTuneNetwork(Network *net)
+{
+   char key[MAX_TUNING_KEY_LENGTH];
+   char cpuModel[64];
+   int settings[NUM_TUNED_SETTINGS];
+
+   // the key is the topology (such as 3136-100-100-5) followed by the CPU model
+   key[0] = '\0';
+   for (int n = 0; n < net->numLayers && strlen(key) < MAX_TUNING_KEY_LENGTH - 64; n++)
+   {
+      sprintf(key + strlen(key), n == 0 ? "%d" : "-%d", net->layerDimensions[n]);
+   }
+   getCpuModel(cpuModel, sizeof(cpuModel));
+   sprintf(key + strlen(key), " %s", cpuModel);
+
+   if (findTunedSettings(net->tuningFile, key, settings) == 0)
+   {
+      applyTunedSettings(settings);
+      printf("Using tuned settings from %s: %d threads, blocks %d/%d/%d\n", net->tuningFile,
+             settings[0], settings[1], settings[2], settings[3]);
+      return;
+   }
+
+   printf("Tuning the %s kernels for %s...\n", getMatrixKernelName(), key);
+
+   double *inputs = allocateAligned(net->inputStride * sizeof(double));
+   double *labels = calloc(net->numOutputNodes, sizeof(double));
+   int batchStride = net->layerDimensions[0] > net->inputStride ? net->layerDimensions[0] : net->inputStride;
+   double *batch = allocateAligned((size_t)TUNING_BATCH_SIZE * batchStride * sizeof(double));
+   double *batchOutputs = malloc((size_t)TUNING_BATCH_SIZE * net->layerDimensions[1] * sizeof(double));
+   if (inputs == NULL || labels == NULL || batch == NULL || batchOutputs == NULL)
+   {
+      printf("There was an error allocating memory for tuning.\n");
+      freeAligned(inputs);
+      free(labels);
+      freeAligned(batch);
+      free(batchOutputs);
+      return;
+   }
+
+   // drawn from the generator's state without stepping it, so tuning leaves training (and a resumed checkpoint) as it was
+   for (int i = 0; i < net->inputStride; i++)
+   {
+      inputs[i] = randomNumberAt(net->randomState, i, 0.0, 1.0);
+   }
+   for (int i = 0; i < TUNING_BATCH_SIZE * batchStride; i++)
+   {
+      batch[i] = randomNumberAt(net->randomState, (unsigned long long)net->inputStride + i, 0.0, 1.0);
+   }
+
+   int threadCandidates[MAX_THREAD_CANDIDATES];
+   int numThreadCandidates = 0;
+   int numProcessors = getNumProcessors();
+   for (int t = 1; t < numProcessors && numThreadCandidates < MAX_THREAD_CANDIDATES - 1; t *= 2)
+   {
+      threadCandidates[numThreadCandidates++] = t;
+   }
+   threadCandidates[numThreadCandidates++] = numProcessors;
+
+   int depthCandidates[] = {64, 128, 256, 512, 1024};
+   int colCandidates[] = {32, 64, 128, 256};
+   int rowCandidates[] = {16, 32, 64, 128};
+
+   int *candidates[NUM_TUNED_SETTINGS] = {threadCandidates, rowCandidates, depthCandidates, colCandidates};
+   int numCandidates[NUM_TUNED_SETTINGS] = {numThreadCandidates, 4, 5, 4};
+   int tuningOrder[NUM_TUNED_SETTINGS] = {0, 2, 3, 1};
+
+   settings[0] = 1;
+   getMatrixBlockSizes(&settings[1], &settings[2], &settings[3]);
+
+   for (int s = 0; s < NUM_TUNED_SETTINGS; s++)
+   {
+      int setting = tuningOrder[s];
+      int bestValue = settings[setting];
+      double bestTime = -1.0;
+
+      for (int c = 0; c < numCandidates[setting]; c++)
+      {
+         settings[setting] = candidates[setting][c];
+         applyTunedSettings(settings);
+
+         double time = timeTuningStep(net, inputs, labels, batch, batchOutputs);
+         if (net->printDebugMessages == 'Y')
+         {
+            printf("DEBUG: %d threads, blocks %d/%d/%d: %lfms\n", settings[0], settings[1], settings[2],
+                   settings[3], time * 1000);
+         }
+
+         if (bestTime < 0.0 || time < bestTime)
+         {
+            bestTime = time;
+            bestValue = settings[setting];
+         }
+      }
+
+      settings[setting] = bestValue;
+   }
+
+   applyTunedSettings(settings);
+   saveTunedSettings(net->tuningFile, key, settings);
+
+   printf("Tuned settings: %d threads, blocks %d/%d/%d\n", settings[0], settings[1], settings[2], settings[3]);
+
+   freeAligned(inputs);
+   free(labels);
+   freeAligned(batch);
+   free(batchOutputs);
+
+   return;
+}
+
+/**
+ * Looks up the settings for a key in a tuning file. Each line of the file
+ * holds a topology, a CPU model, and the settings tuned for them.
+ *
+ * @param tuningFile the path to the tuning file
+ * @param key the topology and CPU model, separated by a space
+ * @param settings where to store the settings that were found
+ * @return 0 if the settings were found, 1 otherwise
+ */
+int findTunedSettings(char *tuningFile, char *key, int settings[])
+{
+   FILE *file = fopen(tuningFile, "r");
+   if (file == NULL)
+   {
+      return 1;
+   }
+
+   char line[MAX_TUNING_KEY_LENGTH + 64];
+   char topology[MAX_TUNING_KEY_LENGTH];
+   char cpuModel[MAX_TUNING_KEY_LENGTH];
+   char lineKey[2 * MAX_TUNING_KEY_LENGTH + 1];
+   int found = 1;
+
+   while (found != 0 && fgets(line, sizeof(line), file) != NULL)
+   {
+      if (sscanf(line, "%1023s %1023s %d %d %d %d", topology, cpuModel,
+                 &settings[0], &settings[1], &settings[2], &settings[3]) != 6)
+      {
+         continue;
+      }
+
+      sprintf(lineKey, "%s %s", topology, cpuModel);
+      if (strcmp(lineKey, key) == 0)
+      {
+         found = 0;
+      }
+   }
+
+   fclose(file);
+
+   return found;
+}
+
+/**
+ * Adds the settings for a key to the end of a tuning file.
+ *
+ * @param tuningFile the path to the tuning file
+ * @param key the topology and CPU model, separated by a space
+ * @param settings the settings to save
+ */
+void saveTunedSettings(char *tuningFile, char *key, int settings[])
+{
+   FILE *file = fopen(tuningFile, "a");
+   if (file == NULL)
+   {
+      printf("Could not save the tuned settings to %s.\n", tuningFile);
+      return;
+   }
+
+   fprintf(file, "%s %d %d %d %d\n", key, settings[0], settings[1], settings[2], settings[3]);
+   fclose(file);
+
+   return;
+}
+
+/**
+ * Applies tuned settings to the matrix kernels.
+ *
+ * @param settings the thread count, then the row, depth, and column block sizes
+ */
+void applyTunedSettings(int settings[])
+{
+   if (getMatrixThreads() != settings[0])
+   {
+      setMatrixThreads(settings[0]);
+   }
+   setMatrixBlockSizes(settings[1], settings[2], settings[3]);
+
+   return;
+}
+
+/**
+ * Times the work the kernels do for the network: a single training step
+ * (run, psis, and a weight update that adds nothing, so the weights are
+ * left untouched) and a batch of forward passes through the first layer.
+ *
+ * @param net the network to time
+ * @param inputs the inputs of the training step
+ * @param labels the expected outputs of the training step
+ * @param batch the input layers of the batch (TUNING_BATCH_SIZE rows, inputStride or
+ *              layerDimensions[0] apart, whichever is larger)
+ * @param batchOutputs where the batch's first hidden layer goes
+ * @return the fastest time of the work, in seconds
+ */
+double timeTuningStep(Network *net, double *inputs, double *labels, double *batch, double *batchOutputs)
+{
+   NetworkScratch *scratch = net->scratch;
+   double bestTime = -1.0;
+   int batchStride = net->layerDimensions[0] > net->inputStride ? net->layerDimensions[0] : net->inputStride;
+
+   scratch->expectedOutputs = labels;
+
+   for (int r = 0; r < NUM_TUNING_REPEATS; r++)
+   {
+      double startTime = getWallTime();
+      double elapsed = 0.0;
+      int steps = 0;
+
+      while (elapsed < MIN_TUNING_TIME)
+      {
+         runNetwork(net, scratch, inputs, NULL);
+         calculatePsis(net, scratch, labels);
+         for (int m = 0; m < net->numLayers - 1; m++)
+         {
+            double *sourceNodes = (m == 0) ? scratch->inputs : scratch->nodes + net->maxNodesInALayer * m;
+            addOuterProduct(net->layerDimensions[m], net->layerDimensions[m + 1], 0.0, sourceNodes,
+                            scratch->psis + net->maxNodesInALayer * (m + 1),
+                            net->weights + net->maxWeightsInALayer * m, net->maxNodesInALayer);
+         }
+
+         multiplyMatrices(TUNING_BATCH_SIZE, net->layerDimensions[1], net->layerDimensions[0], batch, batchStride,
+                          net->weights, net->maxNodesInALayer, batchOutputs, net->layerDimensions[1]);
+
+         steps++;
+         elapsed = getWallTime() - startTime;
+      }
+
+      if (bestTime < 0.0 || elapsed / steps < bestTime)
+      {
+         bestTime = elapsed / steps;
+      }
+   }
+
+   scratch->expectedOutputs = NULL;
+
+   return bestTime;
+}
+
+/**
+ * Gets the model name of the CPU, with spaces replaced by underscores
+ * so that it can be read back as a single word.
+ *
+ * @param model where to store the model name
+ * @param length the size of model
+ */
+void getCpuModel(char *model, int length)
+{
+   char brand[49] = "unknown";
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+   unsigned int registers[12];
+   if (__get_cpuid(0x80000000, &registers[0], &registers[1], &registers[2], &registers[3]) &&
+       registers[0] >= 0x80000004)
+   {
+      for (unsigned int leaf = 0; leaf < 3; leaf++)
+      {
+         __get_cpuid(0x80000002 + leaf, &registers[4 * leaf], &registers[4 * leaf + 1],
+                     &registers[4 * leaf + 2], &registers[4 * leaf + 3]);
+      }
+      memcpy(brand, registers, 48);
+      brand[48] = '\0';
+   }
+#endif
+
+   // trimming the spaces around the name and joining the words inside it
+   char *start = brand;
+   while (*start == ' ')
+   {
+      start++;
+   }
+
+   int n = 0;
+   for (char *c = start; *c != '\0' && n < length - 1; c++)
+   {
+      if (*c == ' ' && (c[1] == ' ' || c[1] == '\0'))
+      {
+         continue;
+      }
+      model[n++] = (*c == ' ') ? '_' : *c;
+   }
+   model[n] = '\0';
+
+   if (n == 0)
+   {
+      strncpy(model, "unknown", length - 1);
+      model[length - 1] = '\0';
+   }
+
+   return;
+}
+
+/**
+ * @return the number of processors the process can run on
+ */
+int getNumProcessors()
+{
+#ifdef _WIN32
+   SYSTEM_INFO info;
+   GetSystemInfo(&info);
+   return (int)info.dwNumberOfProcessors;
+#else
+   long numProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+   return numProcessors > 0 ? (int)numProcessors : 1;
+#endif
+}
+
+/**
+ * @return the current wall-clock time in seconds (only useful for differences)
+ */
+double getWallTime()
+{
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return now.tv_sec + now.tv_nsec / 1e9;
+}
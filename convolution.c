@@ -0,0 +1,230 @@
+/**
+ * Created 10/18/2026
+ * This file runs and trains a convolution layer with max pooling that can
+ * sit in front of the dense layers of a network (see ./network.c), so that
+ * bitmap inputs are seen through a few small shared filters instead of a
+ * weight for every pel.
+ *
+ * The inputs are inputChannels planes of inputWidth by inputHeight values.
+ * Every filter covers a convFilterSize square of every channel and moves
+ * convStride values at a time, and each filter's outputs are max pooled in
+ * poolSize squares. The pooled outputs of every filter, one filter after
+ * another, are the nodes of the network's input layer.
+ *
+ * The convolution is done with im2col: every square the filters cover is
+ * copied into a row of a matrix, so that every filter at every position is
+ * found with one call to multiplyMatrices (see ./matrixFunctions.c). The
+ * filters are stored after every dense layer in the network's weights, as a
+ * (inputChannels * convFilterSize * convFilterSize) by convFilters matrix,
+ * so they are saved, loaded, rolled back, and shared between distributed
+ * workers along with the rest of the weights.
+ *
+ * Functions in this file:
+ *
+ * int setUpConvolution(Network *net)
+ * int findInputShape(Network *net)
+ * void runConvolution(const Network *net, NetworkScratch *scratch, double *inputs, double *outputs)
+ * void addConvolutionGradients(const Network *net, NetworkScratch *scratch, double alpha, double *filterGradients)
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "./headerfiles/matrixFunctions.h"  // importing matrix kernels
+#include "./headerfiles/networkInternals.h" // importing the network layout and functions
+#include "./headerfiles/convolution.h"
+
+/**
+ * Works out the size of the convolution layer from the config, once every
+ * setting has been read, and makes its pooled outputs the input layer of
+ * the dense layers. Does nothing if the config has no filters.
+ *
+ * @param net the network to set up
+ * @return 0 if successful, -1 if the settings do not fit the inputs
+ */
+int setUpConvolution(Network *net)
+{
+   if (net->convFilters <= 0)
+      return 0;
+
+   if (findInputShape(net) != 0)
+   {
+      return -1;
+   }
+   if (net->convFilterSize <= 0 || net->convStride <= 0 || net->poolSize <= 0 ||
+       net->convFilterSize > net->inputWidth || net->convFilterSize > net->inputHeight)
+   {
+      printf("The convolution filters do not fit the %dx%d inputs.\n", net->inputWidth, net->inputHeight);
+      return -1;
+   }
+
+   net->convWidth = (net->inputWidth - net->convFilterSize) / net->convStride + 1;
+   net->convHeight = (net->inputHeight - net->convFilterSize) / net->convStride + 1;
+   net->poolWidth = net->convWidth / net->poolSize; // positions past the last whole square are not pooled
+   net->poolHeight = net->convHeight / net->poolSize;
+
+   if (net->poolWidth <= 0 || net->poolHeight <= 0)
+   {
+      printf("The pooling size %d is larger than the %dx%d convolution outputs.\n", net->poolSize, net->convWidth,
+             net->convHeight);
+      return -1;
+   }
+
+   net->layerDimensions[0] = net->convFilters * net->poolWidth * net->poolHeight;
+
+   printf("convolution layer: %d %dx%d filters over %dx%dx%d inputs, pooled to %d nodes\n", net->convFilters,
+          net->convFilterSize, net->convFilterSize, net->inputWidth, net->inputHeight, net->inputChannels,
+          net->layerDimensions[0]);
+
+   return 0;
+}
+
+/**
+ * Works out how many channels the inputs have from their width and height.
+ * Inputs with no width or height set are taken to be a single square channel.
+ *
+ * @param net the network whose inputs to look at
+ * @return 0 if successful, -1 if the inputs are not whole channels
+ */
+int findInputShape(Network *net)
+{
+   if (net->inputWidth <= 0 || net->inputHeight <= 0)
+   {
+      net->inputWidth = (int)(sqrt((double)net->numInputNodes) + 0.5);
+      net->inputHeight = net->inputWidth;
+   }
+   net->inputChannels = net->numInputNodes / (net->inputWidth * net->inputHeight);
+
+   if (net->inputChannels * net->inputWidth * net->inputHeight != net->numInputNodes)
+   {
+      printf("The %d input nodes are not whole %dx%d channels.\n", net->numInputNodes, net->inputWidth, net->inputHeight);
+      return -1;
+   }
+
+   return 0;
+}
+
+/**
+ * Runs the convolution layer on a set of inputs and max pools its outputs.
+ * The position of every pool's maximum is kept in the scratch for training.
+ *
+ * @param net the network whose filters to use
+ * @param scratch the buffers to run the layer in
+ * @param inputs the input values (numInputNodes long)
+ * @param outputs where to store the pooled outputs (layerDimensions[0] long)
+ */
+void runConvolution(const Network *net, NetworkScratch *scratch, double *inputs, double *outputs)
+{
+   int filterSize = net->convFilterSize;
+   int numFilters = net->convFilters;
+   int depth = net->inputChannels * filterSize * filterSize;
+   int planeSize = net->inputWidth * net->inputHeight;
+   double *columns = scratch->convColumns;
+   double *thetas = scratch->convThetas;
+
+   // copying every square the filters cover into its own row (im2col)
+   for (int y = 0; y < net->convHeight; y++)
+   {
+      for (int x = 0; x < net->convWidth; x++)
+      {
+         double *row = columns + (size_t)(y * net->convWidth + x) * depth;
+
+         for (int c = 0; c < net->inputChannels; c++)
+         {
+            for (int fy = 0; fy < filterSize; fy++)
+            {
+               double *source = inputs + c * planeSize + (y * net->convStride + fy) * net->inputWidth + x * net->convStride;
+               memcpy(row, source, filterSize * sizeof(double));
+               row += filterSize;
+            }
+         }
+      }
+   }
+
+   // every filter at every position at once
+   multiplyMatrices(net->convWidth * net->convHeight, numFilters, depth, columns, depth,
+                    net->weights + net->convWeightsOffset, numFilters, thetas, numFilters);
+
+   // max pooling each filter's outputs
+   int k = 0;
+   for (int f = 0; f < numFilters; f++)
+   {
+      for (int py = 0; py < net->poolHeight; py++)
+      {
+         for (int px = 0; px < net->poolWidth; px++)
+         {
+            double best = -HUGE_VAL;
+            int bestIndex = 0;
+
+            for (int dy = 0; dy < net->poolSize; dy++)
+            {
+               for (int dx = 0; dx < net->poolSize; dx++)
+               {
+                  int position = (py * net->poolSize + dy) * net->convWidth + px * net->poolSize + dx;
+                  int index = position * numFilters + f;
+
+                  thetas[index] = activationFunction(thetas[index]);
+                  double value = outputFunction(thetas[index]);
+                  if (value > best)
+                  {
+                     best = value;
+                     bestIndex = index;
+                  }
+               }
+            }
+
+            outputs[k] = best;
+            scratch->poolIndices[k] = bestIndex;
+            k++;
+         }
+      }
+   } // for (int f = 0; f < numFilters; f++)
+
+   return;
+}
+
+/**
+ * Adds alpha times the partial derivatives of the error with respect to
+ * every filter weight to a given array, once the psis of the input layer
+ * have been found (see calculatePsis in ./network.c). Only the maximum of
+ * each pool carries its psi back to the filters.
+ *
+ * @param net the network that was run
+ * @param scratch the scratch the network was run with
+ * @param alpha what to multiply the partial derivatives by (-lambda to train)
+ * @param filterGradients where to add them (laid out like the filters)
+ */
+void addConvolutionGradients(const Network *net, NetworkScratch *scratch, double alpha, double *filterGradients)
+{
+   int numFilters = net->convFilters;
+   int numPositions = net->convWidth * net->convHeight;
+   int depth = net->inputChannels * net->convFilterSize * net->convFilterSize;
+   double *convPsis = scratch->convPsis;
+
+   memset(convPsis, 0, (size_t)numPositions * numFilters * sizeof(double));
+   for (int k = 0; k < net->layerDimensions[0]; k++)
+   {
+      int index = scratch->poolIndices[k];
+      convPsis[index] = scratch->psis[k] * outputDerivFunction(scratch->convThetas[index]);
+   }
+
+   for (int p = 0; p < numPositions; p++)
+   {
+      double *positionPsis = convPsis + (size_t)p * numFilters;
+
+      int used = 0; // most positions are not the maximum of any pool
+      for (int f = 0; f < numFilters && !used; f++)
+      {
+         used = positionPsis[f] != 0.0;
+      }
+
+      if (used)
+      {
+         addOuterProduct(depth, numFilters, alpha, scratch->convColumns + (size_t)p * depth, positionPsis,
+                         filterGradients, numFilters);
+      }
+   }
+
+   return;
+}
@@ -10,6 +10,7 @@
  * void writePelsToTextFile(unsigned int *pels, int numPels, char *pelsOutputFile)
  * void writeBitmap(char *pelsOutputFile, char *originalDIBFile, char *outputDIBFile)
  * void writeBitmapHelper(char *outFileName, unsigned int *pels, int numPels, BITMAPFILEHEADER bmpFileHeader, BITMAPINFOHEADER bmpInfoHeader)
+ * unsigned int *loadBitmap(char *inFileName, BITMAPFILEHEADER *bmpFileHeader, BITMAPINFOHEADER *bmpInfoHeader)
 {
  */
 
@@ -260,3 +261,85 @@ void writeBitmapHelper(
 
    return;
 }
+
+/**
+ * This function reads in a bitmap's headers and pels without writing
+ * them out anywhere, for code that works on the whole bitmap in memory.
+ * The pels are kept in the order they are stored in the file, in the same
+ * blue|green|red|reserved form that readBitmap writes to the text file.
+ * Note: this will only run for 24-bit and 32-bit bitmaps (that don't have a color table)
+ *
+ * @param inFileName the name of the input bitmap file
+ * @param bmpFileHeader where to store the bitmap file header
+ * @param bmpInfoHeader where to store the bitmap info header
+ * @return the array of pels (biWidth * |biHeight| long), or NULL if it could not be read
+ */
+unsigned int *loadBitmap(char *inFileName, BITMAPFILEHEADER *bmpFileHeader, BITMAPINFOHEADER *bmpInfoHeader)
+{
+   FILE *inFile = fopen(inFileName, "rb");
+
+   if (inFile == NULL)
+   {
+      fprintf(stderr, "INPUT ERROR: %s\n", strerror(errno));
+      return NULL;
+   }
+
+   if (fread(bmpFileHeader, sizeof(BITMAPFILEHEADER), 1, inFile) != 1 ||
+       fread(bmpInfoHeader, sizeof(BITMAPINFOHEADER), 1, inFile) != 1)
+   {
+      fprintf(stderr, "ERROR: %s is not a bitmap.\n", inFileName);
+      fclose(inFile);
+      return NULL;
+   }
+
+   int bytesPerPixel = bmpInfoHeader->biBitCount / 8;
+   int width = bmpInfoHeader->biWidth;
+   int biHeightAbs = bmpInfoHeader->biHeight < 0 ? -bmpInfoHeader->biHeight : bmpInfoHeader->biHeight;
+
+   if (bytesPerPixel != 3 && bytesPerPixel != 4)
+   {
+      fprintf(stderr, "ERROR: Bitmap must be 24-bit or 32-bit.\n");
+      fclose(inFile);
+      return NULL;
+   }
+
+   int rowBytes = (width * bytesPerPixel + 3) / 4 * 4; // rows are padded to whole 4-byte words
+   unsigned char *row = malloc(rowBytes);
+   unsigned int *pels = malloc((size_t)width * biHeightAbs * sizeof(int));
+
+   if (row == NULL || pels == NULL)
+   {
+      fprintf(stderr, "ERROR: Could not allocate memory for the pels.\n");
+      free(row);
+      free(pels);
+      fclose(inFile);
+      return NULL;
+   }
+
+   fseek(inFile, bmpFileHeader->bfOffBits, SEEK_SET);
+
+   for (int y = 0; y < biHeightAbs; y++)
+   {
+      if (fread(row, 1, rowBytes, inFile) != (size_t)rowBytes)
+      {
+         fprintf(stderr, "ERROR: %s ends before its last pel.\n", inFileName);
+         free(row);
+         free(pels);
+         fclose(inFile);
+         return NULL;
+      }
+
+      for (int x = 0; x < width; x++)
+      {
+         unsigned char *pel = row + x * bytesPerPixel; // pels are stored blue, green, red, (reserved)
+         unsigned int reserved = bytesPerPixel == 4 ? pel[3] : 0;
+
+         pels[y * width + x] = (unsigned int)pel[0] << 24 | (unsigned int)pel[1] << 16 | (unsigned int)pel[2] << 8 | reserved;
+      }
+   }
+
+   free(row);
+   fclose(inFile);
+
+   return pels;
+}
@@ -0,0 +1,178 @@
+/**
+ * Created 10/18/2026
+ * This file distills a large trained network (the teacher) into a smaller
+ * one (the student) that is cheaper to run.
+ *
+ * The teacher is run over every training set the student holds, and its
+ * outputs replace the student's expected outputs as soft targets. The
+ * student is then trained on them with the usual training loop. Soft
+ * targets carry how sure the teacher is about every output, not just which
+ * one is right, which is more for a small network to learn from.
+ *
+ * Once the student is trained, the error of both networks on the real
+ * expected outputs and the time each takes to run are printed side by side.
+ *
+ * Functions in this file:
+ *
+ * int runDistillation(void)
+ * int distillNetwork(Network *teacher, Network *student)
+ * double findErrorOnSets(Network *net, Network *sets)
+ * int countWeights(const Network *net)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./headerfiles/networkInternals.h" // importing the network layout and functions
+#include "./headerfiles/pruning.h"          // importing the inference timer
+#include "./headerfiles/distill.h"
+
+/**
+ * Asks for the teacher's and the student's configs, trains the teacher
+ * first if its config says to, then distills it into the student and
+ * writes the student's weights to the student's weights output file.
+ *
+ * @return 0 if successful, 1 otherwise (the exit code of the process)
+ */
+int runDistillation(void)
+{
+   char teacherConfig[MAX_FILE_NAME_LENGTH];
+   char studentConfig[MAX_FILE_NAME_LENGTH];
+
+   printf("What config file should the teacher use? ");
+   scanf("%s", teacherConfig);
+   printf("What config file should the student use? ");
+   scanf("%s", studentConfig);
+
+   Network *teacher = createNetwork(teacherConfig);
+   if (teacher == NULL)
+   {
+      return 1;
+   }
+
+   if (teacher->trainNetwork == 'Y')
+   {
+      printf("\nTRAINING THE TEACHER:\n");
+      runForAllTrainingSets(teacher);
+      train(teacher, teacher->maxIterations, teacher->targetError);
+      writeWeightsToFile(teacher, teacher->weightsFileOutput);
+   }
+
+   Network *student = createNetwork(studentConfig);
+   if (student == NULL)
+   {
+      freeNetwork(teacher);
+      return 1;
+   }
+
+   int result = distillNetwork(teacher, student);
+   if (result == 0)
+   {
+      writeWeightsToFile(student, student->weightsFileOutput);
+   }
+
+   freeNetwork(student);
+   freeNetwork(teacher);
+
+   return result == 0 ? 0 : 1;
+}
+
+/**
+ * Trains the student on the teacher's outputs for the student's training
+ * sets, then puts the real expected outputs back and prints the error,
+ * size, and latency of both networks.
+ *
+ * @param teacher the trained network to learn from
+ * @param student the network to train (which must hold its training sets)
+ * @return 0 if successful, -1 otherwise
+ */
+int distillNetwork(Network *teacher, Network *student)
+{
+   if (teacher->numInputNodes != student->numInputNodes || teacher->numOutputNodes != student->numOutputNodes)
+   {
+      printf("The teacher and the student must have the same number of inputs and outputs.\n");
+      return -1;
+   }
+   if (student->trainingInputs == NULL)
+   {
+      printf("The student's config must train (trainNetwork Y) with its training sets in memory to be distilled.\n");
+      return -1;
+   }
+
+   size_t numLabels = (size_t)student->numTrainingSets * student->numOutputNodes;
+   double *realLabels = malloc((numLabels + 1) * sizeof(double));
+   if (realLabels == NULL)
+   {
+      printf("There was an error allocating memory for distillation.\n");
+      return -1;
+   }
+   memcpy(realLabels, student->trainingLabels, numLabels * sizeof(double));
+
+   // the teacher's outputs become the student's expected outputs
+   teacher->scratch->expectedOutputs = NULL;
+   for (int t = 0; t < student->numTrainingSets; t++)
+   {
+      runNetwork(teacher, teacher->scratch, student->trainingInputs + (size_t)t * student->inputStride,
+                 student->trainingLabels + (size_t)t * student->numOutputNodes);
+   }
+
+   printf("\nTRAINING THE STUDENT ON THE TEACHER'S OUTPUTS:\n");
+   runForAllTrainingSets(student);
+   train(student, student->maxIterations, student->targetError);
+
+   memcpy(student->trainingLabels, realLabels, numLabels * sizeof(double));
+   free(realLabels);
+
+   double teacherError = findErrorOnSets(teacher, student);
+   double studentError = findErrorOnSets(student, student);
+   double teacherTime = timeInference(teacher, teacher->useSparseKernels);
+   double studentTime = timeInference(student, student->useSparseKernels);
+
+   printf("\n%-8s %20s %10s %14s\n", "", "error", "weights", "latency");
+   printf("%-8s %20.16lf %10d %12.4lfms\n", "teacher", teacherError, countWeights(teacher), teacherTime * 1000.0);
+   printf("%-8s %20.16lf %10d %12.4lfms\n", "student", studentError, countWeights(student), studentTime * 1000.0);
+   printf("The student runs %.2lfx as fast as the teacher.\n", teacherTime / studentTime);
+
+   return 0;
+}
+
+/**
+ * Finds the total error of a network over the training sets
+ * that another network holds (which may be itself).
+ *
+ * @param net the network to run
+ * @param sets the network holding the training sets
+ * @return the sum of the errors of every training set
+ */
+double findErrorOnSets(Network *net, Network *sets)
+{
+   double errorSum = 0.0;
+
+   for (int t = 0; t < sets->numTrainingSets; t++)
+   {
+      net->scratch->expectedOutputs = sets->trainingLabels + (size_t)t * sets->numOutputNodes;
+      runNetwork(net, net->scratch, sets->trainingInputs + (size_t)t * sets->inputStride, NULL);
+      errorSum += net->scratch->error;
+   }
+   net->scratch->expectedOutputs = NULL;
+
+   return errorSum;
+}
+
+/**
+ * @return the number of weights a network uses (not counting the padding of the mkj layout)
+ *
+ * @param net the network
+ */
+int countWeights(const Network *net)
+{
+   int numWeights = net->totalWeights - net->convWeightsOffset; // the convolution filters, if any
+
+   for (int m = 0; m < net->numLayers - 1; m++)
+   {
+      numWeights += net->layerDimensions[m] * net->layerDimensions[m + 1];
+   }
+
+   return numWeights;
+}
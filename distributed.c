@@ -0,0 +1,674 @@
+/**
+ * Created 10/18/2026
+ * This file is responsible for data-parallel training over TCP.
+ *
+ * One coordinator process and N worker processes all read the same
+ * config. The coordinator hands out ranks, tells every worker where its
+ * neighbour in the ring is listening, and sends every worker the same
+ * starting weights. Each worker then only holds its own shard of the
+ * training sets; every epoch, the workers find the gradients for their
+ * shards, add them together with a ring all-reduce, and apply the
+ * averaged update to their (identical) copies of the weights. The
+ * error sum rides along at the end of the gradient buffer, so every worker
+ * sees the same error and train() stops all of them on the same cycle.
+ * Weights and gradients are packed before they are sent (see packWeights
+ * in ./network.c), so only the ones that are used cross the network, not
+ * the padding of the mkj layout.
+ * When training finishes, rank 0 sends the weights back to the coordinator,
+ * which reports on the full training sets and writes the usual output files.
+ *
+ * Values are sent in host byte order, so every machine in a group should
+ * share the same architecture.
+ *
+ * Functions in this file:
+ *
+ * int runCoordinator(int port, int numWorkers)
+ * int runWorker(char *coordinatorHost, int coordinatorPort)
+ * void trainDistributedEpoch(Network *net)
+ * void ringAllReduce(struct DistributedGroup *group, double *values, int length)
+ *
+ * void initializeSockets(void)
+ * SOCKET openListeningSocket(int port)
+ * SOCKET connectToHost(char *host, int port)
+ * int sendAll(SOCKET connection, void *data, size_t numBytes)
+ * int receiveAll(SOCKET connection, void *data, size_t numBytes)
+ * void *sendAllThread(void *job)
+ * void exchangeChunks(struct DistributedGroup *group, double *outgoing, int numOutgoing, double *incoming, int numIncoming)
+ */
+
+#include "./headerfiles/sockets.h" // importing sockets (before anything that includes windows.h)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "./headerfiles/dibdump.h" // importing dibdump functions
+#include "./headerfiles/pruning.h" // importing the sparse layers
+
+#include "./headerfiles/networkInternals.h"
+#include "./headerfiles/distributed.h"
+
+#define MAX_HOST_LENGTH 64        // max characters in a worker's address
+#define MAX_SEND_LENGTH 0x40000000 // most bytes handed to a single send or recv
+
+/**
+ * A worker's place in the ring, along with the buffers
+ * it needs for training.
+ */
+struct DistributedGroup
+{
+   int workerRank;          // this worker's position in the ring
+   int numWorkers;          // how many workers are in the ring
+   SOCKET nextWorker;       // connection to the worker this one sends to
+   SOCKET previousWorker;   // connection to the worker this one receives from
+   double *gradientBuffer;  // gradients for every weight (in mkj order)
+   int numUsedWeights;      // weights that are sent (see findNumUsedWeights)
+   double *packedBuffer;    // gradients of the weights that are used, plus the error sum at the end
+   double *previousWeights; // weights before the last update (for weight rollback)
+   double *chunkBuffer;     // incoming values during the reduce part of the all-reduce
+};
+
+/**
+ * The values a single call to sendAllThread needs, since
+ * a thread can only be handed one argument.
+ */
+struct SendJob
+{
+   SOCKET connection;
+   void *data;
+   size_t numBytes;
+   int result;
+};
+
+// function headers ----------------------
+
+void *sendAllThread(void *);
+void exchangeChunks(struct DistributedGroup *, double *, int, double *, int);
+
+/**
+ * Runs this process as the coordinator of a distributed training group.
+ * The config is read from the same prompt as a normal run.
+ *
+ * @param port the port to listen for workers on
+ * @param numWorkers how many workers to wait for before training starts
+ * @return the exit code for the process
+ */
+int runCoordinator(int port, int numWorkers)
+{
+   char configFilename[MAX_FILE_NAME_LENGTH];
+
+   printf("What config file should I use? ");
+   scanf("%s", configFilename);
+
+   Network *net = createNetwork(configFilename); // the coordinator keeps every training set for the final report
+   if (net == NULL)
+   {
+      return 1;
+   }
+
+   initializeSockets();
+   SOCKET listener = openListeningSocket(port);
+   if (listener == INVALID_SOCKET)
+   {
+      fprintf(stderr, "ERROR: could not listen on port %d\n", port);
+      freeNetwork(net);
+      return 1;
+   }
+
+   SOCKET *workers = malloc(numWorkers * sizeof(SOCKET));
+   int *workerPorts = malloc(numWorkers * sizeof(int));
+   char (*workerHosts)[MAX_HOST_LENGTH] = malloc(numWorkers * MAX_HOST_LENGTH);
+   int numUsedWeights = findNumUsedWeights(net);
+   double *packedWeights = malloc(numUsedWeights * sizeof(double));
+   if (workers == NULL || workerPorts == NULL || workerHosts == NULL || packedWeights == NULL)
+   {
+      printf("There was an error allocating memory for the workers.\n");
+      closesocket(listener);
+      free(workers);
+      free(workerPorts);
+      free(workerHosts);
+      free(packedWeights);
+      freeNetwork(net);
+      return 1;
+   }
+
+   int numJoined = 0;
+   int failed = 0;
+
+   for (int r = 0; r < numWorkers && !failed; r++) // ranks are handed out in the order workers connect
+   {
+      struct sockaddr_in address;
+      socklen_t addressLength = sizeof(address);
+
+      workers[r] = accept(listener, (struct sockaddr *)&address, &addressLength);
+      if (workers[r] == INVALID_SOCKET)
+      {
+         fprintf(stderr, "ERROR: could not accept worker %d\n", r);
+         failed = 1;
+         break;
+      }
+      numJoined++;
+
+      if (receiveAll(workers[r], &workerPorts[r], sizeof(int)) != 0)
+      {
+         fprintf(stderr, "ERROR: worker %d left before joining the ring\n", r);
+         failed = 1;
+         break;
+      }
+      strncpy(workerHosts[r], inet_ntoa(address.sin_addr), MAX_HOST_LENGTH - 1);
+      workerHosts[r][MAX_HOST_LENGTH - 1] = '\0';
+
+      printf("Worker %d joined from %s (ring port %d)\n", r, workerHosts[r], workerPorts[r]);
+   }
+   closesocket(listener);
+
+   for (int r = 0; r < numWorkers && !failed; r++) // telling every worker its place in the ring
+   {
+      int next = (r + 1) % numWorkers;
+
+      if (sendAll(workers[r], &r, sizeof(int)) != 0 || sendAll(workers[r], &numWorkers, sizeof(int)) != 0 ||
+          sendAll(workers[r], workerHosts[next], MAX_HOST_LENGTH) != 0 ||
+          sendAll(workers[r], &workerPorts[next], sizeof(int)) != 0)
+      {
+         fprintf(stderr, "ERROR: lost the connection to worker %d before training started\n", r);
+         failed = 1;
+      }
+   }
+
+   packWeights(net, net->weights, packedWeights);
+
+   for (int r = 0; r < numWorkers && !failed; r++) // every worker starts from the same weights
+   {
+      if (sendAll(workers[r], packedWeights, numUsedWeights * sizeof(double)) != 0)
+      {
+         fprintf(stderr, "ERROR: lost the connection to worker %d before training started\n", r);
+         failed = 1;
+      }
+   }
+
+   if (failed)
+   {
+      for (int r = 0; r < numJoined; r++)
+      {
+         closesocket(workers[r]);
+      }
+      free(workers);
+      free(workerPorts);
+      free(workerHosts);
+      free(packedWeights);
+      freeNetwork(net);
+      return 1;
+   }
+
+   printf("Distributed training started with %d workers\n", numWorkers);
+
+   clock_t CPU_time_1 = clock();
+
+   if (receiveAll(workers[0], packedWeights, numUsedWeights * sizeof(double)) == 0)
+   {
+      unpackWeights(net, packedWeights, net->weights);
+   }
+   else
+   {
+      fprintf(stderr, "ERROR: lost the connection to worker 0 before training finished\n");
+   }
+
+   clock_t CPU_time_2 = clock();
+
+   for (int r = 0; r < numWorkers; r++)
+   {
+      closesocket(workers[r]);
+   }
+
+   printf("AFTER DISTRIBUTED TRAINING:\n");
+   runForAllTrainingSets(net);
+
+   writeWeightsToFile(net, net->weightsFileOutput);
+   writeOutputsToFile(net);
+
+   if (net->useBitmap == 'Y')
+   {
+      writeBitmap(net->nodesFileOutput, net->bitmapFileInput, net->bitmapFileOutput);
+   }
+
+   free(workers);
+   free(workerPorts);
+   free(workerHosts);
+   free(packedWeights);
+   freeNetwork(net);
+
+   printf("Time taken: %fms", ((double)(CPU_time_2 - CPU_time_1)) / CLOCKS_PER_SEC * 1000);
+
+   return 0;
+}
+
+/**
+ * Runs this process as a worker in a distributed training group.
+ * The config is read from the same prompt as a normal run.
+ *
+ * @param coordinatorHost the address of the coordinator
+ * @param coordinatorPort the port the coordinator is listening on
+ * @return the exit code for the process
+ */
+int runWorker(char *coordinatorHost, int coordinatorPort)
+{
+   char configFilename[MAX_FILE_NAME_LENGTH];
+
+   printf("What config file should I use? ");
+   scanf("%s", configFilename);
+
+   initializeSockets();
+
+   // listening before joining, so the previous worker can always connect
+   SOCKET listener = openListeningSocket(0);
+   if (listener == INVALID_SOCKET)
+   {
+      fprintf(stderr, "ERROR: could not open a port for the ring\n");
+      return 1;
+   }
+   struct sockaddr_in address;
+   socklen_t addressLength = sizeof(address);
+   getsockname(listener, (struct sockaddr *)&address, &addressLength);
+   int ringPort = ntohs(address.sin_port);
+
+   SOCKET coordinator = connectToHost(coordinatorHost, coordinatorPort);
+   if (coordinator == INVALID_SOCKET)
+   {
+      fprintf(stderr, "ERROR: could not reach the coordinator at %s:%d\n", coordinatorHost, coordinatorPort);
+      closesocket(listener);
+      return 1;
+   }
+
+   struct DistributedGroup group;
+   char nextHost[MAX_HOST_LENGTH];
+   int nextPort;
+
+   if (sendAll(coordinator, &ringPort, sizeof(int)) != 0 ||
+       receiveAll(coordinator, &group.workerRank, sizeof(int)) != 0 ||
+       receiveAll(coordinator, &group.numWorkers, sizeof(int)) != 0 ||
+       receiveAll(coordinator, nextHost, MAX_HOST_LENGTH) != 0 || receiveAll(coordinator, &nextPort, sizeof(int)) != 0)
+   {
+      fprintf(stderr, "ERROR: lost the connection to the coordinator before joining the ring\n");
+      closesocket(coordinator);
+      closesocket(listener);
+      return 1;
+   }
+   nextHost[MAX_HOST_LENGTH - 1] = '\0';
+
+   printf("Joined as worker %d of %d\n", group.workerRank, group.numWorkers);
+
+   // only loads this worker's shard of the training sets
+   Network *net = createNetworkShard(configFilename, group.workerRank, group.numWorkers);
+   if (net == NULL)
+   {
+      closesocket(coordinator);
+      closesocket(listener);
+      return 1;
+   }
+
+   group.numUsedWeights = findNumUsedWeights(net);
+   group.gradientBuffer = calloc(net->totalWeights, sizeof(double));
+   group.packedBuffer = malloc((group.numUsedWeights + 1) * sizeof(double));
+   group.previousWeights = malloc(net->totalWeights * sizeof(double));
+   group.chunkBuffer = malloc((group.numUsedWeights / group.numWorkers + 2) * sizeof(double));
+   group.nextWorker = INVALID_SOCKET;
+   group.previousWorker = INVALID_SOCKET;
+
+   int failed = 0;
+   if (group.gradientBuffer == NULL || group.packedBuffer == NULL || group.previousWeights == NULL ||
+       group.chunkBuffer == NULL)
+   {
+      printf("There was an error allocating memory for distributed training.\n");
+      failed = 1;
+   }
+   else if (receiveAll(coordinator, group.packedBuffer, group.numUsedWeights * sizeof(double)) != 0)
+   {
+      fprintf(stderr, "ERROR: lost the connection to the coordinator before training started\n");
+      failed = 1;
+   }
+   else if ((group.nextWorker = connectToHost(nextHost, nextPort)) == INVALID_SOCKET)
+   {
+      fprintf(stderr, "ERROR: could not reach the next worker at %s:%d\n", nextHost, nextPort);
+      failed = 1;
+   }
+   else if ((group.previousWorker = accept(listener, NULL, NULL)) == INVALID_SOCKET)
+   {
+      fprintf(stderr, "ERROR: could not accept the previous worker\n");
+      failed = 1;
+   }
+   closesocket(listener);
+
+   if (failed)
+   {
+      if (group.nextWorker != INVALID_SOCKET)
+      {
+         closesocket(group.nextWorker);
+      }
+      closesocket(coordinator);
+      free(group.gradientBuffer);
+      free(group.packedBuffer);
+      free(group.previousWeights);
+      free(group.chunkBuffer);
+      freeNetwork(net);
+      return 1;
+   }
+
+   unpackWeights(net, group.packedBuffer, net->weights);
+   findSparseLayers(net); // the coordinator's weights replaced the ones the sparse layers were found from
+   memcpy(group.previousWeights, net->weights, net->totalWeights * sizeof(double));
+
+   net->group = &group;
+   net->epochFunction = &trainDistributedEpoch;
+
+   if (net->trainNetwork == 'Y')
+   {
+      train(net, net->maxIterations, net->targetError);
+   }
+
+   int exitCode = 0;
+   if (group.workerRank == 0)
+   {
+      packWeights(net, net->weights, group.packedBuffer);
+      if (sendAll(coordinator, group.packedBuffer, group.numUsedWeights * sizeof(double)) != 0)
+      {
+         fprintf(stderr, "ERROR: lost the connection to the coordinator before the weights were sent back\n");
+         exitCode = 1;
+      }
+   }
+
+   closesocket(coordinator);
+   closesocket(group.nextWorker);
+   closesocket(group.previousWorker);
+
+   free(group.gradientBuffer);
+   free(group.packedBuffer);
+   free(group.previousWeights);
+   free(group.chunkBuffer);
+   freeNetwork(net);
+
+   return exitCode;
+}
+
+/**
+ * Trains the network once over the whole (distributed) training set.
+ * This worker finds the gradients for its own shard, the ring adds up
+ * every worker's gradients, and the averaged gradient is applied to the
+ * weights. Since every worker applies the same update to the same weights,
+ * their weights never drift apart. Only the gradients of the weights that
+ * are used are added up.
+ *
+ * The error found here belongs to the weights from before this epoch's
+ * update, so when adaptive learning decides the error went up, it is the
+ * previous update that gets rolled back, and no update is applied.
+ *
+ * @param net the worker's network
+ */
+void trainDistributedEpoch(Network *net)
+{
+   struct DistributedGroup *group = net->group;
+   int totalWeights = net->totalWeights;
+   int numUsedWeights = group->numUsedWeights;
+
+   memset(group->gradientBuffer, 0, totalWeights * sizeof(double));
+
+   double errorSum = calculateGradients(net, 0, net->numTrainingSets, group->gradientBuffer);
+
+   packWeights(net, group->gradientBuffer, group->packedBuffer);
+   group->packedBuffer[numUsedWeights] = errorSum;
+
+   ringAllReduce(group, group->packedBuffer, numUsedWeights + 1);
+
+   double newError = group->packedBuffer[numUsedWeights];
+   unpackWeights(net, group->packedBuffer, group->gradientBuffer); // the padding's gradients stay 0
+
+   if (adaptLearningFactor(net, newError, group->previousWeights) == 'n')
+   {
+      memcpy(group->previousWeights, net->weights, totalWeights * sizeof(double));
+
+      double scale = net->learningFactor / net->totalTrainingSets; // averaging the summed gradients
+      for (int i = 0; i < totalWeights; i++)
+      {
+         net->weights[i] -= scale * group->gradientBuffer[i];
+      }
+   }
+
+   return;
+}
+
+/**
+ * Adds an array together across every worker in the ring, so that every
+ * worker ends up with the same sums. The array is split into one chunk per
+ * worker; first each chunk is passed around the ring and added to until
+ * one worker holds its full sum, then the finished chunks are passed around
+ * once more so every worker has all of them.
+ *
+ * @param group this worker's place in the ring
+ * @param values the array to add up (overwritten with the sums)
+ * @param length the number of values in the array
+ */
+void ringAllReduce(struct DistributedGroup *group, double *values, int length)
+{
+   int rank = group->workerRank;
+   int numWorkers = group->numWorkers;
+
+   for (int step = 0; step < numWorkers - 1; step++) // adding up the chunks
+   {
+      int sendChunk = (rank - step + numWorkers) % numWorkers;
+      int receiveChunk = (rank - step - 1 + numWorkers) % numWorkers;
+
+      int sendStart = (int)((long long)length * sendChunk / numWorkers);
+      int sendEnd = (int)((long long)length * (sendChunk + 1) / numWorkers);
+      int receiveStart = (int)((long long)length * receiveChunk / numWorkers);
+      int receiveEnd = (int)((long long)length * (receiveChunk + 1) / numWorkers);
+
+      exchangeChunks(group, values + sendStart, sendEnd - sendStart, group->chunkBuffer, receiveEnd - receiveStart);
+
+      for (int i = receiveStart; i < receiveEnd; i++)
+      {
+         values[i] += group->chunkBuffer[i - receiveStart];
+      }
+   }
+
+   for (int step = 0; step < numWorkers - 1; step++) // sharing the finished chunks
+   {
+      int sendChunk = (rank - step + 1 + numWorkers) % numWorkers;
+      int receiveChunk = (rank - step + numWorkers) % numWorkers;
+
+      int sendStart = (int)((long long)length * sendChunk / numWorkers);
+      int sendEnd = (int)((long long)length * (sendChunk + 1) / numWorkers);
+      int receiveStart = (int)((long long)length * receiveChunk / numWorkers);
+      int receiveEnd = (int)((long long)length * (receiveChunk + 1) / numWorkers);
+
+      exchangeChunks(group, values + sendStart, sendEnd - sendStart, values + receiveStart, receiveEnd - receiveStart);
+   }
+
+   return;
+}
+
+/**
+ * Sends a chunk to the next worker while receiving one from the previous
+ * worker. The send happens on its own thread so that a full socket buffer
+ * can never leave every worker in the ring stuck sending at once.
+ *
+ * @param group this worker's place in the ring
+ * @param outgoing the values to send
+ * @param numOutgoing the number of values to send
+ * @param incoming where to store the received values
+ * @param numIncoming the number of values to receive
+ */
+void exchangeChunks(struct DistributedGroup *group, double *outgoing, int numOutgoing, double *incoming, int numIncoming)
+{
+   struct SendJob job = {group->nextWorker, outgoing, numOutgoing * sizeof(double), 0};
+   pthread_t sender;
+
+   // sending on this thread instead could leave every worker in the ring stuck sending at once
+   if (pthread_create(&sender, NULL, &sendAllThread, &job) != 0)
+   {
+      fprintf(stderr, "ERROR: could not start the thread that sends to the next worker\n");
+      exit(1);
+   }
+
+   if (receiveAll(group->previousWorker, incoming, numIncoming * sizeof(double)) != 0)
+   {
+      fprintf(stderr, "ERROR: lost the connection to the previous worker\n");
+      exit(1);
+   }
+
+   pthread_join(sender, NULL);
+
+   if (job.result != 0)
+   {
+      fprintf(stderr, "ERROR: lost the connection to the next worker\n");
+      exit(1);
+   }
+
+   return;
+}
+
+/**
+ * Starts up the socket library (only needed on Windows).
+ */
+void initializeSockets()
+{
+#ifdef _WIN32
+   WSADATA wsaData;
+   WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+   return;
+}
+
+/**
+ * Opens a TCP socket that listens on every interface.
+ *
+ * @param port the port to listen on (0 lets the system pick one)
+ * @return the listening socket, or INVALID_SOCKET on failure
+ */
+SOCKET openListeningSocket(int port)
+{
+   SOCKET listener = socket(AF_INET, SOCK_STREAM, 0);
+   if (listener == INVALID_SOCKET)
+   {
+      return INVALID_SOCKET;
+   }
+
+   int reuse = 1;
+   setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (char *)&reuse, sizeof(reuse));
+
+   struct sockaddr_in address;
+   memset(&address, 0, sizeof(address));
+   address.sin_family = AF_INET;
+   address.sin_addr.s_addr = htonl(INADDR_ANY);
+   address.sin_port = htons(port);
+
+   if (bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listener, 16) != 0)
+   {
+      closesocket(listener);
+      return INVALID_SOCKET;
+   }
+
+   return listener;
+}
+
+/**
+ * Opens a TCP connection to a given host and port. Nagle's algorithm is
+ * turned off, since the ring sends many chunks back and forth.
+ *
+ * @param host the name or address of the host
+ * @param port the port to connect to
+ * @return the connected socket, or INVALID_SOCKET on failure
+ */
+SOCKET connectToHost(char *host, int port)
+{
+   struct addrinfo hints;
+   struct addrinfo *result;
+   char portString[16];
+
+   memset(&hints, 0, sizeof(hints));
+   hints.ai_family = AF_INET;
+   hints.ai_socktype = SOCK_STREAM;
+   sprintf(portString, "%d", port);
+
+   if (getaddrinfo(host, portString, &hints, &result) != 0)
+   {
+      return INVALID_SOCKET;
+   }
+
+   SOCKET connection = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+   if (connection != INVALID_SOCKET && connect(connection, result->ai_addr, result->ai_addrlen) != 0)
+   {
+      closesocket(connection);
+      connection = INVALID_SOCKET;
+   }
+   freeaddrinfo(result);
+
+   if (connection != INVALID_SOCKET)
+   {
+      int noDelay = 1;
+      setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, (char *)&noDelay, sizeof(noDelay));
+   }
+
+   return connection;
+}
+
+/**
+ * Sends every byte of a buffer, however many calls that takes.
+ *
+ * @param connection the socket to send on
+ * @param data the bytes to send
+ * @param numBytes the number of bytes to send
+ * @return 0 on success, -1 if the connection failed
+ */
+int sendAll(SOCKET connection, void *data, size_t numBytes)
+{
+   char *bytes = (char *)data;
+   while (numBytes > 0)
+   {
+      int sent = send(connection, bytes, numBytes > MAX_SEND_LENGTH ? MAX_SEND_LENGTH : (int)numBytes, 0);
+      if (sent <= 0)
+      {
+         return -1;
+      }
+      bytes += sent;
+      numBytes -= sent;
+   }
+   return 0;
+}
+
+/**
+ * Receives exactly a given number of bytes, however many calls that takes.
+ *
+ * @param connection the socket to receive on
+ * @param data where to store the bytes
+ * @param numBytes the number of bytes to receive
+ * @return 0 on success, -1 if the connection failed or closed early
+ */
+int receiveAll(SOCKET connection, void *data, size_t numBytes)
+{
+   char *bytes = (char *)data;
+   while (numBytes > 0)
+   {
+      int received = recv(connection, bytes, numBytes > MAX_SEND_LENGTH ? MAX_SEND_LENGTH : (int)numBytes, 0);
+      if (received <= 0)
+      {
+         return -1;
+      }
+      bytes += received;
+      numBytes -= received;
+   }
+   return 0;
+}
+
+/**
+ * Thread entry point that runs sendAll on a SendJob.
+ *
+ * @param job the SendJob to run (its result is filled in)
+ * @return NULL
+ */
+void *sendAllThread(void *job)
+{
+   struct SendJob *sendJob = (struct SendJob *)job;
+   sendJob->result = sendAll(sendJob->connection, sendJob->data, sendJob->numBytes);
+   return NULL;
+}
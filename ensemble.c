@@ -0,0 +1,618 @@
+/**
+ * Created 10/18/2026
+ * This file runs several trained networks with the same layout (such as
+ * weights from different seeds, or checkpoints of one run) over every
+ * training set in a single pass, instead of reading and parsing the
+ * training sets once per network.
+ *
+ * The training sets are taken ENSEMBLE_BATCH_SIZE at a time and run
+ * through every network while they are still in cache. The first layers
+ * of weights of every network are stored side by side as one matrix, so a
+ * single call to multiplyMatrices (see ./matrixFunctions.c) finds the
+ * first hidden layer of every network for the whole batch, and the inputs
+ * are read once for all of them. The rest of each network's layers are run
+ * a batch at a time as well, straight from that shared matrix of nodes.
+ * Every network's later layers (and convolution filters) are stored packed,
+ * layerDimensions[m] by layerDimensions[m + 1] each, without the padding of
+ * the mkj layout, so only one padded copy of the weights is ever held.
+ * A convolution layer has weights of its own in every network, so with one
+ * the input layer is found for each network in turn, but the first layer
+ * of weights is still read from the shared matrix.
+ *
+ * A network whose weights were saved pruned (see ./pruning.c) runs its
+ * layers that are past the sparse threshold with the sparse kernel, one set
+ * at a time. The shared first layer is only skipped if every network's first
+ * layer is run sparsely.
+ *
+ * Every set's row in the predictions file (see ./predict.c) holds the
+ * outputs of each network in order, followed by their average.
+ *
+ * Functions in this file:
+ *
+ * int runEnsemble(void)
+ * int ensembleAll(Network *net, int numModels, char **weightsFiles)
+ * int loadEnsemble(Ensemble *ensemble, char **weightsFiles)
+ * void freeEnsemble(Ensemble *ensemble)
+ * void runEnsembleBatch(Ensemble *ensemble, int numSets)
+ * void finishEnsembleLayer(const Network *net, double *nodes, int stride, int numSets, int numNodes, char isOutputLayer)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./headerfiles/outputFunctions.h"  // importing softmax
+#include "./headerfiles/matrixFunctions.h"  // importing matrix kernels
+#include "./headerfiles/autoTune.h"         // importing the wall clock
+#include "./headerfiles/convolution.h"      // importing the convolution layer
+#include "./headerfiles/projection.h"       // and the input reduction
+#include "./headerfiles/networkInternals.h" // importing the network layout and functions
+#include "./headerfiles/predict.h"          // importing the predictions file
+#include "./headerfiles/pruning.h"          // importing the sparse layers
+#include "./headerfiles/ensemble.h"
+
+#define ENSEMBLE_BATCH_SIZE 32 // training sets run through every network at once
+
+/**
+ * The networks being run together, and the buffers a batch is run in.
+ */
+struct Ensemble
+{
+   Network *net;          // the shared layout (its weights are swapped for paddedWeights while a convolution layer runs)
+   int numModels;
+   double **modelWeights; // every network's layers after the first, packed one after another, then its filters
+   size_t filtersOffset;  // where each network's convolution filters start in its packed weights
+   int numFilterWeights;  // the weights of each network's convolution filters (0 for none)
+   double *paddedWeights; // one network's weights laid out the same as net->weights (read into, and run filters from)
+   struct SparseLayer **modelSparseLayers; // every network's sparse layers (NULL for a network that is run densely)
+   char sparseFirstLayers; // Y if every network's first layer is run with the sparse kernel
+   double *firstLayer;    // every network's first layer of weights side by side, firstWidth columns each
+   int firstWidth;        // the nodes in the first hidden layer
+   int sharedWidth;       // numModels * firstWidth, the row length of firstLayer and firstNodes
+
+   double *inputs;        // the batch's inputs, numInputNodes apart
+   double *labels;        // the batch's expected outputs, numOutputNodes apart
+   double *inputLayers;   // the batch's convolved or reduced inputs, maxNodesInALayer apart
+   double *firstNodes;    // the first hidden layer of every network for the whole batch, sharedWidth apart
+   double *layers[2];     // the nodes of the batch in one network's later layers, maxNodesInALayer apart,
+                          // one layer in each buffer in turn
+   double *outputs;       // the batch's rows of the predictions file, rowLength apart
+   int rowLength;         // (numModels + 1) * numOutputNodes
+   double *errors;        // the total error of each network, then of the average
+};
+
+// function headers ----------------------
+
+int loadEnsemble(Ensemble *, char **);
+void freeEnsemble(Ensemble *);
+void runEnsembleBatch(Ensemble *, int);
+void finishEnsembleLayer(const Network *, double *, int, int, int, char);
+
+// functions ----------------------
+
+/**
+ * Asks for a config and the weights files of every network to run, then
+ * runs them all over the training sets in the config's training sets file
+ * (the networks are not trained first).
+ *
+ * @return 0 if successful, 1 otherwise (the exit code of the process)
+ */
+int runEnsemble(void)
+{
+   char configFilename[MAX_FILE_NAME_LENGTH];
+   int numModels = 0;
+
+   printf("What config file should I use? ");
+   scanf("%s", configFilename);
+   printf("How many weights files should I run? ");
+   scanf("%d", &numModels);
+
+   if (numModels < 1)
+   {
+      printf("An ensemble needs at least one weights file.\n");
+      return 1;
+   }
+
+   char *names = malloc((size_t)numModels * MAX_FILE_NAME_LENGTH);
+   char **weightsFiles = malloc(numModels * sizeof(char *));
+   if (names == NULL || weightsFiles == NULL)
+   {
+      printf("There was an error allocating memory for the weights files' names.\n");
+      free(names);
+      free(weightsFiles);
+      return 1;
+   }
+
+   for (int i = 0; i < numModels; i++)
+   {
+      weightsFiles[i] = names + (size_t)i * MAX_FILE_NAME_LENGTH;
+      printf("What is weights file %d? ", i + 1);
+      scanf("%s", weightsFiles[i]);
+   }
+
+   int result = 1;
+   Network *net = createNetwork(configFilename);
+   if (net != NULL)
+   {
+      result = ensembleAll(net, numModels, weightsFiles) == 0 ? 0 : 1;
+      freeNetwork(net);
+   }
+
+   free(weightsFiles);
+   free(names);
+
+   return result;
+}
+
+/**
+ * Runs every network over every training set in one pass, writes each
+ * set's outputs from every network and their average to the predictions
+ * file, and prints the total error of each network and of the average,
+ * and how fast the sets were run.
+ *
+ * @param net the network whose layout every weights file holds (its own weights are not run)
+ * @param numModels the number of weights files
+ * @param weightsFiles the weights file of each network
+ * @return 0 if successful, -1 otherwise
+ */
+int ensembleAll(Network *net, int numModels, char **weightsFiles)
+{
+   if (net->numLayers < 2)
+   {
+      printf("An ensemble needs networks with at least one layer of weights.\n");
+      return -1;
+   }
+
+   Ensemble ensemble;
+   memset(&ensemble, 0, sizeof(Ensemble));
+   ensemble.net = net;
+   ensemble.numModels = numModels;
+
+   if (loadEnsemble(&ensemble, weightsFiles) != 0)
+   {
+      freeEnsemble(&ensemble);
+      return -1;
+   }
+
+   FILE *nodesFile = NULL;
+   int numSets = net->numTrainingSets;
+
+   if (net->trainingInputs == NULL) // streaming the training sets
+   {
+      nodesFile = fopen(net->nodesFileInput, "r");
+      if (nodesFile == NULL)
+      {
+         printf("There was an error opening the training sets file %s.\n", net->nodesFileInput);
+         freeEnsemble(&ensemble);
+         return -1;
+      }
+      fscanf(nodesFile, "%x", &numSets);
+   }
+
+   Predictions *predictions = createPredictionsFile(net, net->predictionsFile, numSets, ensemble.rowLength);
+   if (predictions == NULL)
+   {
+      if (nodesFile != NULL)
+      {
+         fclose(nodesFile);
+      }
+      freeEnsemble(&ensemble);
+      return -1;
+   }
+
+   double startTime = getWallTime();
+   int numRun = 0;
+
+   while (numRun < numSets)
+   {
+      int batchSize = numSets - numRun < ENSEMBLE_BATCH_SIZE ? numSets - numRun : ENSEMBLE_BATCH_SIZE;
+      int numRead = 0;
+
+      for (; numRead < batchSize; numRead++) // gathering the batch's inputs and expected outputs
+      {
+         double *inputs = ensemble.inputs + (size_t)numRead * net->numInputNodes;
+         double *labels = ensemble.labels + (size_t)numRead * net->numOutputNodes;
+
+         if (nodesFile != NULL)
+         {
+            if (readTrainingSet(net, nodesFile, inputs, labels) != 0)
+               break;
+         }
+         else
+         {
+            memcpy(inputs, net->trainingInputs + (size_t)(numRun + numRead) * net->inputStride,
+                   net->numInputNodes * sizeof(double));
+            memcpy(labels, net->trainingLabels + (size_t)(numRun + numRead) * net->numOutputNodes,
+                   net->numOutputNodes * sizeof(double));
+         }
+      }
+
+      if (numRead == 0)
+         break;
+
+      runEnsembleBatch(&ensemble, numRead);
+
+      for (int b = 0; b < numRead; b++)
+      {
+         writePrediction(predictions, numRun + b, ensemble.outputs + (size_t)b * ensemble.rowLength);
+      }
+      numRun += numRead;
+
+      if (numRead < batchSize)
+         break;
+   } // while (numRun < numSets)
+
+   double elapsed = getWallTime() - startTime;
+
+   finishPredictionsFile(predictions, numRun);
+
+   if (numRun < numSets)
+   {
+      printf("The training sets file %s ended after %d of its %d sets.\n", net->nodesFileInput, numRun, numSets);
+   }
+   for (int i = 0; i < numModels; i++)
+   {
+      printf("Network %d (%s) has a total error of %lf\n", i + 1, weightsFiles[i], ensemble.errors[i]);
+   }
+   printf("The average of the %d networks has a total error of %lf\n", numModels, ensemble.errors[numModels]);
+   printf("Ran %d training sets through %d networks in %.3lfms (%.0lf sets per second)\n", numRun, numModels,
+          elapsed * 1000.0, elapsed > 0.0 ? numRun / elapsed : 0.0);
+   printf("Finished writing predictions to %s\n", net->predictionsFile);
+
+   if (nodesFile != NULL)
+   {
+      fclose(nodesFile);
+   }
+   freeEnsemble(&ensemble);
+
+   return 0;
+}
+
+/**
+ * Loads every network's weights and lays their first layers of weights
+ * side by side, packs the rest of each network's weights, and allocates
+ * the buffers a batch is run in. Each weights file is read into the one
+ * padded copy of the weights, which its sparse layers are found from.
+ *
+ * @param ensemble the ensemble to load (with its network and number of networks set)
+ * @param weightsFiles the weights file of each network
+ * @return 0 if successful, -1 otherwise
+ */
+int loadEnsemble(Ensemble *ensemble, char **weightsFiles)
+{
+   Network *net = ensemble->net;
+   int numModels = ensemble->numModels;
+   int maxNodesInALayer = net->maxNodesInALayer;
+   int numInputLayerNodes = net->layerDimensions[0];
+   size_t weightsLength = (size_t)net->maxWeightsInALayer * net->numLayers + net->totalWeights - net->convWeightsOffset;
+
+   ensemble->numFilterWeights = net->totalWeights - net->convWeightsOffset;
+   size_t modelLength = ensemble->numFilterWeights; // every layer after the first, packed, then the filters
+   for (int m = 1; m < net->numLayers - 1; m++)
+   {
+      modelLength += (size_t)net->layerDimensions[m] * net->layerDimensions[m + 1];
+   }
+   ensemble->filtersOffset = modelLength - ensemble->numFilterWeights;
+
+   ensemble->firstWidth = net->layerDimensions[1];
+   ensemble->sharedWidth = numModels * ensemble->firstWidth;
+   ensemble->rowLength = (numModels + 1) * net->numOutputNodes;
+
+   ensemble->modelWeights = calloc(numModels, sizeof(double *));
+   ensemble->paddedWeights = calloc(weightsLength, sizeof(double));
+   ensemble->modelSparseLayers = calloc(numModels, sizeof(struct SparseLayer *));
+   ensemble->errors = calloc(numModels + 1, sizeof(double));
+   ensemble->firstLayer = allocateAligned((size_t)numInputLayerNodes * ensemble->sharedWidth * sizeof(double));
+   ensemble->inputs = allocateAligned((size_t)ENSEMBLE_BATCH_SIZE * net->numInputNodes * sizeof(double));
+   ensemble->labels = malloc((size_t)ENSEMBLE_BATCH_SIZE * net->numOutputNodes * sizeof(double));
+   ensemble->inputLayers = allocateAligned((size_t)ENSEMBLE_BATCH_SIZE * maxNodesInALayer * sizeof(double));
+   ensemble->firstNodes = allocateAligned((size_t)ENSEMBLE_BATCH_SIZE * ensemble->sharedWidth * sizeof(double));
+   ensemble->layers[0] = allocateAligned((size_t)ENSEMBLE_BATCH_SIZE * maxNodesInALayer * sizeof(double));
+   ensemble->layers[1] = allocateAligned((size_t)ENSEMBLE_BATCH_SIZE * maxNodesInALayer * sizeof(double));
+   ensemble->outputs = malloc((size_t)ENSEMBLE_BATCH_SIZE * ensemble->rowLength * sizeof(double));
+
+   if (ensemble->modelWeights == NULL || ensemble->paddedWeights == NULL || ensemble->modelSparseLayers == NULL ||
+       ensemble->errors == NULL || ensemble->firstLayer == NULL || ensemble->inputs == NULL ||
+       ensemble->labels == NULL || ensemble->inputLayers == NULL || ensemble->firstNodes == NULL ||
+       ensemble->layers[0] == NULL || ensemble->layers[1] == NULL || ensemble->outputs == NULL)
+   {
+      printf("There was an error allocating memory for the ensemble.\n");
+      return -1;
+   }
+
+   double *ownWeights = net->weights;
+   struct SparseLayer *ownSparseLayers = net->sparseLayers; // the config's own weights' sparse layers are put back after
+   char ownUseSparseKernels = net->useSparseKernels;
+   net->sparseLayers = NULL;
+
+   ensemble->sparseFirstLayers = 'Y';
+
+   for (int i = 0; i < numModels; i++)
+   {
+      ensemble->modelWeights[i] = malloc((modelLength > 0 ? modelLength : 1) * sizeof(double));
+      if (ensemble->modelWeights[i] == NULL)
+      {
+         printf("There was an error allocating memory for the weights of network %d.\n", i + 1);
+         net->sparseLayers = ownSparseLayers;
+         return -1;
+      }
+
+      net->weights = ensemble->paddedWeights; // the weights file is read into the padded layout
+      int result = initializeWeightsFromFile(net, weightsFiles[i]);
+      if (result == 0)
+      {
+         findSparseLayers(net); // and its sparse layers are found from them
+         ensemble->modelSparseLayers[i] = net->sparseLayers;
+         net->sparseLayers = NULL;
+      }
+      net->weights = ownWeights;
+
+      if (result != 0)
+      {
+         net->sparseLayers = ownSparseLayers;
+         net->useSparseKernels = ownUseSparseKernels;
+         return -1;
+      }
+
+      if (ensemble->modelSparseLayers[i] == NULL || ensemble->modelSparseLayers[i][0].useSparseKernel != 'Y')
+      {
+         ensemble->sparseFirstLayers = 'n';
+      }
+
+      for (int k = 0; k < numInputLayerNodes; k++) // this network's columns of the shared first layer
+      {
+         memcpy(ensemble->firstLayer + (size_t)k * ensemble->sharedWidth + i * ensemble->firstWidth,
+                ensemble->paddedWeights + k * maxNodesInALayer, ensemble->firstWidth * sizeof(double));
+      }
+
+      double *packed = ensemble->modelWeights[i]; // then its other layers and its filters
+      for (int m = 1; m < net->numLayers - 1; m++)
+      {
+         for (int k = 0; k < net->layerDimensions[m]; k++)
+         {
+            memcpy(packed, ensemble->paddedWeights + m * net->maxWeightsInALayer + k * maxNodesInALayer,
+                   net->layerDimensions[m + 1] * sizeof(double));
+            packed += net->layerDimensions[m + 1];
+         }
+      }
+      memcpy(packed, ensemble->paddedWeights + net->convWeightsOffset, ensemble->numFilterWeights * sizeof(double));
+   }
+
+   net->sparseLayers = ownSparseLayers;
+   net->useSparseKernels = ownUseSparseKernels;
+
+   return 0;
+}
+
+/**
+ * Frees everything loadEnsemble allocated, even if it failed partway.
+ *
+ * @param ensemble the ensemble to free
+ */
+void freeEnsemble(Ensemble *ensemble)
+{
+   if (ensemble->modelWeights != NULL)
+   {
+      for (int i = 0; i < ensemble->numModels; i++)
+      {
+         free(ensemble->modelWeights[i]);
+      }
+   }
+   free(ensemble->modelWeights);
+   free(ensemble->paddedWeights);
+
+   if (ensemble->modelSparseLayers != NULL)
+   {
+      Network *net = ensemble->net;
+      struct SparseLayer *ownSparseLayers = net->sparseLayers;
+      char ownUseSparseKernels = net->useSparseKernels;
+
+      for (int i = 0; i < ensemble->numModels; i++) // freed the same way as the network's own
+      {
+         net->sparseLayers = ensemble->modelSparseLayers[i];
+         freeSparseLayers(net);
+      }
+
+      net->sparseLayers = ownSparseLayers;
+      net->useSparseKernels = ownUseSparseKernels;
+   }
+   free(ensemble->modelSparseLayers);
+   free(ensemble->errors);
+   freeAligned(ensemble->firstLayer);
+   freeAligned(ensemble->inputs);
+   free(ensemble->labels);
+   freeAligned(ensemble->inputLayers);
+   freeAligned(ensemble->firstNodes);
+   freeAligned(ensemble->layers[0]);
+   freeAligned(ensemble->layers[1]);
+   free(ensemble->outputs);
+
+   return;
+}
+
+/**
+ * Runs a batch of training sets through every network, filling in each
+ * set's row of outputs and adding each network's errors (and the error of
+ * the average) to the totals. For each network, this is the same as
+ * runNetwork on each set, except that every layer of weights is applied
+ * to the whole batch at once, and the first layer to every network at once.
+ *
+ * @param ensemble the ensemble to run
+ * @param numSets the number of sets in the batch (at most ENSEMBLE_BATCH_SIZE)
+ */
+void runEnsembleBatch(Ensemble *ensemble, int numSets)
+{
+   Network *net = ensemble->net;
+   int maxNodesInALayer = net->maxNodesInALayer;
+   int numOutputNodes = net->numOutputNodes;
+   int numModels = ensemble->numModels;
+   int sharedWidth = ensemble->sharedWidth;
+   int numInputLayerNodes = net->layerDimensions[0];
+   char firstIsOutputLayer = net->numLayers == 2;
+
+   if (net->convFilters == 0 && ensemble->sparseFirstLayers != 'Y') // every network has the same input layer, so their first layers are found at once
+   {
+      double *sourceNodes = ensemble->inputs;
+      int sourceStride = net->numInputNodes;
+
+      if (net->projection != NULL)
+      {
+         for (int b = 0; b < numSets; b++)
+         {
+            projectInputs(net, ensemble->inputs + (size_t)b * net->numInputNodes,
+                          ensemble->inputLayers + (size_t)b * maxNodesInALayer);
+         }
+         sourceNodes = ensemble->inputLayers;
+         sourceStride = maxNodesInALayer;
+      }
+
+      multiplyMatrices(numSets, sharedWidth, numInputLayerNodes, sourceNodes, sourceStride, ensemble->firstLayer,
+                       sharedWidth, ensemble->firstNodes, sharedWidth);
+   }
+
+   for (int i = 0; i < numModels; i++) // looping through the networks
+   {
+      double *modelWeights = ensemble->modelWeights[i]; // moved past each layer as it is run
+      struct SparseLayer *sparseLayers = ensemble->modelSparseLayers[i];
+      double *sourceNodes = ensemble->firstNodes + i * ensemble->firstWidth;
+      int sourceStride = sharedWidth;
+
+      if (net->convFilters > 0) // this network's own filters make its input layer
+      {
+         memcpy(ensemble->paddedWeights + net->convWeightsOffset, modelWeights + ensemble->filtersOffset,
+                ensemble->numFilterWeights * sizeof(double));
+         double *ownWeights = net->weights;
+         net->weights = ensemble->paddedWeights;
+         for (int b = 0; b < numSets; b++)
+         {
+            runConvolution(net, net->scratch, ensemble->inputs + (size_t)b * net->numInputNodes,
+                           ensemble->inputLayers + (size_t)b * maxNodesInALayer);
+         }
+         net->weights = ownWeights;
+      }
+
+      if (ensemble->sparseFirstLayers == 'Y') // every network's first layer is run on its own
+      {
+         double *inputLayer = ensemble->inputs;
+         int inputStride = net->numInputNodes;
+         if (net->convFilters > 0 || net->projection != NULL)
+         {
+            inputLayer = ensemble->inputLayers;
+            inputStride = maxNodesInALayer;
+         }
+         if (net->convFilters == 0 && net->projection != NULL && i == 0) // the reduced inputs are the same for every network
+         {
+            for (int b = 0; b < numSets; b++)
+            {
+               projectInputs(net, ensemble->inputs + (size_t)b * net->numInputNodes,
+                             ensemble->inputLayers + (size_t)b * maxNodesInALayer);
+            }
+         }
+
+         for (int b = 0; b < numSets; b++)
+         {
+            multiplySparseMatrixVector(ensemble->firstWidth, sparseLayers[0].rowStarts, sparseLayers[0].columns,
+                                       sparseLayers[0].values, inputLayer + (size_t)b * inputStride,
+                                       sourceNodes + (size_t)b * sharedWidth);
+         }
+      }
+      else if (net->convFilters > 0)
+      {
+         multiplyMatrices(numSets, ensemble->firstWidth, numInputLayerNodes, ensemble->inputLayers, maxNodesInALayer,
+                          ensemble->firstLayer + i * ensemble->firstWidth, sharedWidth, sourceNodes, sharedWidth);
+      }
+
+      finishEnsembleLayer(net, sourceNodes, sourceStride, numSets, ensemble->firstWidth, firstIsOutputLayer);
+
+      for (int m = 1; m < net->numLayers - 1; m++) // looping through the rest of the connectivity layers
+      {
+         int numSourceNodes = net->layerDimensions[m];
+         int numDestNodes = net->layerDimensions[m + 1];
+         double *destNodes = ensemble->layers[m % 2];
+
+         if (sparseLayers != NULL && sparseLayers[m].useSparseKernel == 'Y')
+         {
+            for (int b = 0; b < numSets; b++)
+            {
+               multiplySparseMatrixVector(numDestNodes, sparseLayers[m].rowStarts, sparseLayers[m].columns,
+                                          sparseLayers[m].values, sourceNodes + (size_t)b * sourceStride,
+                                          destNodes + (size_t)b * maxNodesInALayer);
+            }
+         }
+         else
+         {
+            multiplyMatrices(numSets, numDestNodes, numSourceNodes, sourceNodes, sourceStride, modelWeights, numDestNodes,
+                             destNodes, maxNodesInALayer);
+         }
+         modelWeights += (size_t)numSourceNodes * numDestNodes;
+         finishEnsembleLayer(net, destNodes, maxNodesInALayer, numSets, numDestNodes, m == net->numLayers - 2);
+
+         sourceNodes = destNodes;
+         sourceStride = maxNodesInALayer;
+      } // for (int m = 1; m < numLayers - 1; m++)
+
+      for (int b = 0; b < numSets; b++)
+      {
+         double *outputs = ensemble->outputs + (size_t)b * ensemble->rowLength;
+         double *average = outputs + numModels * numOutputNodes;
+         double *setOutputs = sourceNodes + (size_t)b * sourceStride;
+
+         memcpy(outputs + i * numOutputNodes, setOutputs, numOutputNodes * sizeof(double));
+         for (int j = 0; j < numOutputNodes; j++)
+         {
+            average[j] = (i == 0 ? 0.0 : average[j]) + setOutputs[j];
+         }
+
+         ensemble->errors[i] += net->errorFunction(ensemble->labels + (size_t)b * numOutputNodes, setOutputs, numOutputNodes);
+      }
+   } // for (int i = 0; i < numModels; i++)
+
+   for (int b = 0; b < numSets; b++)
+   {
+      double *average = ensemble->outputs + (size_t)b * ensemble->rowLength + numModels * numOutputNodes;
+
+      for (int j = 0; j < numOutputNodes; j++)
+      {
+         average[j] /= numModels;
+      }
+
+      ensemble->errors[numModels] += net->errorFunction(ensemble->labels + (size_t)b * numOutputNodes, average, numOutputNodes);
+   }
+
+   return;
+}
+
+/**
+ * Applies the activation and output functions to the thetas of one layer
+ * of a batch, in place, normalizing an output layer as a whole when the
+ * network uses softmax (the same as runFromInputLayer in ./network.c).
+ *
+ * @param net the network the layer belongs to
+ * @param nodes the thetas of the first set in the batch
+ * @param stride the distance between the sets' thetas
+ * @param numSets the number of sets in the batch
+ * @param numNodes the number of nodes in the layer
+ * @param isOutputLayer whether the layer is the output layer
+ */
+void finishEnsembleLayer(const Network *net, double *nodes, int stride, int numSets, int numNodes, char isOutputLayer)
+{
+   char normalize = isOutputLayer && net->useSoftmax == 'Y';
+
+   for (int b = 0; b < numSets; b++)
+   {
+      double *setNodes = nodes + (size_t)b * stride;
+
+      for (int j = 0; j < numNodes; j++) // looping through the layer
+      {
+         double theta = activationFunction(setNodes[j]);
+         setNodes[j] = normalize ? theta : outputFunction(theta);
+      }
+
+      if (normalize)
+      {
+         softmax(setNodes, numNodes);
+      }
+   }
+
+   return;
+}
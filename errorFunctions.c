@@ -11,6 +11,7 @@
  * Functions in this file:
  * 
  * quadraticLoss
+ * crossEntropyLoss
  */
 
 #include <stdlib.h>
@@ -31,9 +32,32 @@ double quadraticLoss(double expectedOutput[], double actualOutput[], int arrayLe
    double error = 0.0;
    for (int i = 0; i < arrayLength; i++)
    {
-      double deviation = expectedOutput[0] - actualOutput[0];
+      double deviation = expectedOutput[i] - actualOutput[i];
       error += deviation * deviation;
    }
    return 0.5 * error;
 }
 
+/**
+ * The cross-entropy error function returns the negative sum of each expected
+ * output times the log of the matching actual output. It is meant for
+ * classification, where the actual outputs come from a softmax layer (so they
+ * sum to 1) and the expected outputs are 1 for the right class and 0 otherwise.
+ * Actual outputs are clamped away from 0 so the log stays finite.
+ * 
+ * @param expectedOutput array of the expected outputs
+ * @param actualOutput array of the actual outputs
+ * @param arrayLength the number of outputs to compare and use to calculate error
+ */
+double crossEntropyLoss(double expectedOutput[], double actualOutput[], int arrayLength)
+{
+   double error = 0.0;
+   for (int i = 0; i < arrayLength; i++)
+   {
+      if (expectedOutput[i] != 0.0)
+      {
+         error -= expectedOutput[i] * log(fmax(actualOutput[i], 1e-300));
+      }
+   }
+   return error;
+}
@@ -0,0 +1,364 @@
+/**
+ * Created 10/18/2026
+ * This file bakes a trained network into a standalone C source file, for
+ * running it where reading a config and a weights file at startup is too
+ * slow (or there is no file system at all).
+ *
+ * The source file holds the network's layer sizes as #defines, its weights
+ * as aligned static const arrays (with the padding of the mkj layout left
+ * out), and a forward function written for those exact sizes, with every
+ * buffer on the stack. It only needs <math.h>; nothing is parsed, read, or
+ * allocated when a program that links it starts. The names in the file
+ * start with the network's exportName, so several baked networks can be
+ * linked into one program.
+ *
+ * The convolution layer and the input reduction are baked too. The output
+ * and activation functions are the ones this build of the network uses
+ * (see ./network.c), so they must be ones this file knows how to write.
+ *
+ * Functions in this file:
+ *
+ * int runExport(void)
+ * int exportNetwork(const Network *net, char *sourceFile)
+ * void writeBakedArray(FILE *source, const char *exportName, const char *arrayName, const double *values, int numRows, int numColumns, int stride)
+ * void writeBakedForward(FILE *source, const Network *net)
+ * const char *findBakedOutputFunction(void)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "./headerfiles/outputFunctions.h"     // importing the output
+#include "./headerfiles/activationFunctions.h" // and activation functions to recognize them
+#include "./headerfiles/networkInternals.h"    // importing the network layout and functions
+#include "./headerfiles/export.h"
+
+#define BAKED_VALUES_PER_LINE 4 // weights written on each line of the source file
+
+// function headers ----------------------
+
+void writeBakedArray(FILE *, const char *, const char *, const double *, int, int, int);
+void writeBakedForward(FILE *, const Network *);
+const char *findBakedOutputFunction(void);
+
+// functions ----------------------
+
+/**
+ * Asks for a config, a trained weights file, and where to write the
+ * source file, then bakes the network into it.
+ *
+ * @return 0 if successful, 1 otherwise (the exit code of the process)
+ */
+int runExport(void)
+{
+   char configFilename[MAX_FILE_NAME_LENGTH];
+   char weightsFile[MAX_FILE_NAME_LENGTH];
+   char sourceFile[MAX_FILE_NAME_LENGTH];
+
+   printf("What config file should I use? ");
+   scanf("%s", configFilename);
+   printf("What weights file should I bake in? ");
+   scanf("%s", weightsFile);
+   printf("Where should I write the C source file? ");
+   scanf("%s", sourceFile);
+
+   Network *net = createNetwork(configFilename);
+   if (net == NULL)
+   {
+      return 1;
+   }
+
+   int result = initializeWeightsFromFile(net, weightsFile);
+   if (result == 0)
+   {
+      result = exportNetwork(net, sourceFile);
+   }
+
+   freeNetwork(net);
+
+   return result == 0 ? 0 : 1;
+}
+
+/**
+ * Writes a network, with its current weights, as a standalone C source file.
+ *
+ * @param net the network to bake
+ * @param sourceFile where to write the source file
+ * @return 0 if successful, -1 otherwise
+ */
+int exportNetwork(const Network *net, char *sourceFile)
+{
+   const char *name = net->exportName;
+   const char *outputBody = findBakedOutputFunction();
+
+   if (outputBody == NULL)
+   {
+      printf("This build's output or activation function cannot be baked.\n");
+      return -1;
+   }
+   if (!isalpha((unsigned char)name[0]) && name[0] != '_')
+   {
+      printf("The export name %s is not a C identifier.\n", name);
+      return -1;
+   }
+   for (int i = 0; name[i] != '\0'; i++)
+   {
+      if (!isalnum((unsigned char)name[i]) && name[i] != '_')
+      {
+         printf("The export name %s is not a C identifier.\n", name);
+         return -1;
+      }
+   }
+
+   FILE *source = fopen(sourceFile, "w");
+   if (source == NULL)
+   {
+      printf("There was an error opening the source file %s.\n", sourceFile);
+      return -1;
+   }
+
+   char upperName[MAX_FILE_NAME_LENGTH];
+   int length = 0;
+   for (; name[length] != '\0' && length < MAX_FILE_NAME_LENGTH - 1; length++)
+   {
+      upperName[length] = (char)toupper((unsigned char)name[length]);
+   }
+   upperName[length] = '\0';
+
+   fprintf(source, "/**\n");
+   fprintf(source, " * A baked network, written by network.exe export. Do not edit it by hand.\n");
+   fprintf(source, " * Layers:");
+   for (int m = 0; m < net->numLayers; m++)
+   {
+      fprintf(source, " %d", net->layerDimensions[m]);
+   }
+   fprintf(source, " (from %d inputs)\n", net->numInputNodes);
+   fprintf(source, " *\n");
+   fprintf(source, " * void %sRun(const double inputs[%s_NUM_INPUTS], double outputs[%s_NUM_OUTPUTS])\n", name, upperName,
+           upperName);
+   fprintf(source, " */\n\n");
+   fprintf(source, "#include <math.h>\n\n");
+
+   fprintf(source, "#define %s_NUM_INPUTS %d\n", upperName, net->numInputNodes);
+   fprintf(source, "#define %s_NUM_OUTPUTS %d\n", upperName, net->numOutputNodes);
+   fprintf(source, "#define %s_NUM_LAYERS %d\n\n", upperName, net->numLayers);
+
+   if (net->convFilters > 0) // the filters, depth by filter
+   {
+      writeBakedArray(source, name, "Filters", net->weights + net->convWeightsOffset,
+                      net->inputChannels * net->convFilterSize * net->convFilterSize, net->convFilters, net->convFilters);
+   }
+   else if (net->projection != NULL) // the projection, input by reduced input
+   {
+      writeBakedArray(source, name, "Projection", net->projection, net->numInputNodes, net->numReducedInputs,
+                      net->numReducedInputs);
+      writeBakedArray(source, name, "ProjectionOffsets", net->projectionOffsets, 1, net->numReducedInputs,
+                      net->numReducedInputs);
+   }
+
+   for (int m = 0; m < net->numLayers - 1; m++) // every layer of weights, source node by destination node
+   {
+      char arrayName[32];
+      snprintf(arrayName, sizeof(arrayName), "Weights%d", m);
+      writeBakedArray(source, name, arrayName, net->weights + m * net->maxWeightsInALayer, net->layerDimensions[m],
+                      net->layerDimensions[m + 1], net->maxNodesInALayer);
+   }
+
+   fprintf(source, "static double %sOutput(double theta)\n{\n   %s\n}\n\n", name, outputBody);
+
+   if (net->useSoftmax == 'Y')
+   {
+      fprintf(source, "static void %sSoftmax(double values[], int numValues)\n{\n", name);
+      fprintf(source, "   double largest = values[0];\n");
+      fprintf(source, "   for (int i = 1; i < numValues; i++)\n      largest = fmax(largest, values[i]);\n\n");
+      fprintf(source, "   double sum = 0.0;\n");
+      fprintf(source, "   for (int i = 0; i < numValues; i++)\n   {\n");
+      fprintf(source, "      values[i] = exp(values[i] - largest);\n      sum += values[i];\n   }\n\n");
+      fprintf(source, "   for (int i = 0; i < numValues; i++)\n      values[i] /= sum;\n}\n\n");
+   }
+
+   writeBakedForward(source, net);
+
+   int failed = ferror(source);
+   fclose(source);
+
+   if (failed)
+   {
+      printf("There was an error writing the source file %s.\n", sourceFile);
+      return -1;
+   }
+
+   printf("Finished baking the network into %s (call %sRun)\n", sourceFile, name);
+
+   return 0;
+}
+
+/**
+ * Writes a matrix as an aligned static const array named after the
+ * network's export name, row after row with no padding.
+ *
+ * @param source the source file
+ * @param exportName the start of every name in the source file
+ * @param arrayName the rest of the array's name
+ * @param values the first value of the matrix
+ * @param numRows the number of rows
+ * @param numColumns the number of columns
+ * @param stride how far apart the rows are in values
+ */
+void writeBakedArray(FILE *source, const char *exportName, const char *arrayName, const double *values, int numRows,
+                     int numColumns, int stride)
+{
+   long long numValues = (long long)numRows * numColumns;
+   long long written = 0;
+
+   fprintf(source, "_Alignas(64) static const double %s%s[%lld] = {", exportName, arrayName, numValues);
+
+   for (int r = 0; r < numRows; r++)
+   {
+      for (int c = 0; c < numColumns; c++)
+      {
+         if (written % BAKED_VALUES_PER_LINE == 0)
+         {
+            fprintf(source, "\n   ");
+         }
+         fprintf(source, "%.17g,%s", values[(size_t)r * stride + c], (written + 1) % BAKED_VALUES_PER_LINE == 0 ? "" : " ");
+         written++;
+      }
+   }
+
+   fprintf(source, "\n};\n\n");
+
+   return;
+}
+
+/**
+ * Writes the forward function of a network, with its layer sizes written
+ * in as numbers. It works the same as runNetwork in ./network.c (the
+ * activation function is left out, since only the identity is baked).
+ *
+ * @param source the source file
+ * @param net the network being baked
+ */
+void writeBakedForward(FILE *source, const Network *net)
+{
+   const char *name = net->exportName;
+
+   fprintf(source, "void %sRun(const double *inputs, double *outputs)\n{\n", name);
+
+   if (net->convFilters > 0) // each filter at each position, max pooled, without keeping the positions
+   {
+      int filterSize = net->convFilterSize;
+
+      fprintf(source, "   double nodes0[%d];\n\n", net->layerDimensions[0]);
+      fprintf(source, "   // the convolution layer: %d %dx%d filters, pooled in %dx%d squares\n", net->convFilters,
+              filterSize, filterSize, net->poolSize, net->poolSize);
+      fprintf(source, "   for (int f = 0; f < %d; f++)\n", net->convFilters);
+      fprintf(source, "      for (int py = 0; py < %d; py++)\n", net->poolHeight);
+      fprintf(source, "         for (int px = 0; px < %d; px++)\n         {\n", net->poolWidth);
+      fprintf(source, "            double best = -HUGE_VAL;\n");
+      fprintf(source, "            for (int dy = 0; dy < %d; dy++)\n", net->poolSize);
+      fprintf(source, "               for (int dx = 0; dx < %d; dx++)\n               {\n", net->poolSize);
+      fprintf(source, "                  int top = (py * %d + dy) * %d;\n", net->poolSize, net->convStride);
+      fprintf(source, "                  int left = (px * %d + dx) * %d;\n", net->poolSize, net->convStride);
+      fprintf(source, "                  double theta = 0.0;\n");
+      fprintf(source, "                  for (int c = 0; c < %d; c++)\n", net->inputChannels);
+      fprintf(source, "                     for (int fy = 0; fy < %d; fy++)\n", filterSize);
+      fprintf(source, "                        for (int fx = 0; fx < %d; fx++)\n", filterSize);
+      fprintf(source, "                           theta += inputs[c * %d + (top + fy) * %d + left + fx] *\n",
+              net->inputWidth * net->inputHeight, net->inputWidth);
+      fprintf(source, "                                    %sFilters[((c * %d + fy) * %d + fx) * %d + f];\n", name,
+              filterSize, filterSize, net->convFilters);
+      fprintf(source, "                  double value = %sOutput(theta);\n", name);
+      fprintf(source, "                  best = value > best ? value : best;\n");
+      fprintf(source, "               }\n");
+      fprintf(source, "            nodes0[(f * %d + py) * %d + px] = best;\n", net->poolHeight, net->poolWidth);
+      fprintf(source, "         }\n\n");
+   }
+   else if (net->projection != NULL)
+   {
+      int numReduced = net->numReducedInputs;
+
+      fprintf(source, "   double nodes0[%d] = {0.0};\n\n", numReduced);
+      fprintf(source, "   // the input reduction: %d inputs to %d\n", net->numInputNodes, numReduced);
+      fprintf(source, "   for (int i = 0; i < %d; i++)\n   {\n", net->numInputNodes);
+      fprintf(source, "      const double input = inputs[i];\n");
+      fprintf(source, "      const double *row = %sProjection + i * %d;\n", name, numReduced);
+      fprintf(source, "      for (int j = 0; j < %d; j++)\n         nodes0[j] += input * row[j];\n   }\n", numReduced);
+      fprintf(source, "   for (int j = 0; j < %d; j++)\n      nodes0[j] -= %sProjectionOffsets[j];\n\n", numReduced, name);
+   }
+   else
+   {
+      fprintf(source, "   const double *nodes0 = inputs;\n\n");
+   }
+
+   for (int m = 0; m < net->numLayers - 1; m++)
+   {
+      int numSource = net->layerDimensions[m];
+      int numDest = net->layerDimensions[m + 1];
+      char isOutputLayer = m == net->numLayers - 2;
+      const char *destination = isOutputLayer ? "outputs" : NULL;
+      char destinationName[32];
+
+      if (destination == NULL)
+      {
+         snprintf(destinationName, sizeof(destinationName), "nodes%d", m + 1);
+         destination = destinationName;
+         fprintf(source, "   double %s[%d];\n", destination, numDest);
+      }
+
+      fprintf(source, "   { // layer %d: %d nodes to %d nodes\n", m + 1, numSource, numDest);
+      fprintf(source, "      double thetas[%d] = {0.0};\n", numDest);
+      fprintf(source, "      for (int k = 0; k < %d; k++)\n      {\n", numSource);
+      fprintf(source, "         const double source = nodes%d[k];\n", m);
+      fprintf(source, "         const double *row = %sWeights%d + k * %d;\n", name, m, numDest);
+      fprintf(source, "         for (int j = 0; j < %d; j++)\n            thetas[j] += source * row[j];\n      }\n", numDest);
+
+      if (isOutputLayer && net->useSoftmax == 'Y')
+      {
+         fprintf(source, "      for (int j = 0; j < %d; j++)\n         %s[j] = thetas[j];\n", numDest, destination);
+         fprintf(source, "      %sSoftmax(%s, %d);\n", name, destination, numDest);
+      }
+      else
+      {
+         fprintf(source, "      for (int j = 0; j < %d; j++)\n         %s[j] = %sOutput(thetas[j]);\n", numDest,
+                 destination, name);
+      }
+      fprintf(source, "   }\n%s", isOutputLayer ? "" : "\n");
+   } // for (int m = 0; m < numLayers - 1; m++)
+
+   fprintf(source, "}\n");
+
+   return;
+}
+
+/**
+ * Finds the body of the baked output function for the output function
+ * this build uses. Only the identity activation function is baked, since
+ * it is the only one in ./activationFunctions.c.
+ *
+ * @return the body of the function of theta, or NULL if it cannot be baked
+ */
+const char *findBakedOutputFunction(void)
+{
+   if (activationFunction != &identity)
+   {
+      return NULL;
+   }
+
+   if (outputFunction == &sigmoid)
+   {
+      return "return 1.0 / (1.0 + exp(-theta));";
+   }
+   if (outputFunction == &tanh)
+   {
+      return "return tanh(theta);";
+   }
+   if (outputFunction == &relu)
+   {
+      return "return fmax(0.0, theta);";
+   }
+
+   return NULL;
+}
@@ -0,0 +1,321 @@
+/**
+ * Created 10/18/2026
+ * This file freezes layers of a network's weights, so that fine-tuning only
+ * trains the layers that are left and only costs as much as they do.
+ *
+ * freeze_layer_N Y in the config keeps connectivity layer N (numbered from 1,
+ * the layer between the input layer and the first hidden layer) from being
+ * trained, and freeze_convolution Y does the same for the convolution
+ * filters. Backprop stops at the last of the frozen layers at the front of
+ * the network (the frozen boundary), since nothing before it is trained.
+ *
+ * The values of the boundary layer never change while only the layers after
+ * it are trained, so train (see ./network.c) finds them once for every
+ * training set and caches them, in memory or in a file mapped into memory.
+ * Every cycle after that runs each training set from the boundary layer,
+ * and the frozen layers are never run again.
+ *
+ * Functions in this file:
+ *
+ * void findFrozenBoundary(Network *net)
+ * int findFrozenLayerSize(const Network *net)
+ * void cacheFrozenActivations(Network *net)
+ * void freeFrozenActivations(Network *net)
+ * void runFromFrozenBoundary(const Network *net, NetworkScratch *scratch, int t)
+ * double *mapFrozenCache(FrozenCache *cache, char *cacheFile)
+ * void unmapFrozenCache(FrozenCache *cache)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#include "./headerfiles/networkInternals.h" // importing the network layout and functions
+#include "./headerfiles/freeze.h"
+
+struct FrozenCache
+{
+   double *values;  // layerSize values for every training set
+   int layerSize;   // values of the boundary layer
+   size_t numBytes; // bytes of the values
+   char mapped;     // whether the values are mapped from a file (otherwise they were allocated)
+
+#ifdef _WIN32
+   HANDLE fileHandle;
+   HANDLE mapping;
+#else
+   int fileDescriptor;
+#endif
+};
+
+// function headers ----------------------
+
+double *mapFrozenCache(FrozenCache *, char *);
+void unmapFrozenCache(FrozenCache *);
+
+// functions ----------------------
+
+/**
+ * Finds the frozen boundary from the freeze settings: the number of frozen
+ * connectivity layers at the front of the network, so that psis are only
+ * found for the layers to its right. A convolution layer that is trained
+ * needs every psi, so the boundary is the input layer unless its filters
+ * are frozen too. This is called once every setting is known.
+ *
+ * @param net the network whose frozen boundary to find
+ */
+void findFrozenBoundary(Network *net)
+{
+   net->frozenBoundary = 0;
+
+   if (net->convFilters > 0 && net->freezeConvolution != 'Y')
+   {
+      return;
+   }
+
+   while (net->frozenBoundary < net->numLayers - 1 && net->frozenLayers[net->frozenBoundary] == 'Y')
+   {
+      net->frozenBoundary++;
+   }
+
+   if (net->frozenBoundary > 0)
+   {
+      printf("frozen layers: the first %d\n", net->frozenBoundary);
+   }
+
+   return;
+}
+
+/**
+ * Finds how many values of every training set are cached at the frozen
+ * boundary (see cacheFrozenActivations).
+ *
+ * @param net the network (with its convolution layer set up)
+ * @return the size of the boundary layer, or 0 if nothing is cached
+ */
+int findFrozenLayerSize(const Network *net)
+{
+   // the input layer is only worth caching if it is the outputs of frozen filters (reduced inputs already are cached)
+   if (net->frozenBoundary == 0 && (net->convFilters == 0 || net->freezeConvolution != 'Y'))
+   {
+      return 0;
+   }
+
+   return net->layerDimensions[net->frozenBoundary];
+}
+
+/**
+ * Runs the frozen layers once for every training set the network holds and
+ * caches the values of the boundary layer, so that training (and every other
+ * run of the training sets through runTrainingSet) starts from them. This
+ * does nothing if they are already cached, if nothing is frozen, or if the
+ * training sets are not all in memory or are run by a pipeline's stages.
+ * If they cannot be cached, training runs the frozen layers every time.
+ *
+ * @param net the network about to be trained
+ */
+void cacheFrozenActivations(Network *net)
+{
+   int layerSize = findFrozenLayerSize(net);
+   if (net->frozenCache != NULL || layerSize == 0 || net->trainingInputs == NULL || net->pipeline != NULL)
+   {
+      return;
+   }
+
+   FrozenCache *cache = calloc(1, sizeof(FrozenCache));
+   if (cache == NULL)
+   {
+      printf("There was an error allocating memory for the frozen layers' cache.\n");
+      return;
+   }
+
+   cache->layerSize = layerSize;
+   cache->numBytes = ((size_t)net->numTrainingSets * layerSize + 1) * sizeof(double);
+
+   if (net->freezeCacheFile[0] != '\0')
+   {
+      cache->values = mapFrozenCache(cache, net->freezeCacheFile);
+      if (cache->values == NULL)
+      {
+         printf("Could not map the frozen layers' cache %s, so it is kept in memory.\n", net->freezeCacheFile);
+      }
+   }
+   if (cache->values == NULL)
+   {
+      cache->values = malloc(cache->numBytes);
+   }
+   if (cache->values == NULL)
+   {
+      printf("There was an error allocating memory for the frozen layers' cache, so they are run every time.\n");
+      free(cache);
+      return;
+   }
+
+   int boundary = net->frozenBoundary;
+   NetworkScratch *scratch = net->scratch;
+
+   for (int t = 0; t < net->numTrainingSets; t++)
+   {
+      scratch->inputs = prepareInputLayer(net, scratch, net->trainingInputs + (size_t)t * net->inputStride);
+
+      for (int m = 0; m < boundary; m++)
+      {
+         runConnectivityLayer(net, scratch, m);
+      }
+
+      double *layer = boundary == 0 ? scratch->inputs : scratch->nodes + boundary * net->maxNodesInALayer;
+      memcpy(cache->values + (size_t)t * layerSize, layer, layerSize * sizeof(double));
+   }
+
+   net->frozenCache = cache;
+
+   return;
+}
+
+/**
+ * Frees the cached values of the frozen boundary (if there are any).
+ *
+ * @param net the network whose cache to free
+ */
+void freeFrozenActivations(Network *net)
+{
+   FrozenCache *cache = net->frozenCache;
+   if (cache == NULL)
+   {
+      return;
+   }
+
+   if (cache->mapped)
+   {
+      unmapFrozenCache(cache);
+   }
+   else
+   {
+      free(cache->values);
+   }
+   free(cache);
+
+   net->frozenCache = NULL;
+
+   return;
+}
+
+/**
+ * Runs one of the training sets from its cached values of the frozen
+ * boundary, through the layers after it. Otherwise this is the same as
+ * runNetwork on the training set's inputs.
+ *
+ * @param net the network to run (with its frozen activations cached)
+ * @param scratch the buffers to propagate values through
+ * @param t the index of the training set
+ */
+void runFromFrozenBoundary(const Network *net, NetworkScratch *scratch, int t)
+{
+   FrozenCache *cache = net->frozenCache;
+   int boundary = net->frozenBoundary;
+   double *values = cache->values + (size_t)t * cache->layerSize;
+
+   if (boundary == 0)
+   {
+      runFromInputLayer(net, scratch, values, NULL);
+      return;
+   }
+
+   memcpy(scratch->nodes + boundary * net->maxNodesInALayer, values, cache->layerSize * sizeof(double));
+
+   for (int m = boundary; m < net->numLayers - 1; m++) // only the layers after the boundary
+   {
+      runConnectivityLayer(net, scratch, m);
+   }
+
+   finishOutputLayer(net, scratch, NULL);
+
+   return;
+}
+
+/**
+ * Creates (or writes over) the file the cache is kept in and maps it into
+ * memory, so that the cache can be larger than the memory that is free.
+ *
+ * @param cache the cache (with its size set)
+ * @param cacheFile the path of the file
+ * @return the mapped values, or NULL if the file could not be mapped
+ */
+double *mapFrozenCache(FrozenCache *cache, char *cacheFile)
+{
+   void *values = NULL;
+
+#ifdef _WIN32
+   cache->fileHandle = CreateFileA(cacheFile, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                                   FILE_ATTRIBUTE_NORMAL, NULL);
+   if (cache->fileHandle == INVALID_HANDLE_VALUE)
+   {
+      return NULL;
+   }
+
+   unsigned long long numBytes = cache->numBytes;
+   cache->mapping = CreateFileMappingA(cache->fileHandle, NULL, PAGE_READWRITE, (DWORD)(numBytes >> 32),
+                                       (DWORD)(numBytes & 0xFFFFFFFF), NULL);
+   if (cache->mapping != NULL)
+   {
+      values = MapViewOfFile(cache->mapping, FILE_MAP_ALL_ACCESS, 0, 0, cache->numBytes);
+   }
+   if (values == NULL)
+   {
+      if (cache->mapping != NULL)
+      {
+         CloseHandle(cache->mapping);
+      }
+      CloseHandle(cache->fileHandle);
+      return NULL;
+   }
+#else
+   cache->fileDescriptor = open(cacheFile, O_RDWR | O_CREAT | O_TRUNC, 0644);
+   if (cache->fileDescriptor < 0)
+   {
+      return NULL;
+   }
+
+   if (ftruncate(cache->fileDescriptor, cache->numBytes) == 0)
+   {
+      values = mmap(NULL, cache->numBytes, PROT_READ | PROT_WRITE, MAP_SHARED, cache->fileDescriptor, 0);
+   }
+   if (values == NULL || values == MAP_FAILED)
+   {
+      close(cache->fileDescriptor);
+      return NULL;
+   }
+#endif
+
+   cache->mapped = 1;
+
+   return values;
+}
+
+/**
+ * Unmaps the file the cache is kept in. The file is left behind, and is
+ * written over the next time the frozen layers are cached.
+ *
+ * @param cache the mapped cache
+ */
+void unmapFrozenCache(FrozenCache *cache)
+{
+#ifdef _WIN32
+   UnmapViewOfFile(cache->values);
+   CloseHandle(cache->mapping);
+   CloseHandle(cache->fileHandle);
+#else
+   munmap(cache->values, cache->numBytes);
+   close(cache->fileDescriptor);
+#endif
+
+   return;
+}
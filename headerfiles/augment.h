@@ -0,0 +1,21 @@
+/**
+ * Created 10/18/2026
+ * This file contains the header files for augmenting training sets.
+ * More specific documentation can be found in the source file.
+ */
+
+#ifndef augment_h
+#define augment_h
+
+#include "./network.h"
+
+#define AUGMENT_QUEUE_LENGTH 64 // augmented training sets that can wait in the queue
+
+typedef struct Augmenter Augmenter;
+
+Augmenter *createAugmenter(const Network *);
+void freeAugmenter(Augmenter *);
+double *takeAugmentedSet(Augmenter *, int *);
+void releaseAugmentedSet(Augmenter *);
+
+#endif
@@ -0,0 +1,21 @@
+/**
+ * Created 10/18/2026
+ * This file contains the header files for tuning the matrix kernels.
+ * More specific documentation can be found in the source file.
+ */
+
+#ifndef autoTune_h
+#define autoTune_h
+
+#include "./network.h"
+
+void autoTuneNetwork(Network *);
+int findTunedSettings(char *, char *, int[]);
+void saveTunedSettings(char *, char *, int[]);
+void applyTunedSettings(int[]);
+double timeTuningStep(Network *, double *, double *, double *, double *);
+void getCpuModel(char *, int);
+int getNumProcessors(void);
+double getWallTime(void);
+
+#endif
@@ -0,0 +1,17 @@
+/**
+ * Created 10/18/2026
+ * This file contains the header files for the convolution layer.
+ * More specific documentation can be found in the source file.
+ */
+
+#ifndef convolution_h
+#define convolution_h
+
+#include "./networkInternals.h"
+
+int setUpConvolution(Network *);
+int findInputShape(Network *);
+void runConvolution(const Network *, NetworkScratch *, double *, double *);
+void addConvolutionGradients(const Network *, NetworkScratch *, double, double *);
+
+#endif
@@ -14,5 +14,6 @@ int *readBitmap(char *, char *);
 void writePelsToTextFile(unsigned int *, int, char *);
 void writeBitmap(char *, char *, char *);
 void writeBitmapHelper(char *, unsigned int *, int, BITMAPFILEHEADER, BITMAPINFOHEADER);
+unsigned int *loadBitmap(char *, BITMAPFILEHEADER *, BITMAPINFOHEADER *);
 
 #endif
\ No newline at end of file
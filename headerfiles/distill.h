@@ -0,0 +1,17 @@
+/**
+ * Created 10/18/2026
+ * This file contains the header files for distilling a network.
+ * More specific documentation can be found in the source file.
+ */
+
+#ifndef distill_h
+#define distill_h
+
+#include "./network.h"
+
+int runDistillation(void);
+int distillNetwork(Network *, Network *);
+double findErrorOnSets(Network *, Network *);
+int countWeights(const Network *);
+
+#endif
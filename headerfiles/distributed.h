@@ -0,0 +1,19 @@
+/**
+ * Created 10/18/2026
+ * This file contains the header files for distributed training functions.
+ * More specific documentation can be found in the source file.
+ */
+
+#ifndef distributed_h
+#define distributed_h
+
+#include "./network.h"
+
+struct DistributedGroup; // a worker's place in the ring (laid out in the source file)
+
+int runCoordinator(int, int);
+int runWorker(char *, int);
+void trainDistributedEpoch(Network *);
+void ringAllReduce(struct DistributedGroup *, double *, int);
+
+#endif
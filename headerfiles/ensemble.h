@@ -0,0 +1,18 @@
+/**
+ * Created 10/18/2026
+ * This file contains the header files for running several trained networks
+ * over the same training sets at once.
+ * More specific documentation can be found in the source file.
+ */
+
+#ifndef ensemble_h
+#define ensemble_h
+
+#include "./network.h"
+
+typedef struct Ensemble Ensemble;
+
+int runEnsemble(void);
+int ensembleAll(Network *, int, char **);
+
+#endif
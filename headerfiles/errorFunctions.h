@@ -9,5 +9,6 @@
 #define errorFunctions_h
 
 double quadraticLoss(double[], double[], int);
+double crossEntropyLoss(double[], double[], int);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,15 @@
+/**
+ * Created 10/18/2026
+ * This file contains the header files for baking a network into C source.
+ * More specific documentation can be found in the source file.
+ */
+
+#ifndef export_h
+#define export_h
+
+#include "./network.h"
+
+int runExport(void);
+int exportNetwork(const Network *, char *);
+
+#endif
@@ -0,0 +1,20 @@
+/**
+ * Created 10/18/2026
+ * This file contains the header files for freezing layers of a network for fine-tuning.
+ * More specific documentation can be found in the source file.
+ */
+
+#ifndef freeze_h
+#define freeze_h
+
+#include "./network.h"
+
+typedef struct FrozenCache FrozenCache;
+
+void findFrozenBoundary(Network *);
+int findFrozenLayerSize(const Network *);
+void cacheFrozenActivations(Network *);
+void freeFrozenActivations(Network *);
+void runFromFrozenBoundary(const Network *, NetworkScratch *, int);
+
+#endif
@@ -0,0 +1,39 @@
+/**
+ * Created 10/18/2026
+ * This file contains the header files for the logger, along with the
+ * layout of the status page that it keeps in a memory-mapped file.
+ * More specific documentation can be found in the source file.
+ */
+
+#ifndef logger_h
+#define logger_h
+
+#define STATUS_PAGE_MAGIC "NNSTAT01" // marks the start of a status page (and its version)
+
+/**
+ * The status page of a training run, for other processes to map and read.
+ * The sequence number is odd while the page is being updated; a reader
+ * should read it, copy the page, and read it again, starting over if it
+ * was odd or changed in between.
+ */
+struct StatusPage
+{
+   char magic[8];
+   volatile unsigned int sequence;
+   int iteration;         // iterations of training done
+   double error;          // error after the latest iteration
+   double learningFactor; // lambda after the latest iteration
+   double setsPerSecond;  // training sets trained on per second, since the last update
+   double updatedAt;      // when the page was last updated (seconds since the unix epoch)
+};
+
+typedef struct Logger Logger;
+
+Logger *createLogger(int, char *);
+void freeLogger(Logger *);
+void flushLogger(Logger *);
+void logIteration(Logger *, int, double, double, int, char);
+void logTrainingSet(Logger *, double *, int, double *, double *, int);
+void logText(Logger *, const char *, ...);
+
+#endif
@@ -0,0 +1,27 @@
+/**
+ * Created 10/18/2026
+ * This file contains the header files for the matrix kernels.
+ * More specific documentation can be found in the source file.
+ */
+
+#ifndef matrixFunctions_h
+#define matrixFunctions_h
+
+void selectMatrixKernels(void);
+char *getMatrixKernelName(void);
+void setMatrixBlockSizes(int, int, int);
+void getMatrixBlockSizes(int *, int *, int *);
+void setMatrixThreads(int);
+int getMatrixThreads(void);
+
+void multiplyMatrices(int, int, int, const double *, int, const double *, int, double *, int);
+void multiplyMatrixVector(int, int, const double *, int, const double *, double *);
+void addOuterProduct(int, int, double, const double *, const double *, double *, int);
+
+void multiplyMatricesFloat(int, int, int, const float *, int, const float *, int, float *, int);
+void multiplyMatrixVectorFloat(int, int, const float *, int, const float *, float *);
+void addOuterProductFloat(int, int, float, const float *, const float *, float *, int);
+
+void multiplySparseMatrixVector(int, const int *, const int *, const double *, const double *, double *);
+
+#endif
@@ -0,0 +1,16 @@
+/**
+ * Created 10/18/2026
+ * This file contains the header files for planning the memory a network needs.
+ * More specific documentation can be found in the source file.
+ */
+
+#ifndef memoryPlanner_h
+#define memoryPlanner_h
+
+#include "./network.h"
+
+int planMemory(Network *);
+unsigned long long getAvailableMemory(void);
+void trainStreamedEpoch(Network *);
+
+#endif
@@ -0,0 +1,43 @@
+/**
+ * Created 10/18/2026
+ * This file contains the header files for the network library.
+ * A Network is an opaque handle to a whole model (created from a config),
+ * and a NetworkScratch holds the buffers a single forward/backward pass
+ * writes to. Any number of threads can run the same Network at once as
+ * long as each thread uses its own NetworkScratch and nothing is training it.
+ * More specific documentation can be found in the source file.
+ */
+
+#ifndef network_h
+#define network_h
+
+#define MAX_FILE_NAME_LENGTH 2048 // max characters in a file name
+
+typedef struct Network Network;
+typedef struct NetworkScratch NetworkScratch;
+
+// functions that create and free networks
+Network *createNetwork(char *);
+void freeNetwork(Network *);
+NetworkScratch *createScratch(const Network *);
+void freeScratch(NetworkScratch *);
+
+// functions that handle weight i/o
+int initializeWeightsFromFile(Network *, char *);
+void initializeWeightsRandomly(Network *, double, double);
+int writeWeightsToFile(const Network *, char *);
+
+// functions that save/restore the whole state of training
+int saveCheckpoint(const Network *, char *);
+int loadCheckpoint(Network *, char *);
+
+// functions that describe the network
+int getNumInputNodes(const Network *);
+int getNumOutputNodes(const Network *);
+
+// functions that run/train the network
+void runNetwork(const Network *, NetworkScratch *, double *, double *);
+void runForAllTrainingSets(Network *); // does not train
+void train(Network *, int, double);
+
+#endif
@@ -0,0 +1,281 @@
+/**
+ * Created 10/18/2026
+ * This file contains the layout of a Network and a NetworkScratch, along
+ * with the header files for network functions that are only shared between
+ * the files of this project (such as ./distributed.c and ./main.c).
+ * Code outside of this project should only need ./network.h.
+ */
+
+#ifndef networkInternals_h
+#define networkInternals_h
+
+#include <stdio.h>
+
+#include "./network.h"
+
+#define UNSIGNED_INT_SCALER 4294967295.0 // used for scaling the pels to [0,1]
+#define DATA_ALIGNMENT 64               // byte alignment of every training set's inputs
+
+/**
+ * The buffers that a single pass through the network writes to.
+ * Nodes, thetas, and psis are stored one layer after another,
+ * maxNodesInALayer values per layer; the input layer's slots in
+ * nodes are unused, since it is read straight from the inputs.
+ */
+struct NetworkScratch
+{
+   double *nodes;
+   double *thetas;
+   double *psis;
+   double *inputs;          // the values of the input layer in the last run (the caller's inputs, or the
+                            // convolution layer's outputs in the input layer's slots of nodes)
+   double *expectedOutputs; // the expected outputs for the last run (set by the caller, not copied)
+   double error;            // the error of the last run (only found if expectedOutputs is set)
+
+   // buffers of the convolution layer (NULL without one, see ./convolution.c)
+   double *convColumns; // every square the filters cover, one per row
+   double *convThetas;  // every filter at every position, filter by filter within a position
+   double *convPsis;    // laid out like convThetas
+   int *poolIndices;    // where in convThetas each pool's maximum was
+};
+
+/**
+ * A layer of weights after pruning (see ./pruning.c). The weights that are
+ * left are kept in compressed sparse row form, with one row per node of the
+ * destination layer, so that the layer's thetas can be found from the nodes
+ * of the source layer with multiplySparseMatrixVector. The mask is in the
+ * same kj order as the dense weights and marks which weights were kept.
+ */
+struct SparseLayer
+{
+   int numNonZero;
+   int *rowStarts;        // numDest + 1 values
+   int *columns;          // the source node of every value
+   double *values;        // the kept weights, destination node by destination node
+   unsigned char *mask;   // 1 for every kept weight, numSource * numDest values
+   double sparsity;       // the fraction of the layer's weights that were pruned
+   char useSparseKernel;  // whether runNetwork uses values instead of the dense weights
+};
+
+/**
+ * Everything that describes a network: its structure, its weights,
+ * the options read from its config, its training sets, and the
+ * state of its training.
+ */
+struct Network
+{
+   // values that describe the structure of the network
+   int numLayers;
+   int numHiddenLayers;
+   int numInputNodes;
+   int *layerDimensions;
+   int numOutputNodes;
+
+   // values that describe the convolution layer in front of the input layer (see ./convolution.c)
+   int convFilters;    // number of filters (0 for no convolution layer)
+   int convFilterSize; // width and height of every filter
+   int convStride;     // how far the filters move at a time
+   int poolSize;       // width and height of the squares that are max pooled
+   int inputWidth;     // width, height, and number of channels of the inputs
+   int inputHeight;
+   int inputChannels;
+
+   // calculated values related to the structure of the network
+   int totalWeights;
+   int maxNodesInALayer;
+   int maxWeightsInALayer;
+   int convWidth;         // width and height of each filter's outputs
+   int convHeight;
+   int poolWidth;         // width and height of each filter's pooled outputs
+   int poolHeight;
+   int convWeightsOffset; // where the filters start in weights (after every dense layer)
+
+   double *weights; // stored in mkj order, followed by the convolution filters
+
+   // values related to reducing the inputs before the input layer (see ./projection.c)
+   char inputReduction;                       // p for PCA, r for a random projection (0 for none)
+   int numReducedInputs;                      // the number of values the inputs are reduced to
+   char projectionFile[MAX_FILE_NAME_LENGTH]; // where the projection is cached
+   double *projection;                        // numInputNodes by numReducedInputs (NULL for none)
+   double *projectionOffsets;                 // what projecting the mean of the inputs gives
+   double *reducedTrainingInputs;             // numReducedInputs values per training set (NULL if not loaded)
+
+   // file paths for i/o files
+   char weightsFileInput[MAX_FILE_NAME_LENGTH];
+   char weightsFileOutput[MAX_FILE_NAME_LENGTH];
+   char nodesFileInput[MAX_FILE_NAME_LENGTH];
+   char nodesFileOutput[MAX_FILE_NAME_LENGTH];
+
+   char useBitmap;
+   char bitmapFileInput[MAX_FILE_NAME_LENGTH];
+   char bitmapFileOutput[MAX_FILE_NAME_LENGTH];
+
+   char useRandomWeights;
+
+   // options read from the config
+   char trainNetwork;          // whether or not to train (Y for yes, anything else for no)
+   char printNetworkSpecifics; // whether or not to print the specific values of the network
+   char printDebugMessages;    // whether or not to print debug messages
+   char enableWeightRollback;  // whether or not to enable weight rollback
+
+   char autoTune;                         // whether or not to tune the matrix kernels for this network
+   char tuningFile[MAX_FILE_NAME_LENGTH]; // where tuned settings are cached
+
+   // the training sets, with each set's inputs and expected outputs stored apart
+   double *trainingInputs; // inputStride values per set, aligned (NULL if streamed)
+   double *trainingLabels; // numOutputNodes values per set
+   int inputStride;        // numInputNodes rounded up to a whole aligned block
+   int numTrainingSets;    // number of training sets held by this process
+   int totalTrainingSets;  // number of training sets in the whole file
+
+   // values related to sharding the training sets between distributed workers
+   int shardIndex; // which shard of the training sets this process holds
+   int numShards;  // how many shards the training sets are split into
+
+   // values related to training
+   double error;                // current error of network (set to some initial config value)
+   double learningFactor;       // current lambda value
+   double learningFactorScaler; // lambda scaler
+
+   double minLearningFactor; // lower bound for lambda value
+   double maxLearningFactor; // upper bound for lambda value
+
+   int dumpEveryIterations; // dump weights/outputs every _x_ iterations
+
+   int maxIterations;  // max number of iterations before stopping
+   double targetError; // training stops when error reaches this value
+
+   int iteration;                  // training cycles done so far (carried over by checkpoints)
+   unsigned long long randomState; // state of the random number generator (see randomNumber)
+   unsigned long long randomSeed;  // the random_seed setting
+   char fixedSeed;                 // whether random_seed was set (otherwise weights are seeded with the time)
+   char weightInitialization;      // how random weights are bounded: u(niform), x(avier), or h(e)
+
+   // values related to checkpoints of training
+   char checkpointFile[MAX_FILE_NAME_LENGTH]; // where checkpoints are saved (empty to never save them)
+   int checkpointEveryIterations;             // save a checkpoint every _x_ iterations
+   char resume;                               // whether or not to resume from the checkpoint
+
+   // values related to augmenting the training sets while training (see ./augment.c)
+   int augmentCopies;           // augmented copies of every training set trained on each cycle (0 for none)
+   int augmentThreads;          // threads that make the augmented copies
+   int augmentShift;            // most pels the copies are shifted by each way
+   char augmentFlip;            // whether or not copies may be flipped left to right
+   double augmentBrightness;    // most the brightness of the copies changes by
+   double augmentNoise;         // most noise added to every pel of the copies
+   unsigned long long augmentSeed; // the copies' random choices are made from (kept in checkpoints)
+   struct Augmenter *augmenter; // makes the copies (NULL if there are none)
+
+   // values related to scanning a large bitmap with the network (see ./slidingWindow.c)
+   int scanStride;    // how far the window moves at a time
+   int scanThreads;   // threads that run the windows
+   int scanBatchSize; // windows run through each layer at once
+   int scanOutput;    // the output node whose value is the window's score
+
+   // values related to predicting every training set's outputs (see ./predict.c)
+   char predictionsFile[MAX_FILE_NAME_LENGTH];   // where every set's outputs are written
+   char predictionsFormat;                       // b for binary, c for CSV
+   char predictionBitmaps[MAX_FILE_NAME_LENGTH]; // the start of the name of every set's bitmap (empty for none)
+   int predictionThreads;                        // threads that write the bitmaps
+
+   char exportName[MAX_FILE_NAME_LENGTH]; // what the names in a baked network's source start with (see ./export.c)
+
+   // values related to training with the layers split between threads (see ./pipeline.c)
+   int pipelineStages;        // threads the connectivity layers are split between (0 or 1 to not split them)
+   int pipelineBatchSize;     // training sets run with the same weights before they are changed
+   struct Pipeline *pipeline; // the stages' threads and queues (NULL without a pipeline)
+
+   // values related to validating the network while it trains (see ./validation.c)
+   double validationFraction;     // fraction of the training sets held back for validation (0 for none)
+   int numValidationSets;         // sets held back, stored right after the training sets
+   int validationEvery;           // cycles between snapshots of the weights that are validated
+   int validationPatience;        // training stops once the best snapshot is this many cycles old
+   struct Validator *validator;   // validates the snapshots on its own thread (NULL without validation)
+
+   // values related to freezing layers for fine-tuning (see ./freeze.c)
+   char *frozenLayers;                         // Y for every connectivity layer that is not trained (numLayers - 1 long)
+   char freezeConvolution;                     // Y if the convolution filters are not trained
+   int frozenBoundary;                         // frozen connectivity layers at the front (psis are only found after them)
+   char freezeCacheFile[MAX_FILE_NAME_LENGTH]; // where the boundary layer's values are mapped from (in memory if empty)
+   struct FrozenCache *frozenCache;            // the boundary layer's values for every training set (NULL if not cached)
+
+   // values related to training online (see ./online.c)
+   double onlinePublishSeconds; // seconds between versions of the weights being published
+   int onlineKeepVersions;      // versions of the weights kept on disk
+
+   // values related to planning the memory the network needs (see ./memoryPlanner.c)
+   double memoryBudget;     // megabytes the network may use (0 for the memory that is available)
+   char streamTrainingSets; // Y if training reads the training sets a chunk at a time instead of holding them
+   int streamChunkSets;     // training sets in each chunk when they are streamed
+
+   // values related to pruning the weights (see ./pruning.c)
+   double pruneFraction;        // fraction of every layer's weights to prune (0 to never prune)
+   int pruneSteps;              // prune in this many steps, fine-tuning after each one
+   int pruneFineTuneIterations; // training cycles done after each step
+   double sparseThreshold;      // layers at least this sparse are run with the sparse kernel
+   struct SparseLayer *sparseLayers; // one per layer of weights (NULL until pruned)
+   char useSparseKernels;            // whether runNetwork may use the sparse layers (off while training)
+
+   NetworkScratch *scratch; // buffers used while training and running the training sets
+
+   /**
+    * The error function used for this network (see ./errorFunctions.c).
+    * Cross-entropy is always paired with a softmax output layer.
+    */
+   double (*errorFunction)(double[], double[], int);
+   char useSoftmax; // whether the output layer is a softmax instead of the output function
+
+   /**
+    * The function that trains the network once over all of its
+    * training sets. It is swapped out for the distributed version
+    * (see ./distributed.c) when the network belongs to a worker.
+    */
+   void (*epochFunction)(Network *);
+
+   struct DistributedGroup *group; // the worker's connections (NULL unless distributed)
+
+   struct Logger *logger;                 // prints debug output off of the training thread (NULL if nothing is printed)
+   char statusFile[MAX_FILE_NAME_LENGTH]; // where the logger keeps a status page (empty for none)
+};
+
+// the functions the nodes are run through (see ./network.c)
+extern double (*outputFunction)(double);
+extern double (*outputDerivFunction)(double);
+extern double (*activationFunction)(double);
+
+// functions that handle utility tasks like i/o and mem allocation
+Network *createNetworkShard(char *, int, int);
+int parseConfig(Network *, char *);
+void parseOptionalSetting(Network *, char *, char *);
+int takeTrainingSetsInputs(Network *);
+int readTrainingSet(Network *, FILE *, double *, double *);
+void calculateShardBounds(Network *, int *, int *);
+double randomNumber(Network *, double, double);
+double randomNumberAt(unsigned long long, unsigned long long, double, double);
+void *fillRandomWeights(void *);
+void *allocateAligned(size_t);
+void freeAligned(void *);
+void writeOutputsToFile(Network *);
+void calculateNumNodesAndWeights(Network *);
+int findNumUsedWeights(const Network *);
+void packWeights(const Network *, const double *, double *);
+void unpackWeights(const Network *, const double *, double *);
+
+// functions for printing and debugging
+void printWeights(const Network *);
+
+// functions that run/train the network
+void updateWeights(Network *, double *);
+double *prepareInputLayer(const Network *, NetworkScratch *, double *);
+void runFromInputLayer(const Network *, NetworkScratch *, double *, double *);
+void runConnectivityLayer(const Network *, NetworkScratch *, int);
+void finishOutputLayer(const Network *, NetworkScratch *, double *);
+void runTrainingSet(Network *, int);
+void calculatePsis(const Network *, NetworkScratch *, double *);
+void calculateOutputPsis(const Network *, NetworkScratch *, double *);
+void calculateLayerPsis(const Network *, NetworkScratch *, int);
+double calculateGradients(Network *, int, int, double *); // does not change the weights
+char adaptLearningFactor(Network *, double, double *);
+void trainForAllTrainingSets(Network *); // helper function
+
+#endif
@@ -0,0 +1,15 @@
+/**
+ * Created 10/18/2026
+ * This file contains the header files for training a network online.
+ * More specific documentation can be found in the source file.
+ */
+
+#ifndef online_h
+#define online_h
+
+#include "./network.h"
+
+int runOnline(int, char *[]);
+int loadNewestSnapshot(Network *, char *, int *);
+
+#endif
@@ -17,4 +17,6 @@ double tanhDeriv(double);
 double relu(double);
 double reluDeriv(double);
 
+void softmax(double[], int);
+
 #endif
\ No newline at end of file
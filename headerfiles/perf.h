@@ -0,0 +1,14 @@
+/**
+ * Created 10/18/2026
+ * This file contains the header files for checking the shipped workloads against a baseline.
+ * More specific documentation can be found in the source file.
+ */
+
+#ifndef perf_h
+#define perf_h
+
+#include "./network.h"
+
+int runPerf(int, char *[]);
+
+#endif
@@ -0,0 +1,21 @@
+/**
+ * Created 10/18/2026
+ * This file contains the header files for training a network with its
+ * layers split between threads.
+ * More specific documentation can be found in the source file.
+ */
+
+#ifndef pipeline_h
+#define pipeline_h
+
+#include "./network.h"
+
+typedef struct Pipeline Pipeline;
+typedef struct PipelineStage PipelineStage;
+typedef struct PipelineQueue PipelineQueue;
+
+Pipeline *createPipeline(const Network *);
+void freePipeline(Pipeline *);
+void trainPipelinedEpoch(Network *);
+
+#endif
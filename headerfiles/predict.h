@@ -0,0 +1,35 @@
+/**
+ * Created 10/18/2026
+ * This file contains the header files for bulk prediction, along with the
+ * layout of the header of a binary predictions file.
+ * More specific documentation can be found in the source file.
+ */
+
+#ifndef predict_h
+#define predict_h
+
+#include "./network.h"
+
+#define PREDICTIONS_MAGIC "NNPRED01" // marks the start of a binary predictions file (and its version)
+
+/**
+ * The start of a binary predictions file. It is followed by numSets rows
+ * of numOutputs doubles, one row per training set in the order of the
+ * training sets file.
+ */
+struct PredictionsHeader
+{
+   char magic[8];
+   int numSets;
+   int numOutputs;
+};
+
+typedef struct Predictions Predictions;
+
+int runPrediction(void);
+int predictAll(Network *);
+Predictions *createPredictionsFile(const Network *, char *, int, int);
+void writePrediction(Predictions *, int, const double *);
+void finishPredictionsFile(Predictions *, int);
+
+#endif
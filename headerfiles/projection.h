@@ -0,0 +1,22 @@
+/**
+ * Created 10/18/2026
+ * This file contains the header files for reducing a network's inputs.
+ * More specific documentation can be found in the source file.
+ */
+
+#ifndef projection_h
+#define projection_h
+
+#include "./network.h"
+
+int setUpInputReduction(Network *);
+int findPrincipalComponents(Network *);
+void makeRandomProjection(Network *);
+void orthonormalizeColumns(double *, int, int);
+void projectInputs(const Network *, const double *, double *);
+int reduceTrainingSets(Network *);
+int loadProjection(Network *, long long, long long);
+int saveProjection(const Network *, long long, long long);
+void freeProjection(Network *);
+
+#endif
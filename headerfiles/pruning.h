@@ -0,0 +1,22 @@
+/**
+ * Created 10/18/2026
+ * This file contains the header files for pruning a network.
+ * More specific documentation can be found in the source file.
+ */
+
+#ifndef pruning_h
+#define pruning_h
+
+#include "./network.h"
+
+void pruneNetwork(Network *);
+void pruneWeights(Network *, double);
+int compareMagnitudes(const void *, const void *);
+int buildSparseLayers(Network *);
+void findSparseLayers(Network *);
+void refreshSparseLayers(Network *);
+void applyPruningMasks(Network *);
+void freeSparseLayers(Network *);
+double timeInference(Network *, char);
+
+#endif
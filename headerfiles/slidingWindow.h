@@ -0,0 +1,18 @@
+/**
+ * Created 10/18/2026
+ * This file contains the header files for scanning a bitmap with a network.
+ * More specific documentation can be found in the source file.
+ */
+
+#ifndef slidingWindow_h
+#define slidingWindow_h
+
+#include "./network.h"
+
+typedef struct Scan Scan;
+typedef struct ScanBuffers ScanBuffers;
+
+int runScan(void);
+int scanBitmap(Network *, char *, char *);
+
+#endif
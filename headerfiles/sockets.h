@@ -0,0 +1,35 @@
+/**
+ * Created 10/18/2026
+ * This file contains the header files for the TCP helpers shared by
+ * distributed and online training, along with what makes sockets look the
+ * same on every platform. It has to be included before windows.h.
+ * More specific documentation can be found in ./distributed.c.
+ */
+
+#ifndef sockets_h
+#define sockets_h
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+
+typedef int SOCKET;
+#define INVALID_SOCKET (-1)
+#define closesocket close
+#endif
+
+void initializeSockets(void);
+SOCKET openListeningSocket(int);
+SOCKET connectToHost(char *, int);
+int sendAll(SOCKET, void *, size_t);
+int receiveAll(SOCKET, void *, size_t);
+
+#endif
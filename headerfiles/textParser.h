@@ -0,0 +1,38 @@
+/**
+ * Created 10/18/2026
+ * This file contains the header files for the text parser, along with the
+ * layout that tells it where to store the values it parses.
+ * More specific documentation can be found in the source file.
+ */
+
+#ifndef textParser_h
+#define textParser_h
+
+/**
+ * Where the values of a text file go. The values are taken to be rows of
+ * rowLength values (such as the inputs and expected outputs of a training
+ * set); the first splitAt values of row r go in first, firstStride values
+ * apart from row to row, and the rest go in second, secondStride apart.
+ */
+typedef struct TextLayout
+{
+   int rowLength;
+   int splitAt;
+   double *first;
+   long long firstStride;
+   double *second;
+   long long secondStride;
+
+   char hex;         // Y if the values are hex (read into an unsigned int, as %x does), otherwise decimals
+   double hexScaler; // what hex values are divided by
+} TextLayout;
+
+typedef struct TextFile TextFile;
+typedef struct TextChunk TextChunk;
+
+TextFile *openTextFile(char *);
+void closeTextFile(TextFile *);
+int readFirstHexValue(const TextFile *, unsigned int *);
+long long parseTextValues(const TextFile *, long long, long long, const TextLayout *);
+
+#endif
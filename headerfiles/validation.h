@@ -0,0 +1,22 @@
+/**
+ * Created 10/18/2026
+ * This file contains the header files for validating a network while it trains.
+ * More specific documentation can be found in the source file.
+ */
+
+#ifndef validation_h
+#define validation_h
+
+#include "./network.h"
+
+typedef struct Validator Validator;
+
+void splitValidationSets(Network *);
+Validator *createValidator(const Network *);
+void freeValidator(Validator *);
+void startValidation(Validator *);
+void submitSnapshot(Validator *, const Network *);
+char checkValidation(Validator *, const Network *);
+void finishValidation(Validator *, Network *);
+
+#endif
@@ -0,0 +1,620 @@
+/**
+ * Created 10/18/2026
+ * This file holds a logger that keeps printing off of the training thread.
+ *
+ * The training thread (the only producer) copies each log record into a
+ * lock-free ring buffer and moves on; a background thread (the only consumer)
+ * drains the ring, formats the records, and writes them to stdout. If the ring
+ * is full, the producer waits for room instead of dropping records.
+ *
+ * The drain thread can also keep a status page (see ./headerfiles/logger.h)
+ * in a memory-mapped file up to date with the iteration, error, lambda, and
+ * throughput of training, which other processes can read at any time.
+ *
+ * Every logging function also takes a NULL logger, in which case it prints
+ * straight away on the calling thread.
+ *
+ * Functions in this file:
+ *
+ * Logger *createLogger(int maxRecordValues, char *statusFile)
+ * void freeLogger(Logger *logger)
+ * void flushLogger(Logger *logger)
+ * void logIteration(Logger *logger, int iteration, double error, double learningFactor, int numTrainingSets, char print)
+ * void logTrainingSet(Logger *logger, double *inputs, int numInputs, double *expectedOutputs, double *outputs, int numOutputs)
+ * void logText(Logger *logger, const char *format, ...)
+ *
+ * void pushRecord(Logger *logger, struct LogRecord *record, const void *parts[], int partLengths[], int numParts)
+ * void copyFromRing(Logger *logger, size_t position, void *destination, size_t length)
+ * void *drainLogger(void *arg)
+ * void updateStatusPage(Logger *logger, struct LogRecord *record, double *values)
+ * void printIteration(int iteration, double error, double learningFactor)
+ * void printTrainingSet(double *inputs, int numInputs, double *expectedOutputs, double *outputs, int numOutputs)
+ * int mapStatusPage(Logger *logger, char *statusFile)
+ * void unmapStatusPage(Logger *logger)
+ * void waitBriefly(void)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#include "./headerfiles/logger.h"
+#include "./headerfiles/autoTune.h" // importing getWallTime
+
+#define MIN_RING_CAPACITY (1 << 20) // bytes in the smallest ring buffer
+#define MAX_LOG_TEXT_LENGTH 1024    // longest message logText can log
+
+enum LogRecordType
+{
+   ITERATION_RECORD,    // values: iteration, numTrainingSets, print; then error, lambda, and the time as doubles
+   TRAINING_SET_RECORD, // values: numInputs, numOutputs; then the inputs, expected outputs, and outputs as doubles
+   TEXT_RECORD          // the text (with its terminating null)
+};
+
+/**
+ * The start of every record in the ring. Its payload follows it,
+ * padded so that the next record starts on a multiple of 8 bytes.
+ */
+struct LogRecord
+{
+   int type;
+   int length; // bytes in the payload (before padding)
+   int values[4];
+};
+
+struct Logger
+{
+   unsigned char *ring;
+   size_t capacity; // bytes in the ring (a power of 2)
+
+   atomic_size_t head; // total bytes written (only moved by the producer)
+   atomic_size_t tail; // total bytes read (only moved by the consumer)
+   atomic_int stopping;
+
+   pthread_t thread;
+   unsigned char *payload; // where the consumer copies each payload to (as large as the largest record)
+
+   struct StatusPage *status; // NULL if there is no status page
+   double lastStatusTime;     // time and iteration of the last status update (for the throughput)
+   int lastStatusIteration;
+
+#ifdef _WIN32
+   HANDLE statusFileHandle;
+   HANDLE statusMapping;
+#else
+   int statusFileDescriptor;
+#endif
+};
+
+// function headers ----------------------
+
+void pushRecord(Logger *, struct LogRecord *, const void *[], int[], int);
+void copyFromRing(Logger *, size_t, void *, size_t);
+void *drainLogger(void *);
+void updateStatusPage(Logger *, struct LogRecord *, double *);
+void printIteration(int, double, double);
+void printTrainingSet(double *, int, double *, double *, int);
+int mapStatusPage(Logger *, char *);
+void unmapStatusPage(Logger *);
+void waitBriefly(void);
+
+// functions ----------------------
+
+/**
+ * Creates a logger and starts its drain thread.
+ *
+ * @param maxRecordValues the most doubles a single record will hold
+ *                        (the inputs and twice the outputs of a training set)
+ * @param statusFile the path of the status page to keep (NULL or empty for none)
+ * @return the new logger, or NULL if it could not be created
+ */
+Logger *createLogger(int maxRecordValues, char *statusFile)
+{
+   Logger *logger = calloc(1, sizeof(Logger));
+   if (logger == NULL)
+   {
+      return NULL;
+   }
+
+   size_t maxRecordLength = sizeof(struct LogRecord) + (size_t)maxRecordValues * sizeof(double) + MAX_LOG_TEXT_LENGTH;
+
+   logger->capacity = MIN_RING_CAPACITY;
+   while (logger->capacity < 4 * maxRecordLength)
+   {
+      logger->capacity *= 2;
+   }
+
+   logger->ring = malloc(logger->capacity);
+   logger->payload = malloc(maxRecordLength);
+   atomic_init(&logger->head, 0);
+   atomic_init(&logger->tail, 0);
+   atomic_init(&logger->stopping, 0);
+
+   if (logger->ring == NULL || logger->payload == NULL)
+   {
+      printf("There was an error allocating memory for the logger.\n");
+      free(logger->ring);
+      free(logger->payload);
+      free(logger);
+      return NULL;
+   }
+
+   if (statusFile != NULL && statusFile[0] != '\0' && mapStatusPage(logger, statusFile) != 0)
+   {
+      printf("Could not map the status page %s.\n", statusFile);
+   }
+
+   if (pthread_create(&logger->thread, NULL, &drainLogger, logger) != 0)
+   {
+      printf("There was an error starting the logger thread.\n");
+      unmapStatusPage(logger);
+      free(logger->ring);
+      free(logger->payload);
+      free(logger);
+      return NULL;
+   }
+
+   return logger;
+}
+
+/**
+ * Writes out everything left in a logger, then stops its thread and frees it.
+ *
+ * @param logger the logger to free (NULL does nothing)
+ */
+void freeLogger(Logger *logger)
+{
+   if (logger == NULL)
+   {
+      return;
+   }
+
+   atomic_store_explicit(&logger->stopping, 1, memory_order_release);
+   pthread_join(logger->thread, NULL);
+
+   unmapStatusPage(logger);
+   free(logger->ring);
+   free(logger->payload);
+   free(logger);
+
+   return;
+}
+
+/**
+ * Waits until everything logged so far has been written, so that
+ * the caller can print directly without its output jumping the queue.
+ *
+ * @param logger the logger to flush (NULL does nothing)
+ */
+void flushLogger(Logger *logger)
+{
+   if (logger == NULL)
+   {
+      return;
+   }
+
+   while (atomic_load_explicit(&logger->tail, memory_order_acquire) !=
+          atomic_load_explicit(&logger->head, memory_order_relaxed))
+   {
+      waitBriefly();
+   }
+
+   return;
+}
+
+/**
+ * Logs the progress of a training iteration, which updates the status page
+ * (if there is one) and is printed as a debug message if asked to.
+ *
+ * @param logger the logger to use (NULL to print straight away)
+ * @param iteration the number of iterations done
+ * @param error the error after the iteration
+ * @param learningFactor the lambda after the iteration
+ * @param numTrainingSets the number of training sets in each iteration
+ * @param print whether or not to print a debug message
+ */
+void logIteration(Logger *logger, int iteration, double error, double learningFactor, int numTrainingSets, char print)
+{
+   if (logger == NULL)
+   {
+      if (print)
+      {
+         printIteration(iteration, error, learningFactor);
+      }
+      return;
+   }
+
+   double values[3] = {error, learningFactor, getWallTime()};
+   struct LogRecord record = {ITERATION_RECORD, sizeof(values), {iteration, numTrainingSets, print, 0}};
+   const void *parts[1] = {values};
+   int partLengths[1] = {sizeof(values)};
+
+   pushRecord(logger, &record, parts, partLengths, 1);
+
+   return;
+}
+
+/**
+ * Logs the inputs, expected outputs, and actual outputs of a training set.
+ * They are copied, so the caller can reuse its buffers straight away.
+ *
+ * @param logger the logger to use (NULL to print straight away)
+ * @param inputs the inputs of the training set
+ * @param numInputs the number of inputs
+ * @param expectedOutputs the expected outputs of the training set
+ * @param outputs the outputs the network produced
+ * @param numOutputs the number of outputs
+ */
+void logTrainingSet(Logger *logger, double *inputs, int numInputs, double *expectedOutputs, double *outputs, int numOutputs)
+{
+   if (logger == NULL)
+   {
+      printTrainingSet(inputs, numInputs, expectedOutputs, outputs, numOutputs);
+      return;
+   }
+
+   int inputsLength = numInputs * sizeof(double);
+   int outputsLength = numOutputs * sizeof(double);
+   struct LogRecord record = {TRAINING_SET_RECORD, inputsLength + 2 * outputsLength, {numInputs, numOutputs, 0, 0}};
+   const void *parts[3] = {inputs, expectedOutputs, outputs};
+   int partLengths[3] = {inputsLength, outputsLength, outputsLength};
+
+   pushRecord(logger, &record, parts, partLengths, 3);
+
+   return;
+}
+
+/**
+ * Logs a message, formatted like printf (on the calling thread, so this
+ * is meant for occasional messages rather than ones in a hot loop).
+ *
+ * @param logger the logger to use (NULL to print straight away)
+ * @param format the printf format of the message
+ */
+void logText(Logger *logger, const char *format, ...)
+{
+   char text[MAX_LOG_TEXT_LENGTH];
+   va_list arguments;
+
+   va_start(arguments, format);
+   vsnprintf(text, MAX_LOG_TEXT_LENGTH, format, arguments);
+   va_end(arguments);
+
+   if (logger == NULL)
+   {
+      fputs(text, stdout);
+      return;
+   }
+
+   struct LogRecord record = {TEXT_RECORD, strlen(text) + 1, {0, 0, 0, 0}};
+   const void *parts[1] = {text};
+   int partLengths[1] = {record.length};
+
+   pushRecord(logger, &record, parts, partLengths, 1);
+
+   return;
+}
+
+/**
+ * Copies a record into the ring, waiting for room if the ring is full.
+ * Only the one producer thread may call this.
+ *
+ * @param logger the logger to push to
+ * @param record the start of the record (its length must be the sum of the parts)
+ * @param parts the pieces of the payload, in order
+ * @param partLengths the number of bytes in each piece
+ * @param numParts the number of pieces
+ */
+void pushRecord(Logger *logger, struct LogRecord *record, const void *parts[], int partLengths[], int numParts)
+{
+   size_t recordLength = (sizeof(struct LogRecord) + record->length + 7) & ~(size_t)7;
+   size_t head = atomic_load_explicit(&logger->head, memory_order_relaxed);
+
+   while (head + recordLength - atomic_load_explicit(&logger->tail, memory_order_acquire) > logger->capacity)
+   {
+      waitBriefly(); // the ring is full, so waiting for the drain thread to catch up
+   }
+
+   // copying the record in, wrapping around the end of the ring where needed
+   const void *pieces[5];
+   size_t pieceLengths[5];
+   pieces[0] = record;
+   pieceLengths[0] = sizeof(struct LogRecord);
+   for (int p = 0; p < numParts && p < 4; p++)
+   {
+      pieces[p + 1] = parts[p];
+      pieceLengths[p + 1] = partLengths[p];
+   }
+
+   size_t position = head;
+   for (int p = 0; p <= numParts && p < 5; p++)
+   {
+      size_t offset = position & (logger->capacity - 1);
+      size_t firstLength = pieceLengths[p] < logger->capacity - offset ? pieceLengths[p] : logger->capacity - offset;
+
+      memcpy(logger->ring + offset, pieces[p], firstLength);
+      memcpy(logger->ring, (const unsigned char *)pieces[p] + firstLength, pieceLengths[p] - firstLength);
+      position += pieceLengths[p];
+   }
+
+   atomic_store_explicit(&logger->head, head + recordLength, memory_order_release); // publishing the record
+
+   return;
+}
+
+/**
+ * Copies bytes out of the ring, wrapping around its end where needed.
+ *
+ * @param logger the logger whose ring to copy from
+ * @param position the total byte count at which to start copying
+ * @param destination where to copy to
+ * @param length the number of bytes to copy
+ */
+void copyFromRing(Logger *logger, size_t position, void *destination, size_t length)
+{
+   size_t offset = position & (logger->capacity - 1);
+   size_t firstLength = length < logger->capacity - offset ? length : logger->capacity - offset;
+
+   memcpy(destination, logger->ring + offset, firstLength);
+   memcpy((unsigned char *)destination + firstLength, logger->ring, length - firstLength);
+
+   return;
+}
+
+/**
+ * The drain thread: formats and writes every record in the ring, updating
+ * the status page as it goes, until the logger is stopped and the ring is empty.
+ *
+ * @param arg the logger to drain
+ * @return NULL
+ */
+void *drainLogger(void *arg)
+{
+   Logger *logger = arg;
+   size_t tail = atomic_load_explicit(&logger->tail, memory_order_relaxed);
+
+   while (1)
+   {
+      size_t head = atomic_load_explicit(&logger->head, memory_order_acquire);
+
+      if (tail == head)
+      {
+         fflush(stdout);
+         if (atomic_load_explicit(&logger->stopping, memory_order_acquire) &&
+             atomic_load_explicit(&logger->head, memory_order_acquire) == tail)
+         {
+            break;
+         }
+         waitBriefly();
+         continue;
+      }
+
+      while (tail != head)
+      {
+         struct LogRecord record;
+         copyFromRing(logger, tail, &record, sizeof(struct LogRecord));
+         copyFromRing(logger, tail + sizeof(struct LogRecord), logger->payload, record.length);
+
+         double *values = (double *)logger->payload;
+
+         if (record.type == ITERATION_RECORD)
+         {
+            updateStatusPage(logger, &record, values);
+            if (record.values[2])
+            {
+               printIteration(record.values[0], values[0], values[1]);
+            }
+         }
+         else if (record.type == TRAINING_SET_RECORD)
+         {
+            int numInputs = record.values[0];
+            int numOutputs = record.values[1];
+            printTrainingSet(values, numInputs, values + numInputs, values + numInputs + numOutputs, numOutputs);
+         }
+         else if (record.type == TEXT_RECORD)
+         {
+            fputs((char *)logger->payload, stdout);
+         }
+
+         tail += (sizeof(struct LogRecord) + record.length + 7) & ~(size_t)7;
+         atomic_store_explicit(&logger->tail, tail, memory_order_release); // handing the space back to the producer
+      }
+   }
+
+   return NULL;
+}
+
+/**
+ * Updates the status page (if there is one) from an iteration record. The
+ * sequence number is odd while the page is being written, so that readers
+ * can tell when they have read a torn update and should read it again.
+ *
+ * @param logger the logger whose status page to update
+ * @param record the iteration record
+ * @param values the record's error, lambda, and time
+ */
+void updateStatusPage(Logger *logger, struct LogRecord *record, double *values)
+{
+   struct StatusPage *status = logger->status;
+   if (status == NULL)
+   {
+      return;
+   }
+
+   int iteration = record->values[0];
+   double setsPerSecond = status->setsPerSecond;
+   if (logger->lastStatusTime > 0.0 && values[2] > logger->lastStatusTime)
+   {
+      setsPerSecond = (double)(iteration - logger->lastStatusIteration) * record->values[1] /
+                      (values[2] - logger->lastStatusTime);
+   }
+   logger->lastStatusTime = values[2];
+   logger->lastStatusIteration = iteration;
+
+   status->sequence++;
+   atomic_thread_fence(memory_order_release);
+
+   status->iteration = iteration;
+   status->error = values[0];
+   status->learningFactor = values[1];
+   status->setsPerSecond = setsPerSecond;
+   status->updatedAt = (double)time(NULL);
+
+   atomic_thread_fence(memory_order_release);
+   status->sequence++;
+
+   return;
+}
+
+/**
+ * Prints the debug message of a training iteration.
+ *
+ * @param iteration the number of iterations done
+ * @param error the error after the iteration
+ * @param learningFactor the lambda after the iteration
+ */
+void printIteration(int iteration, double error, double learningFactor)
+{
+   printf("DEBUG: iteration %d, error: %.16lf, lambda: %lf\n", iteration, error, learningFactor);
+   return;
+}
+
+/**
+ * Prints the inputs, expected outputs, and actual outputs of a training set.
+ *
+ * @param inputs the inputs of the training set
+ * @param numInputs the number of inputs
+ * @param expectedOutputs the expected outputs of the training set
+ * @param outputs the outputs the network produced
+ * @param numOutputs the number of outputs
+ */
+void printTrainingSet(double *inputs, int numInputs, double *expectedOutputs, double *outputs, int numOutputs)
+{
+   for (int k = 0; k < numInputs; k++)
+   {
+      printf("%lf ", inputs[k]);
+   }
+   printf(" --> (expected ");
+   for (int k = 0; k < numOutputs; k++)
+   {
+      printf(" %lf", expectedOutputs[k]);
+   }
+   printf(") actual: ");
+   for (int k = 0; k < numOutputs; k++)
+   {
+      printf(" %lf", outputs[k]);
+   }
+   printf("\n");
+
+   return;
+}
+
+/**
+ * Creates (or reuses) the status page file and maps it into memory.
+ *
+ * @param logger the logger to keep the status page
+ * @param statusFile the path of the status page
+ * @return 0 if the page was mapped, -1 otherwise
+ */
+int mapStatusPage(Logger *logger, char *statusFile)
+{
+   void *page = NULL;
+
+#ifdef _WIN32
+   logger->statusFileHandle = CreateFileA(statusFile, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                          NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+   if (logger->statusFileHandle == INVALID_HANDLE_VALUE)
+   {
+      return -1;
+   }
+
+   logger->statusMapping = CreateFileMappingA(logger->statusFileHandle, NULL, PAGE_READWRITE, 0, sizeof(struct StatusPage), NULL);
+   if (logger->statusMapping != NULL)
+   {
+      page = MapViewOfFile(logger->statusMapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(struct StatusPage));
+   }
+   if (page == NULL)
+   {
+      if (logger->statusMapping != NULL)
+      {
+         CloseHandle(logger->statusMapping);
+      }
+      CloseHandle(logger->statusFileHandle);
+      return -1;
+   }
+#else
+   logger->statusFileDescriptor = open(statusFile, O_RDWR | O_CREAT, 0644);
+   if (logger->statusFileDescriptor < 0)
+   {
+      return -1;
+   }
+
+   if (ftruncate(logger->statusFileDescriptor, sizeof(struct StatusPage)) == 0)
+   {
+      page = mmap(NULL, sizeof(struct StatusPage), PROT_READ | PROT_WRITE, MAP_SHARED, logger->statusFileDescriptor, 0);
+   }
+   if (page == NULL || page == MAP_FAILED)
+   {
+      close(logger->statusFileDescriptor);
+      return -1;
+   }
+#endif
+
+   logger->status = page;
+   memset(logger->status, 0, sizeof(struct StatusPage));
+   memcpy(logger->status->magic, STATUS_PAGE_MAGIC, sizeof(logger->status->magic));
+
+   return 0;
+}
+
+/**
+ * Unmaps the status page (if there is one). The file is left behind,
+ * holding the last status of training.
+ *
+ * @param logger the logger that keeps the status page
+ */
+void unmapStatusPage(Logger *logger)
+{
+   if (logger->status == NULL)
+   {
+      return;
+   }
+
+#ifdef _WIN32
+   UnmapViewOfFile(logger->status);
+   CloseHandle(logger->statusMapping);
+   CloseHandle(logger->statusFileHandle);
+#else
+   munmap(logger->status, sizeof(struct StatusPage));
+   close(logger->statusFileDescriptor);
+#endif
+
+   logger->status = NULL;
+
+   return;
+}
+
+/**
+ * Sleeps for about a millisecond (used by whichever side of the ring is waiting).
+ */
+void waitBriefly()
+{
+#ifdef _WIN32
+   Sleep(1);
+#else
+   struct timespec pause = {0, 1000000};
+   nanosleep(&pause, NULL);
+#endif
+}
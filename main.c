@@ -0,0 +1,182 @@
+/**
+ * Created 10/18/2026
+ * This file runs a network from the command line, using the
+ * network library in ./network.c.
+ *
+ * Functions in this file:
+ *
+ * int main(int argc, char *argv[])
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "./headerfiles/dibdump.h" // importing dibdump functions
+
+#include "./headerfiles/networkInternals.h" // importing the network layout and functions
+#include "./headerfiles/distributed.h"      // importing distributed training functions
+#include "./headerfiles/pruning.h"          // importing pruning functions
+#include "./headerfiles/distill.h"          // importing distillation
+#include "./headerfiles/slidingWindow.h"    // importing bitmap scanning
+#include "./headerfiles/predict.h"          // importing bulk prediction
+#include "./headerfiles/export.h"           // importing baking networks into C source
+#include "./headerfiles/ensemble.h"         // importing ensemble inference
+#include "./headerfiles/perf.h"             // importing the workloads' baseline checks
+#include "./headerfiles/online.h"           // importing online training
+#include "./headerfiles/augment.h"          // importing the augmenter
+
+/**
+ * The main function makes the actual calls that complete parts
+ * of the process of running a neural network.
+ *
+ * Passing "coordinator <port> <numWorkers>" or "worker <host> <port>"
+ * on the command line runs this process as part of a distributed
+ * training group instead (see ./distributed.c).
+ *
+ * Passing "resume" carries on training from the checkpoint file named in
+ * the config (the same as setting resume to Y in the config).
+ *
+ * Passing "distill" asks for a teacher's and a student's config instead,
+ * and trains the student on the teacher's outputs (see ./distill.c).
+ *
+ * Passing "scan" asks for a config, a bitmap, and a score map file instead,
+ * and runs the network over every window of the bitmap (see ./slidingWindow.c).
+ *
+ * Passing "predict" writes the outputs of every training set to the
+ * predictions file named in the config instead (see ./predict.c).
+ *
+ * Passing "export" asks for a config, a trained weights file, and a C source
+ * file instead, and bakes the network into the source file (see ./export.c).
+ *
+ * Passing "ensemble" asks for a config and several weights files instead,
+ * and runs every one of them over the training sets in a single pass
+ * (see ./ensemble.c).
+ *
+ * Passing "perf <baseline file>" runs the shipped workloads and checks them
+ * against the baseline file (see ./perf.c).
+ *
+ * Passing "online <config file> <source>" keeps the network training on
+ * training sets as they arrive from the source (see ./online.c).
+ *
+ * Passing "config <config file>" uses that config instead of asking for one.
+ */
+int main(int argc, char *argv[])
+{
+   char configFilename[MAX_FILE_NAME_LENGTH];
+
+   if (argc >= 4 && strcmp(argv[1], "coordinator") == 0)
+   {
+      return runCoordinator(atoi(argv[2]), atoi(argv[3]));
+   }
+   if (argc >= 4 && strcmp(argv[1], "worker") == 0)
+   {
+      return runWorker(argv[2], atoi(argv[3]));
+   }
+   if (argc >= 2 && strcmp(argv[1], "distill") == 0)
+   {
+      return runDistillation();
+   }
+   if (argc >= 2 && strcmp(argv[1], "scan") == 0)
+   {
+      return runScan();
+   }
+   if (argc >= 2 && strcmp(argv[1], "predict") == 0)
+   {
+      return runPrediction();
+   }
+   if (argc >= 2 && strcmp(argv[1], "export") == 0)
+   {
+      return runExport();
+   }
+   if (argc >= 2 && strcmp(argv[1], "ensemble") == 0)
+   {
+      return runEnsemble();
+   }
+   if (argc >= 2 && strcmp(argv[1], "perf") == 0)
+   {
+      return runPerf(argc, argv);
+   }
+   if (argc >= 2 && strcmp(argv[1], "online") == 0)
+   {
+      return runOnline(argc, argv);
+   }
+
+   if (argc >= 3 && strcmp(argv[1], "config") == 0)
+   {
+      snprintf(configFilename, MAX_FILE_NAME_LENGTH, "%s", argv[2]);
+   }
+   else
+   {
+      printf("What config file should I use? ");
+      scanf("%s", configFilename);
+   }
+
+   Network *net = createNetwork(configFilename);
+   if (net == NULL)
+   {
+      return 1;
+   }
+
+   if (argc >= 2 && strcmp(argv[1], "resume") == 0 && net->resume != 'Y' &&
+       loadCheckpoint(net, net->checkpointFile) != 0)
+   {
+      freeNetwork(net);
+      return 1;
+   }
+   if (argc >= 2 && strcmp(argv[1], "resume") == 0 && net->resume != 'Y')
+   {
+      findSparseLayers(net); // the checkpoint's weights replaced the ones the sparse layers were found from
+
+      if (net->augmenter != NULL) // started before the checkpoint's seed and iteration were known
+      {
+         freeAugmenter(net->augmenter);
+         if ((net->augmenter = createAugmenter(net)) == NULL)
+         {
+            freeNetwork(net);
+            return 1;
+         }
+      }
+   }
+
+   double checkpointError = net->error;
+
+   printf("\nINITIAL NETWORK:\n");
+   runForAllTrainingSets(net);
+
+   if (net->iteration > 0) // carrying on with the checkpoint's error instead of the initial run's
+   {
+      net->error = checkpointError;
+   }
+
+   clock_t CPU_time_1 = clock();
+
+   if (net->trainNetwork == 'Y')
+   {
+      printf("AFTER TRAINING:\n");
+      train(net, net->maxIterations, net->targetError);
+   }
+
+   clock_t CPU_time_2 = clock();
+
+   if (net->pruneFraction > 0.0)
+   {
+      printf("AFTER PRUNING:\n");
+      pruneNetwork(net);
+   }
+
+   writeWeightsToFile(net, net->weightsFileOutput);
+   writeOutputsToFile(net);
+
+   if (net->useBitmap == 'Y')
+   {
+      writeBitmap(net->nodesFileOutput, net->bitmapFileInput, net->bitmapFileOutput);
+   }
+
+   freeNetwork(net);
+
+   printf("Time taken: %fms", ((double)(CPU_time_2 - CPU_time_1)) / CLOCKS_PER_SEC * 1000);
+
+   return 0;
+}
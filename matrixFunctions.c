@@ -0,0 +1,1464 @@
+/**
+ * Created 10/18/2026
+ * This file holds the matrix kernels used by the dense layers of the
+ * network, in double and float. Matrices are stored row by row, with a
+ * leading dimension (the distance between rows) passed in alongside them,
+ * so the kernels can work directly on the padded mkj weight layout.
+ *
+ * multiplyMatrices is cache-blocked: the depth and the columns are split
+ * into blocks that fit in cache, each block of the right-hand matrix is
+ * packed into contiguous panels, and every panel is run through a
+ * register-tiled kernel that keeps a 4-row tile of the result in registers.
+ * With fewer than 4 rows (such as a single training set) no packing is done,
+ * so the forward pass of a single set never allocates.
+ *
+ * Products that are large enough are split between a pool of threads
+ * (see setMatrixThreads); by default everything runs on the caller.
+ *
+ * The innermost kernels come in SSE2, AVX2 (with FMA), and AVX-512 versions,
+ * plus a plain C version for other CPUs. The fastest set the CPU supports is
+ * picked at runtime the first time selectMatrixKernels is called.
+ *
+ * Functions in this file:
+ *
+ * void selectMatrixKernels(void)
+ * char *getMatrixKernelName(void)
+ * void setMatrixBlockSizes(int rowBlock, int depthBlock, int colBlock)
+ * void getMatrixBlockSizes(int *rowBlock, int *depthBlock, int *colBlock)
+ * void setMatrixThreads(int numThreads)
+ * int getMatrixThreads(void)
+ *
+ * void multiplyMatrices(int numRows, int numCols, int depth, const double *x, int ldx, const double *w, int ldw, double *y, int ldy)
+ * void multiplyMatrixVector(int numRows, int numCols, const double *a, int lda, const double *x, double *y)
+ * void addOuterProduct(int numRows, int numCols, double alpha, const double *x, const double *y, double *a, int lda)
+ *
+ * void multiplyMatricesFloat(int numRows, int numCols, int depth, const float *x, int ldx, const float *w, int ldw, float *y, int ldy)
+ * void multiplyMatrixVectorFloat(int numRows, int numCols, const float *a, int lda, const float *x, float *y)
+ * void addOuterProductFloat(int numRows, int numCols, float alpha, const float *x, const float *y, float *a, int lda)
+ *
+ * void multiplySparseMatrixVector(int numRows, const int *rowStarts, const int *columns, const double *values, const double *x, double *y)
+ *
+ * void runMatrixJob(struct MatrixJob *job, double work)
+ * void *runMatrixWorker(void *arg)
+ * void runMatrixJobPart(struct MatrixJob *job, int part, int numParts)
+ * void multiplyMatrixColumns(int numRows, int firstCol, int endCol, int depth, const double *x, int ldx, const double *w, int ldw, double *y, int ldy)
+ * void multiplyMatrixColumnsFloat(int numRows, int firstCol, int endCol, int depth, const float *x, int ldx, const float *w, int ldw, float *y, int ldy)
+ *
+ * and the tile4, tile1, axpy, and dot kernels for each instruction set
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MATRIX_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+#include "./headerfiles/matrixFunctions.h"
+
+#define TILE_ROWS 4           // rows of the result kept in registers by a tile kernel
+#define MAX_MATRIX_THREADS 64 // most threads the kernels can split a product between
+
+/**
+ * The kernels that make up one instruction set's version of the library.
+ *
+ * tile4 adds x * w into a TILE_ROWS by tileWidth tile of y, and tile1 does
+ * the same for a single row; w is read tileWidth columns at a time from rows
+ * ldw apart. axpy adds alpha * x to y, and dot returns the dot product of x and y.
+ */
+struct MatrixKernels
+{
+   char *name;
+
+   int tileWidth;
+   void (*tile4)(int, const double *, int, const double *, int, double *, int);
+   void (*tile1)(int, const double *, const double *, int, double *);
+   void (*axpy)(int, double, const double *, double *);
+   double (*dot)(int, const double *, const double *);
+
+   int tileWidthFloat;
+   void (*tile4Float)(int, const float *, int, const float *, int, float *, int);
+   void (*tile1Float)(int, const float *, const float *, int, float *);
+   void (*axpyFloat)(int, float, const float *, float *);
+   float (*dotFloat)(int, const float *, const float *);
+};
+
+enum MatrixJobType
+{
+   MULTIPLY_JOB,
+   MULTIPLY_FLOAT_JOB,
+   MATRIX_VECTOR_JOB,
+   MATRIX_VECTOR_FLOAT_JOB,
+   OUTER_PRODUCT_JOB,
+   OUTER_PRODUCT_FLOAT_JOB,
+   SPARSE_MATRIX_VECTOR_JOB
+};
+
+/**
+ * The arguments of one call to the kernels, so that it can be split between
+ * threads. The matrices are in the order of the call's arguments (x, w, y),
+ * except that a matrix-vector product uses x for its matrix and w for its vector
+ * (a sparse matrix's values go in x, with its row starts and columns alongside).
+ */
+struct MatrixJob
+{
+   enum MatrixJobType type;
+   int numRows;
+   int numCols;
+   int depth;
+   const void *x;
+   int ldx;
+   const void *w;
+   int ldw;
+   void *y;
+   int ldy;
+   double alpha;
+   const int *rowStarts;
+   const int *columns;
+};
+
+/**
+ * The threads that large products are split between. Only one caller
+ * can use the pool at a time; other callers run their products alone.
+ */
+struct MatrixPool
+{
+   pthread_mutex_t callerLock; // held by whichever caller is using the pool
+   pthread_mutex_t jobLock;    // guards everything below
+   pthread_cond_t jobReady;
+   pthread_cond_t jobDone;
+
+   pthread_t threads[MAX_MATRIX_THREADS];
+   int numThreads; // including the caller
+
+   struct MatrixJob *job;
+   int numParts;
+   int pending;         // parts still running on pool threads
+   int generation;      // incremented for every job
+   int startGeneration; // the generation when the threads were started
+   char stopping;
+};
+
+// function headers ----------------------
+
+void runMatrixJob(struct MatrixJob *, double);
+void *runMatrixWorker(void *);
+void runMatrixJobPart(struct MatrixJob *, int, int);
+void multiplyMatrixColumns(int, int, int, int, const double *, int, const double *, int, double *, int);
+void multiplyMatrixColumnsFloat(int, int, int, int, const float *, int, const float *, int, float *, int);
+
+void tile4Generic(int, const double *, int, const double *, int, double *, int);
+void tile1Generic(int, const double *, const double *, int, double *);
+void axpyGeneric(int, double, const double *, double *);
+double dotGeneric(int, const double *, const double *);
+void tile4FloatGeneric(int, const float *, int, const float *, int, float *, int);
+void tile1FloatGeneric(int, const float *, const float *, int, float *);
+void axpyFloatGeneric(int, float, const float *, float *);
+float dotFloatGeneric(int, const float *, const float *);
+
+#ifdef MATRIX_KERNELS_X86
+void tile4Sse2(int, const double *, int, const double *, int, double *, int);
+void tile1Sse2(int, const double *, const double *, int, double *);
+void axpySse2(int, double, const double *, double *);
+double dotSse2(int, const double *, const double *);
+void tile4FloatSse2(int, const float *, int, const float *, int, float *, int);
+void tile1FloatSse2(int, const float *, const float *, int, float *);
+void axpyFloatSse2(int, float, const float *, float *);
+float dotFloatSse2(int, const float *, const float *);
+
+void tile4Avx2(int, const double *, int, const double *, int, double *, int);
+void tile1Avx2(int, const double *, const double *, int, double *);
+void axpyAvx2(int, double, const double *, double *);
+double dotAvx2(int, const double *, const double *);
+void tile4FloatAvx2(int, const float *, int, const float *, int, float *, int);
+void tile1FloatAvx2(int, const float *, const float *, int, float *);
+void axpyFloatAvx2(int, float, const float *, float *);
+float dotFloatAvx2(int, const float *, const float *);
+
+void tile4Avx512(int, const double *, int, const double *, int, double *, int);
+void tile1Avx512(int, const double *, const double *, int, double *);
+void axpyAvx512(int, double, const double *, double *);
+double dotAvx512(int, const double *, const double *);
+void tile4FloatAvx512(int, const float *, int, const float *, int, float *, int);
+void tile1FloatAvx512(int, const float *, const float *, int, float *);
+void axpyFloatAvx512(int, float, const float *, float *);
+float dotFloatAvx512(int, const float *, const float *);
+#endif
+
+// variable declarations ----------------------
+
+struct MatrixKernels genericKernels = {
+    "generic",
+    4, &tile4Generic, &tile1Generic, &axpyGeneric, &dotGeneric,
+    4, &tile4FloatGeneric, &tile1FloatGeneric, &axpyFloatGeneric, &dotFloatGeneric};
+
+#ifdef MATRIX_KERNELS_X86
+struct MatrixKernels sse2Kernels = {
+    "sse2",
+    4, &tile4Sse2, &tile1Sse2, &axpySse2, &dotSse2,
+    8, &tile4FloatSse2, &tile1FloatSse2, &axpyFloatSse2, &dotFloatSse2};
+
+struct MatrixKernels avx2Kernels = {
+    "avx2",
+    8, &tile4Avx2, &tile1Avx2, &axpyAvx2, &dotAvx2,
+    16, &tile4FloatAvx2, &tile1FloatAvx2, &axpyFloatAvx2, &dotFloatAvx2};
+
+struct MatrixKernels avx512Kernels = {
+    "avx512",
+    16, &tile4Avx512, &tile1Avx512, &axpyAvx512, &dotAvx512,
+    32, &tile4FloatAvx512, &tile1FloatAvx512, &axpyFloatAvx512, &dotFloatAvx512};
+#endif
+
+struct MatrixKernels *kernels = NULL; // the kernel set in use (picked by selectMatrixKernels)
+
+int rowBlockSize = 64;    // rows of the left-hand matrix handled per block
+int depthBlockSize = 256; // depth handled per block (the height of a packed panel)
+int colBlockSize = 128;   // columns of the right-hand matrix handled per block
+
+double parallelThreshold = 65536.0; // fewest multiply-adds worth splitting between threads
+
+struct MatrixPool pool = {.callerLock = PTHREAD_MUTEX_INITIALIZER,
+                          .jobLock = PTHREAD_MUTEX_INITIALIZER,
+                          .jobReady = PTHREAD_COND_INITIALIZER,
+                          .jobDone = PTHREAD_COND_INITIALIZER,
+                          .numThreads = 1};
+
+// functions ----------------------
+
+/**
+ * Picks the fastest kernel set that this CPU supports. It is safe to call
+ * more than once, but should first be called before any threads use the
+ * kernels (createNetwork does this).
+ */
+void selectMatrixKernels()
+{
+   if (kernels != NULL)
+   {
+      return;
+   }
+
+   kernels = &genericKernels;
+
+#ifdef MATRIX_KERNELS_X86
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx512f"))
+   {
+      kernels = &avx512Kernels;
+   }
+   else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+   {
+      kernels = &avx2Kernels;
+   }
+   else if (__builtin_cpu_supports("sse2"))
+   {
+      kernels = &sse2Kernels;
+   }
+#endif
+}
+
+/**
+ * @return the name of the kernel set in use (such as "avx2")
+ */
+char *getMatrixKernelName()
+{
+   selectMatrixKernels();
+   return kernels->name;
+}
+
+/**
+ * Sets the block sizes used by multiplyMatrices. Values below 1 leave the
+ * corresponding size unchanged.
+ *
+ * @param rowBlock   the rows of the left-hand matrix handled per block
+ * @param depthBlock the depth handled per block
+ * @param colBlock   the columns of the right-hand matrix handled per block
+ */
+void setMatrixBlockSizes(int rowBlock, int depthBlock, int colBlock)
+{
+   if (rowBlock > 0)
+   {
+      rowBlockSize = rowBlock;
+   }
+   if (depthBlock > 0)
+   {
+      depthBlockSize = depthBlock;
+   }
+   if (colBlock > 0)
+   {
+      colBlockSize = colBlock;
+   }
+}
+
+/**
+ * Gets the block sizes used by multiplyMatrices.
+ *
+ * @param rowBlock   where to store the rows of the left-hand matrix handled per block
+ * @param depthBlock where to store the depth handled per block
+ * @param colBlock   where to store the columns of the right-hand matrix handled per block
+ */
+void getMatrixBlockSizes(int *rowBlock, int *depthBlock, int *colBlock)
+{
+   *rowBlock = rowBlockSize;
+   *depthBlock = depthBlockSize;
+   *colBlock = colBlockSize;
+}
+
+/**
+ * Sets how many threads (including the caller) the kernels split large
+ * products between, starting or stopping pool threads as needed.
+ * Should not be called while another thread is using the kernels.
+ *
+ * @param numThreads the number of threads to use (1 to run everything on the caller)
+ */
+void setMatrixThreads(int numThreads)
+{
+   if (numThreads < 1)
+   {
+      numThreads = 1;
+   }
+   if (numThreads > MAX_MATRIX_THREADS)
+   {
+      numThreads = MAX_MATRIX_THREADS;
+   }
+
+   pthread_mutex_lock(&pool.callerLock);
+
+   // stopping the threads of the old pool
+   pthread_mutex_lock(&pool.jobLock);
+   pool.stopping = 1;
+   pthread_cond_broadcast(&pool.jobReady);
+   pthread_mutex_unlock(&pool.jobLock);
+   for (int i = 0; i < pool.numThreads - 1; i++)
+   {
+      pthread_join(pool.threads[i], NULL);
+   }
+
+   pool.stopping = 0;
+   pool.numThreads = 1;
+   pool.startGeneration = pool.generation;
+
+   for (int i = 0; i < numThreads - 1; i++)
+   {
+      if (pthread_create(&pool.threads[i], NULL, &runMatrixWorker, (void *)(intptr_t)(i + 1)) != 0)
+      {
+         printf("Could only start %d matrix threads.\n", pool.numThreads);
+         break;
+      }
+      pool.numThreads++;
+   }
+
+   pthread_mutex_unlock(&pool.callerLock);
+
+   return;
+}
+
+/**
+ * @return the number of threads the kernels split large products between
+ */
+int getMatrixThreads()
+{
+   return pool.numThreads;
+}
+
+/**
+ * Multiplies x (numRows by depth) by w (depth by numCols) and stores
+ * the product in y (numRows by numCols), overwriting what was there.
+ * Large products are split between the pool's threads by columns.
+ *
+ * @param numRows the number of rows in x and y
+ * @param numCols the number of columns in w and y
+ * @param depth   the number of columns in x and rows in w
+ * @param x       the left-hand matrix, with rows ldx apart
+ * @param ldx     the distance between rows of x
+ * @param w       the right-hand matrix, with rows ldw apart
+ * @param ldw     the distance between rows of w
+ * @param y       where to store the product, with rows ldy apart
+ * @param ldy     the distance between rows of y
+ */
+void multiplyMatrices(int numRows, int numCols, int depth, const double *x, int ldx,
+                      const double *w, int ldw, double *y, int ldy)
+{
+   struct MatrixJob job = {.type = MULTIPLY_JOB, .numRows = numRows, .numCols = numCols, .depth = depth,
+                           .x = x, .ldx = ldx, .w = w, .ldw = ldw, .y = y, .ldy = ldy};
+   runMatrixJob(&job, (double)numRows * numCols * depth);
+}
+
+/**
+ * Multiplies a (numRows by numCols) by the vector x and stores the
+ * product in y, overwriting what was there.
+ *
+ * @param numRows the number of rows in a (and values in y)
+ * @param numCols the number of columns in a (and values in x)
+ * @param a       the matrix, with rows lda apart
+ * @param lda     the distance between rows of a
+ * @param x       the vector to multiply by
+ * @param y       where to store the product
+ */
+void multiplyMatrixVector(int numRows, int numCols, const double *a, int lda, const double *x, double *y)
+{
+   struct MatrixJob job = {.type = MATRIX_VECTOR_JOB, .numRows = numRows, .numCols = numCols,
+                           .x = a, .ldx = lda, .w = x, .y = y};
+   runMatrixJob(&job, (double)numRows * numCols);
+}
+
+/**
+ * Adds alpha times the outer product of x and y to a,
+ * so that a[i][j] += alpha * x[i] * y[j].
+ *
+ * @param numRows the number of rows in a (and values in x)
+ * @param numCols the number of columns in a (and values in y)
+ * @param alpha   the scale of the outer product
+ * @param x       the vector that indexes the rows
+ * @param y       the vector that indexes the columns
+ * @param a       the matrix to add to, with rows lda apart
+ * @param lda     the distance between rows of a
+ */
+void addOuterProduct(int numRows, int numCols, double alpha, const double *x, const double *y, double *a, int lda)
+{
+   struct MatrixJob job = {.type = OUTER_PRODUCT_JOB, .numRows = numRows, .numCols = numCols,
+                           .x = x, .w = y, .y = a, .ldy = lda, .alpha = alpha};
+   runMatrixJob(&job, (double)numRows * numCols);
+}
+
+/**
+ * The float version of multiplyMatrices.
+ *
+ * @param numRows the number of rows in x and y
+ * @param numCols the number of columns in w and y
+ * @param depth   the number of columns in x and rows in w
+ * @param x       the left-hand matrix, with rows ldx apart
+ * @param ldx     the distance between rows of x
+ * @param w       the right-hand matrix, with rows ldw apart
+ * @param ldw     the distance between rows of w
+ * @param y       where to store the product, with rows ldy apart
+ * @param ldy     the distance between rows of y
+ */
+void multiplyMatricesFloat(int numRows, int numCols, int depth, const float *x, int ldx,
+                           const float *w, int ldw, float *y, int ldy)
+{
+   struct MatrixJob job = {.type = MULTIPLY_FLOAT_JOB, .numRows = numRows, .numCols = numCols, .depth = depth,
+                           .x = x, .ldx = ldx, .w = w, .ldw = ldw, .y = y, .ldy = ldy};
+   runMatrixJob(&job, (double)numRows * numCols * depth);
+}
+
+/**
+ * The float version of multiplyMatrixVector.
+ *
+ * @param numRows the number of rows in a (and values in y)
+ * @param numCols the number of columns in a (and values in x)
+ * @param a       the matrix, with rows lda apart
+ * @param lda     the distance between rows of a
+ * @param x       the vector to multiply by
+ * @param y       where to store the product
+ */
+void multiplyMatrixVectorFloat(int numRows, int numCols, const float *a, int lda, const float *x, float *y)
+{
+   struct MatrixJob job = {.type = MATRIX_VECTOR_FLOAT_JOB, .numRows = numRows, .numCols = numCols,
+                           .x = a, .ldx = lda, .w = x, .y = y};
+   runMatrixJob(&job, (double)numRows * numCols);
+}
+
+/**
+ * The float version of addOuterProduct.
+ *
+ * @param numRows the number of rows in a (and values in x)
+ * @param numCols the number of columns in a (and values in y)
+ * @param alpha   the scale of the outer product
+ * @param x       the vector that indexes the rows
+ * @param y       the vector that indexes the columns
+ * @param a       the matrix to add to, with rows lda apart
+ * @param lda     the distance between rows of a
+ */
+void addOuterProductFloat(int numRows, int numCols, float alpha, const float *x, const float *y, float *a, int lda)
+{
+   struct MatrixJob job = {.type = OUTER_PRODUCT_FLOAT_JOB, .numRows = numRows, .numCols = numCols,
+                           .x = x, .w = y, .y = a, .ldy = lda, .alpha = alpha};
+   runMatrixJob(&job, (double)numRows * numCols);
+}
+
+/**
+ * Multiplies a sparse matrix, stored in compressed sparse row (CSR) form,
+ * by the vector x and stores the product in y, overwriting what was there.
+ * Row i's values are values[rowStarts[i]] up to values[rowStarts[i + 1]],
+ * and the column of each value is in the same place in columns.
+ *
+ * @param numRows   the number of rows in the matrix (and values in y)
+ * @param rowStarts where each row starts in values and columns (numRows + 1 long)
+ * @param columns   the column of every value
+ * @param values    the values of the matrix, row by row
+ * @param x         the vector to multiply by
+ * @param y         where to store the product
+ */
+void multiplySparseMatrixVector(int numRows, const int *rowStarts, const int *columns, const double *values,
+                                const double *x, double *y)
+{
+   struct MatrixJob job = {.type = SPARSE_MATRIX_VECTOR_JOB, .numRows = numRows, .x = values, .w = x, .y = y,
+                           .rowStarts = rowStarts, .columns = columns};
+   runMatrixJob(&job, rowStarts[numRows]);
+}
+
+// thread pool ----------------------
+
+/**
+ * Runs a job, splitting it between the pool's threads if it is large
+ * enough and no other thread is already using the pool.
+ *
+ * @param job the job to run
+ * @param work roughly how many multiply-adds the job takes
+ */
+void runMatrixJob(struct MatrixJob *job, double work)
+{
+   selectMatrixKernels();
+
+   if (pool.numThreads == 1 || work < parallelThreshold || pthread_mutex_trylock(&pool.callerLock) != 0)
+   {
+      runMatrixJobPart(job, 0, 1);
+      return;
+   }
+
+   pthread_mutex_lock(&pool.jobLock);
+   pool.job = job;
+   pool.numParts = pool.numThreads;
+   pool.pending = pool.numThreads - 1;
+   pool.generation++;
+   pthread_cond_broadcast(&pool.jobReady);
+   pthread_mutex_unlock(&pool.jobLock);
+
+   runMatrixJobPart(job, 0, pool.numParts); // the caller does the first part itself
+
+   pthread_mutex_lock(&pool.jobLock);
+   while (pool.pending > 0)
+   {
+      pthread_cond_wait(&pool.jobDone, &pool.jobLock);
+   }
+   pthread_mutex_unlock(&pool.jobLock);
+
+   pthread_mutex_unlock(&pool.callerLock);
+
+   return;
+}
+
+/**
+ * Waits for jobs and runs its own part of each one until the pool is stopped.
+ *
+ * @param arg which part of each job this thread runs
+ * @return NULL
+ */
+void *runMatrixWorker(void *arg)
+{
+   int part = (int)(intptr_t)arg;
+
+   pthread_mutex_lock(&pool.jobLock);
+   int lastGeneration = pool.startGeneration;
+
+   while (1)
+   {
+      while (pool.generation == lastGeneration && !pool.stopping)
+      {
+         pthread_cond_wait(&pool.jobReady, &pool.jobLock);
+      }
+      if (pool.stopping)
+      {
+         break;
+      }
+
+      lastGeneration = pool.generation;
+      struct MatrixJob *job = pool.job;
+      int numParts = pool.numParts;
+      pthread_mutex_unlock(&pool.jobLock);
+
+      runMatrixJobPart(job, part, numParts);
+
+      pthread_mutex_lock(&pool.jobLock);
+      pool.pending--;
+      if (pool.pending == 0)
+      {
+         pthread_cond_signal(&pool.jobDone);
+      }
+   }
+
+   pthread_mutex_unlock(&pool.jobLock);
+
+   return NULL;
+}
+
+/**
+ * Runs one part of a job. Products of matrices are split by columns
+ * (in whole tiles), and everything else is split by rows.
+ *
+ * @param job the job to run
+ * @param part which part to run
+ * @param numParts how many parts the job is split into
+ */
+void runMatrixJobPart(struct MatrixJob *job, int part, int numParts)
+{
+   int isMultiply = job->type == MULTIPLY_JOB || job->type == MULTIPLY_FLOAT_JOB;
+   int total = isMultiply ? job->numCols : job->numRows;
+   int unit = 1;
+
+   if (job->type == MULTIPLY_JOB)
+   {
+      unit = kernels->tileWidth;
+   }
+   else if (job->type == MULTIPLY_FLOAT_JOB)
+   {
+      unit = kernels->tileWidthFloat;
+   }
+
+   int partSize = ((total + numParts - 1) / numParts + unit - 1) / unit * unit;
+   int first = part * partSize;
+   int end = first + partSize < total ? first + partSize : total;
+
+   if (first >= end)
+   {
+      return;
+   }
+
+   switch (job->type)
+   {
+   case MULTIPLY_JOB:
+      multiplyMatrixColumns(job->numRows, first, end, job->depth, job->x, job->ldx, job->w, job->ldw, job->y, job->ldy);
+      break;
+   case MULTIPLY_FLOAT_JOB:
+      multiplyMatrixColumnsFloat(job->numRows, first, end, job->depth, job->x, job->ldx, job->w, job->ldw, job->y, job->ldy);
+      break;
+   case MATRIX_VECTOR_JOB:
+      for (int i = first; i < end; i++)
+      {
+         ((double *)job->y)[i] = kernels->dot(job->numCols, (const double *)job->x + i * job->ldx, job->w);
+      }
+      break;
+   case MATRIX_VECTOR_FLOAT_JOB:
+      for (int i = first; i < end; i++)
+      {
+         ((float *)job->y)[i] = kernels->dotFloat(job->numCols, (const float *)job->x + i * job->ldx, job->w);
+      }
+      break;
+   case OUTER_PRODUCT_JOB:
+      for (int i = first; i < end; i++)
+      {
+         double xValue = ((const double *)job->x)[i];
+         if (xValue != 0.0)
+         {
+            kernels->axpy(job->numCols, job->alpha * xValue, job->w, (double *)job->y + i * job->ldy);
+         }
+      }
+      break;
+   case OUTER_PRODUCT_FLOAT_JOB:
+      for (int i = first; i < end; i++)
+      {
+         float xValue = ((const float *)job->x)[i];
+         if (xValue != 0.0f)
+         {
+            kernels->axpyFloat(job->numCols, (float)job->alpha * xValue, job->w, (float *)job->y + i * job->ldy);
+         }
+      }
+      break;
+   case SPARSE_MATRIX_VECTOR_JOB:
+      for (int i = first; i < end; i++)
+      {
+         const double *values = job->x;
+         const double *vector = job->w;
+         double sum0 = 0.0, sum1 = 0.0; // two sums, so consecutive products do not wait on each other
+         int p = job->rowStarts[i];
+         for (; p + 1 < job->rowStarts[i + 1]; p += 2)
+         {
+            sum0 += values[p] * vector[job->columns[p]];
+            sum1 += values[p + 1] * vector[job->columns[p + 1]];
+         }
+         if (p < job->rowStarts[i + 1])
+         {
+            sum0 += values[p] * vector[job->columns[p]];
+         }
+         ((double *)job->y)[i] = sum0 + sum1;
+      }
+      break;
+   }
+
+   return;
+}
+
+// blocked products ----------------------
+
+/**
+ * Does the work of multiplyMatrices for a range of the columns of w and y.
+ *
+ * @param numRows  the number of rows in x and y
+ * @param firstCol the first column to find (a multiple of the tile width)
+ * @param endCol   one past the last column to find
+ * @param depth    the number of columns in x and rows in w
+ * @param x        the left-hand matrix, with rows ldx apart
+ * @param ldx      the distance between rows of x
+ * @param w        the right-hand matrix, with rows ldw apart
+ * @param ldw      the distance between rows of w
+ * @param y        where to store the product, with rows ldy apart
+ * @param ldy      the distance between rows of y
+ */
+void multiplyMatrixColumns(int numRows, int firstCol, int endCol, int depth, const double *x, int ldx,
+                           const double *w, int ldw, double *y, int ldy)
+{
+   int width = kernels->tileWidth;
+   char usePacking = numRows >= TILE_ROWS;
+   double *packed = NULL;
+
+   for (int i = 0; i < numRows; i++)
+   {
+      memset(y + i * ldy + firstCol, 0, (endCol - firstCol) * sizeof(double));
+   }
+
+   if (usePacking)
+   {
+      packed = malloc(depthBlockSize * (colBlockSize + width) * sizeof(double));
+      if (packed == NULL)
+      {
+         usePacking = 0;
+      }
+   }
+
+   for (int colStart = firstCol; colStart < endCol; colStart += colBlockSize)
+   {
+      int colEnd = colStart + colBlockSize < endCol ? colStart + colBlockSize : endCol;
+      int tiledEnd = colStart + (colEnd - colStart) / width * width; // end of the columns that fill a whole tile
+
+      for (int depthStart = 0; depthStart < depth; depthStart += depthBlockSize)
+      {
+         int blockDepth = depthStart + depthBlockSize < depth ? depthBlockSize : depth - depthStart;
+         const double *block = w + depthStart * ldw;
+
+         /*
+          * Packs the block so that each tile's panel is contiguous,
+          * with width values for each row of the depth
+          */
+         if (usePacking)
+         {
+            for (int j = colStart; j < tiledEnd; j += width)
+            {
+               double *panel = packed + (j - colStart) * blockDepth;
+               for (int k = 0; k < blockDepth; k++)
+               {
+                  memcpy(panel + k * width, block + k * ldw + j, width * sizeof(double));
+               }
+            }
+         }
+
+         for (int rowStart = 0; rowStart < numRows; rowStart += rowBlockSize)
+         {
+            int rowEnd = rowStart + rowBlockSize < numRows ? rowStart + rowBlockSize : numRows;
+
+            for (int j = colStart; j < tiledEnd; j += width)
+            {
+               const double *panel = usePacking ? packed + (j - colStart) * blockDepth : block + j;
+               int panelStride = usePacking ? width : ldw;
+
+               int i = rowStart;
+               for (; i + TILE_ROWS <= rowEnd; i += TILE_ROWS)
+               {
+                  kernels->tile4(blockDepth, x + i * ldx + depthStart, ldx, panel, panelStride, y + i * ldy + j, ldy);
+               }
+               for (; i < rowEnd; i++)
+               {
+                  kernels->tile1(blockDepth, x + i * ldx + depthStart, panel, panelStride, y + i * ldy + j);
+               }
+            }
+
+            // columns left over after the last whole tile
+            for (int i = rowStart; i < rowEnd; i++)
+            {
+               for (int k = 0; k < blockDepth; k++)
+               {
+                  double xValue = x[i * ldx + depthStart + k];
+                  for (int j = tiledEnd; j < colEnd; j++)
+                  {
+                     y[i * ldy + j] += xValue * block[k * ldw + j];
+                  }
+               }
+            }
+         }
+      }
+   }
+
+   free(packed);
+}
+
+/**
+ * The float version of multiplyMatrixColumns.
+ *
+ * @param numRows  the number of rows in x and y
+ * @param firstCol the first column to find (a multiple of the tile width)
+ * @param endCol   one past the last column to find
+ * @param depth    the number of columns in x and rows in w
+ * @param x        the left-hand matrix, with rows ldx apart
+ * @param ldx      the distance between rows of x
+ * @param w        the right-hand matrix, with rows ldw apart
+ * @param ldw      the distance between rows of w
+ * @param y        where to store the product, with rows ldy apart
+ * @param ldy      the distance between rows of y
+ */
+void multiplyMatrixColumnsFloat(int numRows, int firstCol, int endCol, int depth, const float *x, int ldx,
+                                const float *w, int ldw, float *y, int ldy)
+{
+   int width = kernels->tileWidthFloat;
+   char usePacking = numRows >= TILE_ROWS;
+   float *packed = NULL;
+
+   for (int i = 0; i < numRows; i++)
+   {
+      memset(y + i * ldy + firstCol, 0, (endCol - firstCol) * sizeof(float));
+   }
+
+   if (usePacking)
+   {
+      packed = malloc(depthBlockSize * (colBlockSize + width) * sizeof(float));
+      if (packed == NULL)
+      {
+         usePacking = 0;
+      }
+   }
+
+   for (int colStart = firstCol; colStart < endCol; colStart += colBlockSize)
+   {
+      int colEnd = colStart + colBlockSize < endCol ? colStart + colBlockSize : endCol;
+      int tiledEnd = colStart + (colEnd - colStart) / width * width;
+
+      for (int depthStart = 0; depthStart < depth; depthStart += depthBlockSize)
+      {
+         int blockDepth = depthStart + depthBlockSize < depth ? depthBlockSize : depth - depthStart;
+         const float *block = w + depthStart * ldw;
+
+         if (usePacking)
+         {
+            for (int j = colStart; j < tiledEnd; j += width)
+            {
+               float *panel = packed + (j - colStart) * blockDepth;
+               for (int k = 0; k < blockDepth; k++)
+               {
+                  memcpy(panel + k * width, block + k * ldw + j, width * sizeof(float));
+               }
+            }
+         }
+
+         for (int rowStart = 0; rowStart < numRows; rowStart += rowBlockSize)
+         {
+            int rowEnd = rowStart + rowBlockSize < numRows ? rowStart + rowBlockSize : numRows;
+
+            for (int j = colStart; j < tiledEnd; j += width)
+            {
+               const float *panel = usePacking ? packed + (j - colStart) * blockDepth : block + j;
+               int panelStride = usePacking ? width : ldw;
+
+               int i = rowStart;
+               for (; i + TILE_ROWS <= rowEnd; i += TILE_ROWS)
+               {
+                  kernels->tile4Float(blockDepth, x + i * ldx + depthStart, ldx, panel, panelStride, y + i * ldy + j, ldy);
+               }
+               for (; i < rowEnd; i++)
+               {
+                  kernels->tile1Float(blockDepth, x + i * ldx + depthStart, panel, panelStride, y + i * ldy + j);
+               }
+            }
+
+            for (int i = rowStart; i < rowEnd; i++)
+            {
+               for (int k = 0; k < blockDepth; k++)
+               {
+                  float xValue = x[i * ldx + depthStart + k];
+                  for (int j = tiledEnd; j < colEnd; j++)
+                  {
+                     y[i * ldy + j] += xValue * block[k * ldw + j];
+                  }
+               }
+            }
+         }
+      }
+   }
+
+   free(packed);
+}
+
+// generic kernels ----------------------
+
+void tile4Generic(int depth, const double *x, int ldx, const double *w, int ldw, double *y, int ldy)
+{
+   for (int r = 0; r < TILE_ROWS; r++)
+   {
+      tile1Generic(depth, x + r * ldx, w, ldw, y + r * ldy);
+   }
+}
+
+void tile1Generic(int depth, const double *x, const double *w, int ldw, double *y)
+{
+   double sum0 = 0.0, sum1 = 0.0, sum2 = 0.0, sum3 = 0.0;
+   for (int k = 0; k < depth; k++)
+   {
+      const double *row = w + k * ldw;
+      sum0 += x[k] * row[0];
+      sum1 += x[k] * row[1];
+      sum2 += x[k] * row[2];
+      sum3 += x[k] * row[3];
+   }
+   y[0] += sum0;
+   y[1] += sum1;
+   y[2] += sum2;
+   y[3] += sum3;
+}
+
+void axpyGeneric(int n, double alpha, const double *x, double *y)
+{
+   for (int i = 0; i < n; i++)
+   {
+      y[i] += alpha * x[i];
+   }
+}
+
+double dotGeneric(int n, const double *x, const double *y)
+{
+   double sum = 0.0;
+   for (int i = 0; i < n; i++)
+   {
+      sum += x[i] * y[i];
+   }
+   return sum;
+}
+
+void tile4FloatGeneric(int depth, const float *x, int ldx, const float *w, int ldw, float *y, int ldy)
+{
+   for (int r = 0; r < TILE_ROWS; r++)
+   {
+      tile1FloatGeneric(depth, x + r * ldx, w, ldw, y + r * ldy);
+   }
+}
+
+void tile1FloatGeneric(int depth, const float *x, const float *w, int ldw, float *y)
+{
+   float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+   for (int k = 0; k < depth; k++)
+   {
+      const float *row = w + k * ldw;
+      sum0 += x[k] * row[0];
+      sum1 += x[k] * row[1];
+      sum2 += x[k] * row[2];
+      sum3 += x[k] * row[3];
+   }
+   y[0] += sum0;
+   y[1] += sum1;
+   y[2] += sum2;
+   y[3] += sum3;
+}
+
+void axpyFloatGeneric(int n, float alpha, const float *x, float *y)
+{
+   for (int i = 0; i < n; i++)
+   {
+      y[i] += alpha * x[i];
+   }
+}
+
+float dotFloatGeneric(int n, const float *x, const float *y)
+{
+   float sum = 0.0f;
+   for (int i = 0; i < n; i++)
+   {
+      sum += x[i] * y[i];
+   }
+   return sum;
+}
+
+#ifdef MATRIX_KERNELS_X86
+
+// SSE2 kernels (2 doubles or 4 floats per register, tiles 2 registers wide) ----------------------
+
+__attribute__((target("sse2"))) void tile4Sse2(int depth, const double *x, int ldx, const double *w, int ldw, double *y, int ldy)
+{
+   __m128d c00 = _mm_setzero_pd(), c01 = _mm_setzero_pd();
+   __m128d c10 = _mm_setzero_pd(), c11 = _mm_setzero_pd();
+   __m128d c20 = _mm_setzero_pd(), c21 = _mm_setzero_pd();
+   __m128d c30 = _mm_setzero_pd(), c31 = _mm_setzero_pd();
+
+   for (int k = 0; k < depth; k++)
+   {
+      __m128d w0 = _mm_loadu_pd(w + k * ldw);
+      __m128d w1 = _mm_loadu_pd(w + k * ldw + 2);
+      __m128d x0 = _mm_set1_pd(x[k]);
+      __m128d x1 = _mm_set1_pd(x[ldx + k]);
+      __m128d x2 = _mm_set1_pd(x[2 * ldx + k]);
+      __m128d x3 = _mm_set1_pd(x[3 * ldx + k]);
+      c00 = _mm_add_pd(c00, _mm_mul_pd(x0, w0));
+      c01 = _mm_add_pd(c01, _mm_mul_pd(x0, w1));
+      c10 = _mm_add_pd(c10, _mm_mul_pd(x1, w0));
+      c11 = _mm_add_pd(c11, _mm_mul_pd(x1, w1));
+      c20 = _mm_add_pd(c20, _mm_mul_pd(x2, w0));
+      c21 = _mm_add_pd(c21, _mm_mul_pd(x2, w1));
+      c30 = _mm_add_pd(c30, _mm_mul_pd(x3, w0));
+      c31 = _mm_add_pd(c31, _mm_mul_pd(x3, w1));
+   }
+
+   _mm_storeu_pd(y, _mm_add_pd(_mm_loadu_pd(y), c00));
+   _mm_storeu_pd(y + 2, _mm_add_pd(_mm_loadu_pd(y + 2), c01));
+   _mm_storeu_pd(y + ldy, _mm_add_pd(_mm_loadu_pd(y + ldy), c10));
+   _mm_storeu_pd(y + ldy + 2, _mm_add_pd(_mm_loadu_pd(y + ldy + 2), c11));
+   _mm_storeu_pd(y + 2 * ldy, _mm_add_pd(_mm_loadu_pd(y + 2 * ldy), c20));
+   _mm_storeu_pd(y + 2 * ldy + 2, _mm_add_pd(_mm_loadu_pd(y + 2 * ldy + 2), c21));
+   _mm_storeu_pd(y + 3 * ldy, _mm_add_pd(_mm_loadu_pd(y + 3 * ldy), c30));
+   _mm_storeu_pd(y + 3 * ldy + 2, _mm_add_pd(_mm_loadu_pd(y + 3 * ldy + 2), c31));
+}
+
+__attribute__((target("sse2"))) void tile1Sse2(int depth, const double *x, const double *w, int ldw, double *y)
+{
+   __m128d c0 = _mm_setzero_pd(), c1 = _mm_setzero_pd();
+
+   for (int k = 0; k < depth; k++)
+   {
+      __m128d x0 = _mm_set1_pd(x[k]);
+      c0 = _mm_add_pd(c0, _mm_mul_pd(x0, _mm_loadu_pd(w + k * ldw)));
+      c1 = _mm_add_pd(c1, _mm_mul_pd(x0, _mm_loadu_pd(w + k * ldw + 2)));
+   }
+
+   _mm_storeu_pd(y, _mm_add_pd(_mm_loadu_pd(y), c0));
+   _mm_storeu_pd(y + 2, _mm_add_pd(_mm_loadu_pd(y + 2), c1));
+}
+
+__attribute__((target("sse2"))) void axpySse2(int n, double alpha, const double *x, double *y)
+{
+   __m128d a = _mm_set1_pd(alpha);
+   int i = 0;
+   for (; i + 2 <= n; i += 2)
+   {
+      _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), _mm_mul_pd(a, _mm_loadu_pd(x + i))));
+   }
+   for (; i < n; i++)
+   {
+      y[i] += alpha * x[i];
+   }
+}
+
+__attribute__((target("sse2"))) double dotSse2(int n, const double *x, const double *y)
+{
+   __m128d sum = _mm_setzero_pd();
+   int i = 0;
+   for (; i + 2 <= n; i += 2)
+   {
+      sum = _mm_add_pd(sum, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+   }
+   double total = _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+   for (; i < n; i++)
+   {
+      total += x[i] * y[i];
+   }
+   return total;
+}
+
+__attribute__((target("sse2"))) void tile4FloatSse2(int depth, const float *x, int ldx, const float *w, int ldw, float *y, int ldy)
+{
+   __m128 c00 = _mm_setzero_ps(), c01 = _mm_setzero_ps();
+   __m128 c10 = _mm_setzero_ps(), c11 = _mm_setzero_ps();
+   __m128 c20 = _mm_setzero_ps(), c21 = _mm_setzero_ps();
+   __m128 c30 = _mm_setzero_ps(), c31 = _mm_setzero_ps();
+
+   for (int k = 0; k < depth; k++)
+   {
+      __m128 w0 = _mm_loadu_ps(w + k * ldw);
+      __m128 w1 = _mm_loadu_ps(w + k * ldw + 4);
+      __m128 x0 = _mm_set1_ps(x[k]);
+      __m128 x1 = _mm_set1_ps(x[ldx + k]);
+      __m128 x2 = _mm_set1_ps(x[2 * ldx + k]);
+      __m128 x3 = _mm_set1_ps(x[3 * ldx + k]);
+      c00 = _mm_add_ps(c00, _mm_mul_ps(x0, w0));
+      c01 = _mm_add_ps(c01, _mm_mul_ps(x0, w1));
+      c10 = _mm_add_ps(c10, _mm_mul_ps(x1, w0));
+      c11 = _mm_add_ps(c11, _mm_mul_ps(x1, w1));
+      c20 = _mm_add_ps(c20, _mm_mul_ps(x2, w0));
+      c21 = _mm_add_ps(c21, _mm_mul_ps(x2, w1));
+      c30 = _mm_add_ps(c30, _mm_mul_ps(x3, w0));
+      c31 = _mm_add_ps(c31, _mm_mul_ps(x3, w1));
+   }
+
+   _mm_storeu_ps(y, _mm_add_ps(_mm_loadu_ps(y), c00));
+   _mm_storeu_ps(y + 4, _mm_add_ps(_mm_loadu_ps(y + 4), c01));
+   _mm_storeu_ps(y + ldy, _mm_add_ps(_mm_loadu_ps(y + ldy), c10));
+   _mm_storeu_ps(y + ldy + 4, _mm_add_ps(_mm_loadu_ps(y + ldy + 4), c11));
+   _mm_storeu_ps(y + 2 * ldy, _mm_add_ps(_mm_loadu_ps(y + 2 * ldy), c20));
+   _mm_storeu_ps(y + 2 * ldy + 4, _mm_add_ps(_mm_loadu_ps(y + 2 * ldy + 4), c21));
+   _mm_storeu_ps(y + 3 * ldy, _mm_add_ps(_mm_loadu_ps(y + 3 * ldy), c30));
+   _mm_storeu_ps(y + 3 * ldy + 4, _mm_add_ps(_mm_loadu_ps(y + 3 * ldy + 4), c31));
+}
+
+__attribute__((target("sse2"))) void tile1FloatSse2(int depth, const float *x, const float *w, int ldw, float *y)
+{
+   __m128 c0 = _mm_setzero_ps(), c1 = _mm_setzero_ps();
+
+   for (int k = 0; k < depth; k++)
+   {
+      __m128 x0 = _mm_set1_ps(x[k]);
+      c0 = _mm_add_ps(c0, _mm_mul_ps(x0, _mm_loadu_ps(w + k * ldw)));
+      c1 = _mm_add_ps(c1, _mm_mul_ps(x0, _mm_loadu_ps(w + k * ldw + 4)));
+   }
+
+   _mm_storeu_ps(y, _mm_add_ps(_mm_loadu_ps(y), c0));
+   _mm_storeu_ps(y + 4, _mm_add_ps(_mm_loadu_ps(y + 4), c1));
+}
+
+__attribute__((target("sse2"))) void axpyFloatSse2(int n, float alpha, const float *x, float *y)
+{
+   __m128 a = _mm_set1_ps(alpha);
+   int i = 0;
+   for (; i + 4 <= n; i += 4)
+   {
+      _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(a, _mm_loadu_ps(x + i))));
+   }
+   for (; i < n; i++)
+   {
+      y[i] += alpha * x[i];
+   }
+}
+
+__attribute__((target("sse2"))) float dotFloatSse2(int n, const float *x, const float *y)
+{
+   __m128 sum = _mm_setzero_ps();
+   int i = 0;
+   for (; i + 4 <= n; i += 4)
+   {
+      sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i)));
+   }
+   sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+   sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+   float total = _mm_cvtss_f32(sum);
+   for (; i < n; i++)
+   {
+      total += x[i] * y[i];
+   }
+   return total;
+}
+
+// AVX2 kernels (4 doubles or 8 floats per register, tiles 2 registers wide) ----------------------
+
+__attribute__((target("avx2,fma"))) void tile4Avx2(int depth, const double *x, int ldx, const double *w, int ldw, double *y, int ldy)
+{
+   __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+   __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+   __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+   __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+
+   for (int k = 0; k < depth; k++)
+   {
+      __m256d w0 = _mm256_loadu_pd(w + k * ldw);
+      __m256d w1 = _mm256_loadu_pd(w + k * ldw + 4);
+      __m256d x0 = _mm256_broadcast_sd(x + k);
+      __m256d x1 = _mm256_broadcast_sd(x + ldx + k);
+      __m256d x2 = _mm256_broadcast_sd(x + 2 * ldx + k);
+      __m256d x3 = _mm256_broadcast_sd(x + 3 * ldx + k);
+      c00 = _mm256_fmadd_pd(x0, w0, c00);
+      c01 = _mm256_fmadd_pd(x0, w1, c01);
+      c10 = _mm256_fmadd_pd(x1, w0, c10);
+      c11 = _mm256_fmadd_pd(x1, w1, c11);
+      c20 = _mm256_fmadd_pd(x2, w0, c20);
+      c21 = _mm256_fmadd_pd(x2, w1, c21);
+      c30 = _mm256_fmadd_pd(x3, w0, c30);
+      c31 = _mm256_fmadd_pd(x3, w1, c31);
+   }
+
+   _mm256_storeu_pd(y, _mm256_add_pd(_mm256_loadu_pd(y), c00));
+   _mm256_storeu_pd(y + 4, _mm256_add_pd(_mm256_loadu_pd(y + 4), c01));
+   _mm256_storeu_pd(y + ldy, _mm256_add_pd(_mm256_loadu_pd(y + ldy), c10));
+   _mm256_storeu_pd(y + ldy + 4, _mm256_add_pd(_mm256_loadu_pd(y + ldy + 4), c11));
+   _mm256_storeu_pd(y + 2 * ldy, _mm256_add_pd(_mm256_loadu_pd(y + 2 * ldy), c20));
+   _mm256_storeu_pd(y + 2 * ldy + 4, _mm256_add_pd(_mm256_loadu_pd(y + 2 * ldy + 4), c21));
+   _mm256_storeu_pd(y + 3 * ldy, _mm256_add_pd(_mm256_loadu_pd(y + 3 * ldy), c30));
+   _mm256_storeu_pd(y + 3 * ldy + 4, _mm256_add_pd(_mm256_loadu_pd(y + 3 * ldy + 4), c31));
+}
+
+__attribute__((target("avx2,fma"))) void tile1Avx2(int depth, const double *x, const double *w, int ldw, double *y)
+{
+   __m256d c0 = _mm256_setzero_pd(), c1 = _mm256_setzero_pd();
+
+   for (int k = 0; k < depth; k++)
+   {
+      __m256d x0 = _mm256_broadcast_sd(x + k);
+      c0 = _mm256_fmadd_pd(x0, _mm256_loadu_pd(w + k * ldw), c0);
+      c1 = _mm256_fmadd_pd(x0, _mm256_loadu_pd(w + k * ldw + 4), c1);
+   }
+
+   _mm256_storeu_pd(y, _mm256_add_pd(_mm256_loadu_pd(y), c0));
+   _mm256_storeu_pd(y + 4, _mm256_add_pd(_mm256_loadu_pd(y + 4), c1));
+}
+
+__attribute__((target("avx2,fma"))) void axpyAvx2(int n, double alpha, const double *x, double *y)
+{
+   __m256d a = _mm256_set1_pd(alpha);
+   int i = 0;
+   for (; i + 4 <= n; i += 4)
+   {
+      _mm256_storeu_pd(y + i, _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+   }
+   for (; i < n; i++)
+   {
+      y[i] += alpha * x[i];
+   }
+}
+
+__attribute__((target("avx2,fma"))) double dotAvx2(int n, const double *x, const double *y)
+{
+   __m256d sum = _mm256_setzero_pd();
+   int i = 0;
+   for (; i + 4 <= n; i += 4)
+   {
+      sum = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), sum);
+   }
+   __m128d half = _mm_add_pd(_mm256_castpd256_pd128(sum), _mm256_extractf128_pd(sum, 1));
+   double total = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+   for (; i < n; i++)
+   {
+      total += x[i] * y[i];
+   }
+   return total;
+}
+
+__attribute__((target("avx2,fma"))) void tile4FloatAvx2(int depth, const float *x, int ldx, const float *w, int ldw, float *y, int ldy)
+{
+   __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+   __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+   __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+   __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+
+   for (int k = 0; k < depth; k++)
+   {
+      __m256 w0 = _mm256_loadu_ps(w + k * ldw);
+      __m256 w1 = _mm256_loadu_ps(w + k * ldw + 8);
+      __m256 x0 = _mm256_broadcast_ss(x + k);
+      __m256 x1 = _mm256_broadcast_ss(x + ldx + k);
+      __m256 x2 = _mm256_broadcast_ss(x + 2 * ldx + k);
+      __m256 x3 = _mm256_broadcast_ss(x + 3 * ldx + k);
+      c00 = _mm256_fmadd_ps(x0, w0, c00);
+      c01 = _mm256_fmadd_ps(x0, w1, c01);
+      c10 = _mm256_fmadd_ps(x1, w0, c10);
+      c11 = _mm256_fmadd_ps(x1, w1, c11);
+      c20 = _mm256_fmadd_ps(x2, w0, c20);
+      c21 = _mm256_fmadd_ps(x2, w1, c21);
+      c30 = _mm256_fmadd_ps(x3, w0, c30);
+      c31 = _mm256_fmadd_ps(x3, w1, c31);
+   }
+
+   _mm256_storeu_ps(y, _mm256_add_ps(_mm256_loadu_ps(y), c00));
+   _mm256_storeu_ps(y + 8, _mm256_add_ps(_mm256_loadu_ps(y + 8), c01));
+   _mm256_storeu_ps(y + ldy, _mm256_add_ps(_mm256_loadu_ps(y + ldy), c10));
+   _mm256_storeu_ps(y + ldy + 8, _mm256_add_ps(_mm256_loadu_ps(y + ldy + 8), c11));
+   _mm256_storeu_ps(y + 2 * ldy, _mm256_add_ps(_mm256_loadu_ps(y + 2 * ldy), c20));
+   _mm256_storeu_ps(y + 2 * ldy + 8, _mm256_add_ps(_mm256_loadu_ps(y + 2 * ldy + 8), c21));
+   _mm256_storeu_ps(y + 3 * ldy, _mm256_add_ps(_mm256_loadu_ps(y + 3 * ldy), c30));
+   _mm256_storeu_ps(y + 3 * ldy + 8, _mm256_add_ps(_mm256_loadu_ps(y + 3 * ldy + 8), c31));
+}
+
+__attribute__((target("avx2,fma"))) void tile1FloatAvx2(int depth, const float *x, const float *w, int ldw, float *y)
+{
+   __m256 c0 = _mm256_setzero_ps(), c1 = _mm256_setzero_ps();
+
+   for (int k = 0; k < depth; k++)
+   {
+      __m256 x0 = _mm256_broadcast_ss(x + k);
+      c0 = _mm256_fmadd_ps(x0, _mm256_loadu_ps(w + k * ldw), c0);
+      c1 = _mm256_fmadd_ps(x0, _mm256_loadu_ps(w + k * ldw + 8), c1);
+   }
+
+   _mm256_storeu_ps(y, _mm256_add_ps(_mm256_loadu_ps(y), c0));
+   _mm256_storeu_ps(y + 8, _mm256_add_ps(_mm256_loadu_ps(y + 8), c1));
+}
+
+__attribute__((target("avx2,fma"))) void axpyFloatAvx2(int n, float alpha, const float *x, float *y)
+{
+   __m256 a = _mm256_set1_ps(alpha);
+   int i = 0;
+   for (; i + 8 <= n; i += 8)
+   {
+      _mm256_storeu_ps(y + i, _mm256_fmadd_ps(a, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+   }
+   for (; i < n; i++)
+   {
+      y[i] += alpha * x[i];
+   }
+}
+
+__attribute__((target("avx2,fma"))) float dotFloatAvx2(int n, const float *x, const float *y)
+{
+   __m256 sum = _mm256_setzero_ps();
+   int i = 0;
+   for (; i + 8 <= n; i += 8)
+   {
+      sum = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), sum);
+   }
+   __m128 half = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+   half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+   half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+   float total = _mm_cvtss_f32(half);
+   for (; i < n; i++)
+   {
+      total += x[i] * y[i];
+   }
+   return total;
+}
+
+// AVX-512 kernels (8 doubles or 16 floats per register, tiles 2 registers wide) ----------------------
+
+__attribute__((target("avx512f"))) void tile4Avx512(int depth, const double *x, int ldx, const double *w, int ldw, double *y, int ldy)
+{
+   __m512d c00 = _mm512_setzero_pd(), c01 = _mm512_setzero_pd();
+   __m512d c10 = _mm512_setzero_pd(), c11 = _mm512_setzero_pd();
+   __m512d c20 = _mm512_setzero_pd(), c21 = _mm512_setzero_pd();
+   __m512d c30 = _mm512_setzero_pd(), c31 = _mm512_setzero_pd();
+
+   for (int k = 0; k < depth; k++)
+   {
+      __m512d w0 = _mm512_loadu_pd(w + k * ldw);
+      __m512d w1 = _mm512_loadu_pd(w + k * ldw + 8);
+      __m512d x0 = _mm512_set1_pd(x[k]);
+      __m512d x1 = _mm512_set1_pd(x[ldx + k]);
+      __m512d x2 = _mm512_set1_pd(x[2 * ldx + k]);
+      __m512d x3 = _mm512_set1_pd(x[3 * ldx + k]);
+      c00 = _mm512_fmadd_pd(x0, w0, c00);
+      c01 = _mm512_fmadd_pd(x0, w1, c01);
+      c10 = _mm512_fmadd_pd(x1, w0, c10);
+      c11 = _mm512_fmadd_pd(x1, w1, c11);
+      c20 = _mm512_fmadd_pd(x2, w0, c20);
+      c21 = _mm512_fmadd_pd(x2, w1, c21);
+      c30 = _mm512_fmadd_pd(x3, w0, c30);
+      c31 = _mm512_fmadd_pd(x3, w1, c31);
+   }
+
+   _mm512_storeu_pd(y, _mm512_add_pd(_mm512_loadu_pd(y), c00));
+   _mm512_storeu_pd(y + 8, _mm512_add_pd(_mm512_loadu_pd(y + 8), c01));
+   _mm512_storeu_pd(y + ldy, _mm512_add_pd(_mm512_loadu_pd(y + ldy), c10));
+   _mm512_storeu_pd(y + ldy + 8, _mm512_add_pd(_mm512_loadu_pd(y + ldy + 8), c11));
+   _mm512_storeu_pd(y + 2 * ldy, _mm512_add_pd(_mm512_loadu_pd(y + 2 * ldy), c20));
+   _mm512_storeu_pd(y + 2 * ldy + 8, _mm512_add_pd(_mm512_loadu_pd(y + 2 * ldy + 8), c21));
+   _mm512_storeu_pd(y + 3 * ldy, _mm512_add_pd(_mm512_loadu_pd(y + 3 * ldy), c30));
+   _mm512_storeu_pd(y + 3 * ldy + 8, _mm512_add_pd(_mm512_loadu_pd(y + 3 * ldy + 8), c31));
+}
+
+__attribute__((target("avx512f"))) void tile1Avx512(int depth, const double *x, const double *w, int ldw, double *y)
+{
+   __m512d c0 = _mm512_setzero_pd(), c1 = _mm512_setzero_pd();
+
+   for (int k = 0; k < depth; k++)
+   {
+      __m512d x0 = _mm512_set1_pd(x[k]);
+      c0 = _mm512_fmadd_pd(x0, _mm512_loadu_pd(w + k * ldw), c0);
+      c1 = _mm512_fmadd_pd(x0, _mm512_loadu_pd(w + k * ldw + 8), c1);
+   }
+
+   _mm512_storeu_pd(y, _mm512_add_pd(_mm512_loadu_pd(y), c0));
+   _mm512_storeu_pd(y + 8, _mm512_add_pd(_mm512_loadu_pd(y + 8), c1));
+}
+
+__attribute__((target("avx512f"))) void axpyAvx512(int n, double alpha, const double *x, double *y)
+{
+   __m512d a = _mm512_set1_pd(alpha);
+   int i = 0;
+   for (; i + 8 <= n; i += 8)
+   {
+      _mm512_storeu_pd(y + i, _mm512_fmadd_pd(a, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+   }
+   for (; i < n; i++)
+   {
+      y[i] += alpha * x[i];
+   }
+}
+
+__attribute__((target("avx512f"))) double dotAvx512(int n, const double *x, const double *y)
+{
+   __m512d sum = _mm512_setzero_pd();
+   int i = 0;
+   for (; i + 8 <= n; i += 8)
+   {
+      sum = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), sum);
+   }
+   double total = _mm512_reduce_add_pd(sum);
+   for (; i < n; i++)
+   {
+      total += x[i] * y[i];
+   }
+   return total;
+}
+
+__attribute__((target("avx512f"))) void tile4FloatAvx512(int depth, const float *x, int ldx, const float *w, int ldw, float *y, int ldy)
+{
+   __m512 c00 = _mm512_setzero_ps(), c01 = _mm512_setzero_ps();
+   __m512 c10 = _mm512_setzero_ps(), c11 = _mm512_setzero_ps();
+   __m512 c20 = _mm512_setzero_ps(), c21 = _mm512_setzero_ps();
+   __m512 c30 = _mm512_setzero_ps(), c31 = _mm512_setzero_ps();
+
+   for (int k = 0; k < depth; k++)
+   {
+      __m512 w0 = _mm512_loadu_ps(w + k * ldw);
+      __m512 w1 = _mm512_loadu_ps(w + k * ldw + 16);
+      __m512 x0 = _mm512_set1_ps(x[k]);
+      __m512 x1 = _mm512_set1_ps(x[ldx + k]);
+      __m512 x2 = _mm512_set1_ps(x[2 * ldx + k]);
+      __m512 x3 = _mm512_set1_ps(x[3 * ldx + k]);
+      c00 = _mm512_fmadd_ps(x0, w0, c00);
+      c01 = _mm512_fmadd_ps(x0, w1, c01);
+      c10 = _mm512_fmadd_ps(x1, w0, c10);
+      c11 = _mm512_fmadd_ps(x1, w1, c11);
+      c20 = _mm512_fmadd_ps(x2, w0, c20);
+      c21 = _mm512_fmadd_ps(x2, w1, c21);
+      c30 = _mm512_fmadd_ps(x3, w0, c30);
+      c31 = _mm512_fmadd_ps(x3, w1, c31);
+   }
+
+   _mm512_storeu_ps(y, _mm512_add_ps(_mm512_loadu_ps(y), c00));
+   _mm512_storeu_ps(y + 16, _mm512_add_ps(_mm512_loadu_ps(y + 16), c01));
+   _mm512_storeu_ps(y + ldy, _mm512_add_ps(_mm512_loadu_ps(y + ldy), c10));
+   _mm512_storeu_ps(y + ldy + 16, _mm512_add_ps(_mm512_loadu_ps(y + ldy + 16), c11));
+   _mm512_storeu_ps(y + 2 * ldy, _mm512_add_ps(_mm512_loadu_ps(y + 2 * ldy), c20));
+   _mm512_storeu_ps(y + 2 * ldy + 16, _mm512_add_ps(_mm512_loadu_ps(y + 2 * ldy + 16), c21));
+   _mm512_storeu_ps(y + 3 * ldy, _mm512_add_ps(_mm512_loadu_ps(y + 3 * ldy), c30));
+   _mm512_storeu_ps(y + 3 * ldy + 16, _mm512_add_ps(_mm512_loadu_ps(y + 3 * ldy + 16), c31));
+}
+
+__attribute__((target("avx512f"))) void tile1FloatAvx512(int depth, const float *x, const float *w, int ldw, float *y)
+{
+   __m512 c0 = _mm512_setzero_ps(), c1 = _mm512_setzero_ps();
+
+   for (int k = 0; k < depth; k++)
+   {
+      __m512 x0 = _mm512_set1_ps(x[k]);
+      c0 = _mm512_fmadd_ps(x0, _mm512_loadu_ps(w + k * ldw), c0);
+      c1 = _mm512_fmadd_ps(x0, _mm512_loadu_ps(w + k * ldw + 16), c1);
+   }
+
+   _mm512_storeu_ps(y, _mm512_add_ps(_mm512_loadu_ps(y), c0));
+   _mm512_storeu_ps(y + 16, _mm512_add_ps(_mm512_loadu_ps(y + 16), c1));
+}
+
+__attribute__((target("avx512f"))) void axpyFloatAvx512(int n, float alpha, const float *x, float *y)
+{
+   __m512 a = _mm512_set1_ps(alpha);
+   int i = 0;
+   for (; i + 16 <= n; i += 16)
+   {
+      _mm512_storeu_ps(y + i, _mm512_fmadd_ps(a, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+   }
+   for (; i < n; i++)
+   {
+      y[i] += alpha * x[i];
+   }
+}
+
+__attribute__((target("avx512f"))) float dotFloatAvx512(int n, const float *x, const float *y)
+{
+   __m512 sum = _mm512_setzero_ps();
+   int i = 0;
+   for (; i + 16 <= n; i += 16)
+   {
+      sum = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), sum);
+   }
+   float total = _mm512_reduce_add_ps(sum);
+   for (; i < n; i++)
+   {
+      total += x[i] * y[i];
+   }
+   return total;
+}
+
+#endif
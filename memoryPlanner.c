@@ -0,0 +1,401 @@
+/**
+ * Created 10/18/2026
+ * This file works out how much memory a network will need before any of
+ * it is allocated, so that a config that is too large is turned away (or
+ * trained another way) up front instead of failing partway through
+ * loading or running the machine out of memory.
+ *
+ * Once every setting is known (see parseConfig in ./network.c), the
+ * planner adds up the exact bytes of every large allocation the config
+ * leads to, laid out the way the network lays them out: the weights, the
+ * buffers of a run, what training keeps beside the weights (the rollback
+ * copy, the gradients of a pipeline or of distributed training, the
+ * snapshots that are validated), the convolution layer's and the
+ * projection's buffers, and the training sets (with the cached outputs of
+ * their frozen layers).
+ * The total is compared against the memory_budget setting, or against the
+ * memory that is available if there is no budget.
+ *
+ * If everything fits, the training sets are held in memory as usual. If
+ * only the training sets do not fit, training streams them from the file
+ * instead, streamChunkSets at a time (as many as fit in what is left of
+ * the budget), and trains on each chunk as it is read. If even the rest
+ * does not fit, the config is turned away.
+ *
+ * Functions in this file:
+ *
+ * int planMemory(Network *net)
+ * unsigned long long getAvailableMemory(void)
+ * void trainStreamedEpoch(Network *net)
+ * unsigned long long findScratchBytes(const Network *net, int maxNodesInALayer)
+ * void printMemoryLine(char *name, unsigned long long bytes)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "./headerfiles/augment.h"          // importing the augmenter's queue length
+#include "./headerfiles/freeze.h"           // importing the size of the frozen layers' cache
+#include "./headerfiles/networkInternals.h" // importing the network layout and functions
+#include "./headerfiles/memoryPlanner.h"
+
+#define BYTES_PER_MEGABYTE (1024.0 * 1024.0)
+
+// function headers ----------------------
+
+unsigned long long findScratchBytes(const Network *, int);
+void printMemoryLine(char *, unsigned long long);
+
+// functions ----------------------
+
+/**
+ * Works out the memory the network will need, prints where it goes, and
+ * decides whether the training sets are held in memory or streamed while
+ * training (setting streamTrainingSets and streamChunkSets). Nothing is
+ * allocated; this is called once every setting is known and the
+ * convolution layer (if any) is set up, but before the training sets and
+ * weights are allocated.
+ *
+ * @param net the network to plan for
+ * @return 0 if the network fits in the budget, -1 otherwise
+ */
+int planMemory(Network *net)
+{
+   int numLayers = net->numLayers;
+
+   // the sizes of the layers once the input layer is what it will be (reduced inputs, or the convolution layer's outputs)
+   int inputLayerSize = net->inputReduction != 0 ? net->numReducedInputs : net->layerDimensions[0];
+   int maxNodesInALayer = inputLayerSize;
+   for (int layer = 1; layer < numLayers; layer++)
+   {
+      if (net->layerDimensions[layer] > maxNodesInALayer)
+      {
+         maxNodesInALayer = net->layerDimensions[layer];
+      }
+   }
+
+   unsigned long long maxWeightsInALayer = (unsigned long long)maxNodesInALayer * maxNodesInALayer;
+   unsigned long long numFilterWeights =
+       net->convFilters > 0 ? (unsigned long long)net->inputChannels * net->convFilterSize * net->convFilterSize * net->convFilters
+                            : 0;
+   unsigned long long totalWeights = maxWeightsInALayer * (numLayers - 1) + numFilterWeights;
+
+   unsigned long long numUsedWeights = numFilterWeights; // the weights without the padding (see findNumUsedWeights)
+   for (int m = 0; m < numLayers - 1; m++)
+   {
+      numUsedWeights += (unsigned long long)(m == 0 ? inputLayerSize : net->layerDimensions[m]) * net->layerDimensions[m + 1];
+   }
+
+   // the training sets, as takeTrainingSetsInputs lays them out
+   int doublesPerRow = DATA_ALIGNMENT / sizeof(double);
+   net->inputStride = (net->numInputNodes + doublesPerRow - 1) / doublesPerRow * doublesPerRow;
+
+   char holdsTrainingSets = net->trainNetwork == 'Y' || net->numShards > 1;
+   if (holdsTrainingSets)
+   {
+      FILE *nodesFile = fopen(net->nodesFileInput, "r");
+      unsigned int totalTrainingSets = 0;
+      if (nodesFile == NULL || fscanf(nodesFile, "%x", &totalTrainingSets) != 1)
+      {
+         printf("There was an error opening the training sets file %s.\n", net->nodesFileInput);
+         if (nodesFile != NULL)
+         {
+            fclose(nodesFile);
+         }
+         return -1;
+      }
+      fclose(nodesFile);
+      net->totalTrainingSets = (int)totalTrainingSets;
+
+      int firstValue;
+      int endValue;
+      calculateShardBounds(net, &firstValue, &endValue); // only this shard's sets are held
+   }
+
+   unsigned long long setBytes = ((unsigned long long)net->inputStride + net->numOutputNodes) * sizeof(double);
+   if (net->inputReduction != 0)
+   {
+      setBytes += (unsigned long long)net->numReducedInputs * sizeof(double); // reduced once they are loaded
+   }
+
+   // everything but the training sets
+   unsigned long long weightsBytes = (maxWeightsInALayer * numLayers + numFilterWeights) * sizeof(double);
+   unsigned long long scratchBytes = findScratchBytes(net, maxNodesInALayer);
+
+   unsigned long long optimizerBytes = 0;
+   if (net->trainNetwork == 'Y' && net->enableWeightRollback == 'Y' && net->learningFactorScaler != 1.0)
+   {
+      optimizerBytes += totalWeights * sizeof(double); // the weights rolled back to
+   }
+   if (net->numShards > 1)
+   {
+      optimizerBytes += (2 * totalWeights + numUsedWeights + numUsedWeights / net->numShards + 3) * sizeof(double); // see ./distributed.c
+   }
+
+   unsigned long long projectionBytes = 0;
+   if (net->inputReduction != 0)
+   {
+      projectionBytes = ((unsigned long long)net->numInputNodes + 1) * net->numReducedInputs * sizeof(double);
+   }
+
+   unsigned long long fixedBytes = weightsBytes + scratchBytes + optimizerBytes + projectionBytes;
+
+   // what only comes with the training sets in memory
+   unsigned long long inMemoryBytes = 0;
+   if (holdsTrainingSets)
+   {
+      inMemoryBytes = (unsigned long long)net->numTrainingSets * setBytes;
+      if (net->augmentCopies > 0)
+      {
+         inMemoryBytes += (unsigned long long)AUGMENT_QUEUE_LENGTH * net->inputStride * sizeof(double);
+      }
+      if (net->pipelineStages > 1)
+      {
+         int numSlots = 2 * net->pipelineStages < net->pipelineBatchSize ? 2 * net->pipelineStages : net->pipelineBatchSize;
+         inMemoryBytes += totalWeights * sizeof(double) + numSlots * scratchBytes; // see ./pipeline.c
+      }
+      if (net->validationFraction > 0.0 && net->trainNetwork == 'Y' && net->numShards == 1)
+      {
+         inMemoryBytes += 4 * numUsedWeights * sizeof(double) + weightsBytes + scratchBytes; // see ./validation.c
+      }
+      if (net->trainNetwork == 'Y' && net->freezeCacheFile[0] == '\0' && net->pipelineStages <= 1)
+      {
+         inMemoryBytes += (unsigned long long)net->numTrainingSets * findFrozenLayerSize(net) * sizeof(double); // see ./freeze.c
+      }
+   }
+
+   unsigned long long budget = net->memoryBudget > 0.0 ? (unsigned long long)(net->memoryBudget * BYTES_PER_MEGABYTE)
+                                                       : getAvailableMemory();
+
+   net->streamTrainingSets = 'n';
+   unsigned long long trainingSetsBytes = inMemoryBytes;
+
+   if (fixedBytes + inMemoryBytes > budget && holdsTrainingSets && net->numShards == 1 && budget > fixedBytes)
+   {
+      unsigned long long chunkSets = (budget - fixedBytes) / ((unsigned long long)net->inputStride * sizeof(double) +
+                                                              net->numOutputNodes * sizeof(double));
+      if (chunkSets > 0)
+      {
+         net->streamTrainingSets = 'Y';
+         net->streamChunkSets = chunkSets < (unsigned long long)net->numTrainingSets ? (int)chunkSets : net->numTrainingSets;
+         trainingSetsBytes = (unsigned long long)net->streamChunkSets * (net->inputStride + net->numOutputNodes) * sizeof(double);
+      }
+   }
+
+   unsigned long long totalBytes = fixedBytes + trainingSetsBytes;
+
+   printf("Memory plan (%s %.1lfMB):\n", net->memoryBudget > 0.0 ? "budget" : "available", budget / BYTES_PER_MEGABYTE);
+   printMemoryLine("weights", weightsBytes);
+   printMemoryLine("buffers of a run", scratchBytes);
+   printMemoryLine("training state", optimizerBytes);
+   printMemoryLine("projection", projectionBytes);
+   printMemoryLine("training sets", trainingSetsBytes);
+   printMemoryLine("total", totalBytes);
+
+   if (!holdsTrainingSets)
+   {
+      printf("   the training sets are streamed one at a time, since the network only runs\n");
+   }
+   else if (net->streamTrainingSets == 'Y')
+   {
+      printf("   the %d training sets (%.1lfMB) do not fit, so training streams them %d at a time\n", net->numTrainingSets,
+             inMemoryBytes / BYTES_PER_MEGABYTE, net->streamChunkSets);
+      if (net->augmentCopies > 0 || net->pipelineStages > 1 || net->validationFraction > 0.0)
+      {
+         printf("   augmentation, pipelines, and validation need the training sets in memory, so they are off\n");
+         net->augmentCopies = 0;
+         net->pipelineStages = 0;
+         net->validationFraction = 0.0;
+      }
+   }
+
+   if (totalBytes > budget)
+   {
+      printf("The network needs %.1lfMB, which is more than the %.1lfMB it may use.\n", totalBytes / BYTES_PER_MEGABYTE,
+             budget / BYTES_PER_MEGABYTE);
+      return -1;
+   }
+
+   return 0;
+}
+
+/**
+ * Finds how much physical memory the process could use without swapping.
+ * On Linux this is MemAvailable from /proc/meminfo, which counts the page
+ * cache that can be given back as well as the memory that is free (the
+ * free pages alone are often a small part of it, since the kernel keeps
+ * memory busy caching files).
+ *
+ * @return the bytes of physical memory that are available for the process to use
+ */
+unsigned long long getAvailableMemory(void)
+{
+#ifdef _WIN32
+   MEMORYSTATUSEX status;
+   status.dwLength = sizeof(status);
+   if (GlobalMemoryStatusEx(&status))
+   {
+      return (unsigned long long)status.ullAvailPhys;
+   }
+   return 0;
+#else
+   FILE *memInfo = fopen("/proc/meminfo", "r");
+   if (memInfo != NULL)
+   {
+      char line[256];
+      unsigned long long availableKilobytes = 0;
+      int found = 0;
+
+      while (!found && fgets(line, sizeof(line), memInfo) != NULL)
+      {
+         found = sscanf(line, "MemAvailable: %llu kB", &availableKilobytes) == 1;
+      }
+      fclose(memInfo);
+
+      if (found)
+      {
+         return availableKilobytes * 1024;
+      }
+   }
+
+   // without MemAvailable (an older kernel, or not Linux), only the free pages are known
+#ifdef _SC_AVPHYS_PAGES
+   long numPages = sysconf(_SC_AVPHYS_PAGES);
+#else
+   long numPages = sysconf(_SC_PHYS_PAGES);
+#endif
+   long pageSize = sysconf(_SC_PAGESIZE);
+
+   return numPages > 0 && pageSize > 0 ? (unsigned long long)numPages * pageSize : 0;
+#endif
+}
+
+/**
+ * Trains the network once for all training sets, reading them from the
+ * training sets file streamChunkSets at a time and training on each chunk
+ * as soon as it is read, then calculates the new error. This takes the
+ * place of trainForAllTrainingSets in ./network.c when the training sets
+ * do not fit in memory, and trains the same way.
+ *
+ * @param net the network to train (with streamed training sets)
+ */
+void trainStreamedEpoch(Network *net)
+{
+   FILE *nodesFile = fopen(net->nodesFileInput, "r");
+   double *chunkInputs = allocateAligned((size_t)net->streamChunkSets * net->inputStride * sizeof(double));
+   double *chunkLabels = malloc((size_t)net->streamChunkSets * net->numOutputNodes * sizeof(double));
+   double *oldWeights = NULL;
+   // only enable weight rollback if adaptive learning is enabled as well
+   if (net->enableWeightRollback == 'Y' && net->learningFactorScaler != 1.0)
+   {
+      oldWeights = malloc(net->totalWeights * sizeof(double));
+   }
+
+   unsigned int totalSets = 0;
+   if (nodesFile == NULL || fscanf(nodesFile, "%x", &totalSets) != 1 ||
+       chunkInputs == NULL || chunkLabels == NULL ||
+       (oldWeights == NULL && net->enableWeightRollback == 'Y' && net->learningFactorScaler != 1.0))
+   {
+      printf("There was an error streaming the training sets file %s.\n", net->nodesFileInput);
+      if (nodesFile != NULL)
+      {
+         fclose(nodesFile);
+      }
+      freeAligned(chunkInputs);
+      free(chunkLabels);
+      free(oldWeights);
+      return;
+   }
+
+   for (size_t i = 0; i < (size_t)net->streamChunkSets * net->inputStride; i++)
+   {
+      chunkInputs[i] = 0.0; // padding
+   }
+
+   for (int i = 0; oldWeights != NULL && i < net->totalWeights; i++)
+   {
+      oldWeights[i] = net->weights[i]; // storing old weights
+   }
+
+   int numSets = (int)totalSets;
+   double errorSum = 0.0;
+   int numRead = 0;
+
+   while (numRead < numSets)
+   {
+      int chunkSize = 0;
+      for (; chunkSize < net->streamChunkSets && numRead + chunkSize < numSets; chunkSize++) // reading the chunk
+      {
+         if (readTrainingSet(net, nodesFile, chunkInputs + (size_t)chunkSize * net->inputStride,
+                             chunkLabels + (size_t)chunkSize * net->numOutputNodes) != 0)
+            break;
+      }
+
+      for (int t = 0; t < chunkSize; t++) // training on it
+      {
+         double *expectedOutputs = chunkLabels + (size_t)t * net->numOutputNodes;
+
+         net->scratch->expectedOutputs = expectedOutputs;
+         runNetwork(net, net->scratch, chunkInputs + (size_t)t * net->inputStride, NULL);
+         updateWeights(net, expectedOutputs);
+
+         errorSum += net->scratch->error;
+      }
+
+      numRead += chunkSize;
+      if (chunkSize == 0 || (chunkSize < net->streamChunkSets && numRead < numSets)) // the file ran out
+         break;
+   } // while (numRead < numSets)
+
+   net->scratch->expectedOutputs = NULL;
+
+   adaptLearningFactor(net, errorSum, oldWeights);
+
+   fclose(nodesFile);
+   freeAligned(chunkInputs);
+   free(chunkLabels);
+   free(oldWeights);
+
+   return;
+}
+
+/**
+ * Finds the bytes of the buffers of one run (see createScratch in ./network.c).
+ *
+ * @param net the network
+ * @param maxNodesInALayer the most nodes in any layer, once the input layer is set
+ * @return the bytes of a NetworkScratch and its buffers
+ */
+unsigned long long findScratchBytes(const Network *net, int maxNodesInALayer)
+{
+   unsigned long long bytes = sizeof(NetworkScratch) + 3ULL * maxNodesInALayer * net->numLayers * sizeof(double);
+
+   if (net->convFilters > 0)
+   {
+      unsigned long long numPositions = (unsigned long long)net->convWidth * net->convHeight;
+      unsigned long long depth = (unsigned long long)net->inputChannels * net->convFilterSize * net->convFilterSize;
+
+      bytes += numPositions * (depth + 2ULL * net->convFilters) * sizeof(double) + net->layerDimensions[0] * sizeof(int);
+   }
+
+   return bytes;
+}
+
+/**
+ * Prints one line of the memory plan.
+ *
+ * @param name what the memory is for
+ * @param bytes how much of it there is
+ */
+void printMemoryLine(char *name, unsigned long long bytes)
+{
+   printf("   %-18s %12.3lfMB\n", name, bytes / BYTES_PER_MEGABYTE);
+
+   return;
+}
@@ -2,43 +2,109 @@
  * Gloria Zhu
  * Created 9/7/2019
  * This file defines and runs a network.
- * 
+ *
+ * Every function here works on a Network handle (see ./headerfiles/network.h)
+ * instead of process-wide state, so a process can hold several networks at
+ * once. Functions that only read a network and write to a NetworkScratch
+ * (such as runNetwork) are safe to call from many threads at once, as long
+ * as every thread has its own scratch.
+ *
  * Functions in this file:
- * 
- * void parseConfig(void)
- * void takeDimensionInputs(void)
- * void takeTrainingSetsInputs(void)
- * void initializeWeightsFromFile(void)
- * void initializeWeightsRandomly(double, double)
- * double randomNumber(double, double)
- * void writeWeightsToFile(void)
- * void writeOutputsToFile(void)
- * void calculateNumNodesAndWeights(void)
- * void freeMemory(void)
- * 
- * void printWeights(void)
- * void printNetworkConfiguration(void)
- * void runNetwork(void)
- * 
- * double calculateError(void)
- * void runForAllTrainingSets(void);
- * void trainForAllTrainingSets(void);
- * void train(int, double);
+ *
+ * Network *createNetwork(char *)
+ * Network *createNetworkShard(char *, int, int)
+ * void freeNetwork(Network *)
+ * NetworkScratch *createScratch(const Network *)
+ * void freeScratch(NetworkScratch *)
+ * int parseConfig(Network *, char *)
+ * void parseOptionalSetting(Network *, char *, char *)
+ * int takeTrainingSetsInputs(Network *)
+ * int readTrainingSet(Network *, FILE *, double *, double *)
+ * void calculateShardBounds(Network *, int *, int *)
+ * int initializeWeightsFromFile(Network *, char *)
+ * void initializeWeightsRandomly(Network *, double, double)
+ * double randomNumber(Network *, double, double)
+ * double randomNumberAt(unsigned long long, unsigned long long, double, double)
+ * void *fillRandomWeights(void *)
+ * void *allocateAligned(size_t)
+ * void freeAligned(void *)
+ * int writeWeightsToFile(const Network *, char *)
+ * int saveCheckpoint(const Network *, char *)
+ * int loadCheckpoint(Network *, char *)
+ * int findNumUsedWeights(const Network *)
+ * void packWeights(const Network *, const double *, double *)
+ * void unpackWeights(const Network *, const double *, double *)
+ * void writeOutputsToFile(Network *)
+ * void calculateNumNodesAndWeights(Network *)
+ * int getNumInputNodes(const Network *)
+ * int getNumOutputNodes(const Network *)
+ *
+ * void printWeights(const Network *)
+ * void runNetwork(const Network *, NetworkScratch *, double *, double *)
+ * double *prepareInputLayer(const Network *, NetworkScratch *, double *)
+ * void runFromInputLayer(const Network *, NetworkScratch *, double *, double *)
+ * void runConnectivityLayer(const Network *, NetworkScratch *, int)
+ * void finishOutputLayer(const Network *, NetworkScratch *, double *)
+ * void runTrainingSet(Network *, int)
+ *
+ * void updateWeights(Network *, double *)
+ * void calculatePsis(const Network *, NetworkScratch *, double *)
+ * void calculateOutputPsis(const Network *, NetworkScratch *, double *)
+ * void calculateLayerPsis(const Network *, NetworkScratch *, int)
+ * double calculateGradients(Network *, int, int, double *)
+ * char adaptLearningFactor(Network *, double, double *)
+ * void runForAllTrainingSets(Network *);
+ * void trainForAllTrainingSets(Network *);
+ * void train(Network *, int, double);
  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <time.h> // need this library to get unique seed (current unix time) for rng
+#include <pthread.h>
 
 #include "./headerfiles/outputFunctions.h"     // importing output,
 #include "./headerfiles/activationFunctions.h" // activation, and
 #include "./headerfiles/errorFunctions.h"      // error functions
 
-#include "./headerfiles/dibdump.h" // importing dibdump functions
+#include "./headerfiles/dibdump.h"         // importing dibdump functions
+#include "./headerfiles/matrixFunctions.h" // importing matrix kernels
+#include "./headerfiles/autoTune.h"        // and the tuner for them
+#include "./headerfiles/logger.h"          // importing the logger
+#include "./headerfiles/pruning.h"         // importing pruning functions
+#include "./headerfiles/convolution.h"     // importing the convolution layer
+#include "./headerfiles/projection.h"      // importing the input reduction
+#include "./headerfiles/augment.h"         // importing the augmenter
+#include "./headerfiles/pipeline.h"        // importing pipelined training
+#include "./headerfiles/memoryPlanner.h"   // importing the memory planner
+#include "./headerfiles/validation.h"      // importing validation while training
+#include "./headerfiles/freeze.h"          // importing frozen layers
+#include "./headerfiles/textParser.h"      // importing the text parser
+
+#include "./headerfiles/networkInternals.h" // importing the network layout and functions
+#include "./headerfiles/distributed.h"      // importing distributed training functions
+
+#define CHECKPOINT_MAGIC "NNCKPT02"      // marks the start of a checkpoint file (and its version)
+#define CHECKPOINT_MAGIC_LENGTH 8
+#define RANDOM_STEP 0x9E3779B97F4A7C15ULL // how far the random number generator's state moves per number
 
-#define MAX_FILE_NAME_LENGTH 2048        // max characters in a file name
-#define UNSIGNED_INT_SCALER 4294967295.0 // used for scaling the pels to [0,1]
+/**
+ * The part of the weights one thread fills with random values
+ * (see initializeWeightsRandomly).
+ */
+struct WeightsFill
+{
+   Network *net;
+   unsigned long long key; // the generator's state before the first weight
+   double lowerBound;      // the bounds of uniform weights
+   double upperBound;
+   int firstRow;           // the rows of weights to fill (the rows of every layer, one after another)
+   int endRow;
+   int firstFilterWeight;  // the convolution filters' weights to fill
+   int endFilterWeight;
+};
 
 /**
  * This function pointer refers to the output function
@@ -57,533 +123,1624 @@ double (*outputDerivFunction)(double value) = &sigmoidDeriv; // set the output d
 
 /**
  * This function pointer refers to the activation function
- * to be used in calculating the activation of a unit according 
- * to input. Activation functions are 
+ * to be used in calculating the activation of a unit according
+ * to input. Activation functions are
  * defined in ./activationFunctions.c and included in this file.
  */
 double (*activationFunction)(double input) = &identity; // set the activation function here
 
 /**
- * This function pointer refers to the error function
- * to be used in calculating error. Error functions are
- * defined in ./errorFunctions.c and included in this file.
+ * Creates a network from a config file (see the README for details on
+ * the options), including its training sets and starting weights.
+ *
+ * @param configFilename the path to the config file
+ * @return the new network, or NULL if the config could not be read
  */
-double (*errorFunction)(
-    double expectedOutput[],
-    double actualOutput[],
-    int numNodes) = &quadraticLoss; // set the error function here
+Network *createNetwork(char *configFilename)
+{
+   return createNetworkShard(configFilename, 0, 1);
+}
 
-// function headers ----------------------
+/**
+ * Creates a network from a config file that only holds one shard of
+ * the training sets in the config (used by distributed workers).
+ *
+ * @param configFilename the path to the config file
+ * @param shardIndex which shard of the training sets to hold
+ * @param numShards how many shards the training sets are split into
+ * @return the new network, or NULL if the config could not be read
+ */
+Network *createNetworkShard(char *configFilename, int shardIndex, int numShards)
+{
+   Network *net = calloc(1, sizeof(Network));
+   if (net == NULL)
+   {
+      printf("There was an error allocating memory for the network.\n");
+      return NULL;
+   }
 
-// functions that handle utility tasks like i/o and mem allocation
-void parseConfig(void);
-void takeDimensionInputs(void);
-void takeTrainingSetsInputs(void);
-void initializeWeightsFromFile(void);
-void initializeWeightsRandomly(double, double);
-double randomNumber(double, double);
-void writeWeightsToFile(void);
-void writeOutputsToFile(void);
-void calculateNumNodesAndWeights(void);
-void freeMemory(void);
+   net->shardIndex = shardIndex;
+   net->numShards = numShards;
+   net->epochFunction = &trainForAllTrainingSets;
+   net->errorFunction = &quadraticLoss; // can be changed with the error_function setting
+   net->useSoftmax = 'n';
+   net->autoTune = 'n';
+   strcpy(net->tuningFile, "./tuning.txt");
+   strcpy(net->projectionFile, "./projection.bin");
+   net->resume = 'n';
+   net->pruneSteps = 1;
+   net->sparseThreshold = 0.5;
+   net->convFilterSize = 5;
+   net->convStride = 1;
+   net->poolSize = 2;
+   net->augmentThreads = 1;
+   net->augmentFlip = 'n';
+   net->scanStride = 8;
+   net->scanThreads = 1;
+   net->scanBatchSize = 16;
+   strcpy(net->predictionsFile, "./predictions.bin");
+   net->predictionsFormat = 'b';
+   net->predictionThreads = 1;
+   strcpy(net->exportName, "baked");
+   net->fixedSeed = 'n';
+   net->weightInitialization = 'u';
+   net->pipelineBatchSize = 16;
+   net->streamTrainingSets = 'n';
+   net->validationEvery = 1;
+   net->validationPatience = 10;
+   net->onlinePublishSeconds = 5.0;
+   net->onlineKeepVersions = 3;
+
+   selectMatrixKernels(); // picking the matrix kernels before any thread can use them
+
+   if (parseConfig(net, configFilename) != 0)
+   {
+      freeNetwork(net);
+      return NULL;
+   }
 
-// functions for printing and debugging
-void printWeights(void);
-void printNetworkConfiguration(void);
+   net->augmentSeed = net->randomState; // replaced by the checkpoint's if training resumes
 
-// functions that run/train the network
-void runNetwork(void);
-double calculateError(void);
-void runForAllTrainingSets(void);   // does not train
-void trainForAllTrainingSets(void); // helper function
-void train(int, double);
+   if (net->resume == 'Y' && loadCheckpoint(net, net->checkpointFile) != 0)
+   {
+      freeNetwork(net);
+      return NULL;
+   }
 
-// variable declarations ----------------------
+   findSparseLayers(net); // weights that were saved pruned are run sparsely (see ./pruning.c)
 
-// variables that describe the structure of the network
-char configFilename[MAX_FILE_NAME_LENGTH];
+   if (net->autoTune == 'Y')
+   {
+      autoTuneNetwork(net);
+   }
 
-int numLayers;
-int numHiddenLayers;
-int numInputNodes;
-int *layerDimensions;
-int numOutputNodes;
+   if (net->augmentCopies > 0 && net->numShards > 1)
+   {
+      printf("Augmented copies cannot be trained on by a distributed group, so augment_copies must be 0.\n");
+      freeNetwork(net);
+      return NULL;
+   }
 
-char useRandomWeights;
+   if (net->augmentCopies > 0 && net->trainingInputs != NULL)
+   {
+      if (findInputShape(net) != 0 || (net->augmenter = createAugmenter(net)) == NULL)
+      {
+         freeNetwork(net);
+         return NULL;
+      }
+   }
 
-// arrays that hold the actual values of the network
-double *nodes;
-double *weights;
-double *expectedOutputs;
+   if (net->streamTrainingSets == 'Y')
+   {
+      net->epochFunction = &trainStreamedEpoch;
+   }
 
-// backprop arrays
-double *thetas;
-double *psis;
+   if (net->pipelineStages > 1 && net->trainingInputs != NULL && net->numShards == 1)
+   {
+      if ((net->pipeline = createPipeline(net)) == NULL)
+      {
+         freeNetwork(net);
+         return NULL;
+      }
+      net->epochFunction = &trainPipelinedEpoch;
+   }
 
-// calculated values related to the structure of the network
-int totalWeights;
-int maxNodesInALayer;
-int maxWeightsInALayer;
+   if (net->numValidationSets > 0 && (net->validator = createValidator(net)) == NULL)
+   {
+      freeNetwork(net);
+      return NULL;
+   }
 
-// file paths for i/o files
-char weightsFileInput[MAX_FILE_NAME_LENGTH];
-char weightsFileOutput[MAX_FILE_NAME_LENGTH];
+   // printing is handed off to a logger thread if there is anything to print
+   if (net->printDebugMessages == 'Y' || net->printNetworkSpecifics == 'Y' || net->statusFile[0] != '\0')
+   {
+      net->logger = createLogger(net->numInputNodes + 2 * net->numOutputNodes, net->statusFile);
+   }
+
+   return net;
+}
+
+/**
+ * This function is responsible for freeing a network
+ * after running/training it.
+ *
+ * @param net the network to free
+ */
+void freeNetwork(Network *net)
+{
+   freePipeline(net->pipeline);   // stopped first, since their threads read the weights and training sets
+   freeValidator(net->validator);
+   freeAugmenter(net->augmenter);
+   freeLogger(net->logger);
+   freeSparseLayers(net);
+   freeProjection(net);
+   freeFrozenActivations(net);
+   free(net->layerDimensions);
+   free(net->frozenLayers);
+   free(net->weights);
+   freeAligned(net->trainingInputs);
+   free(net->trainingLabels);
+   if (net->scratch != NULL)
+   {
+      freeScratch(net->scratch);
+   }
+   free(net);
 
-char nodesFileInput[MAX_FILE_NAME_LENGTH];
-char nodesFileOutput[MAX_FILE_NAME_LENGTH];
-int numTrainingSets;
+   return;
+}
 
-char useBitmap;
-char bitmapFileInput[MAX_FILE_NAME_LENGTH];
-char bitmapFileOutput[MAX_FILE_NAME_LENGTH];
+/**
+ * Allocates the buffers needed for one pass through a network.
+ * Each thread running a network at the same time needs its own.
+ *
+ * @param net the network the scratch will be used with
+ * @return the new scratch, or NULL if memory could not be allocated
+ */
+NetworkScratch *createScratch(const Network *net)
+{
+   NetworkScratch *scratch = malloc(sizeof(NetworkScratch));
+   if (scratch == NULL)
+   {
+      printf("There was an error allocating memory for a scratch.\n");
+      return NULL;
+   }
 
-// values related to training
-char trainNetwork;          // whether or not to train (Y for yes, anything else for no)
-char printNetworkSpecifics; // whether or not to print the specific values of the network
-char printDebugMessages;    // whether or not to print debug messages
-char enableWeightRollback;  // whether or not to enable weight rollback
+   scratch->nodes = malloc(net->maxNodesInALayer * net->numLayers * sizeof(double));
+   if (scratch->nodes == NULL)
+   {
+      printf("There was an error allocating memory for nodes.\n");
+   }
+   scratch->inputs = NULL; // bound to the caller's inputs on every run
+   scratch->expectedOutputs = NULL;
+   scratch->convColumns = NULL;
+   scratch->convThetas = NULL;
+   scratch->convPsis = NULL;
+   scratch->poolIndices = NULL;
+
+   scratch->thetas = malloc(net->maxNodesInALayer * net->numLayers * sizeof(double));
+   if (scratch->thetas == NULL)
+   {
+      printf("There was an error allocating memory for thetas.\n");
+   }
+   scratch->psis = malloc(net->maxNodesInALayer * net->numLayers * sizeof(double));
+   if (scratch->psis == NULL)
+   {
+      printf("There was an error allocating memory for psis.\n");
+   }
 
-double *trainingSets; // stores training set values
+   if (scratch->nodes == NULL || scratch->thetas == NULL || scratch->psis == NULL)
+   {
+      freeScratch(scratch);
+      return NULL;
+   }
 
-double error;                // current error of network (set to some initial config value)
-double learningFactor;       // current lambda value
-double learningFactorScaler; // lambda scaler
+   if (net->convFilters > 0)
+   {
+      size_t numPositions = (size_t)net->convWidth * net->convHeight;
+      int depth = net->inputChannels * net->convFilterSize * net->convFilterSize;
+
+      scratch->convColumns = malloc(numPositions * depth * sizeof(double));
+      scratch->convThetas = malloc(numPositions * net->convFilters * sizeof(double));
+      scratch->convPsis = malloc(numPositions * net->convFilters * sizeof(double));
+      scratch->poolIndices = malloc(net->layerDimensions[0] * sizeof(int));
+      if (scratch->convColumns == NULL || scratch->convThetas == NULL || scratch->convPsis == NULL ||
+          scratch->poolIndices == NULL)
+      {
+         printf("There was an error allocating memory for the convolution layer.\n");
+         freeScratch(scratch);
+         return NULL;
+      }
+   }
 
-double minLearningFactor; // lower bound for lambda value
-double maxLearningFactor; // upper bound for lambda value
+   return scratch;
+}
 
-int dumpEveryIterations; // dump weights/outputs every _x_ iterations
+/**
+ * Frees a scratch made by createScratch.
+ *
+ * @param scratch the scratch to free
+ */
+void freeScratch(NetworkScratch *scratch)
+{
+   free(scratch->nodes);
+   free(scratch->thetas);
+   free(scratch->psis);
+   free(scratch->convColumns);
+   free(scratch->convThetas);
+   free(scratch->convPsis);
+   free(scratch->poolIndices);
+   free(scratch);
 
-int maxIterations;  // max number of iterations before stopping
-double targetError; // training stops when error reaches this value
+   return;
+}
 
 /**
- * The main function makes the actual calls that complete parts
- * of the process of running a neural network.
+ * This function parses in all of the network's options through the
+ * config file (see the README for details on the options).
+ *
+ * @param net the network to fill in
+ * @param configFilename the path to the config file
+ * @return 0 on success, -1 if the config could not be read
  */
-int main()
+int parseConfig(Network *net, char *configFilename)
 {
-    printf("What config file should I use? ");
-    scanf("%s", &configFilename);
-    parseConfig();
+   FILE *config = fopen(configFilename, "r");
+   if (config == NULL)
+   {
+      printf("There was an error opening the config file %s.\n", configFilename);
+      return -1;
+   }
+
+   char dummy[MAX_FILE_NAME_LENGTH]; // dummy value for handling the descriptor strings in the config file
+
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%d", &net->numInputNodes); // reading in number of input nodes
+
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%d", &net->numHiddenLayers); // reading in number of hidden layers
+
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%d", &net->numOutputNodes); // reading in number of output nodes
+
+   net->numLayers = net->numHiddenLayers + 2; // setting some network structure values
+   net->layerDimensions = calloc(net->numLayers, sizeof(int));
+   net->frozenLayers = calloc(net->numLayers - 1, sizeof(char)); // one per connectivity layer
+   if (net->layerDimensions == NULL || net->frozenLayers == NULL)
+   {
+      printf("There was an error allocating memory for the layers.\n");
+      fclose(config);
+      return -1;
+   }
+   net->layerDimensions[0] = net->numInputNodes;
+   net->layerDimensions[net->numLayers - 1] = net->numOutputNodes;
+
+   for (int i = 0; i < net->numHiddenLayers; i++) // taking in hidden layer dimensions
+   {
+      fscanf(config, "%s", dummy);
+      fscanf(config, "%d", net->layerDimensions + i + 1);
+   }
+
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%s", dummy);
+   net->trainNetwork = dummy[0]; // whether to train or just run instead
+
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%s", dummy);
+   net->printNetworkSpecifics = dummy[0]; // whether or not to print network specifics
+
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%s", dummy);
+   net->printDebugMessages = dummy[0]; // whether or not to print debug messages
+
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%s", dummy);
+   net->useBitmap = dummy[0]; // whether or not to use bitmaps
+   printf("use bitmap? %c\n", net->useBitmap);
+
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%s", net->bitmapFileInput); // input bitmap file
+   printf("bitmap input: %s\n", net->bitmapFileInput);
+
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%s", net->bitmapFileOutput); // outputted bitmap file
+   printf("bitmap output: %s\n", net->bitmapFileOutput);
+
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%s", net->nodesFileInput); // reading in training sets
+   printf("nodes input: %s\n", net->nodesFileInput);
+
+   if (net->useBitmap == 'Y')
+   {
+      readBitmap(net->bitmapFileInput, net->nodesFileInput);
+   }
+
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%s", net->nodesFileOutput); // where it would dump output values
+   printf("nodes output: %s\n", net->nodesFileOutput);
+
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%s", dummy);
+   net->useRandomWeights = dummy[0]; // whether or not to randomize weights
+   printf("use random weights? %c\n", net->useRandomWeights);
+
+   double randomWeightsLowerBound;
+   double randomWeightsUpperBound;
+
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%lf", &randomWeightsLowerBound); // reading in randomized weights' lower bound
+
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%lf", &randomWeightsUpperBound); // reading in randomized weights' lower bound
+
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%s", net->weightsFileInput); // where it would read preset weights from
+   printf("weights input: %s\n", net->weightsFileInput);
+
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%s", net->weightsFileOutput); // where it would dump weights to
+   printf("weights output: %s\n", net->weightsFileOutput);
+
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%d", &net->dumpEveryIterations); // where it would dump weights to
 
-    printf("\nINITIAL NETWORK:\n");
-    runForAllTrainingSets();
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%lf", &net->learningFactor); // reading in initial learning factor
+   printf("learning factor: %lf\n", net->learningFactor);
 
-    clock_t CPU_time_1 = clock();
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%lf", &net->learningFactorScaler); // reading in learning factor scaler
+   printf("learning factor scaler: %lf\n", net->learningFactorScaler);
 
-    if (trainNetwork == 'Y')
-    {
-        printf("AFTER TRAINING:\n");
-        train(maxIterations, targetError);
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%lf", &net->minLearningFactor); // reading in minimum allowed learning factor
+
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%lf", &net->maxLearningFactor); // reading in maximum allowed learning factor
+
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%s", dummy);
+   net->enableWeightRollback = dummy[0]; // whether or not to enable weight rollback
+
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%d", &net->maxIterations); // reading in max iterations for training
+
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%lf", &net->error); // reading in initial error
+
+   fscanf(config, "%s", dummy);
+   fscanf(config, "%lf", &net->targetError); // reading in target error
+
+   char value[MAX_FILE_NAME_LENGTH];
+   while (fscanf(config, "%s", dummy) == 1 && fscanf(config, "%s", value) == 1) // optional settings, in any order
+   {
+      parseOptionalSetting(net, dummy, value);
    }
 
-   clock_t CPU_time_2 = clock();
+   fclose(config);
+
+   // the weights are laid out once every setting is known, since a convolution layer changes the input layer,
+   // and nothing large is allocated until the memory it all needs is known to fit (see ./memoryPlanner.c)
+   if (setUpConvolution(net) != 0)
+   {
+      return -1;
+   }
 
-   writeWeightsToFile();
-   writeOutputsToFile();
+   findFrozenBoundary(net); // before planning, since the frozen layers may be cached
 
-   if (useBitmap == 'Y')
+   if (planMemory(net) != 0)
    {
-      writeBitmap(nodesFileOutput, bitmapFileInput, bitmapFileOutput);
+      return -1;
    }
 
-   freeMemory();
+   // a network that only runs streams its training sets from the file instead, as does one that trains on more than fits
+   if ((net->trainNetwork == 'Y' || net->numShards > 1) && net->streamTrainingSets != 'Y' &&
+       takeTrainingSetsInputs(net) != 0)
+   {
+      return -1;
+   }
 
-   printf("Time taken: %fms", ((double)(CPU_time_2 - CPU_time_1)) / CLOCKS_PER_SEC * 1000);
+   splitValidationSets(net); // before a projection is found from the training sets
+
+   if (setUpInputReduction(net) != 0)
+   {
+      return -1;
+   }
+
+   calculateNumNodesAndWeights(net); // calculating some useful values
+
+   net->weights = malloc((net->maxWeightsInALayer * net->numLayers + net->totalWeights - net->convWeightsOffset) *
+                         sizeof(double)); // allocating memory
+   if (net->weights == NULL)
+   {
+      printf("There was an error allocating memory for weights.\n");
+      return -1;
+   }
+
+   net->scratch = createScratch(net);
+   if (net->scratch == NULL)
+   {
+      return -1;
+   }
+
+   if (net->useRandomWeights == 'Y')
+   {
+      initializeWeightsRandomly(net, randomWeightsLowerBound, randomWeightsUpperBound);
+   }
+   else if (initializeWeightsFromFile(net, net->weightsFileInput) != 0 && net->resume != 'Y')
+   {
+      return -1; // nothing could be run without weights (a checkpoint that is resumed from brings its own)
+   }
 
    return 0;
 }
 
 /**
- * This function parses in all of the network's options through the
- * config file (see the README for details on the options).
+ * This function applies one of the optional settings that may follow
+ * the required ones at the end of the config (see the README).
+ *
+ * @param net the network to apply the setting to
+ * @param name the name of the setting
+ * @param value the value of the setting
  */
-void parseConfig()
+void parseOptionalSetting(Network *net, char *name, char *value)
 {
-   FILE *config = fopen(configFilename, "r");
+   if (strcmp(name, "error_function") == 0)
+   {
+      if (strcmp(value, "cross_entropy") == 0) // cross-entropy is only used with a softmax output layer
+      {
+         net->errorFunction = &crossEntropyLoss;
+         net->useSoftmax = 'Y';
+      }
+      else if (strcmp(value, "quadratic") == 0)
+      {
+         net->errorFunction = &quadraticLoss;
+         net->useSoftmax = 'n';
+      }
+      else
+      {
+         printf("Unknown error function %s, using quadratic.\n", value);
+      }
+      printf("error function: %s\n", value);
+   }
+   else if (strcmp(name, "threads") == 0)
+   {
+      setMatrixThreads(atoi(value));
+      printf("threads: %d\n", getMatrixThreads());
+   }
+   else if (strcmp(name, "auto_tune") == 0)
+   {
+      net->autoTune = value[0];
+   }
+   else if (strcmp(name, "tuning_file") == 0)
+   {
+      strncpy(net->tuningFile, value, MAX_FILE_NAME_LENGTH - 1);
+   }
+   else if (strcmp(name, "checkpoint_file") == 0)
+   {
+      strncpy(net->checkpointFile, value, MAX_FILE_NAME_LENGTH - 1);
+      printf("checkpoint file: %s\n", net->checkpointFile);
+   }
+   else if (strcmp(name, "checkpoint_every_x_iterations") == 0)
+   {
+      net->checkpointEveryIterations = atoi(value);
+   }
+   else if (strcmp(name, "resume") == 0)
+   {
+      net->resume = value[0];
+   }
+   else if (strcmp(name, "status_file") == 0)
+   {
+      strncpy(net->statusFile, value, MAX_FILE_NAME_LENGTH - 1);
+      printf("status file: %s\n", net->statusFile);
+   }
+   else if (strcmp(name, "convolution_filters") == 0)
+   {
+      net->convFilters = atoi(value);
+   }
+   else if (strcmp(name, "convolution_filter_size") == 0)
+   {
+      net->convFilterSize = atoi(value);
+   }
+   else if (strcmp(name, "convolution_stride") == 0)
+   {
+      net->convStride = atoi(value);
+   }
+   else if (strcmp(name, "pooling_size") == 0)
+   {
+      net->poolSize = atoi(value);
+   }
+   else if (strcmp(name, "input_width") == 0)
+   {
+      net->inputWidth = atoi(value);
+   }
+   else if (strcmp(name, "input_height") == 0)
+   {
+      net->inputHeight = atoi(value);
+   }
+   else if (strcmp(name, "augment_copies") == 0)
+   {
+      net->augmentCopies = atoi(value);
+      printf("augmented copies: %d\n", net->augmentCopies);
+   }
+   else if (strcmp(name, "augment_threads") == 0)
+   {
+      net->augmentThreads = atoi(value);
+   }
+   else if (strcmp(name, "augment_shift") == 0)
+   {
+      net->augmentShift = atoi(value);
+   }
+   else if (strcmp(name, "augment_flip") == 0)
+   {
+      net->augmentFlip = value[0];
+   }
+   else if (strcmp(name, "augment_brightness") == 0)
+   {
+      net->augmentBrightness = atof(value);
+   }
+   else if (strcmp(name, "augment_noise") == 0)
+   {
+      net->augmentNoise = atof(value);
+   }
+   else if (strcmp(name, "scan_stride") == 0)
+   {
+      net->scanStride = atoi(value);
+   }
+   else if (strcmp(name, "scan_threads") == 0)
+   {
+      net->scanThreads = atoi(value);
+   }
+   else if (strcmp(name, "scan_batch_size") == 0)
+   {
+      net->scanBatchSize = atoi(value);
+   }
+   else if (strcmp(name, "scan_output") == 0)
+   {
+      net->scanOutput = atoi(value);
+   }
+   else if (strcmp(name, "predictions_file") == 0)
+   {
+      strncpy(net->predictionsFile, value, MAX_FILE_NAME_LENGTH - 1);
+   }
+   else if (strcmp(name, "predictions_format") == 0)
+   {
+      net->predictionsFormat = strcmp(value, "csv") == 0 ? 'c' : 'b';
+   }
+   else if (strcmp(name, "prediction_bitmaps") == 0)
+   {
+      strncpy(net->predictionBitmaps, value, MAX_FILE_NAME_LENGTH - 1);
+   }
+   else if (strcmp(name, "prediction_threads") == 0)
+   {
+      net->predictionThreads = atoi(value);
+   }
+   else if (strcmp(name, "export_name") == 0)
+   {
+      strncpy(net->exportName, value, MAX_FILE_NAME_LENGTH - 1);
+   }
+   else if (strcmp(name, "random_seed") == 0)
+   {
+      net->randomSeed = strtoull(value, NULL, 10);
+      net->randomState = net->randomSeed; // so anything drawn before the weights is seeded as well
+      net->fixedSeed = 'Y';
+      printf("random seed: %llu\n", net->randomSeed);
+   }
+   else if (strcmp(name, "weight_initialization") == 0)
+   {
+      if (strcmp(value, "xavier") == 0 || strcmp(value, "he") == 0 || strcmp(value, "uniform") == 0)
+      {
+         net->weightInitialization = value[0];
+      }
+      else
+      {
+         printf("Unknown weight initialization %s, using uniform.\n", value);
+      }
+   }
+   else if (strcmp(name, "pipeline_stages") == 0)
+   {
+      net->pipelineStages = atoi(value);
+      printf("pipeline stages: %d\n", net->pipelineStages);
+   }
+   else if (strcmp(name, "pipeline_batch_size") == 0)
+   {
+      net->pipelineBatchSize = atoi(value) > 0 ? atoi(value) : 1;
+   }
+   else if (strcmp(name, "validation_fraction") == 0)
+   {
+      net->validationFraction = atof(value);
+      printf("validation fraction: %lf\n", net->validationFraction);
+   }
+   else if (strcmp(name, "validation_every") == 0)
+   {
+      net->validationEvery = atoi(value) > 0 ? atoi(value) : 1;
+   }
+   else if (strcmp(name, "validation_patience") == 0)
+   {
+      net->validationPatience = atoi(value) > 0 ? atoi(value) : 1;
+   }
+   else if (strcmp(name, "online_publish_seconds") == 0)
+   {
+      net->onlinePublishSeconds = atof(value) > 0.0 ? atof(value) : 1.0;
+   }
+   else if (strcmp(name, "online_keep_versions") == 0)
+   {
+      net->onlineKeepVersions = atoi(value) > 1 ? atoi(value) : 2; // a reader may still be loading the one before the newest
+   }
+   else if (strcmp(name, "memory_budget") == 0)
+   {
+      net->memoryBudget = atof(value);
+      printf("memory budget: %.1lfMB\n", net->memoryBudget);
+   }
+   else if (strcmp(name, "input_reduction") == 0)
+   {
+      if (strcmp(value, "pca") == 0 || strcmp(value, "random") == 0)
+      {
+         net->inputReduction = value[0]; // p or r
+      }
+      else if (strcmp(value, "none") != 0)
+      {
+         printf("Unknown input reduction %s, using none.\n", value);
+      }
+      printf("input reduction: %s\n", value);
+   }
+   else if (strcmp(name, "reduced_inputs") == 0)
+   {
+      net->numReducedInputs = atoi(value);
+   }
+   else if (strcmp(name, "projection_file") == 0)
+   {
+      strncpy(net->projectionFile, value, MAX_FILE_NAME_LENGTH - 1);
+   }
+   else if (strcmp(name, "prune_fraction") == 0)
+   {
+      net->pruneFraction = atof(value);
+      printf("prune fraction: %lf\n", net->pruneFraction);
+   }
+   else if (strcmp(name, "prune_steps") == 0)
+   {
+      net->pruneSteps = atoi(value) > 0 ? atoi(value) : 1;
+   }
+   else if (strcmp(name, "prune_fine_tune_iterations") == 0)
+   {
+      net->pruneFineTuneIterations = atoi(value);
+   }
+   else if (strcmp(name, "sparse_threshold") == 0)
+   {
+      net->sparseThreshold = atof(value);
+   }
+   else if (strncmp(name, "freeze_layer_", strlen("freeze_layer_")) == 0)
+   {
+      int layer = atoi(name + strlen("freeze_layer_")); // numbered from 1, like the hidden layers
+      if (layer >= 1 && layer <= net->numLayers - 1)
+      {
+         net->frozenLayers[layer - 1] = value[0];
+      }
+      else
+      {
+         printf("There is no connectivity layer %d to freeze.\n", layer);
+      }
+   }
+   else if (strcmp(name, "freeze_convolution") == 0)
+   {
+      net->freezeConvolution = value[0];
+   }
+   else if (strcmp(name, "freeze_cache_file") == 0)
+   {
+      strncpy(net->freezeCacheFile, value, MAX_FILE_NAME_LENGTH - 1);
+   }
+   else
+   {
+      printf("Ignoring unknown setting %s.\n", name);
+   }
 
-   char dummy[MAX_FILE_NAME_LENGTH]; // dummy value for handling the descriptor strings in the config file
+   return;
+}
+
+/**
+ * This function allocates space for all the training sets
+ * according to the number of training sets (first line of
+ * the input file) and the number of input and output nodes
+ * (set in the config file).
+ * It then reads in the values and stores them, parsing the
+ * file on several threads (see ./textParser.c).
+ *
+ * Inputs and expected outputs are stored in separate arrays, so each
+ * training set's inputs can be handed straight to runNetwork. Every row
+ * of inputs starts on a DATA_ALIGNMENT boundary.
+ *
+ * Only the training sets in the network's shard are stored
+ * (which is all of them unless training is distributed).
+ *
+ * @param net the network to store the training sets in
+ * @return 0 if successful, -1 if the file could not be read or memory could not be allocated
+ */
+int takeTrainingSetsInputs(Network *net)
+{
+   int firstValue; // index of the first value in this shard
+   int endValue;   // index one past the last value in this shard
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%d", &numInputNodes); // reading in number of input nodes
+   TextFile *nodesFile = openTextFile(net->nodesFileInput);
+   unsigned int totalTrainingSets = 0;
+   if (nodesFile == NULL || readFirstHexValue(nodesFile, &totalTrainingSets) != 0)
+   {
+      printf("There was an error opening the training sets file %s.\n", net->nodesFileInput);
+      closeTextFile(nodesFile);
+      return -1;
+   }
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%d", &numHiddenLayers); // reading in number of hidden layers
+   net->totalTrainingSets = (int)totalTrainingSets;
+   calculateShardBounds(net, &firstValue, &endValue);
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%d", &numOutputNodes); // reading in number of output nodes
+   if (net->useBitmap == 'Y')
+   {
+      printf("num training sets: %d\n", net->numTrainingSets);
+   }
 
-   numLayers = numHiddenLayers + 2; // setting some network structure values
-   layerDimensions = calloc(numLayers, sizeof(int));
-   layerDimensions[0] = numInputNodes;
-   layerDimensions[numLayers - 1] = numOutputNodes;
+   int doublesPerRow = DATA_ALIGNMENT / sizeof(double);
+   net->inputStride = (net->numInputNodes + doublesPerRow - 1) / doublesPerRow * doublesPerRow;
 
-   for (int i = 0; i < numHiddenLayers; i++) // taking in hidden layer dimensions
+   net->trainingInputs = allocateAligned((size_t)net->numTrainingSets * net->inputStride * sizeof(double));
+   net->trainingLabels = calloc((size_t)net->numTrainingSets * net->numOutputNodes, sizeof(double));
+   if (net->trainingInputs == NULL || net->trainingLabels == NULL)
    {
-      fscanf(config, "%s", &dummy);
-      fscanf(config, "%d", layerDimensions + i + 1);
+      printf("There was an error allocating memory for the training sets.\n");
+      closeTextFile(nodesFile);
+      return -1;
    }
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%s", &trainNetwork); // whether to train or just run instead
+   for (int t = 0; t < net->numTrainingSets; t++)
+   {
+      double *inputs = net->trainingInputs + (size_t)t * net->inputStride;
+      for (int k = net->numInputNodes; k < net->inputStride; k++)
+      {
+         inputs[k] = 0.0; // padding
+      }
+   }
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%s", &printNetworkSpecifics); // whether or not to print network specifics
+   // every value of the shard, parsed in parallel (see ./textParser.c) into the inputs and labels
+   TextLayout layout = {.rowLength = net->numInputNodes + net->numOutputNodes,
+                        .splitAt = net->numInputNodes,
+                        .first = net->trainingInputs,
+                        .firstStride = net->inputStride,
+                        .second = net->trainingLabels,
+                        .secondStride = net->numOutputNodes,
+                        .hex = net->useBitmap == 'Y' ? 'Y' : 'n',
+                        .hexScaler = UNSIGNED_INT_SCALER};
+
+   long long numRead = parseTextValues(nodesFile, 1 + (long long)firstValue, endValue - firstValue, &layout); // after the count
+   if (numRead < endValue - firstValue)
+   {
+      printf("The training sets file %s ran out after %lld of its values.\n", net->nodesFileInput, 1 + firstValue + numRead);
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%s", &printDebugMessages); // whether or not to print debug messages
+      // a short file repeats its last value, as fscanf into the same variable did
+      double lastValue = 0.0;
+      for (long long v = numRead > 0 ? numRead - 1 : 0; v < endValue - firstValue; v++)
+      {
+         int t = (int)(v / layout.rowLength);
+         int i = (int)(v % layout.rowLength);
+         double *value = i < net->numInputNodes ? net->trainingInputs + (size_t)t * net->inputStride + i
+                                                : net->trainingLabels + (size_t)t * net->numOutputNodes + i - net->numInputNodes;
+         if (v < numRead)
+         {
+            lastValue = *value;
+         }
+         else
+         {
+            *value = lastValue;
+         }
+      }
+   }
 
-   calculateNumNodesAndWeights(); // calculating some useful values
+   closeTextFile(nodesFile);
 
-   nodes = malloc(maxNodesInALayer * numLayers * sizeof(double)); // allocating memory
-   if (nodes == NULL)
+   return 0;
+}
+
+/**
+ * Reads the next training set from a training sets file. Values are
+ * pels in hex (scaled to [0,1]) when the network uses a bitmap, and
+ * plain decimals otherwise.
+ *
+ * @param net the network the training set is for
+ * @param nodesFile the file to read from (just past the previous set)
+ * @param inputs where to store the numInputNodes input values
+ * @param expectedOutputs where to store the numOutputNodes expected output values
+ * @return 0 on success, -1 if the file ran out
+ */
+int readTrainingSet(Network *net, FILE *nodesFile, double *inputs, double *expectedOutputs)
+{
+   for (int i = 0; i < net->numInputNodes + net->numOutputNodes; i++)
    {
-      printf("There was an error allocating memory for nodes.\n");
+      double value;
+
+      if (net->useBitmap == 'Y') // take input from a bitmap
+      {
+         unsigned int node = 0;
+         if (fscanf(nodesFile, "%x", &node) != 1)
+            return -1;
+         // printf("%u divided by %lf is %lf\n", (unsigned int) node, UNSIGNED_INT_SCALER, ((double)node) / UNSIGNED_INT_SCALER);
+         value = ((double)node) / UNSIGNED_INT_SCALER;
+      }
+      else // take input from a pre-setup file
+      {
+         if (fscanf(nodesFile, "%lf", &value) != 1)
+            return -1;
+      }
+
+      if (i < net->numInputNodes)
+         inputs[i] = value;
+      else
+         expectedOutputs[i - net->numInputNodes] = value;
+   }
+
+   return 0;
+}
+
+/**
+ * This function works out which training sets belong to the network's
+ * shard once the total number of training sets is known, and sets
+ * numTrainingSets accordingly. Shards are contiguous and as even in size
+ * as possible.
+ *
+ * @param net the network being loaded
+ * @param firstValue set to the index of the shard's first value in the file
+ * @param endValue set to the index one past the shard's last value in the file
+ */
+void calculateShardBounds(Network *net, int *firstValue, int *endValue)
+{
+   int valuesPerSet = net->numInputNodes + net->numOutputNodes;
+   int firstSet = (int)((long long)net->totalTrainingSets * net->shardIndex / net->numShards);
+   int endSet = (int)((long long)net->totalTrainingSets * (net->shardIndex + 1) / net->numShards);
+
+   net->numTrainingSets = endSet - firstSet;
+   *firstValue = firstSet * valuesPerSet;
+   *endValue = endSet * valuesPerSet;
+
+   return;
+}
+
+/**
+ * This function initializes the weights to known values from
+ * a file, parsing it on several threads (see ./textParser.c).
+ * Weights are stored in mkj order.
+ *
+ * @param net the network to load the weights into
+ * @param weightsFileInput the file to read the weights from
+ * @return 0 on success, -1 if the file could not be opened
+ */
+int initializeWeightsFromFile(Network *net, char *weightsFileInput)
+{
+   TextFile *weightsFile = openTextFile(weightsFileInput);
+   if (weightsFile == NULL)
+   {
+      printf("There was an error opening the weights file %s.\n", weightsFileInput);
+      return -1;
    }
-   weights = malloc(maxWeightsInALayer * numLayers * sizeof(double));
-   if (weights == NULL)
+
+   TextLayout layout = {.rowLength = net->totalWeights,
+                        .splitAt = net->totalWeights,
+                        .first = net->weights,
+                        .hex = 'n'};
+
+   long long numRead = parseTextValues(weightsFile, 0, net->totalWeights, &layout);
+   for (long long i = numRead; i < net->totalWeights; i++) // a short file repeats its last weight
    {
-      printf("There was an error allocating memory for weights.\n");
+      net->weights[i] = numRead > 0 ? net->weights[numRead - 1] : 0.0;
+   }
+
+   closeTextFile(weightsFile);
+
+   return 0;
+}
+
+/**
+ * Initializes all weights randomly. Uniform weights are between the given
+ * bounds; Xavier weights are within sqrt(6 / (fanIn + fanOut)) of 0 and He
+ * weights within sqrt(6 / fanIn), where fanIn and fanOut are the sizes of
+ * the layers (or the filters) the weights connect.
+ *
+ * Randomization uses the random_seed setting as its seed, or the current
+ * time without one. Every weight's value only depends on the seed and its
+ * place in the weights (see randomNumberAt), so the rows of weights are
+ * split between the matrix threads and filled at once, and the same seed
+ * gives the same weights with any number of threads. The padding between
+ * layers is zeroed.
+ *
+ * @param net the network to initialize
+ * @param lowerBound the lower bound of uniform weights
+ * @param upperBound the upper bound of uniform weights
+ */
+void initializeWeightsRandomly(Network *net, double lowerBound, double upperBound)
+{
+   if (net->fixedSeed != 'Y')
+   {
+      net->randomState = (unsigned long long)time(0);
    }
-   expectedOutputs = malloc(numOutputNodes * sizeof(double));
-   if (expectedOutputs == NULL)
+
+   int numThreads = getMatrixThreads();
+   int numRows = net->maxNodesInALayer * (net->numLayers - 1);
+   int numFilterWeights = net->totalWeights - net->convWeightsOffset;
+   struct WeightsFill *fills = malloc(numThreads * sizeof(struct WeightsFill));
+   pthread_t *threads = malloc(numThreads * sizeof(pthread_t));
+
+   if (fills == NULL || threads == NULL)
    {
-      printf("There was an error allocating memory for expected outputs.\n");
+      numThreads = 1; // filling them all on this thread instead
    }
 
-   thetas = malloc(maxNodesInALayer * numLayers * sizeof(double));
-   if (thetas == NULL)
+   struct WeightsFill single;
+   struct WeightsFill *fill = fills != NULL ? fills : &single;
+
+   for (int t = 0; t < numThreads; t++)
    {
-      printf("There was an error allocating memory for thetas.\n");
+      fill[t].net = net;
+      fill[t].key = net->randomState;
+      fill[t].lowerBound = lowerBound;
+      fill[t].upperBound = upperBound;
+      fill[t].firstRow = (int)((long long)numRows * t / numThreads);
+      fill[t].endRow = (int)((long long)numRows * (t + 1) / numThreads);
+      fill[t].firstFilterWeight = net->convWeightsOffset + (int)((long long)numFilterWeights * t / numThreads);
+      fill[t].endFilterWeight = net->convWeightsOffset + (int)((long long)numFilterWeights * (t + 1) / numThreads);
    }
-   psis = malloc(maxNodesInALayer * numLayers * sizeof(double));
-   if (psis == NULL)
+
+   int numStarted = 1; // this thread fills the first part
+   while (numStarted < numThreads &&
+          pthread_create(&threads[numStarted], NULL, &fillRandomWeights, &fill[numStarted]) == 0)
    {
-      printf("There was an error allocating memory for psis.\n");
+      numStarted++;
    }
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%s", &useBitmap); // whether or not to use bitmaps
-   printf("use bitmap? %c\n", useBitmap);
+   fillRandomWeights(&fill[0]);
+   for (int t = numStarted; t < numThreads; t++) // any parts a thread could not be started for
+   {
+      fillRandomWeights(&fill[t]);
+   }
+   for (int t = 1; t < numStarted; t++)
+   {
+      pthread_join(threads[t], NULL);
+   }
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%s", &bitmapFileInput); // input bitmap file
-   printf("bitmap input: %s\n", bitmapFileInput);
+   // moving the generator past every weight, as if they had been drawn one at a time
+   net->randomState += (unsigned long long)net->totalWeights * RANDOM_STEP;
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%s", &bitmapFileOutput); // outputted bitmap file
-   printf("bitmap output: %s\n", bitmapFileOutput);
+   free(fills);
+   free(threads);
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%s", nodesFileInput); // reading in training sets
-   printf("nodes input: %s\n", nodesFileInput);
+   printf("Finished initializing weights\n");
+   return;
+}
+
+/**
+ * Fills one thread's part of the weights with random values
+ * (see initializeWeightsRandomly).
+ *
+ * @param argument the WeightsFill that describes the part to fill
+ * @return NULL
+ */
+void *fillRandomWeights(void *argument)
+{
+   struct WeightsFill *fill = (struct WeightsFill *)argument;
+   Network *net = fill->net;
+   int maxNodesInALayer = net->maxNodesInALayer;
 
-   if (useBitmap == 'Y')
+   for (int row = fill->firstRow; row < fill->endRow; row++)
    {
-      readBitmap(bitmapFileInput, nodesFileInput);
+      int m = row / maxNodesInALayer; // the row is the weights leaving node k of layer m
+      int k = row % maxNodesInALayer;
+      int fanIn = net->layerDimensions[m];
+      int fanOut = net->layerDimensions[m + 1];
+      double *weights = net->weights + (size_t)row * maxNodesInALayer;
+      unsigned long long first = (unsigned long long)row * maxNodesInALayer;
+      int numRandom = k < fanIn ? fanOut : 0;
+
+      double lowerBound = fill->lowerBound;
+      double upperBound = fill->upperBound;
+      if (net->weightInitialization != 'u')
+      {
+         upperBound = sqrt(6.0 / (net->weightInitialization == 'x' ? fanIn + fanOut : fanIn));
+         lowerBound = -upperBound;
+      }
+
+      for (int j = 0; j < numRandom; j++) // kept simple so that the compiler can vectorize it
+      {
+         weights[j] = randomNumberAt(fill->key, first + j, lowerBound, upperBound);
+      }
+      for (int j = numRandom; j < maxNodesInALayer; j++) // the padding
+      {
+         weights[j] = 0.0;
+      }
+   } // for (int row = firstRow; row < endRow; row++)
+
+   int filterArea = net->convFilterSize * net->convFilterSize;
+   double filterBound = fill->upperBound;
+   if (net->weightInitialization != 'u' && net->convFilters > 0)
+   {
+      int fanIn = net->inputChannels * filterArea;
+      filterBound = sqrt(6.0 / (net->weightInitialization == 'x' ? fanIn + net->convFilters * filterArea : fanIn));
    }
+   double filterLowerBound = net->weightInitialization != 'u' ? -filterBound : fill->lowerBound;
 
-   takeTrainingSetsInputs();
+   for (int i = fill->firstFilterWeight; i < fill->endFilterWeight; i++) // the convolution filters, if any
+   {
+      net->weights[i] = randomNumberAt(fill->key, i, filterLowerBound, filterBound);
+   }
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%s", nodesFileOutput); // where it would dump output values
-   printf("nodes output: %s\n", nodesFileOutput);
+   return NULL;
+}
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%s", &useRandomWeights); // whether or not to randomize weights
-   printf("use random weights? %c\n", useRandomWeights);
+/**
+ * Allocates memory that starts on a DATA_ALIGNMENT byte boundary.
+ *
+ * @param numBytes the number of bytes to allocate
+ * @return the memory (freed with freeAligned), or NULL on failure
+ */
+void *allocateAligned(size_t numBytes)
+{
+#ifdef _WIN32
+   return _aligned_malloc(numBytes > 0 ? numBytes : 1, DATA_ALIGNMENT);
+#else
+   void *memory = NULL;
+   if (posix_memalign(&memory, DATA_ALIGNMENT, numBytes > 0 ? numBytes : 1) != 0)
+   {
+      return NULL;
+   }
+   return memory;
+#endif
+}
 
-   double randomWeightsLowerBound;
-   double randomWeightsUpperBound;
+/**
+ * Frees memory from allocateAligned.
+ *
+ * @param memory the memory to free (may be NULL)
+ */
+void freeAligned(void *memory)
+{
+#ifdef _WIN32
+   _aligned_free(memory);
+#else
+   free(memory);
+#endif
+   return;
+}
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%lf", &randomWeightsLowerBound); // reading in randomized weights' lower bound
+/**
+ * Draws the next number from the network's random number generator
+ * (SplitMix64), whose whole state is a single value in the network so
+ * that it can be saved in a checkpoint.
+ *
+ * @param net the network whose generator to use
+ * @param lowerBound the lower bound of the random number
+ * @param upperBound the upper bound of the random number
+ * @return a random number between a given lower and upper bound
+ */
+double randomNumber(Network *net, double lowerBound, double upperBound)
+{
+   double number = randomNumberAt(net->randomState, 0, lowerBound, upperBound);
+   net->randomState += RANDOM_STEP;
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%lf", &randomWeightsUpperBound); // reading in randomized weights' lower bound
+   return number;
+}
+
+/**
+ * Finds any number the generator would draw from a given state without
+ * drawing the ones before it: the number at index i is the one
+ * randomNumber would return after drawing i others. This is what lets
+ * weights be filled on many threads at once.
+ *
+ * @param key the state of the generator
+ * @param index how many numbers come before this one
+ * @param lowerBound the lower bound of the random number
+ * @param upperBound the upper bound of the random number
+ * @return a random number between a given lower and upper bound
+ */
+double randomNumberAt(unsigned long long key, unsigned long long index, double lowerBound, double upperBound)
+{
+   unsigned long long z = key + (index + 1) * RANDOM_STEP;
+   z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+   z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+   z ^= z >> 31;
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%s", &weightsFileInput); // where it would read preset weights from
-   printf("weights input: %s\n", weightsFileInput);
+   return (double)(z >> 11) / 9007199254740992.0 * (upperBound - lowerBound) + lowerBound; // top 53 bits, scaled to [0,1)
+}
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%s", &weightsFileOutput); // where it would dump weights to
-   printf("weights output: %s\n", weightsFileOutput);
+/**
+ * This function write the current weights to a file.
+ * Weights are stored in mkj order.
+ *
+ * @param net the network whose weights to write
+ * @param weightsFileOutput the file to write the weights to
+ * @return 0 on success, -1 if the file could not be opened
+ */
+int writeWeightsToFile(const Network *net, char *weightsFileOutput)
+{
+   FILE *weightsFile = fopen(weightsFileOutput, "w+");
+   if (weightsFile == NULL)
+   {
+      printf("There was an error opening the weights file %s.\n", weightsFileOutput);
+      return -1;
+   }
+
+   for (int i = 0; i < net->totalWeights; i++)
+   {
+      fprintf(weightsFile, "%lf\n", net->weights[i]);
+   }
+
+   fclose(weightsFile);
+
+   return 0;
+}
+
+/**
+ * Saves everything needed to carry on training exactly where it stopped:
+ * the topology (to check against on loading), the iteration count, the
+ * learning factor, the error, the state of the random number generator,
+ * the seed of the augmented copies, and every weight. Only the weights that are used are saved (not the
+ * padding of the mkj layout), as raw doubles so that none of their
+ * precision is lost.
+ *
+ * The checkpoint is written to a temporary file first and then renamed,
+ * so a run that dies while saving never leaves a half-written checkpoint.
+ *
+ * @param net the network to save
+ * @param checkpointFile the path to save the checkpoint to
+ * @return 0 if the checkpoint was saved, -1 otherwise
+ */
+int saveCheckpoint(const Network *net, char *checkpointFile)
+{
+   char tempFile[MAX_FILE_NAME_LENGTH + 8];
+   sprintf(tempFile, "%s.tmp", checkpointFile);
+
+   FILE *file = fopen(tempFile, "wb");
+   if (file == NULL)
+   {
+      printf("There was an error opening the checkpoint file %s.\n", tempFile);
+      return -1;
+   }
+
+   int written = fwrite(CHECKPOINT_MAGIC, 1, CHECKPOINT_MAGIC_LENGTH, file) == CHECKPOINT_MAGIC_LENGTH;
+   written = written && fwrite(&net->numLayers, sizeof(int), 1, file) == 1;
+   written = written && fwrite(net->layerDimensions, sizeof(int), net->numLayers, file) == (size_t)net->numLayers;
+   written = written && fwrite(&net->iteration, sizeof(int), 1, file) == 1;
+   written = written && fwrite(&net->learningFactor, sizeof(double), 1, file) == 1;
+   written = written && fwrite(&net->error, sizeof(double), 1, file) == 1;
+   written = written && fwrite(&net->randomState, sizeof(unsigned long long), 1, file) == 1;
+   written = written && fwrite(&net->augmentSeed, sizeof(unsigned long long), 1, file) == 1;
+
+   for (int m = 0; m < net->numLayers - 1 && written; m++)
+   {
+      for (int k = 0; k < net->layerDimensions[m] && written; k++)
+      {
+         double *row = net->weights + m * net->maxWeightsInALayer + k * net->maxNodesInALayer;
+         written = fwrite(row, sizeof(double), net->layerDimensions[m + 1], file) == (size_t)net->layerDimensions[m + 1];
+      }
+   }
+
+   int numConvWeights = net->totalWeights - net->convWeightsOffset; // the convolution filters, if any
+   written = written && fwrite(net->weights + net->convWeightsOffset, sizeof(double), numConvWeights, file) ==
+                           (size_t)numConvWeights;
+
+   if (fclose(file) != 0 || !written)
+   {
+      printf("There was an error writing the checkpoint file %s.\n", tempFile);
+      remove(tempFile);
+      return -1;
+   }
+
+#ifdef _WIN32
+   remove(checkpointFile); // rename will not replace a file on Windows
+#endif
+   if (rename(tempFile, checkpointFile) != 0)
+   {
+      printf("There was an error replacing the checkpoint file %s.\n", checkpointFile);
+      return -1;
+   }
+
+   return 0;
+}
+
+/**
+ * Loads a checkpoint saved by saveCheckpoint, so that training carries
+ * on exactly where it stopped. The checkpoint has to be for a network
+ * with the same layer sizes.
+ *
+ * @param net the network to load the checkpoint into
+ * @param checkpointFile the path to the checkpoint
+ * @return 0 if the checkpoint was loaded, -1 otherwise
+ */
+int loadCheckpoint(Network *net, char *checkpointFile)
+{
+   FILE *file = fopen(checkpointFile, "rb");
+   if (file == NULL)
+   {
+      printf("There was an error opening the checkpoint file %s.\n", checkpointFile);
+      return -1;
+   }
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%d", &dumpEveryIterations); // where it would dump weights to
+   char magic[CHECKPOINT_MAGIC_LENGTH];
+   int numLayers = 0;
+   int valid = fread(magic, 1, CHECKPOINT_MAGIC_LENGTH, file) == CHECKPOINT_MAGIC_LENGTH &&
+               memcmp(magic, CHECKPOINT_MAGIC, CHECKPOINT_MAGIC_LENGTH) == 0;
+   valid = valid && fread(&numLayers, sizeof(int), 1, file) == 1 && numLayers == net->numLayers;
 
-   if (useRandomWeights == 'Y')
+   for (int n = 0; n < net->numLayers && valid; n++)
    {
-      initializeWeightsRandomly(randomWeightsLowerBound, randomWeightsUpperBound);
+      int layerDimension = 0;
+      valid = fread(&layerDimension, sizeof(int), 1, file) == 1 && layerDimension == net->layerDimensions[n];
    }
-   else
+
+   if (!valid)
    {
-      initializeWeightsFromFile();
+      printf("The checkpoint file %s is not a checkpoint of this network.\n", checkpointFile);
+      fclose(file);
+      return -1;
    }
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%lf", &learningFactor); // reading in initial learning factor
-   printf("learning factor: %lf\n", learningFactor);
-
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%lf", &learningFactorScaler); // reading in learning factor scaler
-   printf("learning factor scaler: %lf\n", learningFactorScaler);
+   valid = fread(&net->iteration, sizeof(int), 1, file) == 1;
+   valid = valid && fread(&net->learningFactor, sizeof(double), 1, file) == 1;
+   valid = valid && fread(&net->error, sizeof(double), 1, file) == 1;
+   valid = valid && fread(&net->randomState, sizeof(unsigned long long), 1, file) == 1;
+   valid = valid && fread(&net->augmentSeed, sizeof(unsigned long long), 1, file) == 1;
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%lf", &minLearningFactor); // reading in minimum allowed learning factor
-
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%lf", &maxLearningFactor); // reading in maximum allowed learning factor
+   for (int m = 0; m < net->numLayers - 1 && valid; m++)
+   {
+      for (int k = 0; k < net->layerDimensions[m] && valid; k++)
+      {
+         double *row = net->weights + m * net->maxWeightsInALayer + k * net->maxNodesInALayer;
+         valid = fread(row, sizeof(double), net->layerDimensions[m + 1], file) == (size_t)net->layerDimensions[m + 1];
+      }
+   }
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%s", &enableWeightRollback); // whether or not to enable weight rollback
+   int numConvWeights = net->totalWeights - net->convWeightsOffset; // the convolution filters, if any
+   valid = valid && fread(net->weights + net->convWeightsOffset, sizeof(double), numConvWeights, file) ==
+                        (size_t)numConvWeights;
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%d", &maxIterations); // reading in max iterations for training
+   fclose(file);
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%lf", &error); // reading in initial error
+   if (!valid)
+   {
+      printf("The checkpoint file %s ended early.\n", checkpointFile);
+      return -1;
+   }
 
-   fscanf(config, "%s", &dummy);
-   fscanf(config, "%lf", &targetError); // reading in target error
+   printf("Resuming from iteration %d (error %.16lf, lambda %lf)\n", net->iteration, net->error, net->learningFactor);
 
-   fclose(config);
+   return 0;
 }
 
 /**
- * This function allocates space for all the training sets 
- * according to the number of training sets (first line of
- * the input file) and the number of input and output nodes 
- * (set in the config file). 
- * It then reads in the values and stores them.
+ * Finds how many of the weights are used: layerDimensions[m] by
+ * layerDimensions[m + 1] in each layer, along with the convolution filters,
+ * leaving out the padding of the mkj layout. This is how many values
+ * packWeights packs them into.
+ *
+ * @param net the network whose weights to count
+ * @return the number of weights that are used
  */
-void takeTrainingSetsInputs()
+int findNumUsedWeights(const Network *net)
 {
-   if (useBitmap == 'Y') // take input from a bitmap
-   {
-      unsigned int node = 0.0;
-      FILE *nodesFile = fopen(nodesFileInput, "r");
-
-      fscanf(nodesFile, "%x", &numTrainingSets);
+   int numUsed = net->totalWeights - net->convWeightsOffset; // the convolution filters, if any
 
-      printf("num training sets: %d\n", numTrainingSets);
+   for (int m = 0; m < net->numLayers - 1; m++)
+   {
+      numUsed += net->layerDimensions[m] * net->layerDimensions[m + 1];
+   }
 
-      trainingSets = calloc(numTrainingSets * (numInputNodes + numOutputNodes), sizeof(double));
+   return numUsed;
+}
 
-      for (int i = 0; i < numTrainingSets * (numInputNodes + numOutputNodes); i++)
+/**
+ * Packs values laid out like the weights (in padded mkj order, such as the
+ * weights themselves or their gradients) so that only the ones that are
+ * used are kept: each layer's rows of layerDimensions[m + 1] values one
+ * after another, then the convolution filters.
+ *
+ * @param net the network the values belong to
+ * @param weights the values in mkj order (totalWeights of them)
+ * @param packed where to pack them (findNumUsedWeights of them)
+ */
+void packWeights(const Network *net, const double *weights, double *packed)
+{
+   for (int m = 0; m < net->numLayers - 1; m++)
+   {
+      for (int k = 0; k < net->layerDimensions[m]; k++)
       {
-         fscanf(nodesFile, "%x", &node);
-         // printf("%u divided by %lf is %lf\n", (unsigned int) node, UNSIGNED_INT_SCALER, ((double)node) / UNSIGNED_INT_SCALER);
-         *(trainingSets + i) = ((double)node) / UNSIGNED_INT_SCALER;
+         memcpy(packed, weights + m * net->maxWeightsInALayer + k * net->maxNodesInALayer,
+                net->layerDimensions[m + 1] * sizeof(double));
+         packed += net->layerDimensions[m + 1];
       }
-
-      fclose(nodesFile);
    }
-   else // take input from a pre-setup file
-   {
-      double node = 0.0;
-      FILE *nodesFile = fopen(nodesFileInput, "r");
 
-      fscanf(nodesFile, "%x", &numTrainingSets);
+   memcpy(packed, weights + net->convWeightsOffset, (net->totalWeights - net->convWeightsOffset) * sizeof(double));
 
-      trainingSets = calloc(numTrainingSets * (numInputNodes + numOutputNodes), sizeof(double));
+   return;
+}
 
-      for (int i = 0; i < numTrainingSets * (numInputNodes + numOutputNodes); i++)
+/**
+ * Puts values packed by packWeights back in their places in mkj order.
+ * The padding is left as it was.
+ *
+ * @param net the network the values belong to
+ * @param packed the packed values
+ * @param weights where to unpack them (totalWeights of them, in mkj order)
+ */
+void unpackWeights(const Network *net, const double *packed, double *weights)
+{
+   for (int m = 0; m < net->numLayers - 1; m++)
+   {
+      for (int k = 0; k < net->layerDimensions[m]; k++)
       {
-         fscanf(nodesFile, "%lf", &node);
-         *(trainingSets + i) = node;
+         memcpy(weights + m * net->maxWeightsInALayer + k * net->maxNodesInALayer, packed,
+                net->layerDimensions[m + 1] * sizeof(double));
+         packed += net->layerDimensions[m + 1];
       }
-
-      fclose(nodesFile);
    }
 
+   memcpy(weights + net->convWeightsOffset, packed, (net->totalWeights - net->convWeightsOffset) * sizeof(double));
+
    return;
 }
 
 /**
- * This function initializes the weights to known values from
- * a file. Weights are stored in mkj order.
+ * This function writes all the current outputs (left in the network's
+ * own scratch by the last training set it ran) to the config's output file.
+ *
+ * @param net the network whose outputs to write
  */
-void initializeWeightsFromFile()
+void writeOutputsToFile(Network *net)
 {
-   double weight = 0.0;
-   FILE *weightsFile = fopen(weightsFileInput, "r");
+   FILE *outFile = fopen(net->nodesFileOutput, "w");
+   double *outputs = net->scratch->nodes + net->maxNodesInALayer * (net->numLayers - 1);
 
-   for (int i = 0; i < totalWeights; i++)
+   for (int i = 0; i < net->numOutputNodes; i++)
    {
-      fscanf(weightsFile, "%lf", &weight);
-      *(weights + i) = weight;
+      fprintf(outFile, "%x\n", (unsigned int)(outputs[i] * UNSIGNED_INT_SCALER));
    }
 
-   fclose(weightsFile);
+   fclose(outFile);
 
    return;
 }
 
 /**
- * Initializes all weights randomly to values between given bounds.
- * Randomization uses the current time as its seed.
- * 
- * @param lowerBound the lower bound of the randomized weights
- * @param upperBound the upper bound of the randomized weights
+ * This function is responsible for calculating the maximum nodes
+ * and maximum weights in a layer. These values are used for
+ * allocating space.
+ *
+ * @param net the network to calculate the values for
  */
-void initializeWeightsRandomly(double lowerBound, double upperBound)
+void calculateNumNodesAndWeights(Network *net)
 {
-   srand(time(0));
-   for (int m = 0; m < numLayers - 1; m++)
+   for (int layer = 0; layer < net->numLayers; layer++)
    {
-      for (int j = 0; j < layerDimensions[m]; j++)
+      // maintaining maxNodesInALayer
+      if (net->layerDimensions[layer] > net->maxNodesInALayer)
       {
-         for (int k = 0; k < layerDimensions[m + 1]; k++)
-         {
-            unsigned int index = m * maxWeightsInALayer + j * maxNodesInALayer + k;
-            double randWeight = randomNumber(lowerBound, upperBound);
-
-            weights[index] = randWeight;
-         }
+         net->maxNodesInALayer = net->layerDimensions[layer];
       }
    }
-   printf("Finished initializing weights\n");
+
+   net->maxWeightsInALayer = net->maxNodesInALayer * net->maxNodesInALayer;
+   net->totalWeights = net->maxWeightsInALayer * (net->numLayers - 1);
+
+   net->convWeightsOffset = net->totalWeights; // the convolution filters come after every dense layer
+   if (net->convFilters > 0)
+   {
+      net->totalWeights += net->inputChannels * net->convFilterSize * net->convFilterSize * net->convFilters;
+   }
+
    return;
 }
 
 /**
- * @return a random number between a given lower and upper bound
- * 
- * @param lowerBound the lower bound of the randomized weights
- * @param upperBound the upper bound of the randomized weights
- */ 
-double randomNumber(double lowerBound, double upperBound) {
-   return (double)rand() / (double)RAND_MAX * (upperBound - lowerBound) + lowerBound;
+ * @return the number of input nodes a network takes
+ *
+ * @param net the network
+ */
+int getNumInputNodes(const Network *net)
+{
+   return net->numInputNodes;
 }
 
 /**
- * This function write the current weights to a file.
- * Weights are stored in mkj order.
+ * @return the number of output nodes a network produces
+ *
+ * @param net the network
  */
-void writeWeightsToFile()
+int getNumOutputNodes(const Network *net)
 {
-   FILE *weightsFile = fopen(weightsFileOutput, "w+");
-
-   for (int i = 0; i < totalWeights; i++)
-   {
-      fprintf(weightsFile, "%lf\n", weights[i]);
-   }
+   return net->numOutputNodes;
+}
 
-   fclose(weightsFile);
+/**
+ * This function actually runs the network on a set of inputs.
+ * It does not do any training and merely propagates values
+ * throughout the nodes of the scratch, while collecting theta
+ * values to be used in backprop.
+ *
+ * If the scratch has expected outputs bound, the error of this
+ * run is found as soon as the output layer is done (while it is
+ * still in cache) and left in the scratch.
+ *
+ * The inputs are not copied; the scratch keeps a pointer to them
+ * as its input layer, so they must stay put until backprop is done.
+ * A convolution layer (see ./convolution.c) or input reduction (see
+ * ./projection.c) instead writes the input layer into the scratch.
+ *
+ * The network itself is only read, so many threads can run the
+ * same network at once if each has its own scratch.
+ *
+ * Each layer's thetas are found with one call to the matrix kernels,
+ * so the activation function is applied to each node's summed input
+ * (the same as applying it to every product while it is the identity).
+ * Layers that were pruned past the sparse threshold are run from their
+ * sparse form instead (see ./pruning.c).
+ *
+ * @param net the network to run
+ * @param scratch the buffers to propagate values through
+ * @param inputs the input values (numInputNodes long)
+ * @param outputs where to copy the output values (NULL to leave them in the scratch)
+ */
+void runNetwork(const Network *net, NetworkScratch *scratch, double *inputs, double *outputs)
+{
+   runFromInputLayer(net, scratch, prepareInputLayer(net, scratch, inputs), outputs);
 
    return;
 }
 
 /**
- * This function writes all the current outputs to a specified file.
+ * Finds the input layer of a run from its inputs: the outputs of the
+ * convolution layer, or the reduced inputs, are written into the scratch,
+ * and otherwise the inputs are the input layer themselves.
+ *
+ * @param net the network to run
+ * @param scratch the buffers the network will be run with
+ * @param inputs the input values (numInputNodes long)
+ * @return the values of the input layer
  */
-void writeOutputsToFile()
+double *prepareInputLayer(const Network *net, NetworkScratch *scratch, double *inputs)
 {
-   FILE *outFile = fopen(nodesFileOutput, "w");
-
-   for (int i = 0; i < numOutputNodes; i++)
+   if (net->convFilters > 0) // the convolution layer's outputs are the input layer
    {
-      fprintf(outFile, "%x\n", (unsigned int)(nodes[maxNodesInALayer * (numLayers - 1) + i] * UNSIGNED_INT_SCALER));
+      runConvolution(net, scratch, inputs, scratch->nodes);
+      return scratch->nodes;
+   }
+   if (net->projection != NULL) // and so are the reduced inputs
+   {
+      projectInputs(net, inputs, scratch->nodes);
+      return scratch->nodes;
    }
 
-   fclose(outFile);
-
-   return;
+   return inputs;
 }
 
 /**
- * This function is responsible for calculating the maximum nodes
- * and maximum weights in a layer. These values are used for
- * allocating space.
+ * Runs the network from values that are already its input layer, such as
+ * a training set that was reduced once when it was loaded. Otherwise this
+ * is the same as runNetwork.
+ *
+ * @param net the network to run
+ * @param scratch the buffers to propagate values through
+ * @param inputLayer the values of the input layer (layerDimensions[0] long)
+ * @param outputs where to copy the output values (NULL to leave them in the scratch)
  */
-void calculateNumNodesAndWeights()
+void runFromInputLayer(const Network *net, NetworkScratch *scratch, double *inputLayer, double *outputs)
 {
-   for (int layer = 0; layer < numLayers; layer++)
+   scratch->inputs = inputLayer; // binding the input layer
+
+   for (int m = 0; m < net->numLayers - 1; m++) // looping through connectivity layers
    {
-      // maintaining maxNodesInALayer
-      if (layerDimensions[layer] > maxNodesInALayer)
-      {
-         maxNodesInALayer = layerDimensions[layer];
-      }
+      runConnectivityLayer(net, scratch, m);
    }
 
-   maxWeightsInALayer = maxNodesInALayer * maxNodesInALayer;
-   totalWeights = maxWeightsInALayer * (numLayers - 1);
+   finishOutputLayer(net, scratch, outputs);
 
    return;
 }
 
 /**
- * This function actually runs the network (which is assumed
- * to have already been initialized with inputs and weights).
- * It does not do any error calculation or training and merely
- * propagates values throughout the nodes, while collecting
- * theta values to be used in backprop.
+ * Finds the thetas and the values of the nodes to the right of one
+ * connectivity layer from the nodes to its left.
+ *
+ * @param net the network being run
+ * @param scratch the buffers of the run (with its input layer bound)
+ * @param m the connectivity layer
  */
-void runNetwork()
+void runConnectivityLayer(const Network *net, NetworkScratch *scratch, int m)
 {
-   for (int m = 0; m < numLayers - 1; m++) // looping through connectivity layers
-   {
-      int numSourceNodes = layerDimensions[m];
-      int numDestNodes = layerDimensions[m + 1];
-
-      for (int j = 0; j < numDestNodes; j++) // looping through right layer
-      {
-         int destNodeIndex = (m + 1) * maxNodesInALayer + j;
-         thetas[destNodeIndex] = 0.0;
+   int maxNodesInALayer = net->maxNodesInALayer;
+   int numSourceNodes = net->layerDimensions[m];
+   int numDestNodes = net->layerDimensions[m + 1];
+   double *sourceNodes = (m == 0) ? scratch->inputs : scratch->nodes + m * maxNodesInALayer;
 
-         for (int k = 0; k < numSourceNodes; k++) // looping through left layer
-         {
-            int sourceNodeIndex = m * maxNodesInALayer + k;
-            int currentWeightIndex = m * maxNodesInALayer * maxNodesInALayer + k * maxNodesInALayer + j;
+   double *destThetas = scratch->thetas + (m + 1) * maxNodesInALayer;
+   double *destNodes = scratch->nodes + (m + 1) * maxNodesInALayer;
 
-            thetas[destNodeIndex] += activationFunction(weights[currentWeightIndex] * nodes[sourceNodeIndex]);
-         } // for (int k = 0; k < numSourceNodes; k++)
+   // every theta in the right layer at once (see ./matrixFunctions.c)
+   if (net->useSparseKernels == 'Y' && net->sparseLayers[m].useSparseKernel == 'Y')
+   {
+      struct SparseLayer *layer = &net->sparseLayers[m];
+      multiplySparseMatrixVector(numDestNodes, layer->rowStarts, layer->columns, layer->values, sourceNodes, destThetas);
+   }
+   else
+   {
+      multiplyMatrices(1, numDestNodes, numSourceNodes, sourceNodes, numSourceNodes,
+                       net->weights + m * net->maxWeightsInALayer, maxNodesInALayer, destThetas, maxNodesInALayer);
+   }
 
-         nodes[destNodeIndex] = outputFunction(thetas[destNodeIndex]);
-      } // for (int j = 0; j < numDestNodes; j++)
-   }    // for (int m = 0; m < numLayers - 1; m++)
+   for (int j = 0; j < numDestNodes; j++) // looping through right layer
+   {
+      destThetas[j] = activationFunction(destThetas[j]);
+      destNodes[j] = outputFunction(destThetas[j]);
+   }
 
    return;
 }
 
 /**
- * This function calculates the error of a network (that
- * should already have been run) according to the
- * error function defined above.
+ * Finishes a run once every connectivity layer has been run: normalizes
+ * the output layer if the network uses softmax, finds the error if the
+ * scratch has expected outputs bound, and copies out the outputs.
+ *
+ * @param net the network being run
+ * @param scratch the buffers of the run
+ * @param outputs where to copy the output values (NULL to leave them in the scratch)
  */
-double calculateError()
+void finishOutputLayer(const Network *net, NetworkScratch *scratch, double *outputs)
 {
-   double *actualOutputs = calloc(numOutputNodes, sizeof(double));
+   int maxNodesInALayer = net->maxNodesInALayer;
+   double *outputLayer = scratch->nodes + maxNodesInALayer * (net->numLayers - 1);
 
-   // storing actual outputs into an array to pass into the error function
-   int nodeIndex = (numLayers - 1) * maxNodesInALayer;
-   for (int i = 0; i < numOutputNodes; i++)
+   if (net->useSoftmax == 'Y') // the output layer is normalized as a whole
    {
-      actualOutputs[i] = nodes[nodeIndex + i];
+      for (int i = 0; i < net->numOutputNodes; i++)
+      {
+         outputLayer[i] = scratch->thetas[maxNodesInALayer * (net->numLayers - 1) + i];
+      }
+      softmax(outputLayer, net->numOutputNodes);
    }
 
-   double error = errorFunction(expectedOutputs, actualOutputs, numOutputNodes);
+   if (scratch->expectedOutputs != NULL)
+   {
+      scratch->error = net->errorFunction(scratch->expectedOutputs, outputLayer, net->numOutputNodes);
+   }
 
-   free(actualOutputs);
+   if (outputs != NULL)
+   {
+      for (int i = 0; i < net->numOutputNodes; i++)
+      {
+         outputs[i] = outputLayer[i];
+      }
+   }
 
-   return error;
+   return;
 }
 
 /**
- * This function is responsible for freeing memory after running/training the network.
+ * Runs the network's own scratch on one of the training sets it holds,
+ * finding the error of the run. Training sets whose values at the frozen
+ * boundary are cached (see ./freeze.c) are run from there, and training
+ * sets that were reduced when they were loaded (see ./projection.c) are run
+ * from their reduced form.
+ *
+ * @param net the network to run
+ * @param t the index of the training set
  */
-void freeMemory()
+void runTrainingSet(Network *net, int t)
 {
-   free(layerDimensions);
-   free(nodes);
-   free(weights);
-   free(expectedOutputs);
-   free(thetas);
-   free(psis);
+   net->scratch->expectedOutputs = net->trainingLabels + (size_t)t * net->numOutputNodes;
+
+   if (net->frozenCache != NULL)
+   {
+      runFromFrozenBoundary(net, net->scratch, t);
+   }
+   else if (net->reducedTrainingInputs != NULL)
+   {
+      runFromInputLayer(net, net->scratch, net->reducedTrainingInputs + (size_t)t * net->numReducedInputs, NULL);
+   }
+   else
+   {
+      runNetwork(net, net->scratch, net->trainingInputs + (size_t)t * net->inputStride, NULL);
+   }
 
    return;
 }
@@ -591,13 +1748,15 @@ void freeMemory()
 /**
  * This function prints the current
  * weights of the neural network.
+ *
+ * @param net the network whose weights to print
  */
-void printWeights()
+void printWeights(const Network *net)
 {
    printf("\nNOW PRINTING WEIGHTS\n");
-   for (int i = 0; i < totalWeights; i++)
+   for (int i = 0; i < net->totalWeights; i++)
    {
-      printf("%lf\n", weights[i]);
+      printf("%lf\n", net->weights[i]);
    }
 
    return;
@@ -606,238 +1765,504 @@ void printWeights()
 /**
  * Trains the network once for all training sets, using backprop,
  * then calculates the new error.
- * 
+ *
  * Adaptive learning can be disabled by setting the learning
- * factor scaler to 1.0 in the config. Weight rollback can 
+ * factor scaler to 1.0 in the config. Weight rollback can
  * also be enabled/disabled.
+ *
+ * With augmentation on, the network is also trained on the augmented
+ * copies waiting in the augmenter's queue (see ./augment.c) after the
+ * real training sets.
+ *
+ * @param net the network to train
  */
-void trainForAllTrainingSets()
+void trainForAllTrainingSets(Network *net)
 {
-   double *oldWeights;
+   double *weights = net->weights;
+
+   double *oldWeights = NULL;
    // only enable weight rollback if adaptive learning is enabled as well
-   if (enableWeightRollback == 'Y' && learningFactorScaler != 1.0)
+   if (net->enableWeightRollback == 'Y' && net->learningFactorScaler != 1.0)
    {
-      oldWeights = calloc(totalWeights, sizeof(double));
-      for (int i = 0; i < totalWeights; i++)
+      oldWeights = calloc(net->totalWeights, sizeof(double));
+      for (int i = 0; i < net->totalWeights; i++)
       {
          oldWeights[i] = weights[i]; // storing old weights
       }
    }
 
    double errorSum = 0.0;
-   int index = 0;
-   for (int t = 0; t < numTrainingSets; t++) // train on every training set
+   for (int t = 0; t < net->numTrainingSets; t++) // train on every training set
    {
-      for (int k = 0; k < numInputNodes; k++) // setting correct input values
-      {
-         nodes[k] = trainingSets[index];
-         index++;
-      }
-      for (int k = 0; k < numOutputNodes; k++) // setting correct expected output values
-      {
-         expectedOutputs[k] = trainingSets[index];
-         index++;
-      }
-
-      runNetwork();
-
-      // collecting/applying psi values in the rightmost layer
-      for (int j = layerDimensions[numLayers - 2] - 1; j >= 0; j--) // last hidden layer
-      {
-         int sourceNodeIndex = maxNodesInALayer * (numLayers - 2) + j;
-
-         for (int i = layerDimensions[numLayers - 1] - 1; i >= 0; i--) // output layer
-         {
-            int destNodeIndex = maxNodesInALayer * (numLayers - 1) + i;
+      double *expectedOutputs = net->trainingLabels + (size_t)t * net->numOutputNodes;
 
-            int weightJIIndex = maxWeightsInALayer * (numLayers - 2) + maxNodesInALayer * j + i;
+      runTrainingSet(net, t);
+      updateWeights(net, expectedOutputs);
 
-            double w = nodes[destNodeIndex] - expectedOutputs[i];
-            double theta = thetas[maxNodesInALayer * (numLayers - 1) + i];
-            double psiI = w * outputDerivFunction(theta);
+      errorSum += net->scratch->error;
+   } // for (int t = 0; t < numTrainingSets; t++)
 
-            psis[destNodeIndex] = psiI;
-            psis[maxNodesInALayer * (numLayers - 2) + j] += psiI * weights[weightJIIndex];
+   // augmented copies only train the network (the error stays that of the real training sets)
+   for (int i = 0; net->augmenter != NULL && i < net->numTrainingSets * net->augmentCopies; i++)
+   {
+      int t;
+      double *inputs = takeAugmentedSet(net->augmenter, &t);
+      double *expectedOutputs = net->trainingLabels + (size_t)t * net->numOutputNodes;
 
-            /**
-             * A -= is used here instead of a += like the documentation states
-             * because when the weights are calculated, they are not multiplied
-             * by the the extra -1 in the calculation formula. This avoids
-             * unnecessarily flipping signs two times, saving time.
-             */ 
-            weights[weightJIIndex] -= learningFactor * nodes[sourceNodeIndex] * psiI;
+      net->scratch->expectedOutputs = expectedOutputs;
+      runNetwork(net, net->scratch, inputs, NULL);
+      updateWeights(net, expectedOutputs);
 
-         } // for (int i = layerDimensions[numLayers - 1] - 1; i >= 0; i--)
+      releaseAugmentedSet(net->augmenter);
+   }
 
-         double thetaJ = thetas[maxNodesInALayer * (numLayers - 2) + j];
-         psis[maxNodesInALayer * (numLayers - 2) + j] *= outputDerivFunction(thetaJ);
-      } // for (int j = layerDimensions[numLayers - 2] - 1; j >= 0; j--)
+   double newError = errorSum;
 
-      // collecting/applying values in the non-rightmost layers
-      for (int m = numLayers - 3; m >= 0; m--) // looping backwards through connectivity layers
-      {
-         int numSourceNodes = layerDimensions[m];
-         int numDestNodes = layerDimensions[m + 1];
+   adaptLearningFactor(net, newError, oldWeights);
 
-         for (int j = numDestNodes - 1; j >= 0; j--) // looping through right layer
-         {
-            int destNodeIndex = maxNodesInALayer * (m + 1) + j;
+   if (net->enableWeightRollback == 'Y' && net->learningFactorScaler != 1.0)
+   {
+      free(oldWeights);
+   }
 
-            for (int k = numSourceNodes - 1; k >= 0; k--) // looping through left layer
-            {
-               int sourceNodeIndex = maxNodesInALayer * m + k;
+   return;
+}
 
-               double psiJ = psis[destNodeIndex];
-               int weightKJIndex = maxWeightsInALayer * m + maxNodesInALayer * k + j;
+/**
+ * Trains the network on the training set it was just run on, using
+ * backprop: finds the psis, then moves every weight against its partial
+ * derivative, scaled by the learning factor. Frozen layers are left as
+ * they are (see ./freeze.c).
+ *
+ * @param net the network that was just run (with its own scratch)
+ * @param expectedOutputs the expected outputs of the training set
+ */
+void updateWeights(Network *net, double *expectedOutputs)
+{
+   int maxNodesInALayer = net->maxNodesInALayer;
+   int maxWeightsInALayer = net->maxWeightsInALayer;
+   double *nodes = net->scratch->nodes;
+   double *psis = net->scratch->psis;
+
+   calculatePsis(net, net->scratch, expectedOutputs);
+
+   /**
+    * A -= is used here instead of a += like the documentation states
+    * because when the weights are calculated, they are not multiplied
+    * by the the extra -1 in the calculation formula. This avoids
+    * unnecessarily flipping signs two times, saving time.
+    */
+   for (int m = net->numLayers - 2; m >= 0; m--) // looping backwards through connectivity layers
+   {
+      if (net->frozenLayers[m] == 'Y')
+         continue;
 
-               weights[weightKJIndex] -= learningFactor * nodes[sourceNodeIndex] * psiJ;
+      double *sourceNodes = (m == 0) ? net->scratch->inputs : nodes + maxNodesInALayer * m;
 
-            } // for (int k = numSourceNodes - 1; k >= 0; k--)
-         }    // for (int j = numDestNodes - 1; j >= 0; j--)
-      }       // for (int m = numLayers - 3; m >= 0; m--)
+      addOuterProduct(net->layerDimensions[m], net->layerDimensions[m + 1], -net->learningFactor, sourceNodes,
+                      psis + maxNodesInALayer * (m + 1), net->weights + maxWeightsInALayer * m, maxNodesInALayer);
+   }
 
-      double err = calculateError();
+   if (net->convFilters > 0 && net->freezeConvolution != 'Y')
+   {
+      addConvolutionGradients(net, net->scratch, -net->learningFactor, net->weights + net->convWeightsOffset);
+   }
 
-      errorSum += err * err;
-   }          // for (int t = 0; t < numTrainingSets; t++)
+   return;
+}
 
-   double newError = 0.5 * errorSum; // multiply by 0.5 according to the error function
+/**
+ * Updates the error and the learning factor after a round of training
+ * has produced a new error, rolling the weights back to a given copy
+ * if the error went up and weight rollback is enabled.
+ *
+ * Adaptive learning can be disabled by setting the learning
+ * factor scaler to 1.0 in the config.
+ *
+ * @param net the network being trained
+ * @param newError the error produced by the latest round of training
+ * @param oldWeights the weights to roll back to (only used if rollback is enabled)
+ * @return 'Y' if the weights were rolled back, 'n' otherwise
+ */
+char adaptLearningFactor(Network *net, double newError, double *oldWeights)
+{
+   char rolledBack = 'n';
 
-   if (learningFactorScaler != 1.0) // enable adaptive learning
+   if (net->learningFactorScaler != 1.0) // enable adaptive learning
    {
-      if (newError > error && learningFactor > minLearningFactor) // error went up and the learning factor has room to decrease
+      if (newError > net->error && net->learningFactor > net->minLearningFactor) // error went up and the learning factor has room to decrease
       {
-         learningFactor /= learningFactorScaler;
+         net->learningFactor /= net->learningFactorScaler;
 
-         if (enableWeightRollback == 'Y')
+         if (net->enableWeightRollback == 'Y')
          {
-            for (int i = 0; i < totalWeights; i++)
+            for (int i = 0; i < net->totalWeights; i++)
             {
-               weights[i] = oldWeights[i];
+               net->weights[i] = oldWeights[i];
             }
-            free(oldWeights);
+            rolledBack = 'Y';
          }
       }
-      else if (newError < error) // error went down
+      else if (newError < net->error) // error went down
       {
-         error = newError;
-         learningFactor *= learningFactorScaler;
+         net->error = newError;
+         net->learningFactor *= net->learningFactorScaler;
       }
 
-      if (learningFactor > maxLearningFactor)
-         learningFactor = maxLearningFactor; // capping the learning factor
+      if (net->learningFactor > net->maxLearningFactor)
+         net->learningFactor = net->maxLearningFactor; // capping the learning factor
    }
    else // adaptive learning is disabled
    {
-      error = newError;
+      net->error = newError;
+   }
+
+   return rolledBack;
+}
+
+/**
+ * Finds the psi value of every node to the right of the input layer
+ * after the network has been run on a training set, working backwards
+ * from the output layer (and of the input layer too, if it holds the
+ * outputs of a convolution layer). The weights are only read, so they
+ * can be updated from the psis afterwards. Nothing is found at or before
+ * the frozen boundary, since no weight there is trained (see ./freeze.c).
+ *
+ * @param net the network that was run
+ * @param scratch the scratch the network was run with
+ * @param expectedOutputs the expected outputs of the training set
+ */
+void calculatePsis(const Network *net, NetworkScratch *scratch, double *expectedOutputs)
+{
+   calculateOutputPsis(net, scratch, expectedOutputs);
+
+   // psi values in the hidden layers, found from the layer to their right
+   for (int n = net->numLayers - 2; n >= 1 && n > net->frozenBoundary; n--)
+   {
+      calculateLayerPsis(net, scratch, n);
+   }
+
+   // psi values of the convolution layer's pooled outputs, which it carries back to its filters itself
+   if (net->convFilters > 0 && net->freezeConvolution != 'Y')
+   {
+      calculateLayerPsis(net, scratch, 0);
    }
 
    return;
 }
 
 /**
- * This runs the network for all the training sets and prints
- * out the input nodes, output nodes, expected output nodes, and error.
- * It also prints out the total error over all training sets.
- * No training is done.
+ * Finds the psi value of every node in the output layer.
+ *
+ * @param net the network that was run
+ * @param scratch the scratch the network was run with
+ * @param expectedOutputs the expected outputs of the training set
+ */
+void calculateOutputPsis(const Network *net, NetworkScratch *scratch, double *expectedOutputs)
+{
+   int outputLayer = net->maxNodesInALayer * (net->numLayers - 1);
+
+   for (int i = 0; i < net->numOutputNodes; i++)
+   {
+      int nodeIndex = outputLayer + i;
+      scratch->psis[nodeIndex] = scratch->nodes[nodeIndex] - expectedOutputs[i];
+      if (net->useSoftmax != 'Y') // softmax with cross-entropy needs no derivative
+      {
+         scratch->psis[nodeIndex] *= outputDerivFunction(scratch->thetas[nodeIndex]);
+      }
+   }
+
+   return;
+}
+
+/**
+ * Finds the psi value of every node in one layer from the psis of the
+ * layer to its right, through the weights between them. The input layer
+ * (layer 0) only has psis when it holds the outputs of a convolution
+ * layer, and they are left without the output function's derivative.
+ *
+ * @param net the network that was run
+ * @param scratch the scratch the network was run with (with the psis of layer n + 1 found)
+ * @param n the layer whose psis to find
+ */
+void calculateLayerPsis(const Network *net, NetworkScratch *scratch, int n)
+{
+   int maxNodesInALayer = net->maxNodesInALayer;
+   double *layerPsis = scratch->psis + maxNodesInALayer * n;
+
+   multiplyMatrixVector(net->layerDimensions[n], net->layerDimensions[n + 1], net->weights + net->maxWeightsInALayer * n,
+                        maxNodesInALayer, scratch->psis + maxNodesInALayer * (n + 1), layerPsis);
+
+   if (n > 0)
+   {
+      for (int j = 0; j < net->layerDimensions[n]; j++)
+      {
+         layerPsis[j] *= outputDerivFunction(scratch->thetas[maxNodesInALayer * n + j]);
+      }
+   }
+
+   return;
+}
+
+/**
+ * Runs the network on a range of the training sets it holds and
+ * adds the partial derivatives of the error with respect to every weight
+ * to a given array (in the same mkj order as the weights). The weights
+ * themselves are left untouched, so the caller decides how to apply them.
+ * Nothing is added for frozen layers, so they stay as they are.
+ *
+ * @param net the network to run
+ * @param firstSet the index of the first training set to use
+ * @param endSet the index one past the last training set to use
+ * @param gradients the array to add the partial derivatives to (totalWeights long)
+ * @return the sum of the errors of the training sets in the range
  */
-void runForAllTrainingSets()
+double calculateGradients(Network *net, int firstSet, int endSet, double *gradients)
 {
-   int index = 0;
+   int numLayers = net->numLayers;
+   int *layerDimensions = net->layerDimensions;
+   int maxNodesInALayer = net->maxNodesInALayer;
+   int maxWeightsInALayer = net->maxWeightsInALayer;
+
+   double *nodes = net->scratch->nodes;
+   double *psis = net->scratch->psis;
+
    double errorSum = 0.0;
 
-   for (int i = 0; i < numTrainingSets; i++) // looping through all training sets
+   for (int t = firstSet; t < endSet; t++)
    {
-      for (int k = 0; k < numInputNodes; k++)
+      double *expectedOutputs = net->trainingLabels + (size_t)t * net->numOutputNodes;
+
+      runTrainingSet(net, t);
+
+      calculatePsis(net, net->scratch, expectedOutputs);
+
+      // partial derivatives of every weight
+      for (int m = 0; m < numLayers - 1; m++)
       {
+         if (net->frozenLayers[m] == 'Y')
+            continue;
 
-         if (printNetworkSpecifics == 'Y') // for debugging
-         {
-            printf("%lf ", trainingSets[index]);
-         }
+         double *sourceNodes = (m == 0) ? net->scratch->inputs : nodes + maxNodesInALayer * m;
 
-         nodes[k] = trainingSets[index];
-         index++;
+         addOuterProduct(layerDimensions[m], layerDimensions[m + 1], 1.0, sourceNodes,
+                         psis + maxNodesInALayer * (m + 1), gradients + maxWeightsInALayer * m, maxNodesInALayer);
       }
-      if (printNetworkSpecifics == 'Y')
+
+      if (net->convFilters > 0 && net->freezeConvolution != 'Y')
       {
-         printf(" --> (expected ");
+         addConvolutionGradients(net, net->scratch, 1.0, gradients + net->convWeightsOffset);
       }
 
-      for (int k = 0; k < numOutputNodes; k++)
+      errorSum += net->scratch->error;
+   } // for (int t = firstSet; t < endSet; t++)
+
+   return errorSum;
+}
+
+/**
+ * This runs the network for all the training sets and prints
+ * out the input nodes, output nodes, expected output nodes, and error.
+ * It also prints out the total error over all training sets.
+ * No training is done.
+ *
+ * If the network never loaded its training sets (because it only runs),
+ * they are streamed from the file one at a time instead.
+ *
+ * @param net the network to run
+ */
+void runForAllTrainingSets(Network *net)
+{
+   NetworkScratch *scratch = net->scratch;
+   double *outputs = scratch->nodes + net->maxNodesInALayer * (net->numLayers - 1);
+
+   FILE *nodesFile = NULL;
+   double *streamedInputs = NULL;
+   double *streamedLabels = NULL;
+
+   if (net->trainingInputs == NULL) // streaming the training sets
+   {
+      nodesFile = fopen(net->nodesFileInput, "r");
+      unsigned int totalTrainingSets = 0;
+      if (nodesFile == NULL || fscanf(nodesFile, "%x", &totalTrainingSets) != 1)
       {
-         
-         if (printNetworkSpecifics == 'Y') // for debugging
+         printf("There was an error opening the training sets file %s.\n", net->nodesFileInput);
+         if (nodesFile != NULL)
          {
-            printf(" %lf", trainingSets[index]);
+            fclose(nodesFile);
          }
+         return;
+      }
+      net->totalTrainingSets = (int)totalTrainingSets;
+      net->numTrainingSets = net->totalTrainingSets;
+
+      streamedInputs = allocateAligned(net->numInputNodes * sizeof(double));
+      streamedLabels = malloc(net->numOutputNodes * sizeof(double));
+   }
+
+   double errorSum = 0.0;
 
-         expectedOutputs[k] = trainingSets[index];
-         index++;
+   for (int i = 0; i < net->numTrainingSets; i++) // looping through all training sets
+   {
+      double *inputs;
+      double *expectedOutputs;
+
+      if (nodesFile != NULL)
+      {
+         inputs = streamedInputs;
+         expectedOutputs = streamedLabels;
+         if (readTrainingSet(net, nodesFile, inputs, expectedOutputs) != 0)
+            break;
+      }
+      else
+      {
+         inputs = net->trainingInputs + (size_t)i * net->inputStride;
+         expectedOutputs = net->trainingLabels + (size_t)i * net->numOutputNodes;
       }
 
-      runNetwork();
-      double err = calculateError();
+      if (nodesFile != NULL)
+      {
+         scratch->expectedOutputs = expectedOutputs;
+         runNetwork(net, scratch, inputs, NULL);
+      }
+      else
+      {
+         runTrainingSet(net, i);
+      }
 
-      if (printNetworkSpecifics == 'Y') // for debugging
+      if (net->printNetworkSpecifics == 'Y') // for debugging (printed by the logger's thread)
       {
-         printf(") actual: ");
-         for (int k = 0; k < numOutputNodes; k++)
-         {
-            printf(" %lf", nodes[maxNodesInALayer * (numLayers - 1) + k]);
-         }
-         printf("\n");
+         logTrainingSet(net->logger, inputs, net->numInputNodes, expectedOutputs, outputs, net->numOutputNodes);
       }
 
-      errorSum += err * err;
+      errorSum += scratch->error;
+   }
+
+   if (nodesFile != NULL)
+   {
+      fclose(nodesFile);
+      freeAligned(streamedInputs);
+      free(streamedLabels);
+   }
+
+   if (net->numShards > 1) // every worker only holds its own shard of the training sets
+   {
+      ringAllReduce(net->group, &errorSum, 1);
    }
 
-   error = errorSum * 0.5; // multiply by 0.5 according to the error function
+   net->error = errorSum;
 
-   printf("Total error: %.16lf\n\n", error);
+   logText(net->logger, "Total error: %.16lf\n\n", net->error);
+   flushLogger(net->logger);
 
    return;
 }
 
 /**
- * Trains the network.
- * 
- * @param numTimes the amount of times to train the network
+ * Trains the network, saving a checkpoint of training every so often
+ * if the config names a checkpoint file. A pruned network is trained
+ * through its dense weights, with the pruned weights put back to zero
+ * after every cycle, and its sparse layers are refreshed at the end.
+ * With validation, training also stops once the validation error has
+ * not gone down in validation_patience cycles, and the weights that did
+ * best on the validation sets are kept (see ./validation.c).
+ * If layers at the front of the network are frozen, their outputs are
+ * cached once before the first cycle (see ./freeze.c).
+ *
+ * @param net the network to train
+ * @param numTimes the amount of times to train the network in total
+ *                 (counting the cycles done before a resumed checkpoint)
  * @param targetError the error at which to stop training (if reached)
  */
-void train(int numTimes, double targetError)
+void train(Network *net, int numTimes, double targetError)
 {
-   int cycles = 0;
-   while (cycles < numTimes && error > targetError)
+   int checkpointEvery = net->checkpointEveryIterations > 0 ? net->checkpointEveryIterations : net->dumpEveryIterations;
+   char saveCheckpoints = net->checkpointFile[0] != '\0' && net->shardIndex == 0; // once per group
+   char pruned = net->sparseLayers != NULL;
+
+   char stoppedEarly = 'n';
+
+   if (pruned)
+   {
+      net->useSparseKernels = 'n'; // the sparse layers go stale as soon as the dense weights change
+   }
+
+   if (net->validator != NULL)
+   {
+      startValidation(net->validator);
+   }
+
+   cacheFrozenActivations(net);
+
+   while (net->iteration < numTimes && net->error > targetError && stoppedEarly != 'Y')
    {
-      trainForAllTrainingSets();
-      cycles++;
+      net->epochFunction(net);
+      net->iteration++;
+
+      if (pruned)
+      {
+         applyPruningMasks(net);
+      }
+
+      if (net->validator != NULL) // validated on another thread, so training carries on straight away
+      {
+         if (net->iteration % net->validationEvery == 0)
+         {
+            submitSnapshot(net->validator, net);
+         }
+         stoppedEarly = checkValidation(net->validator, net);
+      }
+
+      if (net->printDebugMessages == 'Y' || net->logger != NULL) // the logger may also keep a status page
+      {
+         logIteration(net->logger, net->iteration, net->error, net->learningFactor, net->numTrainingSets,
+                      net->printDebugMessages == 'Y');
+      }
 
-      if (printDebugMessages == 'Y')
+      if (net->iteration % net->dumpEveryIterations == 0 && net->shardIndex == 0) // dumps values every _x_ iterations (once per group)
       {
-         printf("DEBUG: iteration %d, error: %.16lf, lambda: %lf\n", cycles, error, learningFactor);
+         writeWeightsToFile(net, net->weightsFileOutput);
+         writeOutputsToFile(net);
       }
 
-      if (cycles % dumpEveryIterations == 0) // dumps values every _x_ iterations
+      if (saveCheckpoints && net->iteration % checkpointEvery == 0)
       {
-         writeWeightsToFile();
-         writeOutputsToFile();
+         saveCheckpoint(net, net->checkpointFile);
       }
    }
 
-   runForAllTrainingSets();
+   if (net->validator != NULL) // keeping the weights that did best on the validation sets
+   {
+      finishValidation(net->validator, net);
+   }
+
+   if (pruned)
+   {
+      refreshSparseLayers(net);
+      net->useSparseKernels = 'Y';
+   }
+
+   // saved before the final run, which replaces the error with that of a clean pass
+   if (saveCheckpoints && (net->iteration == 0 || net->iteration % checkpointEvery != 0))
+   {
+      saveCheckpoint(net, net->checkpointFile);
+   }
 
-   printf("lambda: %lf\n", learningFactor);
-   printf("Stopped after %d cycles (max %d cycles)\n", cycles, numTimes);
-   printf("Current error: %.16lf\n", error);
+   runForAllTrainingSets(net);
+
+   printf("lambda: %lf\n", net->learningFactor);
+   printf("Stopped after %d cycles (max %d cycles)\n", net->iteration, numTimes);
+   printf("Current error: %.16lf\n", net->error);
 
    // printing termination conditions that were or were not met
-   if (cycles == numTimes - 1)
+   if (net->iteration == numTimes - 1)
       printf("Stopped due to cycle amount\n");
-   if (error <= targetError)
-      printf("Stopped due to sufficiently low error (%.16lf < %.16lf)\n", error, targetError);
+   if (stoppedEarly == 'Y')
+      printf("Stopped early since the validation error had not gone down in %d cycles\n", net->validationPatience);
+   if (net->error <= targetError)
+      printf("Stopped due to sufficiently low error (%.16lf < %.16lf)\n", net->error, targetError);
    else
-      printf("Did not reach specified error successfully (%.16lf > %.16lf)\n", error, targetError);
+      printf("Did not reach specified error successfully (%.16lf > %.16lf)\n", net->error, targetError);
 
    return;
-}
\ No newline at end of file
+}
@@ -0,0 +1,604 @@
+/**
+ * Created 10/18/2026
+ * This file keeps a network resident and trains it on new training sets
+ * as they arrive, instead of retraining it from scratch on a regenerated
+ * training sets file, and publishes its weights every so often so that
+ * processes running it can swap in the newest ones.
+ *
+ * Training sets are read from a source: a pipe (stdin), a TCP port that
+ * senders connect to one after another, or a file that is followed as it
+ * is appended to. Either way they are in the same format as the training
+ * sets file, one after another and without the count in front. Each one is
+ * trained on as soon as it is read, with the same backprop step as
+ * trainForAllTrainingSets (see ./network.c).
+ *
+ * Every online_publish_seconds, if anything was trained on since the last
+ * time, a publisher thread copies the weights (holding the lock the
+ * training thread holds while it changes them) and writes the copy as
+ * version N of the weights, to where_to_dump_weights followed by .N. The
+ * version is written to a temporary file first and renamed, and only then
+ * is where_to_dump_weights followed by .latest (which holds the newest
+ * version and its file) replaced the same way, so a reader never sees a
+ * half-written version. Only the newest online_keep_versions versions are
+ * kept. A restarted online run carries on from the newest version.
+ *
+ * Weights that were loaded pruned (see ./pruning.c) are trained through
+ * their dense form, and their pruned weights are put back to zero before
+ * every version is published, so every version stays as sparse.
+ *
+ * Functions in this file:
+ *
+ * int runOnline(int argc, char *argv[])
+ * int loadNewestSnapshot(Network *net, char *weightsFile, int *version)
+ * int openSampleSource(SampleSource *source, char *name)
+ * void closeSampleSource(SampleSource *source)
+ * int readSample(Network *net, SampleSource *source, double *inputs, double *expectedOutputs)
+ * int readToken(SampleSource *source, char *token)
+ * int refillSource(SampleSource *source)
+ * void *runPublisher(void *argument)
+ * int publishSnapshot(Publisher *publisher, int version)
+ * int readNewestVersion(char *weightsFile, int *version, char *versionFile)
+ * void waitForMoreData(void)
+ */
+
+#include "./headerfiles/sockets.h" // importing sockets (before anything that includes windows.h)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "./headerfiles/networkInternals.h" // importing the network layout and functions
+#include "./headerfiles/pruning.h"          // importing the pruning masks
+#include "./headerfiles/online.h"
+
+#define SOURCE_BUFFER_LENGTH 65536 // bytes read from the source at a time
+#define MAX_TOKEN_LENGTH 64        // longest value in a training set
+
+/**
+ * Where training sets come from.
+ */
+typedef struct SampleSource
+{
+   char kind;         // p for a pipe (stdin), s for a TCP port, f for a followed file
+   FILE *file;        // the pipe or the file
+   SOCKET listener;   // the port senders connect to
+   SOCKET connection; // the sender being read from (INVALID_SOCKET between senders)
+   char buffer[SOURCE_BUFFER_LENGTH];
+   int length;   // bytes in the buffer
+   int position; // the next byte to read from the buffer
+} SampleSource;
+
+/**
+ * The thread that publishes the weights, and what it shares with the
+ * training thread.
+ */
+typedef struct Publisher
+{
+   Network *net;        // the network being trained
+   Network snapshotNet; // a copy of the network that writes the snapshot instead of the weights being trained
+   double *snapshot;
+   char weightsFile[MAX_FILE_NAME_LENGTH]; // the versions are named after it
+
+   long long numSamples;   // training sets trained on so far
+   long long numPublished; // training sets that had been trained on when the last version was taken
+   double errorSum;        // error of the training sets since the last version was taken
+   int version;            // the last version published
+   int stopping;
+
+   pthread_mutex_t lock;  // held by the training thread while it changes the weights
+   pthread_cond_t wakeUp; // signalled when the publisher stops
+   pthread_t thread;
+} Publisher;
+
+// function headers ----------------------
+
+int openSampleSource(SampleSource *, char *);
+void closeSampleSource(SampleSource *);
+int readSample(Network *, SampleSource *, double *, double *);
+int readToken(SampleSource *, char *);
+int refillSource(SampleSource *);
+void *runPublisher(void *);
+int publishSnapshot(Publisher *, int);
+int readNewestVersion(char *, int *, char *);
+void waitForMoreData(void);
+
+// functions ----------------------
+
+/**
+ * Trains a network on training sets from a source as they arrive, and
+ * publishes its weights every so often, until the source ends (only a
+ * pipe ends; a port and a followed file are read for as long as the
+ * process runs).
+ *
+ * @param argc the number of command line arguments
+ * @param argv the command line arguments ("online", the config, and the source:
+ *             - for stdin, tcp:<port> for a port, or the path of a file to follow)
+ * @return the exit code for the process
+ */
+int runOnline(int argc, char *argv[])
+{
+   if (argc < 4)
+   {
+      printf("Usage: %s online <config file> <- | tcp:<port> | file to follow>\n", argv[0]);
+      return 1;
+   }
+
+   Network *net = createNetwork(argv[2]);
+   if (net == NULL)
+   {
+      return 1;
+   }
+
+   Publisher *publisher = calloc(1, sizeof(Publisher));
+   SampleSource *source = calloc(1, sizeof(SampleSource));
+   double *inputs = allocateAligned(net->numInputNodes * sizeof(double));
+   double *expectedOutputs = malloc(net->numOutputNodes * sizeof(double));
+   if (publisher == NULL || source == NULL || inputs == NULL || expectedOutputs == NULL)
+   {
+      printf("There was an error allocating memory for online training.\n");
+      free(publisher);
+      free(source);
+      freeAligned(inputs);
+      free(expectedOutputs);
+      freeNetwork(net);
+      return 1;
+   }
+
+   publisher->net = net;
+   strcpy(publisher->weightsFile, net->weightsFileOutput);
+   publisher->snapshot = malloc(net->totalWeights * sizeof(double));
+   publisher->snapshotNet = *net;
+   publisher->snapshotNet.weights = publisher->snapshot;
+
+   if (loadNewestSnapshot(net, publisher->weightsFile, &publisher->version) == 1) // carrying on where the last run stopped
+   {
+      printf("Carrying on from version %d of the weights\n", publisher->version);
+      findSparseLayers(net);
+   }
+   net->useSparseKernels = 'n'; // the sparse layers go stale as soon as the dense weights change
+
+   int status = 0;
+   if (publisher->snapshot == NULL || openSampleSource(source, argv[3]) != 0)
+   {
+      status = 1;
+   }
+   else
+   {
+      pthread_mutex_init(&publisher->lock, NULL);
+      pthread_cond_init(&publisher->wakeUp, NULL);
+      if (pthread_create(&publisher->thread, NULL, &runPublisher, publisher) != 0)
+      {
+         printf("There was an error starting the publishing thread.\n");
+         status = 1;
+      }
+      else
+      {
+         printf("Training online from %s\n", argv[3]);
+
+         while (readSample(net, source, inputs, expectedOutputs) == 0)
+         {
+            pthread_mutex_lock(&publisher->lock); // the publisher only copies the weights between training sets
+            net->scratch->expectedOutputs = expectedOutputs;
+            runNetwork(net, net->scratch, inputs, NULL);
+            updateWeights(net, expectedOutputs);
+            publisher->errorSum += net->scratch->error;
+            publisher->numSamples++;
+            pthread_mutex_unlock(&publisher->lock);
+         }
+
+         pthread_mutex_lock(&publisher->lock); // publishing what is left and stopping
+         publisher->stopping = 1;
+         pthread_cond_broadcast(&publisher->wakeUp);
+         pthread_mutex_unlock(&publisher->lock);
+         pthread_join(publisher->thread, NULL);
+
+         printf("Trained on %lld training sets online\n", publisher->numSamples);
+      }
+      pthread_mutex_destroy(&publisher->lock);
+      pthread_cond_destroy(&publisher->wakeUp);
+      closeSampleSource(source);
+   }
+
+   free(publisher->snapshot);
+   free(publisher);
+   free(source);
+   freeAligned(inputs);
+   free(expectedOutputs);
+   freeNetwork(net);
+
+   return status;
+}
+
+/**
+ * Loads the newest version of the weights published by an online run, if
+ * it is newer than a given version. This is how a process running the
+ * network swaps in new weights; since the weights are read straight into
+ * the network, a process that runs the network on other threads should
+ * load them into a second network with the same config and swap the two.
+ *
+ * @param net the network to load the weights into
+ * @param weightsFile the where_to_dump_weights of the online run's config
+ * @param version the version the network has (0 for none), set to the version loaded
+ * @return 1 if newer weights were loaded, 0 if there are none, -1 if they could not be loaded
+ */
+int loadNewestSnapshot(Network *net, char *weightsFile, int *version)
+{
+   int newestVersion;
+   char versionFile[MAX_FILE_NAME_LENGTH];
+
+   if (readNewestVersion(weightsFile, &newestVersion, versionFile) != 0 || newestVersion <= *version)
+   {
+      return 0;
+   }
+   if (initializeWeightsFromFile(net, versionFile) != 0)
+   {
+      return -1;
+   }
+
+   *version = newestVersion;
+
+   return 1;
+}
+
+/**
+ * Opens a source of training sets.
+ *
+ * @param source the source to open
+ * @param name - for stdin, tcp:<port> for a port, or the path of a file to follow
+ * @return 0 if successful, -1 if the source could not be opened
+ */
+int openSampleSource(SampleSource *source, char *name)
+{
+   source->file = NULL;
+   source->listener = INVALID_SOCKET;
+   source->connection = INVALID_SOCKET;
+   source->length = 0;
+   source->position = 0;
+
+   if (strcmp(name, "-") == 0)
+   {
+      source->kind = 'p';
+      source->file = stdin;
+   }
+   else if (strncmp(name, "tcp:", 4) == 0)
+   {
+      source->kind = 's';
+      initializeSockets();
+      source->listener = openListeningSocket(atoi(name + 4));
+      if (source->listener == INVALID_SOCKET)
+      {
+         printf("There was an error listening on port %s.\n", name + 4);
+         return -1;
+      }
+   }
+   else
+   {
+      source->kind = 'f';
+      source->file = fopen(name, "r");
+      if (source->file == NULL)
+      {
+         printf("There was an error opening the file %s to follow.\n", name);
+         return -1;
+      }
+   }
+
+   return 0;
+}
+
+/**
+ * Closes a source of training sets.
+ *
+ * @param source the source to close
+ */
+void closeSampleSource(SampleSource *source)
+{
+   if (source->kind == 'f' && source->file != NULL)
+   {
+      fclose(source->file);
+   }
+   if (source->connection != INVALID_SOCKET)
+   {
+      closesocket(source->connection);
+   }
+   if (source->listener != INVALID_SOCKET)
+   {
+      closesocket(source->listener);
+   }
+
+   return;
+}
+
+/**
+ * Reads the next training set from a source, waiting for it to arrive.
+ * Values are pels in hex (scaled to [0,1]) when the network uses a bitmap,
+ * and plain decimals otherwise, as in readTrainingSet (see ./network.c).
+ * A training set cut off by its sender going away is dropped.
+ *
+ * @param net the network the training set is for
+ * @param source the source to read from
+ * @param inputs where to store the numInputNodes input values
+ * @param expectedOutputs where to store the numOutputNodes expected output values
+ * @return 0 on success, -1 if the source ended
+ */
+int readSample(Network *net, SampleSource *source, double *inputs, double *expectedOutputs)
+{
+   char token[MAX_TOKEN_LENGTH + 1];
+
+   for (int i = 0; i < net->numInputNodes + net->numOutputNodes; i++)
+   {
+      int result = readToken(source, token);
+      if (result < 0)
+      {
+         return -1;
+      }
+      if (result > 0) // the sender went away, so starting again with the next one
+      {
+         i = -1;
+         continue;
+      }
+
+      double value;
+      if (net->useBitmap == 'Y') // pels
+      {
+         value = ((double)(unsigned int)strtoul(token, NULL, 16)) / UNSIGNED_INT_SCALER;
+      }
+      else
+      {
+         value = strtod(token, NULL);
+      }
+
+      if (i < net->numInputNodes)
+         inputs[i] = value;
+      else
+         expectedOutputs[i - net->numInputNodes] = value;
+   }
+
+   return 0;
+}
+
+/**
+ * Reads the next value (anything between whitespace) from a source,
+ * waiting for more to arrive if the source has not ended. A value is
+ * only finished once the whitespace after it has arrived, so one that
+ * is only half written to a followed file is waited for.
+ *
+ * @param source the source to read from
+ * @param token where to store the value (MAX_TOKEN_LENGTH characters at most; longer values are cut short)
+ * @return 0 on success, -1 if the source ended, 1 if the sender went away partway through
+ */
+int readToken(SampleSource *source, char *token)
+{
+   int length = 0;
+
+   while (1)
+   {
+      if (source->position == source->length)
+      {
+         int result = refillSource(source);
+         if (result < 0 && length > 0) // the last value of a pipe
+            break;
+         if (result != 0)
+            return result;
+      }
+
+      char c = source->buffer[source->position++];
+      if (c == ' ' || c == '\n' || c == '\r' || c == '\t')
+      {
+         if (length > 0)
+            break;
+         continue;
+      }
+
+      if (length < MAX_TOKEN_LENGTH)
+      {
+         token[length++] = c;
+      }
+   } // while (1)
+
+   token[length] = '\0';
+
+   return 0;
+}
+
+/**
+ * Reads more bytes from a source into its buffer, waiting until there
+ * are some. A followed file is checked again every so often, and a port
+ * waits for the next sender once the last one goes away.
+ *
+ * @param source the source to read from
+ * @return 0 if bytes were read, -1 if the source ended, 1 if the sender went away
+ */
+int refillSource(SampleSource *source)
+{
+   source->position = 0;
+   source->length = 0;
+
+   if (source->kind == 's')
+   {
+      while (source->connection == INVALID_SOCKET)
+      {
+         source->connection = accept(source->listener, NULL, NULL);
+      }
+
+      int received = recv(source->connection, source->buffer, SOURCE_BUFFER_LENGTH, 0);
+      if (received <= 0)
+      {
+         closesocket(source->connection);
+         source->connection = INVALID_SOCKET;
+         return 1;
+      }
+      source->length = received;
+
+      return 0;
+   }
+
+   // a line at a time, so a pipe hands over every line as soon as it is written
+   while (fgets(source->buffer, SOURCE_BUFFER_LENGTH, source->file) == NULL)
+   {
+      if (source->kind == 'p')
+      {
+         return -1;
+      }
+      clearerr(source->file); // the end of a followed file is only where its writer has got to
+      waitForMoreData();
+   }
+   source->length = strlen(source->buffer);
+
+   return 0;
+}
+
+/**
+ * Publishes a new version of the weights every online_publish_seconds
+ * (if anything was trained on since the last one), and once more when
+ * it is stopped.
+ *
+ * @param argument the publisher the thread works for
+ * @return NULL
+ */
+void *runPublisher(void *argument)
+{
+   Publisher *publisher = argument;
+   Network *net = publisher->net;
+
+   pthread_mutex_lock(&publisher->lock);
+   while (1)
+   {
+      struct timespec deadline;
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      long long nanoseconds = deadline.tv_nsec + (long long)(net->onlinePublishSeconds * 1e9);
+      deadline.tv_sec += nanoseconds / 1000000000LL;
+      deadline.tv_nsec = nanoseconds % 1000000000LL;
+
+      while (!publisher->stopping && pthread_cond_timedwait(&publisher->wakeUp, &publisher->lock, &deadline) == 0)
+         ;
+
+      if (publisher->numSamples > publisher->numPublished)
+      {
+         if (net->sparseLayers != NULL) // pruned weights stay pruned
+         {
+            applyPruningMasks(net);
+         }
+         memcpy(publisher->snapshot, net->weights, net->totalWeights * sizeof(double)); // taking the weights between training sets
+         long long numNew = publisher->numSamples - publisher->numPublished;
+         double meanError = publisher->errorSum / numNew;
+         publisher->numPublished = publisher->numSamples;
+         publisher->errorSum = 0.0;
+         int version = ++publisher->version;
+         pthread_mutex_unlock(&publisher->lock);
+
+         if (publishSnapshot(publisher, version) == 0)
+         {
+            printf("Published version %d of the weights (%lld new training sets, mean error %.16lf)\n", version, numNew,
+                   meanError);
+         }
+
+         pthread_mutex_lock(&publisher->lock);
+      }
+      else if (publisher->stopping)
+         break;
+   } // while (1)
+   pthread_mutex_unlock(&publisher->lock);
+
+   return NULL;
+}
+
+/**
+ * Writes the snapshot as a version of the weights, points readers to it,
+ * and removes the version that is no longer kept. Every file is written
+ * to a temporary file first and renamed, so it appears all at once.
+ *
+ * @param publisher the publisher whose snapshot to write
+ * @param version the version the snapshot is
+ * @return 0 if successful, -1 otherwise
+ */
+int publishSnapshot(Publisher *publisher, int version)
+{
+   char versionFile[MAX_FILE_NAME_LENGTH + 16];
+   char latestFile[MAX_FILE_NAME_LENGTH + 16];
+   char tempFile[MAX_FILE_NAME_LENGTH + 24];
+
+   sprintf(versionFile, "%s.%d", publisher->weightsFile, version);
+   sprintf(latestFile, "%s.latest", publisher->weightsFile);
+
+   sprintf(tempFile, "%s.tmp", versionFile);
+   if (writeWeightsToFile(&publisher->snapshotNet, tempFile) != 0 || rename(tempFile, versionFile) != 0)
+   {
+      printf("There was an error publishing version %d of the weights.\n", version);
+      remove(tempFile);
+      return -1;
+   }
+
+   sprintf(tempFile, "%s.tmp", latestFile);
+   FILE *file = fopen(tempFile, "w");
+   if (file == NULL)
+   {
+      printf("There was an error opening %s.\n", tempFile);
+      return -1;
+   }
+   fprintf(file, "%d %s\n", version, versionFile);
+   if (fclose(file) != 0)
+   {
+      printf("There was an error writing %s.\n", tempFile);
+      remove(tempFile);
+      return -1;
+   }
+#ifdef _WIN32
+   remove(latestFile); // rename will not replace a file on Windows
+#endif
+   if (rename(tempFile, latestFile) != 0)
+   {
+      printf("There was an error replacing %s.\n", latestFile);
+      return -1;
+   }
+
+   int numKept = publisher->net->onlineKeepVersions;
+   if (version > numKept)
+   {
+      sprintf(versionFile, "%s.%d", publisher->weightsFile, version - numKept);
+      remove(versionFile);
+   }
+
+   return 0;
+}
+
+/**
+ * Reads which version of the weights an online run published last.
+ *
+ * @param weightsFile the where_to_dump_weights of the online run's config
+ * @param version where to store the newest version
+ * @param versionFile where to store the path of the newest version (MAX_FILE_NAME_LENGTH long)
+ * @return 0 if successful, -1 if no version has been published
+ */
+int readNewestVersion(char *weightsFile, int *version, char *versionFile)
+{
+   char latestFile[MAX_FILE_NAME_LENGTH + 16];
+   sprintf(latestFile, "%s.latest", weightsFile);
+
+   FILE *file = fopen(latestFile, "r");
+   if (file == NULL)
+   {
+      return -1;
+   }
+
+   int numRead = fscanf(file, "%d %2047s", version, versionFile);
+   fclose(file);
+
+   return numRead == 2 ? 0 : -1;
+}
+
+/**
+ * Waits a little while before a followed file is checked for more data.
+ */
+void waitForMoreData(void)
+{
+#ifdef _WIN32
+   Sleep(100);
+#else
+   struct timespec delay = {0, 100000000}; // 100ms
+   nanosleep(&delay, NULL);
+#endif
+
+   return;
+}
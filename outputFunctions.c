@@ -11,6 +11,7 @@
  * sigmoid & sigmoidDeriv
  * tanh & tanhDeriv
  * relu & reluDeriv
+ * softmax
  */
 
 #include "./headerfiles/outputFunctions.h"
@@ -96,4 +97,39 @@ double reluDeriv(double value)
       return 0.0;
    }
    
-}
\ No newline at end of file
+}
+
+/**
+ * The softmax function turns a whole layer of activations into
+ * values between 0 and 1 that sum to 1:
+ * softmax(x)_i = e^x_i / (sum over j of e^x_j)
+ * Unlike the other functions in this file, it works on a whole
+ * layer at once (in place). The largest value is subtracted
+ * first so that the exponentials cannot overflow.
+ * 
+ * Its derivative is not needed on its own, since it is only
+ * used together with cross-entropy error, whose combined
+ * derivative is simply the actual minus the expected output.
+ */
+void softmax(double values[], int numValues)
+{
+   double largest = values[0];
+   for (int i = 1; i < numValues; i++)
+   {
+      largest = fmax(largest, values[i]);
+   }
+
+   double sum = 0.0;
+   for (int i = 0; i < numValues; i++)
+   {
+      values[i] = exp(values[i] - largest);
+      sum += values[i];
+   }
+
+   for (int i = 0; i < numValues; i++)
+   {
+      values[i] /= sum;
+   }
+
+   return;
+}
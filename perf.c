@@ -0,0 +1,470 @@
+/**
+ * Created 10/18/2026
+ * This file runs the repository's own workloads end to end and checks
+ * them against a checked-in baseline, so that a change that makes the
+ * real workloads slower (and not just a kernel) is caught.
+ *
+ * The baseline file (see ./perf/baseline.txt) starts with the tolerances
+ * and then lists every workload's config with the numbers it is held to:
+ * the wall time of the whole run, the training cycles done, the peak
+ * memory of the process while it ran, and the training sets run through
+ * the network per second. Each workload runs the way main does (create
+ * the network, run the training sets, train, write the weights and the
+ * outputs), but with its random weights seeded with PERF_SEED and with the
+ * files it writes moved next to the baseline file, so the run repeats
+ * exactly and leaves the repository as it was.
+ *
+ * A workload regresses if it is slower, takes more cycles, uses more
+ * memory, or runs fewer sets per second than its baseline by more than the
+ * tolerance. Wall times also get a few milliseconds of slack, since the
+ * shortest workloads only take a few milliseconds. Passing "update" after
+ * the baseline file writes the numbers that were measured into it instead.
+ *
+ * Functions in this file:
+ *
+ * int runPerf(int argc, char *argv[])
+ * int readPerfBaseline(char *baselineFile, PerfTolerances *tolerances, PerfResult *workloads, int maxWorkloads)
+ * int writePerfBaseline(char *baselineFile, const PerfTolerances *tolerances, const PerfResult *workloads, int numWorkloads)
+ * int runWorkload(char *configFile, char *baselineFile, PerfResult *result)
+ * int writeSeededConfig(char *configFile, char *seededFile)
+ * char *findRegression(const PerfResult *measured, const PerfResult *baseline, const PerfTolerances *tolerances)
+ * void resetPeakMemory(void)
+ * long long getPeakMemory(void)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "./headerfiles/networkInternals.h" // importing the network layout and functions
+#include "./headerfiles/autoTune.h"         // importing getWallTime
+#include "./headerfiles/perf.h"
+
+#define PERF_SEED 1            // seeds every workload's random weights
+#define MAX_PERF_WORKLOADS 64  // most workloads a baseline file can list
+#define MAX_PERF_LINE_LENGTH 4096
+
+/**
+ * How far a workload may be from its baseline before it regresses,
+ * as fractions of the baseline.
+ */
+typedef struct PerfTolerances
+{
+   double time;   // extra wall time
+   double cycles; // extra training cycles
+   double memory; // extra peak memory
+   double rate;   // fewer training sets per second
+   double slack;  // extra milliseconds of wall time any workload may take (short runs are noisy)
+} PerfTolerances;
+
+/**
+ * What was measured for one workload (or what it is held to).
+ */
+typedef struct PerfResult
+{
+   char configFile[MAX_FILE_NAME_LENGTH];
+   double wallMilliseconds;
+   int cycles;
+   long long peakKilobytes;
+   double setsPerSecond;
+} PerfResult;
+
+// function headers ----------------------
+
+int readPerfBaseline(char *, PerfTolerances *, PerfResult *, int);
+int writePerfBaseline(char *, const PerfTolerances *, const PerfResult *, int);
+int runWorkload(char *, char *, PerfResult *);
+int writeSeededConfig(char *, char *);
+char *findRegression(const PerfResult *, const PerfResult *, const PerfTolerances *);
+void resetPeakMemory(void);
+long long getPeakMemory(void);
+
+// functions ----------------------
+
+/**
+ * Runs every workload in a baseline file and compares it against its
+ * baseline, or writes the numbers measured into the file if the argument
+ * after it is "update".
+ *
+ * @param argc the number of command line arguments
+ * @param argv the command line arguments ("perf", the baseline file, and optionally "update")
+ * @return 0 if no workload regressed (or the baseline was updated), 1 otherwise
+ */
+int runPerf(int argc, char *argv[])
+{
+   if (argc < 3)
+   {
+      printf("Usage: %s perf <baseline file> [update]\n", argv[0]);
+      return 1;
+   }
+
+   char *baselineFile = argv[2];
+   char update = argc >= 4 && strcmp(argv[3], "update") == 0;
+
+   PerfTolerances tolerances;
+   PerfResult *baseline = malloc(MAX_PERF_WORKLOADS * sizeof(PerfResult));
+   PerfResult *measured = malloc(MAX_PERF_WORKLOADS * sizeof(PerfResult));
+   if (baseline == NULL || measured == NULL)
+   {
+      printf("There was an error allocating memory for the workloads.\n");
+      free(baseline);
+      free(measured);
+      return 1;
+   }
+
+   int numWorkloads = readPerfBaseline(baselineFile, &tolerances, baseline, MAX_PERF_WORKLOADS);
+   if (numWorkloads <= 0)
+   {
+      free(baseline);
+      free(measured);
+      return 1;
+   }
+
+   for (int i = 0; i < numWorkloads; i++)
+   {
+      printf("\n==== running %s ====\n", baseline[i].configFile);
+      if (runWorkload(baseline[i].configFile, baselineFile, &measured[i]) != 0)
+      {
+         free(baseline);
+         free(measured);
+         return 1;
+      }
+   }
+
+   int numRegressed = 0;
+
+   printf("\n%-32s %12s %10s %12s %14s\n", "workload (baseline)", "wall ms", "cycles", "peak KB", "sets/s");
+   for (int i = 0; i < numWorkloads; i++)
+   {
+      char *regression = update ? NULL : findRegression(&measured[i], &baseline[i], &tolerances);
+      numRegressed += regression != NULL;
+
+      printf("%-32s %12.1lf %10d %12lld %14.1lf   %s\n", measured[i].configFile, measured[i].wallMilliseconds,
+             measured[i].cycles, measured[i].peakKilobytes, measured[i].setsPerSecond,
+             regression != NULL ? regression : "ok");
+      printf("%-32s %12.1lf %10d %12lld %14.1lf\n", "", baseline[i].wallMilliseconds, baseline[i].cycles,
+             baseline[i].peakKilobytes, baseline[i].setsPerSecond);
+   }
+
+   int status = 0;
+   if (update)
+   {
+      status = writePerfBaseline(baselineFile, &tolerances, measured, numWorkloads) == 0 ? 0 : 1;
+      if (status == 0)
+      {
+         printf("Wrote the new baseline to %s\n", baselineFile);
+      }
+   }
+   else if (numRegressed > 0)
+   {
+      printf("%d of the %d workloads regressed\n", numRegressed, numWorkloads);
+      status = 1;
+   }
+   else
+   {
+      printf("No workload regressed\n");
+   }
+
+   free(baseline);
+   free(measured);
+
+   return status;
+}
+
+/**
+ * Reads a baseline file. Lines starting with # are comments, lines naming
+ * a tolerance (time_tolerance, cycles_tolerance, memory_tolerance,
+ * rate_tolerance, or time_slack_ms) set it, and every other line is a
+ * workload's config followed by its wall time in milliseconds, cycles,
+ * peak memory in kilobytes, and training sets per second.
+ *
+ * @param baselineFile the file to read
+ * @param tolerances where to store the tolerances (those not in the file are 0)
+ * @param workloads where to store the workloads
+ * @param maxWorkloads the most workloads to read
+ * @return the number of workloads read, or -1 if the file could not be read
+ */
+int readPerfBaseline(char *baselineFile, PerfTolerances *tolerances, PerfResult *workloads, int maxWorkloads)
+{
+   FILE *file = fopen(baselineFile, "r");
+   if (file == NULL)
+   {
+      printf("There was an error opening the baseline file %s.\n", baselineFile);
+      return -1;
+   }
+
+   char line[MAX_PERF_LINE_LENGTH];
+   char name[MAX_FILE_NAME_LENGTH];
+   int numWorkloads = 0;
+
+   memset(tolerances, 0, sizeof(PerfTolerances));
+
+   while (fgets(line, MAX_PERF_LINE_LENGTH, file) != NULL)
+   {
+      double value;
+
+      if (line[0] == '#' || sscanf(line, "%2047s", name) != 1)
+         continue;
+
+      if (strcmp(name, "time_tolerance") == 0 && sscanf(line, "%*s %lf", &value) == 1)
+         tolerances->time = value;
+      else if (strcmp(name, "cycles_tolerance") == 0 && sscanf(line, "%*s %lf", &value) == 1)
+         tolerances->cycles = value;
+      else if (strcmp(name, "memory_tolerance") == 0 && sscanf(line, "%*s %lf", &value) == 1)
+         tolerances->memory = value;
+      else if (strcmp(name, "rate_tolerance") == 0 && sscanf(line, "%*s %lf", &value) == 1)
+         tolerances->rate = value;
+      else if (strcmp(name, "time_slack_ms") == 0 && sscanf(line, "%*s %lf", &value) == 1)
+         tolerances->slack = value;
+      else if (numWorkloads < maxWorkloads)
+      {
+         PerfResult *workload = &workloads[numWorkloads];
+         if (sscanf(line, "%2047s %lf %d %lld %lf", workload->configFile, &workload->wallMilliseconds, &workload->cycles,
+                    &workload->peakKilobytes, &workload->setsPerSecond) != 5)
+         {
+            printf("Skipping a line of %s that is not a workload: %s", baselineFile, line);
+            continue;
+         }
+         numWorkloads++;
+      }
+   }
+
+   fclose(file);
+
+   if (numWorkloads == 0)
+   {
+      printf("The baseline file %s lists no workloads.\n", baselineFile);
+   }
+
+   return numWorkloads;
+}
+
+/**
+ * Writes a baseline file that readPerfBaseline can read.
+ *
+ * @param baselineFile the file to write
+ * @param tolerances the tolerances to keep
+ * @param workloads the numbers to hold the workloads to
+ * @param numWorkloads the number of workloads
+ * @return 0 if successful, -1 if the file could not be written
+ */
+int writePerfBaseline(char *baselineFile, const PerfTolerances *tolerances, const PerfResult *workloads, int numWorkloads)
+{
+   FILE *file = fopen(baselineFile, "w");
+   if (file == NULL)
+   {
+      printf("There was an error opening the baseline file %s.\n", baselineFile);
+      return -1;
+   }
+
+   fprintf(file, "# The numbers `make perf` holds the shipped workloads to (see ./perf.c), written by `make perf-baseline`.\n");
+   fprintf(file, "# A workload regresses if it is worse than its baseline by more than these fractions of it.\n");
+   fprintf(file, "time_tolerance   %.2lf\n", tolerances->time);
+   fprintf(file, "cycles_tolerance %.2lf\n", tolerances->cycles);
+   fprintf(file, "memory_tolerance %.2lf\n", tolerances->memory);
+   fprintf(file, "rate_tolerance   %.2lf\n", tolerances->rate);
+   fprintf(file, "time_slack_ms    %.1lf\n", tolerances->slack);
+   fprintf(file, "\n# config                       wall_ms     cycles    peak_kb      sets_per_second\n");
+
+   for (int i = 0; i < numWorkloads; i++)
+   {
+      fprintf(file, "%-30s %-11.1lf %-9d %-12lld %.1lf\n", workloads[i].configFile, workloads[i].wallMilliseconds,
+              workloads[i].cycles, workloads[i].peakKilobytes, workloads[i].setsPerSecond);
+   }
+
+   fclose(file);
+
+   return 0;
+}
+
+/**
+ * Runs a workload end to end the way main does, with its random weights
+ * seeded with PERF_SEED and the files it writes moved next to the baseline
+ * file (and removed afterwards), and measures it.
+ *
+ * @param configFile the workload's config
+ * @param baselineFile the baseline file (the files the workload writes are named after it)
+ * @param result where to store what was measured
+ * @return 0 if successful, -1 if the workload could not be run
+ */
+int runWorkload(char *configFile, char *baselineFile, PerfResult *result)
+{
+   char seededFile[MAX_FILE_NAME_LENGTH];
+   char weightsFile[MAX_FILE_NAME_LENGTH];
+   char outputsFile[MAX_FILE_NAME_LENGTH];
+   snprintf(seededFile, MAX_FILE_NAME_LENGTH, "%s.config", baselineFile);
+   snprintf(weightsFile, MAX_FILE_NAME_LENGTH, "%s.weights", baselineFile);
+   snprintf(outputsFile, MAX_FILE_NAME_LENGTH, "%s.outputs", baselineFile);
+
+   if (writeSeededConfig(configFile, seededFile) != 0)
+   {
+      return -1;
+   }
+
+   resetPeakMemory();
+   double startTime = getWallTime();
+
+   Network *net = createNetwork(seededFile);
+   remove(seededFile);
+   if (net == NULL)
+   {
+      printf("The workload %s could not be created.\n", configFile);
+      return -1;
+   }
+
+   strcpy(net->weightsFileOutput, weightsFile); // leaving the repository's files as they were
+   strcpy(net->nodesFileOutput, outputsFile);
+
+   runForAllTrainingSets(net);
+   int numPasses = 1;
+
+   if (net->trainNetwork == 'Y')
+   {
+      train(net, net->maxIterations, net->targetError);
+      numPasses += net->iteration + 1; // every cycle, and the run after training
+   }
+
+   writeWeightsToFile(net, net->weightsFileOutput);
+   writeOutputsToFile(net);
+
+   strcpy(result->configFile, configFile);
+   result->cycles = net->trainNetwork == 'Y' ? net->iteration : 0;
+   double numSetsRun = net->numTrainingSets > 0 ? (double)net->numTrainingSets * numPasses : 0.0;
+
+   freeNetwork(net);
+
+   result->wallMilliseconds = (getWallTime() - startTime) * 1000.0;
+   result->peakKilobytes = getPeakMemory();
+   result->setsPerSecond = result->wallMilliseconds > 0.0 ? numSetsRun / (result->wallMilliseconds / 1000.0) : 0.0;
+
+   remove(weightsFile);
+   remove(outputsFile);
+
+   return 0;
+}
+
+/**
+ * Copies a config and adds a random_seed setting to the end of it,
+ * so that its random weights are the same on every run.
+ *
+ * @param configFile the config to copy
+ * @param seededFile where to write the seeded copy
+ * @return 0 if successful, -1 if either file could not be opened
+ */
+int writeSeededConfig(char *configFile, char *seededFile)
+{
+   FILE *source = fopen(configFile, "r");
+   FILE *seeded = fopen(seededFile, "w");
+   if (source == NULL || seeded == NULL)
+   {
+      printf("There was an error copying the config %s to %s.\n", configFile, seededFile);
+      if (source != NULL)
+      {
+         fclose(source);
+      }
+      if (seeded != NULL)
+      {
+         fclose(seeded);
+      }
+      return -1;
+   }
+
+   char buffer[MAX_PERF_LINE_LENGTH];
+   size_t numRead;
+   while ((numRead = fread(buffer, 1, MAX_PERF_LINE_LENGTH, source)) > 0)
+   {
+      fwrite(buffer, 1, numRead, seeded);
+   }
+   fprintf(seeded, "\nrandom_seed %d\n", PERF_SEED); // the shipped configs may not end with a new line
+
+   fclose(source);
+   fclose(seeded);
+
+   return 0;
+}
+
+/**
+ * Compares what was measured for a workload against its baseline.
+ *
+ * @param measured what was measured
+ * @param baseline what the workload is held to
+ * @param tolerances how far it may be from its baseline
+ * @return what regressed first, or NULL if nothing did
+ */
+char *findRegression(const PerfResult *measured, const PerfResult *baseline, const PerfTolerances *tolerances)
+{
+   if (measured->wallMilliseconds > baseline->wallMilliseconds * (1.0 + tolerances->time) + tolerances->slack)
+      return "REGRESSED (wall time)";
+   if (measured->cycles > baseline->cycles * (1.0 + tolerances->cycles))
+      return "REGRESSED (cycles)";
+   if (measured->peakKilobytes > baseline->peakKilobytes * (1.0 + tolerances->memory))
+      return "REGRESSED (peak memory)";
+   if (measured->setsPerSecond < baseline->setsPerSecond * (1.0 - tolerances->rate) &&
+       baseline->wallMilliseconds > tolerances->slack) // a run shorter than the slack is too short to time its sets
+      return "REGRESSED (sets per second)";
+
+   return NULL;
+}
+
+/**
+ * Starts measuring the peak memory of the process again from what it uses
+ * now. This is only possible on Linux; elsewhere the peak memory is that
+ * of the whole process so far.
+ */
+void resetPeakMemory(void)
+{
+#ifdef __linux__
+   FILE *clearRefs = fopen("/proc/self/clear_refs", "w");
+   if (clearRefs != NULL)
+   {
+      fprintf(clearRefs, "5"); // resets the peak resident set size
+      fclose(clearRefs);
+   }
+#endif
+
+   return;
+}
+
+/**
+ * @return the peak resident memory of the process in kilobytes (since resetPeakMemory on Linux)
+ */
+long long getPeakMemory(void)
+{
+#ifdef _WIN32
+   PROCESS_MEMORY_COUNTERS counters;
+   if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+   {
+      return (long long)(counters.PeakWorkingSetSize / 1024);
+   }
+   return 0;
+#else
+#ifdef __linux__
+   FILE *status = fopen("/proc/self/status", "r");
+   if (status != NULL)
+   {
+      char line[256];
+      long long peakKilobytes = -1;
+      while (fgets(line, sizeof(line), status) != NULL && peakKilobytes < 0)
+      {
+         sscanf(line, "VmHWM: %lld", &peakKilobytes);
+      }
+      fclose(status);
+      if (peakKilobytes >= 0)
+      {
+         return peakKilobytes;
+      }
+   }
+#endif
+   struct rusage usage;
+   getrusage(RUSAGE_SELF, &usage);
+
+   return (long long)usage.ru_maxrss; // kilobytes on Linux
+#endif
+}
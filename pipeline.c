@@ -0,0 +1,666 @@
+/**
+ * Created 10/18/2026
+ * This file trains a network with its layers split between threads, so
+ * that each thread only ever touches the weights of its own layers and
+ * they stay in the cache of the core it runs on.
+ *
+ * The connectivity layers are split into pipelineStages groups, one per
+ * stage, in order. The training thread is the first stage and feeds the
+ * training sets in; every other stage has a thread of its own. A training
+ * set moves through the stages in a slot (a NetworkScratch of its own):
+ * forwards through each stage's layers, then, once the last stage has
+ * found its error and its output psis, backwards through them again, each
+ * stage finding the psis of its layers and adding the partial derivatives
+ * of its weights to its part of the gradients. While one set is in a later
+ * stage, the earlier stages already work on the next ones.
+ *
+ * Slots are passed between neighbouring stages through single-producer,
+ * single-consumer queues, one for each direction between each pair.
+ *
+ * Every set in a batch of pipelineBatchSize sets is run with the same
+ * weights: the batch is fed in, the pipeline drains as the batch's sets come
+ * back, and then each stage moves its own weights against the summed
+ * partial derivatives of the batch. The stages apply their changes when a
+ * flush marker reaches them, which is queued behind the batch and ahead of
+ * the next one, so no set ever sees weights that changed partway through
+ * it. With a batch size of 1, this trains the same as
+ * trainForAllTrainingSets in ./network.c up to rounding, since the partial
+ * derivatives are added up in a different order.
+ *
+ * Functions in this file:
+ *
+ * Pipeline *createPipeline(const Network *net)
+ * void freePipeline(Pipeline *pipeline)
+ * void trainPipelinedEpoch(Network *net)
+ * void *runStage(void *argument)
+ * void runStageForward(Pipeline *pipeline, PipelineStage *stage, int slot)
+ * void runStageBackward(Pipeline *pipeline, PipelineStage *stage, int slot)
+ * void applyStageGradients(Pipeline *pipeline, PipelineStage *stage)
+ * void pushItem(PipelineStage *consumer, PipelineQueue *queue, int item)
+ * int popItem(PipelineQueue *queue, int *item)
+ * int waitForItem(PipelineStage *stage, int *item)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "./headerfiles/matrixFunctions.h"  // importing matrix kernels
+#include "./headerfiles/convolution.h"      // importing the convolution layer
+#include "./headerfiles/augment.h"          // importing the augmenter
+#include "./headerfiles/networkInternals.h" // importing the network layout and functions
+#include "./headerfiles/pipeline.h"
+
+#define PIPELINE_FLUSH -1 // tells every stage to apply its gradients
+#define PIPELINE_SYNC -2  // the same, and comes back to the first stage once every stage has
+#define PIPELINE_STOP -3  // tells every stage thread to finish
+
+/**
+ * A queue of items (slots or markers) from one stage to a neighbouring one.
+ * Only the producer moves head and only the consumer moves tail.
+ */
+struct PipelineQueue
+{
+   int *items;        // capacity items, a power of two
+   unsigned int capacity;
+   atomic_uint head;  // items pushed so far
+   atomic_uint tail;  // items popped so far
+};
+
+/**
+ * One stage of the pipeline: a group of neighbouring connectivity layers.
+ */
+struct PipelineStage
+{
+   struct Pipeline *pipeline;
+   int index;
+   int firstLayer; // the connectivity layers of this stage
+   int endLayer;
+
+   PipelineQueue *fromPrevious; // slots coming forwards (NULL for the first stage)
+   PipelineQueue *fromNext;     // slots coming backwards (NULL for the last stage)
+
+   pthread_mutex_t lock;
+   pthread_cond_t arrived; // signalled when an item is pushed while the stage waits
+   int waiting;            // whether the stage is waiting for an item
+};
+
+struct Pipeline
+{
+   const Network *net; // only its weights are changed, each stage changing its own layers'
+
+   int numStages;
+   PipelineStage *stages;
+   PipelineQueue *forwardQueues;  // forwardQueues[s] goes from stage s to stage s + 1
+   PipelineQueue *backwardQueues; // backwardQueues[s] goes from stage s + 1 to stage s
+   pthread_t *threads;            // the threads of stages 1 and on
+   int numStarted;                // stage threads that were started
+
+   int numSlots;
+   NetworkScratch **slots; // the buffers of each set in the pipeline
+   int *freeSlots;         // the slots not in the pipeline (only used by the first stage)
+   int numFree;
+
+   double *gradients; // the partial derivatives of every weight summed over the batch, in the same mkj order
+   double errorSum;   // the errors of the sets run so far this epoch (only changed by the last stage)
+};
+
+// function headers ----------------------
+
+void *runStage(void *);
+void runStageForward(Pipeline *, PipelineStage *, int);
+void runStageBackward(Pipeline *, PipelineStage *, int);
+void applyStageGradients(Pipeline *, PipelineStage *);
+void pushItem(PipelineStage *, PipelineQueue *, int);
+int popItem(PipelineQueue *, int *);
+int waitForItem(PipelineStage *, int *);
+
+// functions ----------------------
+
+/**
+ * Splits a network's connectivity layers between pipelineStages stages
+ * and starts a thread for every stage after the first.
+ *
+ * @param net the network to train (its training sets must be in memory)
+ * @return the new pipeline, or NULL if it could not be created
+ */
+Pipeline *createPipeline(const Network *net)
+{
+   int numConnectivityLayers = net->numLayers - 1;
+   int numStages = net->pipelineStages < numConnectivityLayers ? net->pipelineStages : numConnectivityLayers;
+
+   if (numStages < 2)
+   {
+      printf("A pipeline needs at least two connectivity layers to split.\n");
+      return NULL;
+   }
+
+   Pipeline *pipeline = calloc(1, sizeof(Pipeline));
+   if (pipeline == NULL)
+   {
+      printf("There was an error allocating memory for the pipeline.\n");
+      return NULL;
+   }
+
+   pipeline->net = net;
+   pipeline->numStages = numStages;
+   pipeline->numSlots = 2 * numStages; // enough for every stage to have a set going each way
+   if (pipeline->numSlots > net->pipelineBatchSize)
+   {
+      pipeline->numSlots = net->pipelineBatchSize;
+   }
+
+   unsigned int capacity = 1; // every slot, plus room for the markers between batches
+   while (capacity < (unsigned int)pipeline->numSlots + 4)
+   {
+      capacity *= 2;
+   }
+
+   pipeline->stages = calloc(numStages, sizeof(PipelineStage));
+   pipeline->forwardQueues = calloc(numStages - 1, sizeof(PipelineQueue));
+   pipeline->backwardQueues = calloc(numStages - 1, sizeof(PipelineQueue));
+   pipeline->threads = calloc(numStages, sizeof(pthread_t));
+   pipeline->slots = calloc(pipeline->numSlots, sizeof(NetworkScratch *));
+   pipeline->freeSlots = malloc(pipeline->numSlots * sizeof(int));
+   pipeline->gradients = allocateAligned(net->totalWeights * sizeof(double));
+
+   if (pipeline->stages == NULL || pipeline->forwardQueues == NULL || pipeline->backwardQueues == NULL ||
+       pipeline->threads == NULL || pipeline->slots == NULL || pipeline->freeSlots == NULL || pipeline->gradients == NULL)
+   {
+      printf("There was an error allocating memory for the pipeline.\n");
+      free(pipeline->stages);
+      free(pipeline->forwardQueues);
+      free(pipeline->backwardQueues);
+      free(pipeline->threads);
+      free(pipeline->slots);
+      free(pipeline->freeSlots);
+      freeAligned(pipeline->gradients);
+      free(pipeline);
+      return NULL;
+   }
+
+   for (int s = 0; s < numStages; s++)
+   {
+      PipelineStage *stage = &pipeline->stages[s];
+      stage->pipeline = pipeline;
+      stage->index = s;
+      stage->firstLayer = numConnectivityLayers * s / numStages;
+      stage->endLayer = numConnectivityLayers * (s + 1) / numStages;
+      stage->fromPrevious = s > 0 ? &pipeline->forwardQueues[s - 1] : NULL;
+      stage->fromNext = s < numStages - 1 ? &pipeline->backwardQueues[s] : NULL;
+      pthread_mutex_init(&stage->lock, NULL);
+      pthread_cond_init(&stage->arrived, NULL);
+   }
+
+   char failed = 0;
+   for (int s = 0; s < numStages - 1; s++)
+   {
+      PipelineQueue *queues[2] = {&pipeline->forwardQueues[s], &pipeline->backwardQueues[s]};
+      for (int q = 0; q < 2; q++)
+      {
+         queues[q]->items = malloc(capacity * sizeof(int));
+         queues[q]->capacity = capacity;
+         atomic_init(&queues[q]->head, 0);
+         atomic_init(&queues[q]->tail, 0);
+         failed = failed || queues[q]->items == NULL;
+      }
+   }
+
+   for (int i = 0; !failed && i < pipeline->numSlots; i++)
+   {
+      pipeline->slots[i] = createScratch(net);
+      pipeline->freeSlots[i] = i;
+      failed = pipeline->slots[i] == NULL;
+   }
+
+   if (failed)
+   {
+      printf("There was an error allocating memory for the pipeline.\n");
+      freePipeline(pipeline);
+      return NULL;
+   }
+
+   pipeline->numFree = pipeline->numSlots;
+   memset(pipeline->gradients, 0, net->totalWeights * sizeof(double));
+
+   for (int s = 1; s < numStages; s++)
+   {
+      if (pthread_create(&pipeline->threads[s], NULL, &runStage, &pipeline->stages[s]) != 0)
+      {
+         printf("There was an error starting the threads of the pipeline.\n");
+         freePipeline(pipeline); // stopping the stages that did start
+         return NULL;
+      }
+      pipeline->numStarted++;
+   }
+
+   printf("Training with %d pipeline stages, updating the weights every %d sets\n", numStages, net->pipelineBatchSize);
+
+   return pipeline;
+}
+
+/**
+ * Stops the stage threads and frees a pipeline made by createPipeline.
+ *
+ * @param pipeline the pipeline to free (may be NULL)
+ */
+void freePipeline(Pipeline *pipeline)
+{
+   if (pipeline == NULL)
+   {
+      return;
+   }
+
+   if (pipeline->numStarted > 0)
+   {
+      pushItem(&pipeline->stages[1], &pipeline->forwardQueues[0], PIPELINE_STOP); // passed along by every stage
+      for (int s = 1; s <= pipeline->numStarted; s++)
+      {
+         pthread_join(pipeline->threads[s], NULL);
+      }
+   }
+
+   for (int s = 0; s < pipeline->numStages; s++)
+   {
+      pthread_mutex_destroy(&pipeline->stages[s].lock);
+      pthread_cond_destroy(&pipeline->stages[s].arrived);
+   }
+   for (int s = 0; s < pipeline->numStages - 1; s++)
+   {
+      free(pipeline->forwardQueues[s].items);
+      free(pipeline->backwardQueues[s].items);
+   }
+   for (int i = 0; i < pipeline->numSlots; i++)
+   {
+      if (pipeline->slots[i] != NULL)
+      {
+         freeScratch(pipeline->slots[i]);
+      }
+   }
+
+   free(pipeline->stages);
+   free(pipeline->forwardQueues);
+   free(pipeline->backwardQueues);
+   free(pipeline->threads);
+   free(pipeline->slots);
+   free(pipeline->freeSlots);
+   freeAligned(pipeline->gradients);
+   free(pipeline);
+
+   return;
+}
+
+/**
+ * Trains the network once for all training sets through its pipeline,
+ * then calculates the new error. This takes the place of
+ * trainForAllTrainingSets in ./network.c, and adapts the learning factor
+ * and rolls the weights back the same way. Augmented copies are still
+ * trained on one at a time afterwards.
+ *
+ * @param net the network to train (with a pipeline)
+ */
+void trainPipelinedEpoch(Network *net)
+{
+   Pipeline *pipeline = net->pipeline;
+   PipelineStage *first = &pipeline->stages[0];
+
+   double *oldWeights = NULL;
+   // only enable weight rollback if adaptive learning is enabled as well
+   if (net->enableWeightRollback == 'Y' && net->learningFactorScaler != 1.0)
+   {
+      oldWeights = malloc(net->totalWeights * sizeof(double));
+      if (oldWeights == NULL) // the epoch is skipped, the same as when a streamed epoch cannot start
+      {
+         printf("There was an error allocating memory for the weights to roll back to.\n");
+         return;
+      }
+      memcpy(oldWeights, net->weights, net->totalWeights * sizeof(double)); // storing old weights
+   }
+
+   pipeline->errorSum = 0.0; // every stage is idle between epochs
+
+   for (int batchStart = 0; batchStart < net->numTrainingSets; batchStart += net->pipelineBatchSize)
+   {
+      int batchEnd = batchStart + net->pipelineBatchSize;
+      if (batchEnd > net->numTrainingSets)
+      {
+         batchEnd = net->numTrainingSets;
+      }
+
+      int nextSet = batchStart;
+      int numDone = 0;
+
+      while (numDone < batchEnd - batchStart)
+      {
+         int slot;
+
+         // sets coming back are finished first, which frees their slots soonest
+         if (popItem(first->fromNext, &slot) == 0 ||
+             ((nextSet == batchEnd || pipeline->numFree == 0) && waitForItem(first, &slot) == 0))
+         {
+            runStageBackward(pipeline, first, slot);
+            pipeline->freeSlots[pipeline->numFree++] = slot;
+            numDone++;
+            continue;
+         }
+
+         // feeding the next set in
+         slot = pipeline->freeSlots[--pipeline->numFree];
+         NetworkScratch *scratch = pipeline->slots[slot];
+         scratch->expectedOutputs = net->trainingLabels + (size_t)nextSet * net->numOutputNodes;
+
+         if (net->reducedTrainingInputs != NULL)
+         {
+            scratch->inputs = net->reducedTrainingInputs + (size_t)nextSet * net->numReducedInputs;
+         }
+         else
+         {
+            scratch->inputs = prepareInputLayer(net, scratch, net->trainingInputs + (size_t)nextSet * net->inputStride);
+         }
+
+         runStageForward(pipeline, first, slot);
+         pushItem(&pipeline->stages[1], &pipeline->forwardQueues[0], slot);
+         nextSet++;
+      } // while (numDone < batchEnd - batchStart)
+
+      // the batch has drained, so every stage moves its weights (the other stages when the marker reaches them)
+      applyStageGradients(pipeline, first);
+      pushItem(&pipeline->stages[1], &pipeline->forwardQueues[0],
+               batchEnd == net->numTrainingSets ? PIPELINE_SYNC : PIPELINE_FLUSH);
+   } // for (int batchStart = 0; batchStart < numTrainingSets; batchStart += pipelineBatchSize)
+
+   int marker = 0;
+   while (net->numTrainingSets > 0 && marker != PIPELINE_SYNC) // waiting until every stage has moved its weights
+   {
+      waitForItem(first, &marker);
+   }
+
+   // augmented copies only train the network (the error stays that of the real training sets)
+   for (int i = 0; net->augmenter != NULL && i < net->numTrainingSets * net->augmentCopies; i++)
+   {
+      int t;
+      double *inputs = takeAugmentedSet(net->augmenter, &t);
+      double *expectedOutputs = net->trainingLabels + (size_t)t * net->numOutputNodes;
+
+      net->scratch->expectedOutputs = expectedOutputs;
+      runNetwork(net, net->scratch, inputs, NULL);
+      updateWeights(net, expectedOutputs);
+
+      releaseAugmentedSet(net->augmenter);
+   }
+
+   adaptLearningFactor(net, pipeline->errorSum, oldWeights);
+
+   free(oldWeights);
+
+   return;
+}
+
+/**
+ * Runs one stage after the first: takes slots coming forwards through
+ * its layers and on to the next stage, and slots coming backwards through
+ * its layers and back to the previous stage, until told to stop. The last
+ * stage turns a slot around as soon as it has found its error.
+ *
+ * @param argument the PipelineStage to run
+ * @return NULL
+ */
+void *runStage(void *argument)
+{
+   PipelineStage *stage = (PipelineStage *)argument;
+   Pipeline *pipeline = stage->pipeline;
+   char isLast = stage->index == pipeline->numStages - 1;
+   PipelineStage *previous = &pipeline->stages[stage->index - 1];
+   PipelineStage *next = isLast ? NULL : &pipeline->stages[stage->index + 1];
+   PipelineQueue *toPrevious = &pipeline->backwardQueues[stage->index - 1];
+   PipelineQueue *toNext = isLast ? NULL : &pipeline->forwardQueues[stage->index];
+
+   while (1)
+   {
+      int item;
+      int fromPrevious = waitForItem(stage, &item);
+
+      if (!fromPrevious) // a slot (or the sync marker) coming back
+      {
+         if (item >= 0)
+         {
+            runStageBackward(pipeline, stage, item);
+         }
+         pushItem(previous, toPrevious, item);
+         continue;
+      }
+
+      if (item == PIPELINE_STOP)
+      {
+         if (!isLast)
+         {
+            pushItem(next, toNext, item);
+         }
+         break;
+      }
+
+      if (item == PIPELINE_FLUSH || item == PIPELINE_SYNC)
+      {
+         applyStageGradients(pipeline, stage);
+         if (!isLast)
+         {
+            pushItem(next, toNext, item);
+         }
+         else if (item == PIPELINE_SYNC) // turned around once the last stage has moved its weights
+         {
+            pushItem(previous, toPrevious, item);
+         }
+         continue;
+      }
+
+      runStageForward(pipeline, stage, item);
+
+      if (isLast)
+      {
+         NetworkScratch *scratch = pipeline->slots[item];
+
+         finishOutputLayer(pipeline->net, scratch, NULL);
+         pipeline->errorSum += scratch->error;
+         calculateOutputPsis(pipeline->net, scratch, scratch->expectedOutputs);
+
+         runStageBackward(pipeline, stage, item);
+         pushItem(previous, toPrevious, item);
+      }
+      else
+      {
+         pushItem(next, toNext, item);
+      }
+   } // while (1)
+
+   return NULL;
+}
+
+/**
+ * Runs a slot's set forwards through a stage's layers.
+ *
+ * @param pipeline the pipeline the stage belongs to
+ * @param stage the stage
+ * @param slot the slot whose set to run
+ */
+void runStageForward(Pipeline *pipeline, PipelineStage *stage, int slot)
+{
+   for (int m = stage->firstLayer; m < stage->endLayer; m++)
+   {
+      runConnectivityLayer(pipeline->net, pipeline->slots[slot], m);
+   }
+
+   return;
+}
+
+/**
+ * Runs a slot's set backwards through a stage's layers, once the psis of
+ * the layer to the right of the stage are known: adds the partial
+ * derivatives of the stage's weights to the gradients, and finds the psis
+ * of the stage's layers for the stage before it. The first stage also
+ * carries them back to the convolution filters, if there are any. Frozen
+ * layers get no partial derivatives, and no psis are found at or before
+ * the frozen boundary (see ./freeze.c).
+ *
+ * @param pipeline the pipeline the stage belongs to
+ * @param stage the stage
+ * @param slot the slot whose set to run
+ */
+void runStageBackward(Pipeline *pipeline, PipelineStage *stage, int slot)
+{
+   const Network *net = pipeline->net;
+   NetworkScratch *scratch = pipeline->slots[slot];
+   int maxNodesInALayer = net->maxNodesInALayer;
+
+   for (int m = stage->endLayer - 1; m >= stage->firstLayer; m--) // looping backwards through connectivity layers
+   {
+      double *sourceNodes = (m == 0) ? scratch->inputs : scratch->nodes + maxNodesInALayer * m;
+
+      if (net->frozenLayers[m] != 'Y')
+      {
+         addOuterProduct(net->layerDimensions[m], net->layerDimensions[m + 1], 1.0, sourceNodes,
+                         scratch->psis + maxNodesInALayer * (m + 1), pipeline->gradients + net->maxWeightsInALayer * m,
+                         maxNodesInALayer);
+      }
+
+      if (m > net->frozenBoundary || (m == 0 && net->convFilters > 0 && net->freezeConvolution != 'Y'))
+      {
+         calculateLayerPsis(net, scratch, m);
+      }
+   }
+
+   if (stage->index == 0 && net->convFilters > 0 && net->freezeConvolution != 'Y')
+   {
+      addConvolutionGradients(net, scratch, 1.0, pipeline->gradients + net->convWeightsOffset);
+   }
+
+   return;
+}
+
+/**
+ * Moves the weights of a stage's layers against their summed partial
+ * derivatives, scaled by the learning factor, and clears the derivatives
+ * for the next batch. The first stage also moves the convolution filters.
+ *
+ * @param pipeline the pipeline the stage belongs to
+ * @param stage the stage
+ */
+void applyStageGradients(Pipeline *pipeline, PipelineStage *stage)
+{
+   const Network *net = pipeline->net;
+   double learningFactor = net->learningFactor; // only changed between epochs, while every stage is idle
+
+   for (int m = stage->firstLayer; m < stage->endLayer; m++)
+   {
+      for (int k = 0; k < net->layerDimensions[m]; k++)
+      {
+         size_t row = (size_t)m * net->maxWeightsInALayer + (size_t)k * net->maxNodesInALayer;
+         double *weights = net->weights + row;
+         double *gradients = pipeline->gradients + row;
+
+         for (int j = 0; j < net->layerDimensions[m + 1]; j++)
+         {
+            weights[j] -= learningFactor * gradients[j];
+            gradients[j] = 0.0;
+         }
+      }
+   }
+
+   if (stage->index == 0)
+   {
+      for (int i = net->convWeightsOffset; i < net->totalWeights; i++) // the convolution filters, if any
+      {
+         net->weights[i] -= learningFactor * pipeline->gradients[i];
+         pipeline->gradients[i] = 0.0;
+      }
+   }
+
+   return;
+}
+
+/**
+ * Pushes an item onto a queue and wakes the stage that takes from it if
+ * it is waiting. The queues are sized so that they never fill.
+ *
+ * @param consumer the stage that takes from the queue
+ * @param queue the queue
+ * @param item the slot or marker to push
+ */
+void pushItem(PipelineStage *consumer, PipelineQueue *queue, int item)
+{
+   unsigned int head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+   queue->items[head & (queue->capacity - 1)] = item;
+   atomic_store(&queue->head, head + 1); // publishing the item (and everything written to its slot)
+
+   pthread_mutex_lock(&consumer->lock);
+   if (consumer->waiting)
+   {
+      pthread_cond_signal(&consumer->arrived);
+   }
+   pthread_mutex_unlock(&consumer->lock);
+
+   return;
+}
+
+/**
+ * Takes the next item from a queue without waiting.
+ *
+ * @param queue the queue (may be NULL)
+ * @param item where to put the item
+ * @return 0 if an item was taken, -1 if the queue was empty
+ */
+int popItem(PipelineQueue *queue, int *item)
+{
+   if (queue == NULL)
+   {
+      return -1;
+   }
+
+   unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+   if (atomic_load(&queue->head) == tail)
+   {
+      return -1;
+   }
+
+   *item = queue->items[tail & (queue->capacity - 1)];
+   atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+
+   return 0;
+}
+
+/**
+ * Waits for the next item coming to a stage, taking items coming back
+ * before items coming forwards.
+ *
+ * @param stage the stage
+ * @param item where to put the item
+ * @return 0 if the item came back from the next stage, 1 if it came from the previous one
+ */
+int waitForItem(PipelineStage *stage, int *item)
+{
+   while (1)
+   {
+      if (popItem(stage->fromNext, item) == 0)
+      {
+         return 0;
+      }
+      if (popItem(stage->fromPrevious, item) == 0)
+      {
+         return 1;
+      }
+
+      pthread_mutex_lock(&stage->lock);
+      stage->waiting = 1;
+      // checked again while holding the lock, so a push in between is not missed
+      while ((stage->fromNext == NULL || atomic_load(&stage->fromNext->head) == atomic_load(&stage->fromNext->tail)) &&
+             (stage->fromPrevious == NULL ||
+              atomic_load(&stage->fromPrevious->head) == atomic_load(&stage->fromPrevious->tail)))
+      {
+         pthread_cond_wait(&stage->arrived, &stage->lock);
+      }
+      stage->waiting = 0;
+      pthread_mutex_unlock(&stage->lock);
+   }
+}
@@ -0,0 +1,656 @@
+/**
+ * Created 10/18/2026
+ * This file runs a network over every training set in its training sets
+ * file and keeps every set's outputs, instead of only the outputs of the
+ * last set run (see writeOutputsToFile in ./network.c).
+ *
+ * The training sets are streamed from the file in one pass (or read from
+ * memory if the network already holds them), and each set's outputs are
+ * written as soon as they are found. In binary form, the predictions file
+ * is a PredictionsHeader followed by a row of doubles per set; it is sized
+ * up front and memory-mapped, so each row is a copy into the mapping and
+ * the operating system writes it out. In CSV form, each set is a line of
+ * its outputs, written through a large buffer.
+ *
+ * When the outputs are the pels of a bitmap (as with the original bitmap
+ * the config names), a bitmap per set can be written as well. Worker
+ * threads take the outputs from a bounded queue and write the bitmaps
+ * straight from memory (see writeBitmapHelper in ./dibdump.c), while the
+ * network runs the next sets.
+ *
+ * Functions in this file:
+ *
+ * int runPrediction(void)
+ * int predictAll(Network *net)
+ * Predictions *createPredictionsFile(const Network *net, char *fileName, int numSets, int rowLength)
+ * void finishPredictionsFile(Predictions *predictions, int numSets)
+ * int openPredictionsFile(Predictions *predictions, char *fileName)
+ * void writePrediction(Predictions *predictions, int set, const double *outputs)
+ * void closePredictionsFile(Predictions *predictions, int numSets)
+ * int startBitmapWriters(Predictions *predictions)
+ * double *takeBitmapSlot(Predictions *predictions, int set)
+ * void queueBitmap(Predictions *predictions)
+ * void stopBitmapWriters(Predictions *predictions)
+ * void *runBitmapWriter(void *argument)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#include "./headerfiles/dibdump.h" // importing dibdump functions
+
+#include "./headerfiles/autoTune.h"         // importing the wall clock
+#include "./headerfiles/networkInternals.h" // importing the network layout and functions
+#include "./headerfiles/predict.h"
+
+#define PREDICTION_QUEUE_LENGTH 64   // sets' outputs that can wait for their bitmaps to be written
+#define CSV_BUFFER_SIZE (1 << 20)    // bytes buffered before a CSV predictions file is written to
+
+struct Predictions
+{
+   const Network *net; // the network being run (only read by the bitmap writers)
+   int numSets;        // training sets in the training sets file
+   int rowLength;      // values written per set (numOutputNodes, unless several networks' outputs are written)
+
+   // the predictions file
+   FILE *csvFile;  // NULL in binary form
+   char *mapping;  // the whole binary predictions file (NULL in CSV form)
+   size_t mappingSize;
+#ifdef _WIN32
+   HANDLE fileHandle;
+   HANDLE mappingHandle;
+#else
+   int fileDescriptor;
+#endif
+
+   // the bitmap writers (none if numThreads is 0)
+   BITMAPFILEHEADER bmpFileHeader; // the headers of the original bitmap
+   BITMAPINFOHEADER bmpInfoHeader;
+   double *slots;      // PREDICTION_QUEUE_LENGTH sets' outputs, numOutputNodes apart
+   int *slotSets;      // the set whose outputs are in each slot (-1 if the slot is free)
+   int numQueued;      // sets whose outputs have been put in the queue
+   int nextTaken;      // the next set for a writer to take
+   int finished;       // whether every set has been queued
+   unsigned int *pels; // a bitmap's pels for each writer, numOutputNodes apart
+   int numWriters;     // writers that have taken their pels
+   pthread_mutex_t lock;
+   pthread_cond_t changed; // signalled whenever a slot is filled or freed, or the last set is queued
+   int numThreads;
+   pthread_t *threads;
+};
+
+// function headers ----------------------
+
+int openPredictionsFile(Predictions *, char *);
+void closePredictionsFile(Predictions *, int);
+int startBitmapWriters(Predictions *);
+double *takeBitmapSlot(Predictions *, int);
+void queueBitmap(Predictions *);
+void stopBitmapWriters(Predictions *);
+void *runBitmapWriter(void *);
+
+// functions ----------------------
+
+/**
+ * Asks for a config, then predicts the outputs of every training set in
+ * its training sets file with the weights it loads (the network is not
+ * trained first).
+ *
+ * @return 0 if successful, 1 otherwise (the exit code of the process)
+ */
+int runPrediction(void)
+{
+   char configFilename[MAX_FILE_NAME_LENGTH];
+
+   printf("What config file should I use? ");
+   scanf("%s", configFilename);
+
+   Network *net = createNetwork(configFilename);
+   if (net == NULL)
+   {
+      return 1;
+   }
+
+   int result = predictAll(net);
+
+   freeNetwork(net);
+
+   return result == 0 ? 0 : 1;
+}
+
+/**
+ * Runs the network over every training set in one pass, writes every
+ * set's outputs to the predictions file (and a bitmap per set, if the
+ * config asks for them), and prints the total error and how fast the
+ * sets were run.
+ *
+ * @param net the network to run
+ * @return 0 if successful, -1 otherwise
+ */
+int predictAll(Network *net)
+{
+   Predictions predictions;
+   memset(&predictions, 0, sizeof(Predictions));
+   predictions.net = net;
+   predictions.rowLength = net->numOutputNodes;
+
+   FILE *nodesFile = NULL;
+   double *streamedInputs = NULL;
+   double *streamedLabels = NULL;
+
+   if (net->trainingInputs == NULL) // streaming the training sets
+   {
+      nodesFile = fopen(net->nodesFileInput, "r");
+      if (nodesFile == NULL)
+      {
+         printf("There was an error opening the training sets file %s.\n", net->nodesFileInput);
+         return -1;
+      }
+      fscanf(nodesFile, "%x", &predictions.numSets);
+
+      streamedInputs = allocateAligned(net->numInputNodes * sizeof(double));
+      streamedLabels = malloc(net->numOutputNodes * sizeof(double));
+      if (streamedInputs == NULL || streamedLabels == NULL)
+      {
+         printf("There was an error allocating memory for prediction.\n");
+         freeAligned(streamedInputs);
+         free(streamedLabels);
+         fclose(nodesFile);
+         return -1;
+      }
+   }
+   else
+   {
+      predictions.numSets = net->numTrainingSets;
+   }
+
+   double *outputs = malloc(net->numOutputNodes * sizeof(double));
+
+   if (outputs == NULL || openPredictionsFile(&predictions, net->predictionsFile) != 0 ||
+       (net->predictionBitmaps[0] != '\0' && startBitmapWriters(&predictions) != 0))
+   {
+      if (predictions.csvFile != NULL || predictions.mapping != NULL)
+      {
+         closePredictionsFile(&predictions, 0);
+      }
+      free(outputs);
+      if (nodesFile != NULL)
+      {
+         fclose(nodesFile);
+         freeAligned(streamedInputs);
+         free(streamedLabels);
+      }
+      return -1;
+   }
+
+   double startTime = getWallTime();
+   double errorSum = 0.0;
+   int numRun = 0;
+
+   while (numRun < predictions.numSets)
+   {
+      double *setOutputs = predictions.numThreads > 0 ? takeBitmapSlot(&predictions, numRun) : outputs;
+
+      if (nodesFile != NULL)
+      {
+         if (readTrainingSet(net, nodesFile, streamedInputs, streamedLabels) != 0)
+            break;
+         net->scratch->expectedOutputs = streamedLabels;
+         runNetwork(net, net->scratch, streamedInputs, setOutputs);
+      }
+      else
+      {
+         runTrainingSet(net, numRun);
+         memcpy(setOutputs, net->scratch->nodes + net->maxNodesInALayer * (net->numLayers - 1),
+                net->numOutputNodes * sizeof(double));
+      }
+
+      errorSum += net->scratch->error;
+      writePrediction(&predictions, numRun, setOutputs);
+
+      if (predictions.numThreads > 0)
+      {
+         queueBitmap(&predictions);
+      }
+      numRun++;
+   } // while (numRun < numSets)
+
+   double elapsed = getWallTime() - startTime;
+
+   net->scratch->expectedOutputs = NULL;
+
+   if (predictions.numThreads > 0)
+   {
+      stopBitmapWriters(&predictions); // waits for every bitmap to be written
+   }
+   closePredictionsFile(&predictions, numRun);
+
+   if (numRun < predictions.numSets)
+   {
+      printf("The training sets file %s ended after %d of its %d sets.\n", net->nodesFileInput, numRun, predictions.numSets);
+   }
+   printf("Predicted %d training sets in %.3lfms (%.0lf sets per second) with a total error of %lf\n", numRun,
+          elapsed * 1000.0, elapsed > 0.0 ? numRun / elapsed : 0.0, errorSum);
+   printf("Finished writing predictions to %s\n", net->predictionsFile);
+
+   free(outputs);
+   if (nodesFile != NULL)
+   {
+      fclose(nodesFile);
+      freeAligned(streamedInputs);
+      free(streamedLabels);
+   }
+
+   return 0;
+}
+
+/**
+ * Creates a predictions file on its own, for writing rows that are not a
+ * single network's outputs (such as every network of an ensemble's, see
+ * ./ensemble.c). Its form is the network's predictionsFormat.
+ *
+ * @param net the network whose settings to use
+ * @param fileName the path of the file
+ * @param numSets the number of rows the file will hold
+ * @param rowLength the number of values in each row
+ * @return the predictions to write with writePrediction, or NULL on failure
+ */
+Predictions *createPredictionsFile(const Network *net, char *fileName, int numSets, int rowLength)
+{
+   Predictions *predictions = malloc(sizeof(Predictions));
+   if (predictions == NULL)
+   {
+      printf("There was an error allocating memory for the predictions file.\n");
+      return NULL;
+   }
+   memset(predictions, 0, sizeof(Predictions));
+   predictions->net = net;
+   predictions->numSets = numSets;
+   predictions->rowLength = rowLength;
+
+   if (openPredictionsFile(predictions, fileName) != 0)
+   {
+      free(predictions);
+      return NULL;
+   }
+
+   return predictions;
+}
+
+/**
+ * Finishes and frees a predictions file made by createPredictionsFile.
+ *
+ * @param predictions the predictions that were written
+ * @param numSets the number of rows that were written
+ */
+void finishPredictionsFile(Predictions *predictions, int numSets)
+{
+   closePredictionsFile(predictions, numSets);
+   free(predictions);
+
+   return;
+}
+
+/**
+ * Creates the predictions file. In binary form it is sized for every set
+ * and mapped into memory, with its header filled in; in CSV form it is
+ * opened with a large buffer.
+ *
+ * @param predictions the predictions to write to the file
+ * @param fileName the path of the file
+ * @return 0 if successful, -1 otherwise
+ */
+int openPredictionsFile(Predictions *predictions, char *fileName)
+{
+   const Network *net = predictions->net;
+
+   if (net->predictionsFormat == 'c')
+   {
+      predictions->csvFile = fopen(fileName, "w");
+      if (predictions->csvFile == NULL)
+      {
+         printf("There was an error opening the predictions file %s.\n", fileName);
+         return -1;
+      }
+      setvbuf(predictions->csvFile, NULL, _IOFBF, CSV_BUFFER_SIZE);
+
+      return 0;
+   }
+
+   predictions->mappingSize = sizeof(struct PredictionsHeader) +
+                              (size_t)predictions->numSets * predictions->rowLength * sizeof(double);
+   void *mapping = NULL;
+
+#ifdef _WIN32
+   predictions->fileHandle = CreateFileA(fileName, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS,
+                                         FILE_ATTRIBUTE_NORMAL, NULL);
+   if (predictions->fileHandle == INVALID_HANDLE_VALUE)
+   {
+      printf("There was an error opening the predictions file %s.\n", fileName);
+      return -1;
+   }
+
+   predictions->mappingHandle = CreateFileMappingA(predictions->fileHandle, NULL, PAGE_READWRITE,
+                                                   (DWORD)((unsigned long long)predictions->mappingSize >> 32),
+                                                   (DWORD)(predictions->mappingSize & 0xFFFFFFFF), NULL);
+   if (predictions->mappingHandle != NULL)
+   {
+      mapping = MapViewOfFile(predictions->mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, predictions->mappingSize);
+   }
+   if (mapping == NULL)
+   {
+      printf("There was an error mapping the predictions file %s.\n", fileName);
+      if (predictions->mappingHandle != NULL)
+      {
+         CloseHandle(predictions->mappingHandle);
+      }
+      CloseHandle(predictions->fileHandle);
+      return -1;
+   }
+#else
+   predictions->fileDescriptor = open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+   if (predictions->fileDescriptor < 0)
+   {
+      printf("There was an error opening the predictions file %s.\n", fileName);
+      return -1;
+   }
+
+   if (ftruncate(predictions->fileDescriptor, predictions->mappingSize) == 0)
+   {
+      mapping = mmap(NULL, predictions->mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, predictions->fileDescriptor, 0);
+   }
+   if (mapping == NULL || mapping == MAP_FAILED)
+   {
+      printf("There was an error mapping the predictions file %s.\n", fileName);
+      close(predictions->fileDescriptor);
+      return -1;
+   }
+#endif
+
+   predictions->mapping = mapping;
+
+   struct PredictionsHeader header;
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, PREDICTIONS_MAGIC, sizeof(header.magic));
+   header.numSets = predictions->numSets;
+   header.numOutputs = predictions->rowLength;
+   memcpy(predictions->mapping, &header, sizeof(header));
+
+   return 0;
+}
+
+/**
+ * Writes one set's outputs to the predictions file.
+ *
+ * @param predictions the predictions being written
+ * @param set the index of the set
+ * @param outputs the set's outputs (rowLength of them)
+ */
+void writePrediction(Predictions *predictions, int set, const double *outputs)
+{
+   int numOutputs = predictions->rowLength;
+
+   if (predictions->csvFile != NULL)
+   {
+      for (int i = 0; i < numOutputs; i++)
+      {
+         fprintf(predictions->csvFile, i == 0 ? "%.17g" : ",%.17g", outputs[i]);
+      }
+      fputc('\n', predictions->csvFile);
+   }
+   else
+   {
+      double *row = (double *)(predictions->mapping + sizeof(struct PredictionsHeader)) + (size_t)set * numOutputs;
+      memcpy(row, outputs, numOutputs * sizeof(double));
+   }
+
+   return;
+}
+
+/**
+ * Finishes the predictions file. If the training sets file ran out early,
+ * a binary predictions file is cut down to the sets that were run.
+ *
+ * @param predictions the predictions that were written
+ * @param numSets the number of sets whose outputs were written
+ */
+void closePredictionsFile(Predictions *predictions, int numSets)
+{
+   if (predictions->csvFile != NULL)
+   {
+      fclose(predictions->csvFile);
+      predictions->csvFile = NULL;
+      return;
+   }
+
+   size_t usedSize = sizeof(struct PredictionsHeader) + (size_t)numSets * predictions->rowLength * sizeof(double);
+   ((struct PredictionsHeader *)predictions->mapping)->numSets = numSets;
+
+#ifdef _WIN32
+   UnmapViewOfFile(predictions->mapping);
+   CloseHandle(predictions->mappingHandle);
+   if (usedSize < predictions->mappingSize)
+   {
+      LARGE_INTEGER end;
+      end.QuadPart = (LONGLONG)usedSize;
+      SetFilePointerEx(predictions->fileHandle, end, NULL, FILE_BEGIN);
+      SetEndOfFile(predictions->fileHandle);
+   }
+   CloseHandle(predictions->fileHandle);
+#else
+   munmap(predictions->mapping, predictions->mappingSize);
+   if (usedSize < predictions->mappingSize)
+   {
+      ftruncate(predictions->fileDescriptor, usedSize);
+   }
+   close(predictions->fileDescriptor);
+#endif
+
+   predictions->mapping = NULL;
+
+   return;
+}
+
+/**
+ * Reads the headers of the original bitmap and starts the threads that
+ * write a bitmap per set. The outputs must be the bitmap's pels.
+ *
+ * @param predictions the predictions to write bitmaps for
+ * @return 0 if successful, -1 otherwise
+ */
+int startBitmapWriters(Predictions *predictions)
+{
+   const Network *net = predictions->net;
+
+   unsigned int *pels = loadBitmap((char *)net->bitmapFileInput, &predictions->bmpFileHeader, &predictions->bmpInfoHeader);
+   if (pels == NULL)
+   {
+      return -1;
+   }
+   free(pels); // only the headers are needed
+
+   int biHeightAbs = predictions->bmpInfoHeader.biHeight < 0 ? -predictions->bmpInfoHeader.biHeight
+                                                             : predictions->bmpInfoHeader.biHeight;
+   if (predictions->bmpInfoHeader.biWidth * biHeightAbs != net->numOutputNodes)
+   {
+      printf("The %d outputs are not the pels of the %ldx%d bitmap %s.\n", net->numOutputNodes,
+             (long)predictions->bmpInfoHeader.biWidth, biHeightAbs, net->bitmapFileInput);
+      return -1;
+   }
+
+   // the pels are written as 32-bit pels right after the headers
+   predictions->bmpInfoHeader.biBitCount = 32;
+   predictions->bmpInfoHeader.biCompression = 0;
+   predictions->bmpInfoHeader.biSizeImage = net->numOutputNodes * 4;
+   predictions->bmpInfoHeader.biClrUsed = 0;
+   predictions->bmpFileHeader.bfOffBits = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER);
+   predictions->bmpFileHeader.bfSize = predictions->bmpFileHeader.bfOffBits + predictions->bmpInfoHeader.biSizeImage;
+
+   int numThreads = net->predictionThreads > 0 ? net->predictionThreads : 1;
+   predictions->slots = malloc((size_t)PREDICTION_QUEUE_LENGTH * net->numOutputNodes * sizeof(double));
+   predictions->slotSets = malloc(PREDICTION_QUEUE_LENGTH * sizeof(int));
+   predictions->threads = malloc(numThreads * sizeof(pthread_t));
+   // allocated before any writer starts, since a writer that could not allocate its own would leave its sets unwritten
+   predictions->pels = malloc((size_t)numThreads * net->numOutputNodes * sizeof(unsigned int));
+
+   if (predictions->slots == NULL || predictions->slotSets == NULL || predictions->threads == NULL ||
+       predictions->pels == NULL)
+   {
+      printf("There was an error allocating memory for the bitmap writers.\n");
+      free(predictions->slots);
+      free(predictions->slotSets);
+      free(predictions->threads);
+      free(predictions->pels);
+      return -1;
+   }
+
+   for (int i = 0; i < PREDICTION_QUEUE_LENGTH; i++)
+   {
+      predictions->slotSets[i] = -1;
+   }
+
+   pthread_mutex_init(&predictions->lock, NULL);
+   pthread_cond_init(&predictions->changed, NULL);
+
+   while (predictions->numThreads < numThreads &&
+          pthread_create(&predictions->threads[predictions->numThreads], NULL, &runBitmapWriter, predictions) == 0)
+   {
+      predictions->numThreads++;
+   }
+
+   if (predictions->numThreads < numThreads)
+   {
+      printf("There was an error starting a bitmap writer thread.\n");
+      stopBitmapWriters(predictions);
+      return -1;
+   }
+
+   return 0;
+}
+
+/**
+ * Waits for the queue slot that a set's outputs go in to be free.
+ *
+ * @param predictions the predictions being written
+ * @param set the index of the set (one more than the last set queued)
+ * @return where to store the set's outputs
+ */
+double *takeBitmapSlot(Predictions *predictions, int set)
+{
+   int slot = set % PREDICTION_QUEUE_LENGTH;
+
+   pthread_mutex_lock(&predictions->lock);
+   while (predictions->slotSets[slot] != -1)
+   {
+      pthread_cond_wait(&predictions->changed, &predictions->lock);
+   }
+   pthread_mutex_unlock(&predictions->lock);
+
+   return predictions->slots + (size_t)slot * predictions->net->numOutputNodes;
+}
+
+/**
+ * Puts the outputs of the set taken last in the queue for its bitmap to be written.
+ *
+ * @param predictions the predictions being written
+ */
+void queueBitmap(Predictions *predictions)
+{
+   pthread_mutex_lock(&predictions->lock);
+   predictions->slotSets[predictions->numQueued % PREDICTION_QUEUE_LENGTH] = predictions->numQueued;
+   predictions->numQueued++;
+   pthread_cond_broadcast(&predictions->changed);
+   pthread_mutex_unlock(&predictions->lock);
+
+   return;
+}
+
+/**
+ * Tells the bitmap writers that every set has been queued,
+ * waits for them to write the rest, and frees the queue.
+ *
+ * @param predictions the predictions being written
+ */
+void stopBitmapWriters(Predictions *predictions)
+{
+   pthread_mutex_lock(&predictions->lock);
+   predictions->finished = 1;
+   pthread_cond_broadcast(&predictions->changed);
+   pthread_mutex_unlock(&predictions->lock);
+
+   for (int i = 0; i < predictions->numThreads; i++)
+   {
+      pthread_join(predictions->threads[i], NULL);
+   }
+   predictions->numThreads = 0;
+
+   pthread_mutex_destroy(&predictions->lock);
+   pthread_cond_destroy(&predictions->changed);
+   free(predictions->slots);
+   free(predictions->slotSets);
+   free(predictions->threads);
+   free(predictions->pels);
+
+   return;
+}
+
+/**
+ * Takes sets' outputs from the queue in order and writes each one as a
+ * bitmap named after the predictionBitmaps prefix and the set's index,
+ * until every set has been queued and written.
+ *
+ * @param argument the predictions the thread works for
+ * @return NULL
+ */
+void *runBitmapWriter(void *argument)
+{
+   Predictions *predictions = argument;
+   const Network *net = predictions->net;
+
+   char bitmapFile[MAX_FILE_NAME_LENGTH + 16];
+
+   pthread_mutex_lock(&predictions->lock);
+   unsigned int *pels = predictions->pels + (size_t)predictions->numWriters++ * net->numOutputNodes;
+
+   while (1)
+   {
+      if (predictions->nextTaken >= predictions->numQueued) // nothing to write yet
+      {
+         if (predictions->finished)
+            break;
+         pthread_cond_wait(&predictions->changed, &predictions->lock);
+         continue;
+      }
+      int set = predictions->nextTaken++;
+      pthread_mutex_unlock(&predictions->lock);
+
+      int slot = set % PREDICTION_QUEUE_LENGTH;
+      double *outputs = predictions->slots + (size_t)slot * net->numOutputNodes;
+
+      for (int i = 0; i < net->numOutputNodes; i++) // scaled the same as writeOutputsToFile
+      {
+         double value = outputs[i] < 0.0 ? 0.0 : (outputs[i] > 1.0 ? 1.0 : outputs[i]);
+         pels[i] = (unsigned int)(value * UNSIGNED_INT_SCALER);
+      }
+
+      snprintf(bitmapFile, sizeof(bitmapFile), "%s%d.bmp", net->predictionBitmaps, set);
+      writeBitmapHelper(bitmapFile, pels, net->numOutputNodes, predictions->bmpFileHeader, predictions->bmpInfoHeader);
+
+      pthread_mutex_lock(&predictions->lock);
+      predictions->slotSets[slot] = -1;
+      pthread_cond_broadcast(&predictions->changed);
+   } // while (1)
+   pthread_mutex_unlock(&predictions->lock);
+
+   return NULL;
+}
@@ -0,0 +1,433 @@
+/**
+ * Created 10/18/2026
+ * This file reduces a network's inputs to fewer values before its input
+ * layer, so that the first layer of weights (the largest one for bitmap
+ * inputs) shrinks with them.
+ *
+ * The inputs are reduced by a fixed projection: either their principal
+ * components (PCA), found from the training sets, or a cheap random
+ * projection that does not look at them at all. The projection is cached
+ * in a file along with the size and modification time of the training sets
+ * file, so it is only found again when the training sets change or the
+ * reduction settings do. The training sets a network holds are reduced
+ * once when it is created, and any other inputs are reduced on every run.
+ *
+ * The principal components are found by subspace iteration: a random set
+ * of directions is multiplied by the covariance of the inputs a few times,
+ * keeping the directions orthonormal, which turns them towards the
+ * directions with the most variance without ever forming the covariance.
+ *
+ * Functions in this file:
+ *
+ * int setUpInputReduction(Network *net)
+ * int findPrincipalComponents(Network *net)
+ * void makeRandomProjection(Network *net)
+ * void orthonormalizeColumns(double *matrix, int numRows, int numCols)
+ * void projectInputs(const Network *net, const double *inputs, double *reduced)
+ * int reduceTrainingSets(Network *net)
+ * int loadProjection(Network *net, long long datasetSize, long long datasetTime)
+ * int saveProjection(const Network *net, long long datasetSize, long long datasetTime)
+ * void freeProjection(Network *net)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/stat.h>
+
+#include "./headerfiles/matrixFunctions.h"  // importing matrix kernels
+#include "./headerfiles/networkInternals.h" // importing the network layout and functions
+#include "./headerfiles/projection.h"
+
+#define PROJECTION_MAGIC "NNPROJ01" // marks the start of a projection file (and its version)
+#define PROJECTION_MAGIC_LENGTH 8
+#define NUM_SUBSPACE_ITERATIONS 8 // times the directions are multiplied by the covariance
+#define PROJECTION_KEY 0x50524F4AULL // mixed into the generator's state for the projection's own random numbers
+
+/**
+ * Readies the network's input reduction once every setting has been read:
+ * loads the cached projection if it still matches the training sets file,
+ * finds it again (and caches it) if not, then makes the reduced inputs the
+ * input layer and reduces the training sets the network holds. Does
+ * nothing if the config has no input reduction.
+ *
+ * @param net the network to set up
+ * @return 0 if successful, -1 if the projection could not be made
+ */
+int setUpInputReduction(Network *net)
+{
+   if (net->inputReduction == 0)
+      return 0;
+
+   if (net->convFilters > 0)
+   {
+      printf("A convolution layer and input reduction cannot be used together.\n");
+      return -1;
+   }
+   if (net->numReducedInputs <= 0 || net->numReducedInputs > net->numInputNodes)
+   {
+      printf("The inputs cannot be reduced to %d values.\n", net->numReducedInputs);
+      return -1;
+   }
+
+   net->projection = malloc((size_t)net->numInputNodes * net->numReducedInputs * sizeof(double));
+   net->projectionOffsets = calloc(net->numReducedInputs, sizeof(double));
+   if (net->projection == NULL || net->projectionOffsets == NULL)
+   {
+      printf("There was an error allocating memory for the projection.\n");
+      return -1;
+   }
+
+   struct stat dataset;
+   if (stat(net->nodesFileInput, &dataset) != 0)
+   {
+      printf("There was an error opening the training sets file %s.\n", net->nodesFileInput);
+      return -1;
+   }
+
+   if (loadProjection(net, (long long)dataset.st_size, (long long)dataset.st_mtime) == 0)
+   {
+      printf("Using the projection cached in %s\n", net->projectionFile);
+   }
+   else
+   {
+      if (net->inputReduction == 'p')
+      {
+         if (net->numShards > 1) // every worker would find its own components from its own shard
+         {
+            printf("Find the principal components with a single process before training distributed.\n");
+            return -1;
+         }
+         if (net->streamTrainingSets == 'Y')
+         {
+            printf("Finding the principal components needs the training sets in memory, which is over the memory budget.\n");
+            printf("Use a random projection, a larger memory_budget, or a cached projection.\n");
+            return -1;
+         }
+         if (net->trainingInputs == NULL && takeTrainingSetsInputs(net) != 0)
+         {
+            return -1;
+         }
+         if (findPrincipalComponents(net) != 0)
+         {
+            return -1;
+         }
+      }
+      else
+      {
+         makeRandomProjection(net);
+      }
+
+      saveProjection(net, (long long)dataset.st_size, (long long)dataset.st_mtime);
+      printf("Reduced the inputs to %d values and cached the projection in %s\n", net->numReducedInputs,
+             net->projectionFile);
+   }
+
+   net->layerDimensions[0] = net->numReducedInputs;
+
+   if (net->trainingInputs != NULL)
+   {
+      return reduceTrainingSets(net);
+   }
+
+   return 0;
+}
+
+/**
+ * Finds the principal components of the training sets the network holds,
+ * as the columns of its projection, and the offsets that center them.
+ *
+ * @param net the network whose training sets to use
+ * @return 0 if successful, -1 if memory could not be allocated
+ */
+int findPrincipalComponents(Network *net)
+{
+   int numSets = net->numTrainingSets;
+   int numInputs = net->numInputNodes;
+   int numReduced = net->numReducedInputs;
+   double *directions = net->projection;
+
+   double *mean = calloc(numInputs, sizeof(double));
+   double *centered = malloc((size_t)numSets * numInputs * sizeof(double));
+   double *scores = malloc((size_t)numSets * numReduced * sizeof(double));
+   if (mean == NULL || centered == NULL || scores == NULL || numSets == 0)
+   {
+      printf("There was an error finding the principal components.\n");
+      free(mean);
+      free(centered);
+      free(scores);
+      return -1;
+   }
+
+   for (int t = 0; t < numSets; t++)
+   {
+      for (int i = 0; i < numInputs; i++)
+      {
+         mean[i] += net->trainingInputs[(size_t)t * net->inputStride + i] / numSets;
+      }
+   }
+   for (int t = 0; t < numSets; t++)
+   {
+      for (int i = 0; i < numInputs; i++)
+      {
+         centered[(size_t)t * numInputs + i] = net->trainingInputs[(size_t)t * net->inputStride + i] - mean[i];
+      }
+   }
+
+   // drawn without stepping the generator, so the weights are the same whether or not the projection was cached
+   unsigned long long key = net->randomState ^ PROJECTION_KEY;
+   for (int i = 0; i < numInputs * numReduced; i++)
+   {
+      directions[i] = randomNumberAt(key, i, -1.0, 1.0);
+   }
+   orthonormalizeColumns(directions, numInputs, numReduced);
+
+   for (int iteration = 0; iteration < NUM_SUBSPACE_ITERATIONS; iteration++)
+   {
+      // directions = centered^T * (centered * directions), one training set at a time
+      multiplyMatrices(numSets, numReduced, numInputs, centered, numInputs, directions, numReduced, scores, numReduced);
+
+      memset(directions, 0, (size_t)numInputs * numReduced * sizeof(double));
+      for (int t = 0; t < numSets; t++)
+      {
+         addOuterProduct(numInputs, numReduced, 1.0, centered + (size_t)t * numInputs, scores + (size_t)t * numReduced,
+                         directions, numReduced);
+      }
+
+      orthonormalizeColumns(directions, numInputs, numReduced);
+   }
+
+   // projecting the mean gives what to take away from every projection to center it
+   multiplyMatrices(1, numReduced, numInputs, mean, numInputs, directions, numReduced, net->projectionOffsets, numReduced);
+
+   free(mean);
+   free(centered);
+   free(scores);
+
+   return 0;
+}
+
+/**
+ * Fills the network's projection with a sparse random projection, where
+ * each value is sqrt(3 / numReducedInputs) times 1 or -1 (each a sixth of
+ * the time) or 0. Distances between inputs are roughly kept.
+ *
+ * @param net the network whose projection to fill
+ */
+void makeRandomProjection(Network *net)
+{
+   double scale = sqrt(3.0 / net->numReducedInputs);
+   unsigned long long key = net->randomState ^ PROJECTION_KEY; // the generator is not stepped (see findPrincipalComponents)
+
+   for (int i = 0; i < net->numInputNodes * net->numReducedInputs; i++)
+   {
+      double draw = randomNumberAt(key, i, 0.0, 6.0);
+      net->projection[i] = draw < 1.0 ? scale : (draw < 2.0 ? -scale : 0.0);
+   }
+   memset(net->projectionOffsets, 0, net->numReducedInputs * sizeof(double));
+
+   return;
+}
+
+/**
+ * Makes the columns of a matrix orthonormal with modified Gram-Schmidt.
+ * A column that is no longer independent of the ones before it is zeroed.
+ *
+ * @param matrix the matrix, stored row by row
+ * @param numRows the number of rows in the matrix
+ * @param numCols the number of columns in the matrix
+ */
+void orthonormalizeColumns(double *matrix, int numRows, int numCols)
+{
+   for (int j = 0; j < numCols; j++)
+   {
+      for (int p = 0; p < j; p++)
+      {
+         double dot = 0.0;
+         for (int i = 0; i < numRows; i++)
+         {
+            dot += matrix[(size_t)i * numCols + j] * matrix[(size_t)i * numCols + p];
+         }
+         for (int i = 0; i < numRows; i++)
+         {
+            matrix[(size_t)i * numCols + j] -= dot * matrix[(size_t)i * numCols + p];
+         }
+      }
+
+      double norm = 0.0;
+      for (int i = 0; i < numRows; i++)
+      {
+         norm += matrix[(size_t)i * numCols + j] * matrix[(size_t)i * numCols + j];
+      }
+      norm = sqrt(norm);
+
+      for (int i = 0; i < numRows; i++)
+      {
+         matrix[(size_t)i * numCols + j] = norm > 1e-12 ? matrix[(size_t)i * numCols + j] / norm : 0.0;
+      }
+   } // for (int j = 0; j < numCols; j++)
+
+   return;
+}
+
+/**
+ * Reduces one set of inputs with the network's projection.
+ *
+ * @param net the network whose projection to use
+ * @param inputs the inputs (numInputNodes long)
+ * @param reduced where to store the reduced inputs (numReducedInputs long)
+ */
+void projectInputs(const Network *net, const double *inputs, double *reduced)
+{
+   multiplyMatrices(1, net->numReducedInputs, net->numInputNodes, inputs, net->numInputNodes, net->projection,
+                    net->numReducedInputs, reduced, net->numReducedInputs);
+
+   for (int j = 0; j < net->numReducedInputs; j++)
+   {
+      reduced[j] -= net->projectionOffsets[j];
+   }
+
+   return;
+}
+
+/**
+ * Reduces every training set the network holds at once, so that
+ * training never has to reduce them again.
+ *
+ * @param net the network whose training sets to reduce
+ * @return 0 if successful, -1 if memory could not be allocated
+ */
+int reduceTrainingSets(Network *net)
+{
+   int numReduced = net->numReducedInputs;
+
+   net->reducedTrainingInputs = malloc(((size_t)net->numTrainingSets * numReduced + 1) * sizeof(double));
+   if (net->reducedTrainingInputs == NULL)
+   {
+      printf("There was an error allocating memory for the reduced training sets.\n");
+      return -1;
+   }
+
+   multiplyMatrices(net->numTrainingSets, numReduced, net->numInputNodes, net->trainingInputs, net->inputStride,
+                    net->projection, numReduced, net->reducedTrainingInputs, numReduced);
+
+   for (int t = 0; t < net->numTrainingSets; t++)
+   {
+      for (int j = 0; j < numReduced; j++)
+      {
+         net->reducedTrainingInputs[(size_t)t * numReduced + j] -= net->projectionOffsets[j];
+      }
+   }
+
+   return 0;
+}
+
+/**
+ * Loads the network's projection from its projection file, as long as the
+ * file was made with the same reduction settings from a training sets file
+ * of the same size and modification time.
+ *
+ * @param net the network to load the projection into
+ * @param datasetSize the size of the training sets file, in bytes
+ * @param datasetTime when the training sets file was last modified
+ * @return 0 if the projection was loaded, -1 if it has to be found again
+ */
+int loadProjection(Network *net, long long datasetSize, long long datasetTime)
+{
+   FILE *file = fopen(net->projectionFile, "rb");
+   if (file == NULL)
+      return -1;
+
+   char magic[PROJECTION_MAGIC_LENGTH];
+   char method;
+   int numInputs, numReduced;
+   long long size, time;
+
+   int valid = fread(magic, 1, PROJECTION_MAGIC_LENGTH, file) == PROJECTION_MAGIC_LENGTH &&
+               memcmp(magic, PROJECTION_MAGIC, PROJECTION_MAGIC_LENGTH) == 0;
+   valid = valid && fread(&method, sizeof(char), 1, file) == 1 && method == net->inputReduction;
+   valid = valid && fread(&numInputs, sizeof(int), 1, file) == 1 && numInputs == net->numInputNodes;
+   valid = valid && fread(&numReduced, sizeof(int), 1, file) == 1 && numReduced == net->numReducedInputs;
+   valid = valid && fread(&size, sizeof(long long), 1, file) == 1 && size == datasetSize;
+   valid = valid && fread(&time, sizeof(long long), 1, file) == 1 && time == datasetTime;
+
+   size_t numValues = (size_t)net->numInputNodes * net->numReducedInputs;
+   valid = valid && fread(net->projectionOffsets, sizeof(double), numReduced, file) == (size_t)numReduced;
+   valid = valid && fread(net->projection, sizeof(double), numValues, file) == numValues;
+
+   fclose(file);
+
+   return valid ? 0 : -1;
+}
+
+/**
+ * Saves the network's projection to its projection file, along with what
+ * it was made from. It is written to a temporary file first and then
+ * renamed, so a run that dies while saving never leaves half of one.
+ *
+ * @param net the network whose projection to save
+ * @param datasetSize the size of the training sets file, in bytes
+ * @param datasetTime when the training sets file was last modified
+ * @return 0 if the projection was saved, -1 otherwise
+ */
+int saveProjection(const Network *net, long long datasetSize, long long datasetTime)
+{
+   char tempFile[MAX_FILE_NAME_LENGTH + 8];
+   sprintf(tempFile, "%s.tmp", net->projectionFile);
+
+   FILE *file = fopen(tempFile, "wb");
+   if (file == NULL)
+   {
+      printf("There was an error opening the projection file %s.\n", tempFile);
+      return -1;
+   }
+
+   size_t numValues = (size_t)net->numInputNodes * net->numReducedInputs;
+
+   int written = fwrite(PROJECTION_MAGIC, 1, PROJECTION_MAGIC_LENGTH, file) == PROJECTION_MAGIC_LENGTH;
+   written = written && fwrite(&net->inputReduction, sizeof(char), 1, file) == 1;
+   written = written && fwrite(&net->numInputNodes, sizeof(int), 1, file) == 1;
+   written = written && fwrite(&net->numReducedInputs, sizeof(int), 1, file) == 1;
+   written = written && fwrite(&datasetSize, sizeof(long long), 1, file) == 1;
+   written = written && fwrite(&datasetTime, sizeof(long long), 1, file) == 1;
+   written = written && fwrite(net->projectionOffsets, sizeof(double), net->numReducedInputs, file) ==
+                           (size_t)net->numReducedInputs;
+   written = written && fwrite(net->projection, sizeof(double), numValues, file) == numValues;
+
+   if (fclose(file) != 0 || !written)
+   {
+      printf("There was an error writing the projection file %s.\n", tempFile);
+      remove(tempFile);
+      return -1;
+   }
+
+#ifdef _WIN32
+   remove(net->projectionFile); // rename will not replace a file on Windows
+#endif
+   if (rename(tempFile, net->projectionFile) != 0)
+   {
+      printf("There was an error replacing the projection file %s.\n", net->projectionFile);
+      return -1;
+   }
+
+   return 0;
+}
+
+/**
+ * Frees the network's projection and reduced training sets, if it has any.
+ *
+ * @param net the network whose projection to free
+ */
+void freeProjection(Network *net)
+{
+   free(net->projection);
+   free(net->projectionOffsets);
+   free(net->reducedTrainingInputs);
+
+   net->projection = NULL;
+   net->projectionOffsets = NULL;
+   net->reducedTrainingInputs = NULL;
+
+   return;
+}
@@ -0,0 +1,414 @@
+/**
+ * Created 10/18/2026
+ * This file prunes a network's weights by magnitude and keeps the pruned
+ * layers in a sparse form for runNetwork (see ./network.c).
+ *
+ * Each step of pruning zeroes the smallest weights of every layer until a
+ * fraction of the layer is gone, then fine-tunes the weights that are left
+ * with train(). The fraction grows with every step until it reaches the
+ * config's prune_fraction, so the network can recover between steps.
+ *
+ * Every pruned layer is kept in compressed sparse row form, with one row per
+ * node of the destination layer, next to a mask of the weights that were
+ * kept. runNetwork uses the sparse form of the layers that are at least
+ * sparseThreshold sparse; training keeps using the dense weights and the
+ * mask, and the sparse form is refreshed once training is done. Weights
+ * that were pruned before they were saved get their sparse form when they
+ * are loaded, so every way of running a network uses it.
+ *
+ * Functions in this file:
+ *
+ * void pruneNetwork(Network *net)
+ * void pruneWeights(Network *net, double fraction)
+ * int compareMagnitudes(const void *a, const void *b)
+ * int buildSparseLayers(Network *net)
+ * void findSparseLayers(Network *net)
+ * void refreshSparseLayers(Network *net)
+ * void applyPruningMasks(Network *net)
+ * void freeSparseLayers(Network *net)
+ * double timeInference(Network *net, char useSparseKernels)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "./headerfiles/networkInternals.h" // importing the network layout and functions
+#include "./headerfiles/autoTune.h"         // importing the wall clock
+#include "./headerfiles/pruning.h"
+
+#define MIN_TIMING_TIME 0.1 // seconds each timing of inference runs for
+
+/**
+ * Prunes the network to its prune fraction in the config's number of steps,
+ * training it for the config's number of fine-tuning cycles after each one,
+ * then reports how sparse every layer is and how much faster it runs.
+ *
+ * @param net the network to prune
+ */
+void pruneNetwork(Network *net)
+{
+   for (int step = 1; step <= net->pruneSteps; step++)
+   {
+      double fraction = net->pruneFraction * step / net->pruneSteps;
+
+      pruneWeights(net, fraction);
+      if (buildSparseLayers(net) != 0)
+      {
+         return;
+      }
+
+      runForAllTrainingSets(net);
+      printf("Pruned %.1lf%% of the weights, error: %.16lf\n", fraction * 100.0, net->error);
+
+      if (net->pruneFineTuneIterations > 0)
+      {
+         train(net, net->iteration + net->pruneFineTuneIterations, net->targetError);
+      }
+   }
+
+   for (int m = 0; m < net->numLayers - 1; m++)
+   {
+      struct SparseLayer *layer = &net->sparseLayers[m];
+      printf("layer %d: %d weights kept (%.1lf%% sparse, %s)\n", m, layer->numNonZero, layer->sparsity * 100.0,
+             layer->useSparseKernel == 'Y' ? "sparse kernel" : "dense kernel");
+   }
+
+   double denseTime = timeInference(net, 'n');
+   double sparseTime = timeInference(net, 'Y');
+   printf("Inference: %.4lfms dense, %.4lfms sparse (%.2lfx)\n", denseTime * 1000.0, sparseTime * 1000.0,
+          denseTime / sparseTime);
+
+   return;
+}
+
+/**
+ * Zeroes the smallest weights of every layer that is not frozen, by magnitude,
+ * until the given fraction of the layer's weights are zero. Weights that are
+ * already zero count towards the fraction, so each step keeps the weights
+ * pruned before.
+ *
+ * @param net the network whose weights to prune
+ * @param fraction the fraction of every layer's weights to zero, from 0 to 1
+ */
+void pruneWeights(Network *net, double fraction)
+{
+   int maxNodesInALayer = net->maxNodesInALayer;
+   double *magnitudes = malloc(net->maxWeightsInALayer * sizeof(double));
+   if (magnitudes == NULL)
+   {
+      printf("There was an error allocating memory for pruning.\n");
+      return;
+   }
+
+   for (int m = 0; m < net->numLayers - 1; m++)
+   {
+      int numSourceNodes = net->layerDimensions[m];
+      int numDestNodes = net->layerDimensions[m + 1];
+      double *weights = net->weights + m * net->maxWeightsInALayer;
+      int numWeights = numSourceNodes * numDestNodes;
+      int numToPrune = (int)(fraction * numWeights);
+
+      if (numToPrune <= 0 || net->frozenLayers[m] == 'Y') // frozen layers keep their weights (see ./freeze.c)
+         continue;
+
+      for (int k = 0; k < numSourceNodes; k++)
+      {
+         for (int j = 0; j < numDestNodes; j++)
+         {
+            magnitudes[k * numDestNodes + j] = fabs(weights[k * maxNodesInALayer + j]);
+         }
+      }
+      qsort(magnitudes, numWeights, sizeof(double), &compareMagnitudes);
+      double threshold = magnitudes[numToPrune - 1]; // the largest magnitude that is pruned
+
+      // zeroing everything below the threshold, then as many ties as are still needed
+      int numPruned = 0;
+      for (int k = 0; k < numSourceNodes; k++)
+      {
+         for (int j = 0; j < numDestNodes; j++)
+         {
+            if (fabs(weights[k * maxNodesInALayer + j]) < threshold)
+            {
+               weights[k * maxNodesInALayer + j] = 0.0;
+               numPruned++;
+            }
+         }
+      }
+      for (int k = 0; k < numSourceNodes && numPruned < numToPrune; k++)
+      {
+         for (int j = 0; j < numDestNodes && numPruned < numToPrune; j++)
+         {
+            if (fabs(weights[k * maxNodesInALayer + j]) == threshold)
+            {
+               weights[k * maxNodesInALayer + j] = 0.0;
+               numPruned++;
+            }
+         }
+      }
+   } // for (int m = 0; m < numLayers - 1; m++)
+
+   free(magnitudes);
+
+   return;
+}
+
+/**
+ * Orders two magnitudes from smallest to largest (for qsort).
+ *
+ * @param a the first magnitude
+ * @param b the second magnitude
+ * @return negative if a is smaller, positive if a is larger, and 0 if they are equal
+ */
+int compareMagnitudes(const void *a, const void *b)
+{
+   double first = *(const double *)a;
+   double second = *(const double *)b;
+
+   return (first > second) - (first < second);
+}
+
+/**
+ * Builds the sparse form and mask of every layer from the nonzero dense
+ * weights, replacing any that were built before. Layers at least
+ * sparseThreshold sparse are marked to be run with the sparse kernel.
+ *
+ * @param net the network whose layers to build
+ * @return 0 if successful, 1 if memory could not be allocated
+ */
+int buildSparseLayers(Network *net)
+{
+   int maxNodesInALayer = net->maxNodesInALayer;
+
+   freeSparseLayers(net);
+
+   net->sparseLayers = calloc(net->numLayers - 1, sizeof(struct SparseLayer));
+   if (net->sparseLayers == NULL)
+   {
+      printf("There was an error allocating memory for the sparse layers.\n");
+      return 1;
+   }
+
+   for (int m = 0; m < net->numLayers - 1; m++)
+   {
+      struct SparseLayer *layer = &net->sparseLayers[m];
+      int numSourceNodes = net->layerDimensions[m];
+      int numDestNodes = net->layerDimensions[m + 1];
+      double *weights = net->weights + m * net->maxWeightsInALayer;
+
+      layer->mask = malloc(numSourceNodes * numDestNodes * sizeof(unsigned char));
+      layer->rowStarts = malloc((numDestNodes + 1) * sizeof(int));
+      if (layer->mask == NULL || layer->rowStarts == NULL)
+      {
+         printf("There was an error allocating memory for the sparse layers.\n");
+         freeSparseLayers(net);
+         return 1;
+      }
+
+      layer->numNonZero = 0;
+      for (int k = 0; k < numSourceNodes; k++)
+      {
+         for (int j = 0; j < numDestNodes; j++)
+         {
+            layer->mask[k * numDestNodes + j] = weights[k * maxNodesInALayer + j] != 0.0;
+            layer->numNonZero += layer->mask[k * numDestNodes + j];
+         }
+      }
+
+      layer->columns = malloc((layer->numNonZero + 1) * sizeof(int)); // never empty, so NULL always means failure
+      layer->values = malloc((layer->numNonZero + 1) * sizeof(double));
+      if (layer->columns == NULL || layer->values == NULL)
+      {
+         printf("There was an error allocating memory for the sparse layers.\n");
+         freeSparseLayers(net);
+         return 1;
+      }
+
+      // one row per destination node, so every theta is a single sparse dot product
+      int p = 0;
+      for (int j = 0; j < numDestNodes; j++)
+      {
+         layer->rowStarts[j] = p;
+         for (int k = 0; k < numSourceNodes; k++)
+         {
+            if (layer->mask[k * numDestNodes + j])
+            {
+               layer->columns[p] = k;
+               layer->values[p] = weights[k * maxNodesInALayer + j];
+               p++;
+            }
+         }
+      }
+      layer->rowStarts[numDestNodes] = p;
+
+      layer->sparsity = 1.0 - (double)layer->numNonZero / (numSourceNodes * numDestNodes);
+      layer->useSparseKernel = layer->sparsity >= net->sparseThreshold ? 'Y' : 'n';
+   } // for (int m = 0; m < numLayers - 1; m++)
+
+   net->useSparseKernels = 'Y';
+
+   return 0;
+}
+
+/**
+ * Builds the sparse layers of weights that were loaded already pruned (from
+ * a weights file or a checkpoint), so that they are run with the sparse
+ * kernel too. They are only kept if at least one layer is sparseThreshold
+ * sparse, so dense weights are run and trained the same as ever. Training
+ * keeps the weights that were loaded as zero at zero, as after pruning.
+ *
+ * @param net the network whose weights were just loaded
+ */
+void findSparseLayers(Network *net)
+{
+   if (buildSparseLayers(net) != 0)
+   {
+      return;
+   }
+
+   int numSparse = 0;
+   for (int m = 0; m < net->numLayers - 1; m++)
+   {
+      numSparse += net->sparseLayers[m].useSparseKernel == 'Y';
+   }
+
+   if (numSparse == 0)
+   {
+      freeSparseLayers(net);
+      return;
+   }
+
+   printf("%d of the layers of weights are pruned past the sparse threshold and run with the sparse kernel\n", numSparse);
+
+   return;
+}
+
+/**
+ * Copies the dense weights that were kept into the sparse layers,
+ * after training has changed them.
+ *
+ * @param net the network whose sparse layers to refresh
+ */
+void refreshSparseLayers(Network *net)
+{
+   for (int m = 0; m < net->numLayers - 1; m++)
+   {
+      struct SparseLayer *layer = &net->sparseLayers[m];
+      double *weights = net->weights + m * net->maxWeightsInALayer;
+
+      for (int j = 0; j < net->layerDimensions[m + 1]; j++)
+      {
+         for (int p = layer->rowStarts[j]; p < layer->rowStarts[j + 1]; p++)
+         {
+            layer->values[p] = weights[layer->columns[p] * net->maxNodesInALayer + j];
+         }
+      }
+   }
+
+   return;
+}
+
+/**
+ * Zeroes every dense weight that was pruned, so that training
+ * cannot bring it back.
+ *
+ * @param net the network whose masks to apply
+ */
+void applyPruningMasks(Network *net)
+{
+   for (int m = 0; m < net->numLayers - 1; m++)
+   {
+      struct SparseLayer *layer = &net->sparseLayers[m];
+      int numDestNodes = net->layerDimensions[m + 1];
+      double *weights = net->weights + m * net->maxWeightsInALayer;
+
+      for (int k = 0; k < net->layerDimensions[m]; k++)
+      {
+         for (int j = 0; j < numDestNodes; j++)
+         {
+            if (!layer->mask[k * numDestNodes + j])
+            {
+               weights[k * net->maxNodesInALayer + j] = 0.0;
+            }
+         }
+      }
+   }
+
+   return;
+}
+
+/**
+ * Frees the sparse layers of a network, if it has any.
+ *
+ * @param net the network whose sparse layers to free
+ */
+void freeSparseLayers(Network *net)
+{
+   if (net->sparseLayers == NULL)
+      return;
+
+   for (int m = 0; m < net->numLayers - 1; m++)
+   {
+      free(net->sparseLayers[m].rowStarts);
+      free(net->sparseLayers[m].columns);
+      free(net->sparseLayers[m].values);
+      free(net->sparseLayers[m].mask);
+   }
+   free(net->sparseLayers);
+
+   net->sparseLayers = NULL;
+   net->useSparseKernels = 'n';
+
+   return;
+}
+
+/**
+ * Times a single forward pass through the network on its first training
+ * set (or on inputs of 0.5 if the training sets are streamed).
+ *
+ * @param net the network to time
+ * @param useSparseKernels whether runNetwork may use the sparse layers (Y for yes)
+ * @return the average time of a forward pass, in seconds
+ */
+double timeInference(Network *net, char useSparseKernels)
+{
+   NetworkScratch *scratch = net->scratch;
+   double *inputs = net->trainingInputs;
+   double *streamedInputs = NULL;
+   char previous = net->useSparseKernels;
+
+   if (inputs == NULL)
+   {
+      streamedInputs = allocateAligned(net->numInputNodes * sizeof(double));
+      if (streamedInputs == NULL)
+      {
+         printf("There was an error allocating memory for timing.\n");
+         return 0.0;
+      }
+      for (int i = 0; i < net->numInputNodes; i++)
+      {
+         streamedInputs[i] = 0.5;
+      }
+      inputs = streamedInputs;
+   }
+
+   net->useSparseKernels = useSparseKernels;
+   scratch->expectedOutputs = NULL;
+
+   runNetwork(net, scratch, inputs, NULL); // warming the caches
+   double startTime = getWallTime();
+   double elapsed = 0.0;
+   int runs = 0;
+
+   while (elapsed < MIN_TIMING_TIME)
+   {
+      runNetwork(net, scratch, inputs, NULL);
+      runs++;
+      elapsed = getWallTime() - startTime;
+   }
+
+   net->useSparseKernels = previous;
+   freeAligned(streamedInputs);
+
+   return elapsed / runs;
+}
@@ -0,0 +1,443 @@
+/**
+ * Created 10/18/2026
+ * This file runs a network over every window of a bitmap that is larger
+ * than the network's inputs, so that what the network recognizes can be
+ * found anywhere in a full-size bitmap instead of only in a cropped one.
+ *
+ * A window the size of the inputs (inputWidth by inputHeight pels) moves
+ * over the bitmap scanStride pels at a time. Worker threads take the
+ * windows a batch at a time, copy each window's pels into a row of a
+ * matrix (scaled the same as the training sets, see readTrainingSet in
+ * ./network.c), and run the whole batch through each layer of weights with
+ * one call to multiplyMatrices (see ./matrixFunctions.c), so every weight
+ * is read once per batch instead of once per window.
+ *
+ * The value of the network's scanOutput node for every window is its
+ * score. The scores are written as a grey bitmap with a pel per window
+ * (see writeBitmapHelper in ./dibdump.c), brighter where the score is higher.
+ *
+ * Functions in this file:
+ *
+ * int runScan(void)
+ * int scanBitmap(Network *net, char *bitmapFile, char *scoreMapFile)
+ * void *runScanWorker(void *argument)
+ * void runWindowBatch(Scan *scan, ScanBuffers *buffers, int firstWindow, int numWindows)
+ * int writeScoreMap(Scan *scan, char *scoreMapFile)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "./headerfiles/dibdump.h" // importing dibdump functions
+
+#include "./headerfiles/outputFunctions.h"  // importing softmax
+#include "./headerfiles/matrixFunctions.h"  // importing matrix kernels
+#include "./headerfiles/autoTune.h"         // importing the wall clock
+#include "./headerfiles/convolution.h"      // importing the convolution layer
+#include "./headerfiles/projection.h"       // and the input reduction
+#include "./headerfiles/networkInternals.h" // importing the network layout and functions
+#include "./headerfiles/slidingWindow.h"
+
+/**
+ * A bitmap being scanned, shared by every worker thread.
+ */
+struct Scan
+{
+   const Network *net; // the network to run (only read)
+
+   unsigned int *pels; // the bitmap's pels, as loaded by loadBitmap
+   int bitmapWidth;
+   int bitmapHeight;
+   BITMAPFILEHEADER bmpFileHeader;
+   BITMAPINFOHEADER bmpInfoHeader;
+
+   int numColumns; // windows across and down the bitmap
+   int numRows;
+   double *scores; // the score of every window, row by row
+
+   int nextWindow; // the first window of the next batch for a worker to take
+   pthread_mutex_t lock;
+};
+
+/**
+ * The buffers a single worker thread runs its batches in.
+ */
+struct ScanBuffers
+{
+   double *windows;          // the inputs of every window in the batch, numInputNodes apart
+   double *layers[2];        // the nodes of every window in the batch, maxNodesInALayer apart,
+                             // one layer in each buffer in turn
+   NetworkScratch *scratch;  // for the convolution layer (NULL without one)
+};
+
+// function headers ----------------------
+
+void *runScanWorker(void *);
+void runWindowBatch(Scan *, ScanBuffers *, int, int);
+int writeScoreMap(Scan *, char *);
+
+// functions ----------------------
+
+/**
+ * Asks for a config, a bitmap to scan, and where to write the score map,
+ * then scans the bitmap with the network the config describes (with the
+ * weights it loads, since the network is not trained first).
+ *
+ * @return 0 if successful, 1 otherwise (the exit code of the process)
+ */
+int runScan(void)
+{
+   char configFilename[MAX_FILE_NAME_LENGTH];
+   char bitmapFile[MAX_FILE_NAME_LENGTH];
+   char scoreMapFile[MAX_FILE_NAME_LENGTH];
+
+   printf("What config file should I use? ");
+   scanf("%s", configFilename);
+   printf("What bitmap should I scan? ");
+   scanf("%s", bitmapFile);
+   printf("Where should I write the score map? ");
+   scanf("%s", scoreMapFile);
+
+   Network *net = createNetwork(configFilename);
+   if (net == NULL)
+   {
+      return 1;
+   }
+
+   int result = scanBitmap(net, bitmapFile, scoreMapFile);
+
+   freeNetwork(net);
+
+   return result == 0 ? 0 : 1;
+}
+
+/**
+ * Runs a network over every window of a bitmap on scanThreads threads,
+ * prints where the best-scoring window is and how fast the windows were
+ * run, and writes the score map.
+ *
+ * @param net the network to run (its inputs must be a single channel of pels)
+ * @param bitmapFile the 24-bit or 32-bit bitmap to scan
+ * @param scoreMapFile where to write the score map
+ * @return 0 if successful, -1 otherwise
+ */
+int scanBitmap(Network *net, char *bitmapFile, char *scoreMapFile)
+{
+   if (findInputShape(net) != 0)
+   {
+      return -1;
+   }
+   if (net->inputChannels != 1)
+   {
+      printf("Only networks whose inputs are a single channel of pels can scan a bitmap.\n");
+      return -1;
+   }
+   if (net->scanStride <= 0 || net->scanBatchSize <= 0 || net->scanOutput < 0 || net->scanOutput >= net->numOutputNodes)
+   {
+      printf("The scan stride and batch size must be positive, and the scan output must be an output node.\n");
+      return -1;
+   }
+
+   Scan scan;
+   memset(&scan, 0, sizeof(Scan));
+   scan.net = net;
+
+   scan.pels = loadBitmap(bitmapFile, &scan.bmpFileHeader, &scan.bmpInfoHeader);
+   if (scan.pels == NULL)
+   {
+      return -1;
+   }
+   scan.bitmapWidth = scan.bmpInfoHeader.biWidth;
+   scan.bitmapHeight = scan.bmpInfoHeader.biHeight < 0 ? -scan.bmpInfoHeader.biHeight : scan.bmpInfoHeader.biHeight;
+
+   if (scan.bitmapWidth < net->inputWidth || scan.bitmapHeight < net->inputHeight)
+   {
+      printf("The %dx%d bitmap is smaller than the %dx%d window.\n", scan.bitmapWidth, scan.bitmapHeight,
+             net->inputWidth, net->inputHeight);
+      free(scan.pels);
+      return -1;
+   }
+
+   scan.numColumns = (scan.bitmapWidth - net->inputWidth) / net->scanStride + 1;
+   scan.numRows = (scan.bitmapHeight - net->inputHeight) / net->scanStride + 1;
+   scan.scores = malloc((size_t)scan.numColumns * scan.numRows * sizeof(double));
+   if (scan.scores == NULL)
+   {
+      printf("There was an error allocating memory for the scores.\n");
+      free(scan.pels);
+      return -1;
+   }
+
+   int numThreads = net->scanThreads > 0 ? net->scanThreads : 1;
+   pthread_t *threads = malloc(numThreads * sizeof(pthread_t));
+   if (threads == NULL)
+   {
+      printf("There was an error allocating memory for the scan threads.\n");
+      free(scan.scores);
+      free(scan.pels);
+      return -1;
+   }
+
+   pthread_mutex_init(&scan.lock, NULL);
+
+   printf("Scanning %d %dx%d windows of the %dx%d bitmap %s (stride %d) on %d threads...\n",
+          scan.numColumns * scan.numRows, net->inputWidth, net->inputHeight, scan.bitmapWidth, scan.bitmapHeight,
+          bitmapFile, net->scanStride, numThreads);
+
+   double startTime = getWallTime();
+
+   int numStarted = 0;
+   while (numStarted < numThreads && pthread_create(&threads[numStarted], NULL, &runScanWorker, &scan) == 0)
+   {
+      numStarted++;
+   }
+   if (numStarted < numThreads)
+   {
+      printf("Could only start %d scan threads.\n", numStarted);
+   }
+   if (numStarted == 0) // running every window on this thread instead
+   {
+      runScanWorker(&scan);
+   }
+
+   for (int i = 0; i < numStarted; i++)
+   {
+      pthread_join(threads[i], NULL);
+   }
+
+   double elapsed = getWallTime() - startTime;
+
+   pthread_mutex_destroy(&scan.lock);
+   free(threads);
+
+   int best = 0;
+   for (int w = 1; w < scan.numColumns * scan.numRows; w++)
+   {
+      if (scan.scores[w] > scan.scores[best])
+      {
+         best = w;
+      }
+   }
+
+   printf("Best window: (%d, %d) with score %lf\n", best % scan.numColumns * net->scanStride,
+          best / scan.numColumns * net->scanStride, scan.scores[best]);
+   printf("Scanned %d windows in %.3lfms (%.0lf windows per second)\n", scan.numColumns * scan.numRows,
+          elapsed * 1000.0, scan.numColumns * scan.numRows / elapsed);
+
+   int result = writeScoreMap(&scan, scoreMapFile);
+
+   free(scan.scores);
+   free(scan.pels);
+
+   return result;
+}
+
+/**
+ * Takes batches of windows and runs them until every window has been run.
+ *
+ * @param argument the scan the thread works for
+ * @return NULL
+ */
+void *runScanWorker(void *argument)
+{
+   Scan *scan = argument;
+   const Network *net = scan->net;
+   int batchSize = net->scanBatchSize;
+   int numWindows = scan->numColumns * scan->numRows;
+
+   ScanBuffers buffers;
+   buffers.windows = allocateAligned((size_t)batchSize * net->numInputNodes * sizeof(double));
+   buffers.layers[0] = allocateAligned((size_t)batchSize * net->maxNodesInALayer * sizeof(double));
+   buffers.layers[1] = allocateAligned((size_t)batchSize * net->maxNodesInALayer * sizeof(double));
+   buffers.scratch = net->convFilters > 0 ? createScratch(net) : NULL;
+
+   if (buffers.windows == NULL || buffers.layers[0] == NULL || buffers.layers[1] == NULL ||
+       (net->convFilters > 0 && buffers.scratch == NULL))
+   {
+      printf("There was an error allocating memory for a scan thread.\n");
+   }
+   else
+   {
+      while (1)
+      {
+         pthread_mutex_lock(&scan->lock);
+         int firstWindow = scan->nextWindow;
+         scan->nextWindow += batchSize;
+         pthread_mutex_unlock(&scan->lock);
+
+         if (firstWindow >= numWindows)
+            break;
+
+         runWindowBatch(scan, &buffers, firstWindow, firstWindow + batchSize > numWindows ? numWindows - firstWindow : batchSize);
+      }
+   }
+
+   freeAligned(buffers.windows);
+   freeAligned(buffers.layers[0]);
+   freeAligned(buffers.layers[1]);
+   if (buffers.scratch != NULL)
+   {
+      freeScratch(buffers.scratch);
+   }
+
+   return NULL;
+}
+
+/**
+ * Runs a batch of windows through the network and stores their scores.
+ * This is the same as runNetwork for each window, except that every
+ * layer of weights is applied to the whole batch at once.
+ *
+ * @param scan the scan the windows belong to
+ * @param buffers the buffers of the thread running them
+ * @param firstWindow the number of the first window in the batch
+ * @param numWindows the number of windows in the batch
+ */
+void runWindowBatch(Scan *scan, ScanBuffers *buffers, int firstWindow, int numWindows)
+{
+   const Network *net = scan->net;
+   int maxNodesInALayer = net->maxNodesInALayer;
+
+   // copying every window's pels into its own row
+   for (int b = 0; b < numWindows; b++)
+   {
+      int window = firstWindow + b;
+      int left = window % scan->numColumns * net->scanStride;
+      int top = window / scan->numColumns * net->scanStride;
+      double *inputs = buffers->windows + (size_t)b * net->numInputNodes;
+
+      for (int y = 0; y < net->inputHeight; y++)
+      {
+         const unsigned int *pels = scan->pels + (size_t)(top + y) * scan->bitmapWidth + left;
+
+         for (int x = 0; x < net->inputWidth; x++)
+         {
+            inputs[y * net->inputWidth + x] = ((double)pels[x]) / UNSIGNED_INT_SCALER;
+         }
+      }
+   }
+
+   double *sourceNodes = buffers->windows; // the input layer is the windows themselves,
+   int sourceStride = net->numInputNodes;    // unless the inputs go through a convolution layer or a projection first
+
+   if (net->convFilters > 0 || net->projection != NULL)
+   {
+      for (int b = 0; b < numWindows; b++)
+      {
+         double *inputs = buffers->windows + (size_t)b * net->numInputNodes;
+         double *inputLayer = buffers->layers[0] + (size_t)b * maxNodesInALayer;
+
+         if (net->convFilters > 0)
+         {
+            runConvolution(net, buffers->scratch, inputs, inputLayer);
+         }
+         else
+         {
+            projectInputs(net, inputs, inputLayer);
+         }
+      }
+
+      sourceNodes = buffers->layers[0];
+      sourceStride = maxNodesInALayer;
+   }
+
+   for (int m = 0; m < net->numLayers - 1; m++) // looping through connectivity layers
+   {
+      int numSourceNodes = net->layerDimensions[m];
+      int numDestNodes = net->layerDimensions[m + 1];
+      double *destNodes = buffers->layers[(m + 1) % 2];
+      char isOutputLayer = m == net->numLayers - 2;
+
+      // every theta of every window in the right layer at once
+      if (net->useSparseKernels == 'Y' && net->sparseLayers[m].useSparseKernel == 'Y')
+      {
+         struct SparseLayer *layer = &net->sparseLayers[m];
+         for (int b = 0; b < numWindows; b++)
+         {
+            multiplySparseMatrixVector(numDestNodes, layer->rowStarts, layer->columns, layer->values,
+                                       sourceNodes + (size_t)b * sourceStride, destNodes + (size_t)b * maxNodesInALayer);
+         }
+      }
+      else
+      {
+         multiplyMatrices(numWindows, numDestNodes, numSourceNodes, sourceNodes, sourceStride,
+                          net->weights + m * net->maxWeightsInALayer, maxNodesInALayer, destNodes, maxNodesInALayer);
+      }
+
+      for (int b = 0; b < numWindows; b++)
+      {
+         double *windowNodes = destNodes + (size_t)b * maxNodesInALayer;
+
+         for (int j = 0; j < numDestNodes; j++) // looping through right layer
+         {
+            double theta = activationFunction(windowNodes[j]);
+            windowNodes[j] = (isOutputLayer && net->useSoftmax == 'Y') ? theta : outputFunction(theta);
+         }
+
+         if (isOutputLayer && net->useSoftmax == 'Y') // the output layer is normalized as a whole
+         {
+            softmax(windowNodes, numDestNodes);
+         }
+      }
+
+      sourceNodes = destNodes;
+      sourceStride = maxNodesInALayer;
+   } // for (int m = 0; m < numLayers - 1; m++)
+
+   for (int b = 0; b < numWindows; b++)
+   {
+      scan->scores[firstWindow + b] = sourceNodes[(size_t)b * maxNodesInALayer + net->scanOutput];
+   }
+
+   return;
+}
+
+/**
+ * Writes the scores of every window as a 32-bit grey bitmap with a pel per
+ * window, laid out the same way up as the scanned bitmap. Scores are
+ * clamped to [0,1], which is black to white.
+ *
+ * @param scan the scan whose scores to write
+ * @param scoreMapFile where to write the bitmap
+ * @return 0 if successful, -1 otherwise
+ */
+int writeScoreMap(Scan *scan, char *scoreMapFile)
+{
+   int numPels = scan->numColumns * scan->numRows;
+   unsigned int *pels = malloc(numPels * sizeof(int));
+   if (pels == NULL)
+   {
+      printf("There was an error allocating memory for the score map.\n");
+      return -1;
+   }
+
+   for (int i = 0; i < numPels; i++)
+   {
+      double score = scan->scores[i] < 0.0 ? 0.0 : (scan->scores[i] > 1.0 ? 1.0 : scan->scores[i]);
+      unsigned int grey = (unsigned int)(score * 255.0 + 0.5);
+
+      pels[i] = grey << 24 | grey << 16 | grey << 8; // in blue|green|red|reserved form
+   }
+
+   BITMAPFILEHEADER bmpFileHeader = scan->bmpFileHeader;
+   BITMAPINFOHEADER bmpInfoHeader = scan->bmpInfoHeader;
+
+   bmpInfoHeader.biSize = sizeof(BITMAPINFOHEADER);
+   bmpInfoHeader.biWidth = scan->numColumns;
+   bmpInfoHeader.biHeight = scan->bmpInfoHeader.biHeight < 0 ? -scan->numRows : scan->numRows;
+   bmpInfoHeader.biBitCount = 32;
+   bmpInfoHeader.biCompression = 0;
+   bmpInfoHeader.biSizeImage = numPels * 4;
+   bmpInfoHeader.biClrUsed = 0;
+   bmpInfoHeader.biClrImportant = 0;
+   bmpFileHeader.bfOffBits = sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER);
+   bmpFileHeader.bfSize = bmpFileHeader.bfOffBits + bmpInfoHeader.biSizeImage;
+
+   writeBitmapHelper(scoreMapFile, pels, numPels, bmpFileHeader, bmpInfoHeader);
+
+   free(pels);
+
+   return 0;
+}
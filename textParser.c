@@ -0,0 +1,636 @@
+/**
+ * Created 10/18/2026
+ * This file reads the text files that hold training sets and weights
+ * (whitespace-separated hex or decimal values, as read by fscanf with %x
+ * and %lf) much faster than reading them one value at a time.
+ *
+ * The whole file is memory-mapped and split into chunks that each end at
+ * whitespace, so no value is split between two chunks. A thread per chunk
+ * first counts the values in its chunk, so that every chunk knows the index
+ * of its first value, and then parses its values straight into where they
+ * belong (see TextLayout in ./headerfiles/textParser.h), without scanf and
+ * without allocating anything per value.
+ *
+ * Values parse to exactly what fscanf gives. Hex values are read into an
+ * unsigned int as %x does. Decimals with at most 19 significant digits,
+ * a mantissa of at most 2^53, and a power of ten of at most 22 either way
+ * (which covers everything written with %lf) are found with one exact
+ * multiplication or division, which rounds the same as strtod; anything
+ * else (more digits, inf, nan, and so on) is handed to strtod itself.
+ *
+ * Functions in this file:
+ *
+ * TextFile *openTextFile(char *fileName)
+ * void closeTextFile(TextFile *file)
+ * int readFirstHexValue(const TextFile *file, unsigned int *value)
+ * long long parseTextValues(const TextFile *file, long long firstValue, long long numValues, const TextLayout *layout)
+ * void *countChunkValues(void *argument)
+ * void *parseChunkValues(void *argument)
+ * void runOnChunks(TextChunk *chunks, int numChunks, void *(*function)(void *))
+ * const char *parseHexValue(const char *cursor, const char *end, double scaler, double *value)
+ * const char *parseDecimalValue(const char *cursor, const char *end, double *value)
+ * const char *parseWithLibrary(const char *cursor, const char *end, char hex, double scaler, double *value)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "./headerfiles/autoTune.h" // importing getNumProcessors
+#include "./headerfiles/textParser.h"
+
+#define MAX_PARSE_THREADS 64        // most threads a file is split between
+#define MIN_CHUNK_SIZE (1 << 20)    // fewest bytes worth giving a thread of its own
+#define MAX_TOKEN_LENGTH 512        // longest value handed to strtod or strtoul
+#define MAX_EXACT_MANTISSA (1ULL << 53)
+
+#define IS_SPACE(c) (spaceTable[(unsigned char)(c)]) // the characters isspace is true for in the C locale
+
+struct TextFile
+{
+   const char *text; // the whole file (NULL if it is empty)
+   size_t size;
+#ifdef _WIN32
+   HANDLE fileHandle;
+   HANDLE mappingHandle;
+#endif
+};
+
+/**
+ * The part of a file that one thread counts and parses.
+ */
+struct TextChunk
+{
+   const char *start;
+   const char *end;        // the chunk ends at whitespace (or the end of the file)
+   long long firstIndex;   // the index in the file of the chunk's first value
+   long long numValues;    // values in the chunk
+
+   long long firstValue;   // the values of the file to store, as passed to parseTextValues
+   long long endValue;
+   const TextLayout *layout;
+   long long firstBadValue; // the first value (counted from firstValue) that did not parse (-1 for none)
+};
+
+static const unsigned char spaceTable[256] = {[' '] = 1, ['\n'] = 1, ['\r'] = 1, ['\t'] = 1, ['\v'] = 1, ['\f'] = 1};
+
+static const double powersOfTen[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// function headers ----------------------
+
+void *countChunkValues(void *);
+void *parseChunkValues(void *);
+void runOnChunks(TextChunk *, int, void *(*)(void *));
+const char *parseHexValue(const char *, const char *, double, double *);
+const char *parseDecimalValue(const char *, const char *, double *);
+const char *parseWithLibrary(const char *, const char *, char, double, double *);
+
+// functions ----------------------
+
+/**
+ * Opens a text file and maps all of it into memory.
+ *
+ * @param fileName the path of the file
+ * @return the mapped file (freed with closeTextFile), or NULL if it could not be opened
+ */
+TextFile *openTextFile(char *fileName)
+{
+   TextFile *file = calloc(1, sizeof(TextFile));
+   if (file == NULL)
+   {
+      return NULL;
+   }
+
+#ifdef _WIN32
+   file->fileHandle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+   LARGE_INTEGER size;
+   if (file->fileHandle == INVALID_HANDLE_VALUE || !GetFileSizeEx(file->fileHandle, &size))
+   {
+      if (file->fileHandle != INVALID_HANDLE_VALUE)
+      {
+         CloseHandle(file->fileHandle);
+      }
+      free(file);
+      return NULL;
+   }
+   file->size = (size_t)size.QuadPart;
+
+   if (file->size > 0)
+   {
+      file->mappingHandle = CreateFileMappingA(file->fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+      if (file->mappingHandle != NULL)
+      {
+         file->text = MapViewOfFile(file->mappingHandle, FILE_MAP_READ, 0, 0, 0);
+      }
+      if (file->text == NULL)
+      {
+         if (file->mappingHandle != NULL)
+         {
+            CloseHandle(file->mappingHandle);
+         }
+         CloseHandle(file->fileHandle);
+         free(file);
+         return NULL;
+      }
+   }
+#else
+   int fileDescriptor = open(fileName, O_RDONLY);
+   struct stat info;
+   if (fileDescriptor < 0 || fstat(fileDescriptor, &info) != 0)
+   {
+      if (fileDescriptor >= 0)
+      {
+         close(fileDescriptor);
+      }
+      free(file);
+      return NULL;
+   }
+   file->size = (size_t)info.st_size;
+
+   if (file->size > 0)
+   {
+      void *text = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+      if (text == MAP_FAILED)
+      {
+         close(fileDescriptor);
+         free(file);
+         return NULL;
+      }
+      file->text = text;
+   }
+   close(fileDescriptor); // the mapping stays valid without it
+#endif
+
+   return file;
+}
+
+/**
+ * Unmaps a text file and frees it.
+ *
+ * @param file the file to close (NULL does nothing)
+ */
+void closeTextFile(TextFile *file)
+{
+   if (file == NULL)
+   {
+      return;
+   }
+
+#ifdef _WIN32
+   if (file->text != NULL)
+   {
+      UnmapViewOfFile(file->text);
+      CloseHandle(file->mappingHandle);
+   }
+   CloseHandle(file->fileHandle);
+#else
+   if (file->text != NULL)
+   {
+      munmap((void *)file->text, file->size);
+   }
+#endif
+
+   free(file);
+
+   return;
+}
+
+/**
+ * Reads the first value of a file as hex, such as the number of training
+ * sets at the start of a training sets file.
+ *
+ * @param file the file to read
+ * @param value where to store the value
+ * @return 0 if successful, -1 if the file does not start with a hex value
+ */
+int readFirstHexValue(const TextFile *file, unsigned int *value)
+{
+   const char *cursor = file->text;
+   const char *end = file->text + file->size;
+
+   while (cursor < end && IS_SPACE(*cursor))
+   {
+      cursor++;
+   }
+
+   double parsed;
+   if (cursor == end || parseHexValue(cursor, end, 1.0, &parsed) == NULL)
+   {
+      return -1;
+   }
+
+   *value = (unsigned int)parsed;
+
+   return 0;
+}
+
+/**
+ * Parses some of the values of a file on as many threads as are worth it,
+ * storing each one where the layout says.
+ *
+ * @param file the file to parse
+ * @param firstValue the index in the file of the first value to store (the values before it are skipped)
+ * @param numValues the number of values to store
+ * @param layout where the values go, and whether they are hex
+ * @return the number of values stored (fewer than numValues if the file
+ *         ran out or a value did not parse, in which case the values
+ *         after it may have been stored too)
+ */
+long long parseTextValues(const TextFile *file, long long firstValue, long long numValues, const TextLayout *layout)
+{
+   if (file->text == NULL || numValues <= 0)
+   {
+      return 0;
+   }
+
+   int numChunks = getNumProcessors();
+   if (numChunks > MAX_PARSE_THREADS)
+   {
+      numChunks = MAX_PARSE_THREADS;
+   }
+   if ((size_t)numChunks > file->size / MIN_CHUNK_SIZE + 1)
+   {
+      numChunks = (int)(file->size / MIN_CHUNK_SIZE + 1);
+   }
+
+   TextChunk chunks[MAX_PARSE_THREADS];
+   const char *end = file->text + file->size;
+   const char *start = file->text;
+
+   // splitting the file into chunks that end at whitespace
+   for (int c = 0; c < numChunks; c++)
+   {
+      const char *chunkEnd = (c == numChunks - 1) ? end : file->text + file->size / numChunks * (c + 1);
+      if (chunkEnd < start)
+      {
+         chunkEnd = start;
+      }
+      while (chunkEnd < end && !IS_SPACE(*chunkEnd))
+      {
+         chunkEnd++;
+      }
+
+      chunks[c].start = start;
+      chunks[c].end = chunkEnd;
+      chunks[c].firstValue = firstValue;
+      chunks[c].endValue = firstValue + numValues;
+      chunks[c].layout = layout;
+      chunks[c].firstBadValue = -1;
+      start = chunkEnd;
+   }
+
+   runOnChunks(chunks, numChunks, &countChunkValues);
+
+   long long numValuesInFile = 0;
+   for (int c = 0; c < numChunks; c++)
+   {
+      chunks[c].firstIndex = numValuesInFile;
+      numValuesInFile += chunks[c].numValues;
+   }
+
+   runOnChunks(chunks, numChunks, &parseChunkValues);
+
+   long long numStored = numValuesInFile - firstValue;
+   numStored = numStored < 0 ? 0 : (numStored > numValues ? numValues : numStored);
+
+   for (int c = 0; c < numChunks; c++)
+   {
+      if (chunks[c].firstBadValue >= 0 && chunks[c].firstBadValue < numStored)
+      {
+         numStored = chunks[c].firstBadValue;
+      }
+   }
+
+   return numStored;
+}
+
+/**
+ * Counts the values in a chunk (the runs of characters between whitespace).
+ *
+ * @param argument the chunk to count
+ * @return NULL
+ */
+void *countChunkValues(void *argument)
+{
+   TextChunk *chunk = argument;
+   long long numValues = 0;
+   unsigned char previousIsSpace = 1;
+
+   for (const char *cursor = chunk->start; cursor < chunk->end; cursor++) // counting where values start, without branching
+   {
+      unsigned char isSpace = IS_SPACE(*cursor);
+      numValues += previousIsSpace & !isSpace;
+      previousIsSpace = isSpace;
+   }
+
+   chunk->numValues = numValues;
+
+   return NULL;
+}
+
+/**
+ * Parses the values of a chunk that are meant to be stored, and stores them.
+ *
+ * @param argument the chunk to parse (once every chunk has been counted)
+ * @return NULL
+ */
+void *parseChunkValues(void *argument)
+{
+   TextChunk *chunk = argument;
+   const TextLayout *layout = chunk->layout;
+
+   long long index = chunk->firstIndex;
+   long long lastIndex = chunk->firstIndex + chunk->numValues;
+   if (lastIndex > chunk->endValue)
+   {
+      lastIndex = chunk->endValue;
+   }
+   if (index >= lastIndex || lastIndex <= chunk->firstValue)
+   {
+      return NULL;
+   }
+
+   const char *cursor = chunk->start;
+   const char *end = chunk->end;
+
+   // skipping the values before firstValue
+   while (index < chunk->firstValue)
+   {
+      while (IS_SPACE(*cursor))
+         cursor++;
+      while (cursor < end && !IS_SPACE(*cursor))
+         cursor++;
+      index++;
+   }
+
+   long long value = index - chunk->firstValue; // counted from firstValue
+   long long row = value / layout->rowLength;
+   int column = (int)(value % layout->rowLength);
+
+   for (; index < lastIndex; index++, value++)
+   {
+      while (IS_SPACE(*cursor))
+         cursor++;
+
+      double parsed;
+      const char *next = layout->hex == 'Y' ? parseHexValue(cursor, end, layout->hexScaler, &parsed)
+                                            : parseDecimalValue(cursor, end, &parsed);
+      if (next == NULL)
+      {
+         chunk->firstBadValue = value;
+         return NULL;
+      }
+      cursor = next;
+
+      if (column < layout->splitAt)
+      {
+         layout->first[row * layout->firstStride + column] = parsed;
+      }
+      else
+      {
+         layout->second[row * layout->secondStride + column - layout->splitAt] = parsed;
+      }
+
+      if (++column == layout->rowLength)
+      {
+         column = 0;
+         row++;
+      }
+   } // for (; index < lastIndex; index++, value++)
+
+   return NULL;
+}
+
+/**
+ * Runs a function on every chunk, each on its own thread (the first on
+ * the caller's thread). Chunks whose thread cannot be started are run on
+ * the caller's thread too.
+ *
+ * @param chunks the chunks
+ * @param numChunks the number of chunks
+ * @param function the function to run on each chunk
+ */
+void runOnChunks(TextChunk *chunks, int numChunks, void *(*function)(void *))
+{
+   pthread_t threads[MAX_PARSE_THREADS];
+   char started[MAX_PARSE_THREADS];
+
+   for (int c = 1; c < numChunks; c++)
+   {
+      started[c] = pthread_create(&threads[c], NULL, function, &chunks[c]) == 0;
+   }
+
+   function(&chunks[0]);
+
+   for (int c = 1; c < numChunks; c++)
+   {
+      if (started[c])
+      {
+         pthread_join(threads[c], NULL);
+      }
+      else
+      {
+         function(&chunks[c]);
+      }
+   }
+
+   return;
+}
+
+/**
+ * Parses a hex value into an unsigned int, as fscanf does with %x,
+ * and divides it by a scaler.
+ *
+ * @param cursor the first character of the value
+ * @param end the end of the text
+ * @param scaler what to divide the value by
+ * @param value where to store the value
+ * @return the character after the value, or NULL if it is not hex
+ */
+const char *parseHexValue(const char *cursor, const char *end, double scaler, double *value)
+{
+   unsigned long long hex = 0;
+   const char *start = cursor;
+
+   while (cursor < end && cursor - start <= 16)
+   {
+      char c = *cursor;
+      int digit;
+
+      if (c >= '0' && c <= '9')
+         digit = c - '0';
+      else if (c >= 'a' && c <= 'f')
+         digit = c - 'a' + 10;
+      else if (c >= 'A' && c <= 'F')
+         digit = c - 'A' + 10;
+      else
+         break;
+
+      hex = hex << 4 | digit;
+      cursor++;
+   }
+
+   if (cursor == start || cursor - start > 16 || (cursor < end && !IS_SPACE(*cursor))) // signs, 0x, and the like
+   {
+      return parseWithLibrary(start, end, 'Y', scaler, value);
+   }
+
+   *value = ((double)(unsigned int)hex) / scaler;
+
+   return cursor;
+}
+
+/**
+ * Parses a decimal value as fscanf does with %lf. Values that cannot be
+ * found exactly with one multiplication or division are left to strtod.
+ *
+ * @param cursor the first character of the value
+ * @param end the end of the text
+ * @param value where to store the value
+ * @return the character after the value, or NULL if it is not a number
+ */
+const char *parseDecimalValue(const char *cursor, const char *end, double *value)
+{
+   const char *start = cursor;
+   unsigned long long mantissa = 0;
+   int numDigits = 0;   // significant digits in the mantissa
+   int exponent = 0;    // the power of ten the mantissa is multiplied by
+   char anyDigits = 0;
+   char negative = 0;
+
+   if (cursor < end && (*cursor == '-' || *cursor == '+'))
+   {
+      negative = *cursor == '-';
+      cursor++;
+   }
+
+   for (; cursor < end && *cursor >= '0' && *cursor <= '9'; cursor++)
+   {
+      anyDigits = 1;
+      if (mantissa != 0 || *cursor != '0')
+      {
+         mantissa = mantissa * 10 + (*cursor - '0');
+         numDigits++;
+      }
+   }
+
+   if (cursor < end && *cursor == '.')
+   {
+      for (cursor++; cursor < end && *cursor >= '0' && *cursor <= '9'; cursor++)
+      {
+         anyDigits = 1;
+         if (mantissa != 0 || *cursor != '0')
+         {
+            mantissa = mantissa * 10 + (*cursor - '0');
+            numDigits++;
+         }
+         exponent--;
+      }
+   }
+
+   if (anyDigits && cursor < end && (*cursor == 'e' || *cursor == 'E'))
+   {
+      cursor++;
+      char negativeExponent = 0;
+      int explicitExponent = 0;
+
+      if (cursor < end && (*cursor == '-' || *cursor == '+'))
+      {
+         negativeExponent = *cursor == '-';
+         cursor++;
+      }
+      if (cursor == end || *cursor < '0' || *cursor > '9')
+      {
+         return parseWithLibrary(start, end, 'n', 1.0, value);
+      }
+      for (; cursor < end && *cursor >= '0' && *cursor <= '9' && explicitExponent < 10000; cursor++)
+      {
+         explicitExponent = explicitExponent * 10 + (*cursor - '0');
+      }
+      exponent += negativeExponent ? -explicitExponent : explicitExponent;
+   }
+
+   if (!anyDigits || numDigits > 19 || mantissa > MAX_EXACT_MANTISSA || (cursor < end && !IS_SPACE(*cursor)))
+   {
+      return parseWithLibrary(start, end, 'n', 1.0, value);
+   }
+
+   double result;
+   if (mantissa == 0)
+   {
+      result = 0.0;
+   }
+   else if (exponent >= 0 && exponent <= 22)
+   {
+      result = (double)mantissa * powersOfTen[exponent];
+   }
+   else if (exponent < 0 && exponent >= -22)
+   {
+      result = (double)mantissa / powersOfTen[-exponent];
+   }
+   else
+   {
+      return parseWithLibrary(start, end, 'n', 1.0, value);
+   }
+
+   *value = negative ? -result : result;
+
+   return cursor;
+}
+
+/**
+ * Parses a value with strtoul or strtod, for the values that the
+ * hand-written parsers leave to them.
+ *
+ * @param cursor the first character of the value
+ * @param end the end of the text
+ * @param hex Y to parse the value as hex (into an unsigned int, divided by scaler)
+ * @param scaler what to divide a hex value by
+ * @param value where to store the value
+ * @return the character after the value, or NULL if it is not a number
+ */
+const char *parseWithLibrary(const char *cursor, const char *end, char hex, double scaler, double *value)
+{
+   char token[MAX_TOKEN_LENGTH];
+   int length = 0;
+
+   while (cursor + length < end && !IS_SPACE(cursor[length]) && length < MAX_TOKEN_LENGTH - 1)
+   {
+      token[length] = cursor[length];
+      length++;
+   }
+   token[length] = '\0';
+
+   char *stop;
+   if (hex == 'Y')
+   {
+      *value = ((double)(unsigned int)strtoul(token, &stop, 16)) / scaler;
+   }
+   else
+   {
+      *value = strtod(token, &stop);
+   }
+
+   if (stop == token)
+   {
+      return NULL;
+   }
+
+   while (cursor < end && !IS_SPACE(*cursor)) // the rest of the value (as fscanf would have stopped on it)
+   {
+      cursor++;
+   }
+
+   return cursor;
+}
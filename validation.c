@@ -0,0 +1,404 @@
+/**
+ * Created 10/18/2026
+ * This file holds back the last of a network's training sets to validate
+ * it on while it trains, and stops training once the network has stopped
+ * getting better on them, keeping the weights it did best with.
+ *
+ * Every validation_every cycles, the training thread packs the weights that
+ * are used into a snapshot (see packWeights in ./network.c) and moves on.
+ * A background thread runs the validation sets through the latest snapshot
+ * with a copy of the network that reads the snapshot instead of the
+ * weights being trained, so training never waits for validation. If
+ * training hands over a new snapshot before the last one is validated,
+ * only the newest is kept.
+ *
+ * The snapshot with the lowest validation error is kept. Once the latest
+ * validated snapshot is validation_patience cycles newer than the best one,
+ * train (see ./network.c) stops, and the best snapshot's weights are put
+ * back into the network.
+ *
+ * Functions in this file:
+ *
+ * void splitValidationSets(Network *net)
+ * Validator *createValidator(const Network *net)
+ * void freeValidator(Validator *validator)
+ * void startValidation(Validator *validator)
+ * void submitSnapshot(Validator *validator, const Network *net)
+ * char checkValidation(Validator *validator, const Network *net)
+ * void finishValidation(Validator *validator, Network *net)
+ * void *runValidator(void *argument)
+ * double validateSnapshot(Validator *validator, double *snapshot)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "./headerfiles/networkInternals.h" // importing the network layout and functions
+#include "./headerfiles/logger.h"           // importing the logger
+#include "./headerfiles/validation.h"
+
+struct Validator
+{
+   const Network *net;     // the network being trained (only its training sets are read)
+   Network snapshotNet;    // a copy of the network that runs the snapshots instead of the weights being trained
+   NetworkScratch *scratch;
+   double *weights;        // the snapshot being validated, unpacked for the copy of the network to run
+   size_t numWeightValues; // doubles in the unpacked weights, padding included
+   int numUsedWeights;     // doubles in each snapshot (see findNumUsedWeights)
+
+   double *packing; // where the training thread packs the next snapshot (only it touches this one)
+   double *pending; // the newest snapshot, waiting to be validated
+   double *working; // the snapshot being validated
+   double *best;    // the snapshot with the lowest validation error so far
+
+   int pendingIteration;   // cycle the pending snapshot was taken after (-1 for none)
+   int submittedIteration; // cycle the last snapshot was taken after (-1 for none)
+   char busy;              // whether a snapshot is being validated
+
+   int lastIteration;    // cycle of the last snapshot that was validated (-1 for none)
+   double lastError;     // its validation error
+   int loggedIteration;  // the last validated cycle the training thread has logged
+   int bestIteration;    // cycle of the best snapshot (-1 for none)
+   double bestError;     // its validation error
+   int stopping;
+
+   pthread_mutex_t lock;
+   pthread_cond_t changed; // signalled whenever a snapshot is handed over or validated, or the validator stops
+   pthread_t thread;
+};
+
+// function headers ----------------------
+
+void *runValidator(void *);
+double validateSnapshot(Validator *, double *);
+
+// functions ----------------------
+
+/**
+ * Holds back the last validation_fraction of the network's training sets
+ * for validation. They stay where they are in memory, right after the
+ * training sets, and are left out of numTrainingSets so that nothing
+ * trains on them. This is called once the training sets are loaded, before
+ * anything (such as a projection) is found from them.
+ *
+ * @param net the network whose training sets to split
+ */
+void splitValidationSets(Network *net)
+{
+   net->numValidationSets = 0;
+
+   if (net->validationFraction <= 0.0 || net->trainNetwork != 'Y')
+   {
+      return;
+   }
+   if (net->numShards > 1 || net->trainingInputs == NULL)
+   {
+      printf("Validation needs all of the training sets in memory in one process, so there is none.\n");
+      return;
+   }
+
+   int numValidationSets = (int)(net->numTrainingSets * net->validationFraction);
+   if (numValidationSets < 1 || numValidationSets >= net->numTrainingSets)
+   {
+      printf("A validation fraction of %lf leaves no training sets to validate on or to train on, so there is none.\n",
+             net->validationFraction);
+      return;
+   }
+
+   net->numValidationSets = numValidationSets;
+   net->numTrainingSets -= numValidationSets;
+   printf("validating on the last %d of the training sets\n", net->numValidationSets);
+
+   return;
+}
+
+/**
+ * Creates a validator for a network whose validation sets have been split
+ * off and starts its thread, which waits for the first snapshot.
+ *
+ * @param net the network to validate (with its weights allocated)
+ * @return the new validator, or NULL if it could not be created
+ */
+Validator *createValidator(const Network *net)
+{
+   Validator *validator = calloc(1, sizeof(Validator));
+   if (validator == NULL)
+   {
+      printf("There was an error allocating memory for the validator.\n");
+      return NULL;
+   }
+
+   validator->net = net;
+   validator->numWeightValues =
+       (size_t)net->maxWeightsInALayer * net->numLayers + net->totalWeights - net->convWeightsOffset;
+   validator->numUsedWeights = findNumUsedWeights(net);
+   validator->weights = calloc(validator->numWeightValues, sizeof(double)); // the padding stays 0
+   validator->packing = calloc(validator->numUsedWeights, sizeof(double));
+   validator->pending = calloc(validator->numUsedWeights, sizeof(double));
+   validator->working = calloc(validator->numUsedWeights, sizeof(double));
+   validator->best = calloc(validator->numUsedWeights, sizeof(double));
+   validator->scratch = createScratch(net);
+
+   if (validator->weights == NULL || validator->packing == NULL || validator->pending == NULL ||
+       validator->working == NULL || validator->best == NULL || validator->scratch == NULL)
+   {
+      printf("There was an error allocating memory for the validator.\n");
+      free(validator->weights);
+      free(validator->packing);
+      free(validator->pending);
+      free(validator->working);
+      free(validator->best);
+      if (validator->scratch != NULL)
+      {
+         freeScratch(validator->scratch);
+      }
+      free(validator);
+      return NULL;
+   }
+
+   // the copy only runs the network, always through the dense weights
+   validator->snapshotNet = *net;
+   validator->snapshotNet.weights = validator->weights;
+   validator->snapshotNet.sparseLayers = NULL;
+   validator->snapshotNet.useSparseKernels = 'n';
+
+   pthread_mutex_init(&validator->lock, NULL);
+   pthread_cond_init(&validator->changed, NULL);
+
+   startValidation(validator);
+
+   if (pthread_create(&validator->thread, NULL, &runValidator, validator) != 0)
+   {
+      printf("There was an error starting the validation thread.\n");
+      pthread_mutex_destroy(&validator->lock);
+      pthread_cond_destroy(&validator->changed);
+      free(validator->weights);
+      free(validator->packing);
+      free(validator->pending);
+      free(validator->working);
+      free(validator->best);
+      freeScratch(validator->scratch);
+      free(validator);
+      return NULL;
+   }
+
+   return validator;
+}
+
+/**
+ * Stops a validator's thread and frees it.
+ *
+ * @param validator the validator to free (NULL does nothing)
+ */
+void freeValidator(Validator *validator)
+{
+   if (validator == NULL)
+   {
+      return;
+   }
+
+   pthread_mutex_lock(&validator->lock);
+   validator->stopping = 1;
+   pthread_cond_broadcast(&validator->changed);
+   pthread_mutex_unlock(&validator->lock);
+
+   pthread_join(validator->thread, NULL);
+
+   pthread_mutex_destroy(&validator->lock);
+   pthread_cond_destroy(&validator->changed);
+   free(validator->weights);
+   free(validator->packing);
+   free(validator->pending);
+   free(validator->working);
+   free(validator->best);
+   freeScratch(validator->scratch);
+   free(validator);
+
+   return;
+}
+
+/**
+ * Forgets every snapshot validated so far, so that a new round of training
+ * (such as fine-tuning after pruning) keeps the best of its own snapshots.
+ * The validator must be idle, as it is after finishValidation.
+ *
+ * @param validator the validator to reset
+ */
+void startValidation(Validator *validator)
+{
+   pthread_mutex_lock(&validator->lock);
+   validator->pendingIteration = -1;
+   validator->submittedIteration = -1;
+   validator->lastIteration = -1;
+   validator->loggedIteration = -1;
+   validator->bestIteration = -1;
+   validator->bestError = HUGE_VAL;
+   pthread_mutex_unlock(&validator->lock);
+
+   return;
+}
+
+/**
+ * Hands a snapshot of the network's weights over to be validated. The
+ * weights that are used are packed before taking the lock, which is only
+ * held to swap the snapshot in; if the last snapshot has not been validated
+ * yet, it is replaced.
+ *
+ * @param validator the network's validator
+ * @param net the network, just after a cycle of training
+ */
+void submitSnapshot(Validator *validator, const Network *net)
+{
+   packWeights(net, net->weights, validator->packing);
+
+   pthread_mutex_lock(&validator->lock);
+   double *snapshot = validator->packing; // the replaced snapshot is packed over next time
+   validator->packing = validator->pending;
+   validator->pending = snapshot;
+   validator->pendingIteration = net->iteration;
+   validator->submittedIteration = net->iteration;
+   pthread_cond_broadcast(&validator->changed);
+   pthread_mutex_unlock(&validator->lock);
+
+   return;
+}
+
+/**
+ * Logs the newest validation error (if debug messages are printed and it
+ * has not been logged yet), and works out whether training should stop.
+ * This is only called from the training thread, which owns the logger.
+ *
+ * @param validator the network's validator
+ * @param net the network being trained
+ * @return 'Y' if the best snapshot is validation_patience cycles older than the newest validated one
+ */
+char checkValidation(Validator *validator, const Network *net)
+{
+   pthread_mutex_lock(&validator->lock);
+   int lastIteration = validator->lastIteration;
+   double lastError = validator->lastError;
+   int bestIteration = validator->bestIteration;
+   pthread_mutex_unlock(&validator->lock);
+
+   if (net->printDebugMessages == 'Y' && lastIteration != validator->loggedIteration)
+   {
+      logText(net->logger, "Validation error after cycle %d: %.16lf\n", lastIteration, lastError);
+      validator->loggedIteration = lastIteration;
+   }
+
+   return bestIteration >= 0 && lastIteration - bestIteration >= net->validationPatience ? 'Y' : 'n';
+}
+
+/**
+ * Validates the network's final weights (if they have not been already),
+ * waits until every snapshot handed over is validated, and puts the best
+ * snapshot's weights back into the network.
+ *
+ * @param validator the network's validator
+ * @param net the network, once it has finished training
+ */
+void finishValidation(Validator *validator, Network *net)
+{
+   if (validator->submittedIteration != net->iteration)
+   {
+      submitSnapshot(validator, net);
+   }
+
+   pthread_mutex_lock(&validator->lock);
+   while (validator->pendingIteration >= 0 || validator->busy)
+   {
+      pthread_cond_wait(&validator->changed, &validator->lock);
+   }
+   pthread_mutex_unlock(&validator->lock);
+
+   if (validator->bestIteration >= 0 && validator->bestIteration != validator->lastIteration)
+   {
+      unpackWeights(net, validator->best, net->weights);
+      printf("Kept the weights from cycle %d, whose validation error was the lowest (%.16lf)\n", validator->bestIteration,
+             validator->bestError);
+   }
+   else if (validator->bestIteration >= 0)
+   {
+      printf("Validation error: %.16lf\n", validator->bestError);
+   }
+
+   return;
+}
+
+/**
+ * Validates the newest snapshot whenever there is one, until the validator
+ * is stopped.
+ *
+ * @param argument the validator the thread works for
+ * @return NULL
+ */
+void *runValidator(void *argument)
+{
+   Validator *validator = argument;
+
+   pthread_mutex_lock(&validator->lock);
+   while (1)
+   {
+      while (!validator->stopping && validator->pendingIteration < 0)
+      {
+         pthread_cond_wait(&validator->changed, &validator->lock);
+      }
+      if (validator->stopping)
+         break;
+
+      double *snapshot = validator->pending; // taking the newest snapshot
+      validator->pending = validator->working;
+      validator->working = snapshot;
+      int iteration = validator->pendingIteration;
+      validator->pendingIteration = -1;
+      validator->busy = 1;
+      pthread_mutex_unlock(&validator->lock);
+
+      double error = validateSnapshot(validator, snapshot);
+
+      pthread_mutex_lock(&validator->lock);
+      validator->lastIteration = iteration;
+      validator->lastError = error;
+      if (error < validator->bestError)
+      {
+         validator->working = validator->best; // the old best is written over by the next snapshot
+         validator->best = snapshot;
+         validator->bestError = error;
+         validator->bestIteration = iteration;
+      }
+      validator->busy = 0;
+      pthread_cond_broadcast(&validator->changed);
+   } // while (1)
+   pthread_mutex_unlock(&validator->lock);
+
+   return NULL;
+}
+
+/**
+ * Runs every validation set through a snapshot of the weights.
+ *
+ * @param validator the validator (its copy of the network and scratch are used)
+ * @param snapshot the packed snapshot to run
+ * @return the sum of the errors of the validation sets
+ */
+double validateSnapshot(Validator *validator, double *snapshot)
+{
+   const Network *net = validator->net;
+   NetworkScratch *scratch = validator->scratch;
+   double errorSum = 0.0;
+
+   unpackWeights(net, snapshot, validator->weights);
+
+   for (int v = 0; v < net->numValidationSets; v++)
+   {
+      int t = net->numTrainingSets + v; // the validation sets come right after the training sets
+      scratch->expectedOutputs = net->trainingLabels + (size_t)t * net->numOutputNodes;
+      runNetwork(&validator->snapshotNet, scratch, net->trainingInputs + (size_t)t * net->inputStride, NULL);
+      errorSum += scratch->error;
+   }
+
+   return errorSum;
+}